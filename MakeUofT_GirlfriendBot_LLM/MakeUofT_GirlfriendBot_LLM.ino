@@ -432,11 +432,9 @@ const char* openai_apiKey = "xxx";
 const char* openai_apiBaseUrl = "https://api.chatanywhere.tech";
 
 //For OLED Display
-unsigned long lastOLED = 0;
 int eyesFrame = 2;   // start OPEN (0=closed,1=half,2=open)
 int blinkStage = 0;  // 0=idle, 1=closing, 2=closed, 3=opening
 int mouthFrame = 0;
-unsigned long lastFrameFlip = 0;
 unsigned long lastBlinkStep = 0;
 unsigned long nextBlinkTime = 0;
 
@@ -445,13 +443,24 @@ int gazeStage = 0;               // 0=idle, 1=going left, 2=hold, 3=returning
 unsigned long lastGazeStep = 0;
 unsigned long nextGazeTime = 0;
 
-const unsigned long OLED_REFRESH_MS = 50;   // how often you redraw screen
-const unsigned long FRAME_FLIP_MS   = 120;  // how fast animation flips 0<->1
-
-const unsigned long MOUTH_START_DELAY_MS = 1300;  // try 120–300ms
-bool speakingDelayed = false;
-unsigned long speakStartMs = 0;
-bool prevRunning = false;
+// Face compositor: loop() says which bitmaps it wants, faceTask draws the layers that changed into the
+// u8g2 buffer and sends only the 8x8 tiles that differ. Blink and gaze frames both go to the eyes layer
+// (tile rows 0..4), the mouth is tile rows 5..7. Nothing goes over I2C while the face is still.
+struct FaceLayer {
+  const unsigned char* want;   // set by loop()
+  const unsigned char* shown;  // on the panel, faceTask only; NULL: unknown, send it all
+  uint8_t tileY;
+  uint8_t tileRows;
+};
+FaceLayer faceLayers[2] = {
+  {eyesFrames[2], NULL, 0, 5},
+  {mouthFrames[0], NULL, 5, 3},
+};
+portMUX_TYPE faceMux = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t faceTaskHandle = NULL;
+const unsigned long OLED_MIN_FRAME_MS = 20;  // changes closer together go out as one frame
+const BaseType_t OLED_TASK_CORE = 1;         // the audio task runs on core 0
+const UBaseType_t OLED_TASK_PRIORITY = 1;    // below the audio task (2)
 
 // TTS Voice Configuration
 // Available voices: "alloy", "echo", "fable", "onyx", "nova", "shimmer"
@@ -587,6 +596,8 @@ void setup() {
   Wire.begin(SDA_PIN, SCL_PIN);
   u8g2.begin();
   u8g2.setPowerSave(0);
+  xTaskCreatePinnedToCore(faceTask, "face", 4096, NULL, OLED_TASK_PRIORITY, &faceTaskHandle, OLED_TASK_CORE);
+  xTaskNotifyGive(faceTaskHandle);          // first frame
   //For Randomized Blink
   randomSeed(esp_random());                 // better on ESP32 than analogRead(0)
   nextBlinkTime = millis() + random(1000, 5000);  // first blink in 1–5s
@@ -630,6 +641,8 @@ void setup() {
     audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);
     // Set volume
     audio.setVolume(100);
+    // Publish the output envelope for the mouth
+    audio.enableEnvelope(true);
 
     // Set system prompt for GPT
     gptChat.setSystemPrompt(systemPrompt);
@@ -889,55 +902,72 @@ void loop() {
     delay(10);
   }
 
-  bool running = audio.isRunning();
-
-  // detect rising edge: audio just started
-  if (running && !prevRunning) {
-    speakStartMs = millis();
-    speakingDelayed = false;
-  }
-
-  // detect falling edge: audio stopped
-  if (!running && prevRunning) {
-    speakingDelayed = false;
-    mouthFrame = 0;           // close immediately when done
-  }
-
-  prevRunning = running;
+  // ---- Mouth animation: what the speaker plays right now ----
+  uint8_t level = 0;
+  uint8_t viseme = Audio::VISEME_REST;
+  audio.getEnvelope(millis(), &level, &viseme);
+  if (viseme == Audio::VISEME_OPEN) {
+    mouthFrame = 1;
+  } else if (viseme == Audio::VISEME_REST || viseme == Audio::VISEME_NARROW) {
+    mouthFrame = 0;           // silence, or teeth together for s/f/sh
+  }                           // VISEME_MID keeps the last frame so the mouth does not flutter
+
+  // ---- Face: faceTask sends whatever changed ----
+  setFace(blinkStage != 0 ? eyesFrames[eyesFrame] : gazeFramesLR[gazePos], mouthFrames[mouthFrame]);
+}
 
-  // only allow mouth once the delay has passed
-  if (running && !speakingDelayed) {
-    if (millis() - speakStartMs >= MOUTH_START_DELAY_MS) {
-      speakingDelayed = true;
-    }
-  }
+void setFace(const unsigned char* eyes, const unsigned char* mouth) {
+  bool changed = false;
+  portENTER_CRITICAL(&faceMux);
+  if (faceLayers[0].want != eyes) { faceLayers[0].want = eyes; changed = true; }
+  if (faceLayers[1].want != mouth) { faceLayers[1].want = mouth; changed = true; }
+  portEXIT_CRITICAL(&faceMux);
+  if (changed && faceTaskHandle) xTaskNotifyGive(faceTaskHandle);
+}
 
-  // ---- Mouth animation (use speakingDelayed, not running) ----
-  if (!speakingDelayed) {
-    mouthFrame = 0;
-  } else {
-    if (millis() - lastFrameFlip > FRAME_FLIP_MS) {
-      lastFrameFlip = millis();
-      mouthFrame ^= 1;
+// Tiles of a 128 px wide layer that differ between two XBM bitmaps. An XBM byte is 8 pixels of a row,
+// so byte column x is tile column x. False if nothing differs.
+bool faceDirtyTiles(const unsigned char* from, const unsigned char* to, uint8_t tileRows,
+                    uint8_t& tx, uint8_t& ty, uint8_t& tw, uint8_t& th) {
+  uint8_t x0 = 16, x1 = 0, y0 = tileRows, y1 = 0;
+  for (uint8_t y = 0; y < tileRows * 8; y++) {
+    for (uint8_t x = 0; x < 16; x++) {
+      if (from && pgm_read_byte(from + y * 16 + x) == pgm_read_byte(to + y * 16 + x)) continue;
+      if (x < x0) x0 = x;
+      if (x > x1) x1 = x;
+      if (y / 8 < y0) y0 = y / 8;
+      if (y / 8 > y1) y1 = y / 8;
     }
   }
+  if (x0 > x1) return false;
+  tx = x0; tw = x1 - x0 + 1;
+  ty = y0; th = y1 - y0 + 1;
+  return true;
+}
 
-  if (millis() - lastOLED > OLED_REFRESH_MS) {
-    lastOLED = millis();
-
-    const unsigned char* eyeBmp;
-
-    // If blinking (half/closed), use blink frames
-    if (blinkStage != 0) {
-      eyeBmp = eyesFrames[eyesFrame];     // closed/half/open during blink
-    } else {
-      eyeBmp = gazeFramesLR[gazePos];
+// Display task: owns u8g2 and I2C after setup(), wakes up when loop() changes the face
+void faceTask(void* param) {
+  unsigned long lastFrame = 0;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    unsigned long since = millis() - lastFrame;
+    if (since < OLED_MIN_FRAME_MS) vTaskDelay(pdMS_TO_TICKS(OLED_MIN_FRAME_MS - since));
+    lastFrame = millis();
+
+    const unsigned char* want[2];
+    portENTER_CRITICAL(&faceMux);
+    want[0] = faceLayers[0].want;
+    want[1] = faceLayers[1].want;
+    portEXIT_CRITICAL(&faceMux);
+
+    for (int i = 0; i < 2; i++) {
+      FaceLayer& layer = faceLayers[i];
+      uint8_t tx, ty, tw, th;
+      if (!faceDirtyTiles(layer.shown, want[i], layer.tileRows, tx, ty, tw, th)) continue;
+      u8g2.drawXBMP(0, layer.tileY * 8, 128, layer.tileRows * 8, want[i]);  // solid: background too
+      u8g2.updateDisplayArea(tx, layer.tileY + ty, tw, th);
+      layer.shown = want[i];
     }
-
-    u8g2.clearBuffer();
-    u8g2.drawXBMP(0, 0, 128, 40, eyeBmp);
-    u8g2.drawXBMP(0, 40, 128, 24, mouthFrames[mouthFrame]);
-    u8g2.sendBuffer();
   }
 }
 
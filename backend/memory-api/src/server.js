@@ -232,6 +232,23 @@ async function embedText(text, taskType = 'RETRIEVAL_DOCUMENT') {
   return values;
 }
 
+// int8 form of an embedding for the device's local recall index: L2-normalized, then scaled so the
+// largest component is 127. The device scores with dot(qa, qb) * sa * sb, i.e. the cosine similarity.
+function quantizeEmbedding(values) {
+  if (!Array.isArray(values) || values.length === 0) return null;
+  let norm = 0;
+  for (const v of values) norm += v * v;
+  norm = Math.sqrt(norm) || 1;
+  let maxAbs = 0;
+  for (const v of values) maxAbs = Math.max(maxAbs, Math.abs(v) / norm);
+  const scale = maxAbs > 0 ? maxAbs / 127 : 1;
+  const q = Buffer.alloc(values.length);
+  for (let i = 0; i < values.length; i++) {
+    q.writeInt8(Math.max(-127, Math.min(127, Math.round(values[i] / norm / scale))), i);
+  }
+  return { q: q.toString('base64'), s: scale };
+}
+
 async function transcribePcmWithGemini(pcmBuffer, { sampleRate = 16000, channels = 1, bitsPerSample = 16 } = {}) {
   if (!GEMINI_API_KEY) return '';
 
@@ -780,6 +797,76 @@ app.post('/v1/memory/recall', auth, async (req, res) => {
   }
 });
 
+// Incremental sync of the device's local recall index: items newer than `since` (ms), oldest first
+app.post('/v1/memory/sync', auth, async (req, res) => {
+  try {
+    if (!ensureMemoryStore(res)) return;
+
+    const deviceId = safeString(req.body?.device_id);
+    const since = Math.max(0, Number(req.body?.since ?? 0) || 0);
+    const limit = Math.max(1, Math.min(32, Number(req.body?.limit ?? 8) || 8));
+    const maxText = Math.max(64, Math.min(2000, Number(req.body?.max_text ?? 480) || 480));
+    // newest first for a cold index: items older than `before` (0: all), `next` is the oldest one sent
+    const desc = req.body?.order === 'desc';
+    const before = Math.max(0, Number(req.body?.before ?? 0) || 0);
+
+    if (!deviceId) {
+      res.status(400).json({ ok: false, error: 'missing_required_fields' });
+      return;
+    }
+
+    const query = { device_id: deviceId, embedding: { $type: 'array' } };
+    if (!desc) query.created_at = { $gt: new Date(since) };
+    else if (before > 0) query.created_at = { $lt: new Date(before) };
+    const docs = await collection
+      .find(query)
+      .project({ _id: 0, kind: 1, text: 1, created_at: 1, embedding: 1 })
+      .sort({ created_at: desc ? -1 : 1 })
+      .limit(limit)
+      .toArray();
+
+    const items = [];
+    for (const d of docs) {
+      const q = quantizeEmbedding(d.embedding);
+      if (!q) continue;
+      items.push({
+        kind: d.kind === 'visual_event' ? 'v' : 'c',
+        text: safeString(d.text).slice(0, maxText),
+        t: new Date(d.created_at).getTime(),
+        q: q.q,
+        s: q.s
+      });
+    }
+
+    const next = docs.length > 0 ? new Date(docs[docs.length - 1].created_at).getTime() : desc ? before : since;
+    res.status(200).json({ ok: true, dim: Number(GEMINI_EMBEDDING_DIM), items, next, more: docs.length === limit });
+  } catch (err) {
+    console.error('[memory-api] sync error', err);
+    res.status(500).json({ ok: false, error: 'internal_error' });
+  }
+});
+
+// Query embedding for a local recall on the device, same quantization as /v1/memory/sync
+app.post('/v1/memory/embed', auth, async (req, res) => {
+  try {
+    const text = safeString(req.body?.text);
+    if (!text) {
+      res.status(400).json({ ok: false, error: 'missing_required_fields' });
+      return;
+    }
+
+    const q = quantizeEmbedding(await embedText(text, 'RETRIEVAL_QUERY'));
+    if (!q) {
+      res.status(503).json({ ok: false, error: 'embedding_unavailable' });
+      return;
+    }
+    res.status(200).json({ ok: true, dim: Number(GEMINI_EMBEDDING_DIM), q: q.q, s: q.s });
+  } catch (err) {
+    console.error('[memory-api] embed error', err);
+    res.status(500).json({ ok: false, error: 'internal_error' });
+  }
+});
+
 await initMongo();
 setInterval(() => pruneAsrSessions(), 60 * 1000).unref();
 
@@ -33,12 +33,18 @@
 #include <GeminiASRChat.h>
 #include <BackendASRChat.h>
 #include <BackendLLMProvider.h>
+#include <HedgedProvider.h>
 #include <BackendTTS.h>
 #include <VisualContextManager.h>
 #include <RemoteMemory.h>
 #include <ElevenLabsTTS.h>
 #include <WebControl.h>
+#include <LatencyTracer.h>
+#include <SystemTelemetry.h>
+#include <AsyncJobRunner.h>
 #include <OpenAIVisionProxy.h>
+#include <AckClips.h>
+#include <EchoCanceller.h>
 #include <ArduinoJson.h>
 #include <Preferences.h>
 #include <ctype.h>
@@ -98,6 +104,7 @@ String elevenlabs_api_key = "";
 String elevenlabs_voice_id = "EST9Ui6982FZPSi7gCHi";
 String elevenlabs_model_id = "eleven_flash_v2_5";
 String elevenlabs_output_format = "mp3_22050_32";
+bool elevenlabs_streaming = true;  // websocket stream-input straight into the player, HTTP + SPIFFS otherwise
 
 // Gemini configuration
 String gemini_apiKey = "";
@@ -107,6 +114,13 @@ String backend_api_url = "";
 String backend_api_key = "";
 bool use_backend_tts = true;
 
+// LLM hedging: route each turn to the fastest healthy provider, hedge slow requests with another one
+bool llm_hedge = false;
+unsigned long llm_deadline_ms = 15000;  // whole LLM step of a turn
+int llm_hedge_pct = 90;                 // hedge after this percentile of the provider latency, 0 = never
+// Conversation memory sent with each request, in approximate tokens; older turns go into a rolling summary
+int llm_history_tokens = 768;
+
 // System prompt
 String system_prompt = "You are a helpful AI assistant.";
 
@@ -126,12 +140,22 @@ String memory_api_key = "";
 String device_id = "";
 String memory_mode = "local";  // local|remote|both
 bool memory_store_visual_events = true;
+bool memory_local_index = true;  // recall from a synced copy of the memory items, the server recall is the fallback
 
 // Interaction mode
 // true  -> one utterance per "start" command/button press
 // false -> continuous auto-restart conversation loop
 bool single_turn_mode = true;
 bool manual_record_control = true;
+// ByteDance ASR: start the LLM request on a stable partial transcript, adopt it if the final one matches
+bool asr_speculative = true;
+// Free version: play a clip from SPIFFS /ack while the reply is prepared if the predicted wait is this long, 0 = off
+int ack_threshold_ms = ACK_THRESHOLD_MS;
+// Free version, continuous mode: the mic stays on through an echo canceller while the reply plays, speech stops it
+bool barge_in_enabled = false;
+int barge_in_ms = AEC_BARGE_IN_MS;
+// I2S at one fixed rate, the replies are resampled to it (no clock change between sources), 0 = I2S follows the reply
+int i2s_rate = 0;
 
 // Web control
 bool web_control_enabled = false;
@@ -165,12 +189,15 @@ OpenAIProvider* openaiProvider = nullptr;
 OpenAIProvider* ttsProvider = nullptr;
 GeminiProvider* geminiProvider = nullptr;
 BackendLLMProvider* backendProvider = nullptr;
+HedgedProvider* hedgedProvider = nullptr;  // only with llm_hedge
 AIProvider* aiProvider = nullptr;
 ArduinoTTSChat* ttsChat = nullptr;  // WebSocket-based TTS for Pro version
 VisualContextManager* visualContextMgr = nullptr;
 WebControl* webControl = nullptr;
 RemoteMemory remoteMemory;
 ElevenLabsTTS elevenlabsTTS;
+AckClips ackClips;
+EchoCanceller echoCanceller;
 BackendTTS backendTTS;
 Preferences preferences;
 
@@ -195,6 +222,28 @@ enum ConversationState {
 // ============================================================================
 
 ConversationState currentState = STATE_WAITING_CONFIG;
+
+enum TurnJobKind : uint8_t {
+  JOB_THINK = 1,   // vision, recall, LLM
+  JOB_SPECULATE,   // the same for a partial transcript, not committed to the conversation yet
+  JOB_SPEAK,       // HTTP TTS download (free version)
+  JOB_STORE,       // remote memory store
+  JOB_SUMMARIZE,   // fold old turns into the conversation summary
+  JOB_MEMORY_SYNC  // pull new memory items into the local recall index
+};
+AsyncJobRunner turnJobs("TurnJobs");
+String turnUserText = "";  // transcription of the turn in flight, for the memory store
+
+// Speculative LLM request started from a stable ASR partial while the silence detection still runs
+struct Speculation {
+  uint32_t jobId;  // 0: none
+  String text;     // partial it was started for
+  bool done;
+  bool ok;
+  String reply;
+  bool adopted;    // the final transcript matched, the turn waits for the reply
+};
+Speculation speculation = {0, "", false, false, "", false};
 bool continuousMode = false;
 bool buttonPressed = false;
 bool wasButtonPressed = false;
@@ -243,6 +292,17 @@ void asrStopRecording() {
   if (asrChat != nullptr) asrChat->stopRecording();
 }
 
+// Mic samples while no recording runs, for the barge-in monitor
+size_t asrReadMicrophone(int16_t* out, size_t maxSamples) {
+  if (isBackendASR()) {
+    return backendAsrChat != nullptr ? backendAsrChat->readMicrophone(out, maxSamples) : 0;
+  }
+  if (isGeminiASR()) {
+    return geminiAsrChat != nullptr ? geminiAsrChat->readMicrophone(out, maxSamples) : 0;
+  }
+  return asrChat != nullptr ? asrChat->readMicrophone(out, maxSamples) : 0;
+}
+
 bool asrIsRecording() {
   if (isBackendASR()) {
     return backendAsrChat != nullptr && backendAsrChat->isRecording();
@@ -438,7 +498,26 @@ void applyVisualContext(const String& ctx, const char* reasonTag) {
   Serial.printf("[Vision] Stored visual event (%s), count_last_hour=%d\n", reasonTag, storedLastHour + 1);
 }
 
+// Same budget for every provider, HedgedProvider replays turns into its members
+void applyHistoryBudget() {
+  size_t tokens = (size_t)max(llm_history_tokens, 64);
+  if (openaiProvider != nullptr) openaiProvider->setHistoryBudget(tokens);
+  if (backendProvider != nullptr) backendProvider->setHistoryBudget(tokens);
+  if (geminiProvider != nullptr) geminiProvider->setHistoryBudget(tokens);
+}
+
+// With hedging the selected provider becomes the preferred member, requests still go through the hedge
+AIProvider* routeLLM(AIProvider* selected) {
+  if (hedgedProvider == nullptr) return selected;
+  hedgedProvider->prefer(selected);
+  return hedgedProvider;
+}
+
 void applyRuntimeModelSwitch(const String& provider, const String& model) {
+  if (turnJobs.busy()) {  // the worker is using aiProvider
+    Serial.println("[Runtime] Turn in progress, model switch ignored");
+    return;
+  }
   if (provider == "backend") {
     if (backendProvider != nullptr) {
       ai_provider = "backend";
@@ -446,7 +525,7 @@ void applyRuntimeModelSwitch(const String& provider, const String& model) {
         gemini_model = model;
         backendProvider->setModel(model);
       }
-      aiProvider = backendProvider;
+      aiProvider = routeLLM(backendProvider);
       if (visualContextMgr != nullptr) visualContextMgr->setProvider(aiProvider);
       saveConfigToFlash();
       Serial.printf("[Runtime] Provider=backend Model=%s\n", aiProvider->getModel().c_str());
@@ -461,7 +540,7 @@ void applyRuntimeModelSwitch(const String& provider, const String& model) {
       ai_provider = "gemini";
       gemini_model = model;
       geminiProvider->setModel(model);
-      aiProvider = geminiProvider;
+      aiProvider = routeLLM(geminiProvider);
       if (visualContextMgr != nullptr) visualContextMgr->setProvider(aiProvider);
       saveConfigToFlash();
       Serial.printf("[Runtime] Provider=gemini Model=%s\n", model.c_str());
@@ -475,7 +554,7 @@ void applyRuntimeModelSwitch(const String& provider, const String& model) {
     ai_provider = "openai";
     openai_model = model;
     openaiProvider->setModel(model);
-    aiProvider = openaiProvider;
+    aiProvider = routeLLM(openaiProvider);
     if (visualContextMgr != nullptr) visualContextMgr->setProvider(aiProvider);
     saveConfigToFlash();
     Serial.printf("[Runtime] Provider=openai Model=%s\n", model.c_str());
@@ -619,6 +698,51 @@ void processRuntimeCommand() {
     return;
   }
 
+  if (cmd == "latency") {
+    latencyTracer.printSummary(Serial);  // full histograms at /metrics
+    return;
+  }
+
+  if (cmd == "health") {
+    systemTelemetry.sampleNow();
+    systemTelemetry.printRecord(Serial);  // full sample at /api/health
+    return;
+  }
+
+  if (cmd == "llm") {
+    if (hedgedProvider == nullptr) {
+      Serial.println("[Runtime] LLM hedging is off (llm_hedge)");
+    } else {
+      Serial.println(hedgedProvider->statsJson());
+    }
+    return;
+  }
+
+  if (cmd == "ack") {
+    Serial.println(ackClips.statsJson());
+    return;
+  }
+  if (cmd == "aec") {
+    Serial.println(echoCanceller.statsJson());
+    return;
+  }
+  if (cmd == "asr") {
+    if (asrChat == nullptr) {
+      Serial.println("[Runtime] ByteDance ASR not in use");
+    } else {
+      Serial.println(asrChat->getTxStatsJson());
+    }
+    return;
+  }
+
+  if (cmd.startsWith("health:")) {
+    int seconds = cmd.substring(7).toInt();
+    if (seconds < 0) seconds = 0;
+    systemTelemetry.setSerialInterval((uint32_t)seconds * 1000);
+    Serial.printf("[Runtime] health record every %ds (0 = off)\n", seconds);
+    return;
+  }
+
   if (cmd.startsWith("testtts:")) {
     String text = cmd.substring(8);
     text.trim();
@@ -724,6 +848,7 @@ bool saveConfigToFlash() {
   preferences.putString("elevenlabs_voice_id", elevenlabs_voice_id);
   preferences.putString("elevenlabs_model_id", elevenlabs_model_id);
   preferences.putString("elevenlabs_output_format", elevenlabs_output_format);
+  preferences.putBool("el_streaming", elevenlabs_streaming);
   preferences.putString("ai_provider", ai_provider);
   preferences.putString("backend_api_url", backend_api_url);
   preferences.putString("backend_api_key", backend_api_key);
@@ -744,11 +869,21 @@ bool saveConfigToFlash() {
   preferences.putString("device_id", device_id);
   preferences.putString("memory_mode", memory_mode);
   preferences.putBool("mem_visual", memory_store_visual_events);
+  preferences.putBool("mem_local", memory_local_index);
   preferences.putBool("single_turn_mode", single_turn_mode);
+  preferences.putBool("asr_specul", asr_speculative);
+  preferences.putInt("ack_thresh", ack_threshold_ms);
+  preferences.putBool("barge_in", barge_in_enabled);
+  preferences.putInt("barge_in_ms", barge_in_ms);
+  preferences.putInt("i2s_rate", i2s_rate);
   preferences.putBool("manual_record_control", manual_record_control);
   preferences.putBool("web_enabled", web_control_enabled);
   preferences.putInt("web_port", web_port);
   preferences.putInt("web_ws_port", web_ws_port);
+  preferences.putBool("llm_hedge", llm_hedge);
+  preferences.putULong("llm_deadline", llm_deadline_ms);
+  preferences.putInt("llm_hedge_pct", llm_hedge_pct);
+  preferences.putInt("llm_hist_tok", llm_history_tokens);
   
   if (subscription == "pro") {
     preferences.putString("minimax_key", minimax_apiKey);
@@ -801,6 +936,7 @@ bool loadConfigFromFlash() {
   elevenlabs_voice_id = preferences.getString("elevenlabs_voice_id", "EST9Ui6982FZPSi7gCHi");
   elevenlabs_model_id = preferences.getString("elevenlabs_model_id", "eleven_flash_v2_5");
   elevenlabs_output_format = preferences.getString("elevenlabs_output_format", "mp3_22050_32");
+  elevenlabs_streaming = preferences.getBool("el_streaming", true);
   ai_provider = preferences.getString("ai_provider", "openai");
   backend_api_url = preferences.getString("backend_api_url", "");
   backend_api_key = preferences.getString("backend_api_key", "");
@@ -821,11 +957,21 @@ bool loadConfigFromFlash() {
   device_id = preferences.getString("device_id", "");
   memory_mode = preferences.getString("memory_mode", "local");
   memory_store_visual_events = preferences.getBool("mem_visual", true);
+  memory_local_index = preferences.getBool("mem_local", true);
   single_turn_mode = preferences.getBool("single_turn_mode", true);
+  asr_speculative = preferences.getBool("asr_specul", true);
+  ack_threshold_ms = preferences.getInt("ack_thresh", ACK_THRESHOLD_MS);
+  barge_in_enabled = preferences.getBool("barge_in", false);
+  barge_in_ms = preferences.getInt("barge_in_ms", AEC_BARGE_IN_MS);
+  i2s_rate = preferences.getInt("i2s_rate", 0);
   manual_record_control = preferences.getBool("manual_record_control", true);
   web_control_enabled = preferences.getBool("web_enabled", false);
   web_port = preferences.getInt("web_port", 80);
   web_ws_port = preferences.getInt("web_ws_port", 81);
+  llm_hedge = preferences.getBool("llm_hedge", false);
+  llm_deadline_ms = preferences.getULong("llm_deadline", 15000);
+  llm_hedge_pct = preferences.getInt("llm_hedge_pct", 90);
+  llm_history_tokens = preferences.getInt("llm_hist_tok", 768);
   
   if (subscription == "pro") {
     minimax_apiKey = preferences.getString("minimax_key", "");
@@ -1003,6 +1149,9 @@ bool receiveConfig() {
           if (doc.containsKey("elevenlabs_output_format")) {
             elevenlabs_output_format = doc["elevenlabs_output_format"].as<String>();
           }
+          if (doc.containsKey("elevenlabs_streaming")) {
+            elevenlabs_streaming = doc["elevenlabs_streaming"].as<bool>();
+          }
           if (doc.containsKey("ai_provider")) {
             ai_provider = doc["ai_provider"].as<String>();
           }
@@ -1063,12 +1212,30 @@ bool receiveConfig() {
           if (doc.containsKey("memory_store_visual_events")) {
             memory_store_visual_events = doc["memory_store_visual_events"].as<bool>();
           }
+          if (doc.containsKey("memory_local_index")) {
+            memory_local_index = doc["memory_local_index"].as<bool>();
+          }
           if (doc.containsKey("single_turn_mode")) {
             single_turn_mode = doc["single_turn_mode"].as<bool>();
           }
           if (doc.containsKey("manual_record_control")) {
             manual_record_control = doc["manual_record_control"].as<bool>();
           }
+          if (doc.containsKey("asr_speculative")) {
+            asr_speculative = doc["asr_speculative"].as<bool>();
+          }
+          if (doc.containsKey("ack_threshold_ms")) {
+            ack_threshold_ms = doc["ack_threshold_ms"].as<int>();
+          }
+          if (doc.containsKey("barge_in")) {
+            barge_in_enabled = doc["barge_in"].as<bool>();
+          }
+          if (doc.containsKey("barge_in_ms")) {
+            barge_in_ms = doc["barge_in_ms"].as<int>();
+          }
+          if (doc.containsKey("i2s_rate")) {
+            i2s_rate = doc["i2s_rate"].as<int>();
+          }
           if (doc.containsKey("web_control_enabled")) {
             web_control_enabled = doc["web_control_enabled"].as<bool>();
           }
@@ -1078,6 +1245,18 @@ bool receiveConfig() {
           if (doc.containsKey("web_ws_port")) {
             web_ws_port = doc["web_ws_port"].as<int>();
           }
+          if (doc.containsKey("llm_hedge")) {
+            llm_hedge = doc["llm_hedge"].as<bool>();
+          }
+          if (doc.containsKey("llm_deadline_ms")) {
+            llm_deadline_ms = doc["llm_deadline_ms"].as<unsigned long>();
+          }
+          if (doc.containsKey("llm_hedge_pct")) {
+            llm_hedge_pct = doc["llm_hedge_pct"].as<int>();
+          }
+          if (doc.containsKey("llm_history_tokens")) {
+            llm_history_tokens = doc["llm_history_tokens"].as<int>();
+          }
           
           // Pro version additional configuration
           if (subscription == "pro") {
@@ -1217,6 +1396,7 @@ bool receiveConfig() {
 
 bool initializeSystem() {
   Serial.println("\n----- System Initialization -----");
+  systemTelemetry.watchTask("loop");
   
   // ========== WiFi Connection ==========
   WiFi.mode(WIFI_STA);
@@ -1297,6 +1477,9 @@ bool initializeSystem() {
         stopContinuousMode();
       }
     });
+    if (asr_speculative) {
+      asrChat->setSpeculativeCallback(onSpeculativeTranscript, 4, 400);  // 4 equal partials or a 400ms pause
+    }
 
     if (!asrChat->connectWebSocket()) {
       Serial.println("ASR service connection failed!");
@@ -1363,6 +1546,26 @@ bool initializeSystem() {
     Serial.printf("LLM Provider: OpenAI (%s)\n", openai_model.c_str());
   }
 
+  if (llm_hedge) {
+    if (geminiProvider == nullptr && gemini_apiKey.length() > 0) {
+      geminiProvider = new GeminiProvider(gemini_apiKey.c_str());
+      geminiProvider->setModel(gemini_model);
+      geminiProvider->setSystemPrompt(system_prompt);
+      geminiProvider->enableMemory(true);
+    }
+    hedgedProvider = new HedgedProvider();
+    hedgedProvider->prefer(aiProvider);  // the configured provider first, the others as alternatives
+    hedgedProvider->addProvider(backendProvider);
+    hedgedProvider->addProvider(geminiProvider);
+    hedgedProvider->addProvider(openaiProvider);
+    hedgedProvider->setDeadline(llm_deadline_ms);
+    hedgedProvider->setHedgePercentile((uint8_t)constrain(llm_hedge_pct, 0, 99));
+    hedgedProvider->setSystemPrompt(system_prompt);
+    aiProvider = hedgedProvider;
+    Serial.printf("LLM hedging: deadline %lums, hedge after p%d\n", llm_deadline_ms, llm_hedge_pct);
+  }
+  applyHistoryBudget();
+
   visualContextMgr = new VisualContextManager(aiProvider);
   visualContextMgr->setCaptureCallbacks(captureJpegStub, releaseJpegStub);
   visualContextMgr->setPrompt(vision_prompt);
@@ -1380,6 +1583,7 @@ bool initializeSystem() {
     ttsChat->setSpeed(tts_speed);
     ttsChat->setVolume(tts_volume);
     ttsChat->setAudioParams(tts_sample_rate, tts_bitrate);
+    if (i2s_rate > 0) ttsChat->setOutputSampleRate(i2s_rate);
 
     // Initialize I2S speaker for WebSocket TTS
     Serial.println("Initializing WebSocket TTS speaker...");
@@ -1391,6 +1595,7 @@ bool initializeSystem() {
     // Set callbacks
     ttsChat->setCompletionCallback(onTTSComplete);
     ttsChat->setErrorCallback(onTTSError);
+    systemTelemetry.watchTask("ttsAudio", ttsChat->getAudioTaskHandle());
 
     // Connect to MiniMax WebSocket
     Serial.println("Connecting to MiniMax TTS WebSocket...");
@@ -1406,6 +1611,10 @@ bool initializeSystem() {
     // Free version: Use ElevenLabs by default, fallback to OpenAI-compatible TTS.
     audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);
     audio.setVolume(20);
+    if (i2s_rate > 0 && !audio.setOutputSampleRate(i2s_rate)) {
+      Serial.printf("I2S rate %d Hz not set, I2S follows the source\n", i2s_rate);
+    }
+    systemTelemetry.setAudio(&audio);  // audio task stack, InBuff fill, decode time, TX underruns
     backendTTS.setConfig(
       backend_api_url.c_str(),
       backend_api_key.c_str(),
@@ -1423,11 +1632,26 @@ bool initializeSystem() {
         elevenlabs_model_id.c_str(),
         elevenlabs_output_format.c_str()
       );
-      Serial.printf("TTS Mode: ElevenLabs (voice=%s, model=%s)\n",
-                    elevenlabs_voice_id.c_str(), elevenlabs_model_id.c_str());
+      elevenlabsTTS.setStreaming(elevenlabs_streaming);
+      Serial.printf("TTS Mode: ElevenLabs (voice=%s, model=%s%s)\n",
+                    elevenlabs_voice_id.c_str(), elevenlabs_model_id.c_str(),
+                    elevenlabsTTS.isStreaming() ? ", streaming" : "");
     } else {
       Serial.printf("TTS Mode: OpenAI-compatible (%s, model=%s)\n", tts_apiBaseUrl.c_str(), tts_openai_model.c_str());
     }
+
+    // acknowledgement clips, decoded once at the rate of the replies
+    ackClips.setThreshold(ack_threshold_ms);
+    if (ack_threshold_ms > 0 && SPIFFS.begin(true)) {
+      size_t clips = ackClips.load(SPIFFS, "/ack", replySampleRate());
+      Serial.printf("Ack clips: %u (threshold %dms)\n", (unsigned)clips, ack_threshold_ms);
+    }
+
+    // barge-in: echo canceller between the reply and the mic
+    echoCanceller.setBargeInMs((uint16_t)constrain(barge_in_ms, 50, 2000));
+    if (barge_in_enabled && !echoCanceller.begin()) {
+      barge_in_enabled = false;
+    }
   }
 
   // ========== Remote Memory ==========
@@ -1438,8 +1662,17 @@ bool initializeSystem() {
   bool remoteEnabled = isRemoteMemoryMode(memory_mode) &&
                        memory_api_url.length() > 0 && memory_api_key.length() > 0;
   remoteMemory.setEnabled(remoteEnabled);
+  remoteMemory.setLocalIndex(memory_local_index);
   Serial.printf("Memory mode: %s (Remote API %s)\n", memory_mode.c_str(), remoteEnabled ? "enabled" : "disabled");
 
+  // ========== Turn Worker ==========
+  if (!turnJobs.begin()) {
+    return false;
+  }
+  if (remoteEnabled && memory_local_index) {
+    turnJobs.submit(JOB_MEMORY_SYNC, memorySyncJob, "", false);  // first fill of the local recall index
+  }
+
   // ========== Web Control ==========
   if (web_control_enabled) {
     webControl = new WebControl((uint16_t)web_port, (uint16_t)web_ws_port);
@@ -1478,6 +1711,7 @@ bool initializeSystem() {
         doc["elevenlabs_voice_id"] = elevenlabs_voice_id;
         doc["elevenlabs_model_id"] = elevenlabs_model_id;
         doc["elevenlabs_output_format"] = elevenlabs_output_format;
+        doc["elevenlabs_streaming"] = elevenlabs_streaming;
         doc["gemini_model"] = gemini_model;
         doc["vision_enabled"] = vision_enabled;
         doc["vision_refresh_interval"] = vision_refresh_interval;
@@ -1487,6 +1721,14 @@ bool initializeSystem() {
         doc["vision_max_events_per_hour"] = vision_max_events_per_hour;
         doc["memory_mode"] = memory_mode;
         doc["web_control_enabled"] = web_control_enabled;
+        doc["llm_hedge"] = llm_hedge;
+        doc["asr_speculative"] = asr_speculative;
+        doc["ack_threshold_ms"] = ack_threshold_ms;
+        doc["barge_in"] = barge_in_enabled;
+        doc["barge_in_ms"] = barge_in_ms;
+        doc["llm_deadline_ms"] = llm_deadline_ms;
+        doc["llm_hedge_pct"] = llm_hedge_pct;
+        doc["llm_history_tokens"] = llm_history_tokens;
         String out;
         serializeJson(doc, out);
         return out;
@@ -1513,7 +1755,36 @@ bool initializeSystem() {
         if (doc.containsKey("elevenlabs_voice_id")) elevenlabs_voice_id = doc["elevenlabs_voice_id"].as<String>();
         if (doc.containsKey("elevenlabs_model_id")) elevenlabs_model_id = doc["elevenlabs_model_id"].as<String>();
         if (doc.containsKey("elevenlabs_output_format")) elevenlabs_output_format = doc["elevenlabs_output_format"].as<String>();
+        if (doc.containsKey("elevenlabs_streaming")) {
+          elevenlabs_streaming = doc["elevenlabs_streaming"].as<bool>();
+          elevenlabsTTS.setStreaming(elevenlabs_streaming);  // takes effect with the next reply
+        }
         if (doc.containsKey("gemini_model")) gemini_model = doc["gemini_model"].as<String>();
+        if (doc.containsKey("asr_speculative")) {
+          asr_speculative = doc["asr_speculative"].as<bool>();
+          if (asrChat != nullptr) asrChat->setSpeculativeCallback(asr_speculative ? onSpeculativeTranscript : nullptr, 4, 400);
+        }
+        if (doc.containsKey("ack_threshold_ms")) {
+          ack_threshold_ms = doc["ack_threshold_ms"].as<int>();
+          ackClips.setThreshold(ack_threshold_ms);
+        }
+        if (doc.containsKey("barge_in")) {
+          barge_in_enabled = doc["barge_in"].as<bool>() && subscription != "pro" && echoCanceller.begin();
+        }
+        if (doc.containsKey("barge_in_ms")) {
+          barge_in_ms = doc["barge_in_ms"].as<int>();
+          echoCanceller.setBargeInMs((uint16_t)constrain(barge_in_ms, 50, 2000));
+        }
+        if (doc.containsKey("llm_deadline_ms")) llm_deadline_ms = doc["llm_deadline_ms"].as<unsigned long>();
+        if (doc.containsKey("llm_hedge_pct")) llm_hedge_pct = doc["llm_hedge_pct"].as<int>();
+        if (hedgedProvider != nullptr) {
+          hedgedProvider->setDeadline(llm_deadline_ms);
+          hedgedProvider->setHedgePercentile((uint8_t)constrain(llm_hedge_pct, 0, 99));
+        }
+        if (doc.containsKey("llm_history_tokens")) {
+          llm_history_tokens = doc["llm_history_tokens"].as<int>();
+          applyHistoryBudget();
+        }
         saveConfigToFlash();
         return true;
       }
@@ -1536,10 +1807,11 @@ bool initializeSystem() {
       return true;
     });
     webControl->setModelHandler([](const String& provider, const String& model) -> bool {
+      if (turnJobs.busy()) return false;  // the worker is using aiProvider
       if (provider == "backend") {
         if (backendProvider == nullptr) return false;
         ai_provider = "backend";
-        aiProvider = backendProvider;
+        aiProvider = routeLLM(backendProvider);
         if (model.length() > 0) {
           gemini_model = model;
           backendProvider->setModel(model);
@@ -1547,7 +1819,7 @@ bool initializeSystem() {
       } else if (provider == "gemini") {
         if (geminiProvider == nullptr) return false;
         ai_provider = "gemini";
-        aiProvider = geminiProvider;
+        aiProvider = routeLLM(geminiProvider);
         if (model.length() > 0) {
           gemini_model = model;
           geminiProvider->setModel(model);
@@ -1555,7 +1827,7 @@ bool initializeSystem() {
       } else {
         if (openaiProvider == nullptr) return false;
         ai_provider = "openai";
-        aiProvider = openaiProvider;
+        aiProvider = routeLLM(openaiProvider);
         if (model.length() > 0) {
           openai_model = model;
           openaiProvider->setModel(model);
@@ -1572,6 +1844,8 @@ bool initializeSystem() {
         DynamicJsonDocument doc(512);
         doc["mode"] = memory_mode;
         doc["remote_memory_enabled"] = remoteMemory.isEnabled();
+        doc["local_index_items"] = remoteMemory.indexSize();
+        doc["local_index_complete"] = remoteMemory.indexComplete();
         String out;
         serializeJson(doc, out);
         return out;
@@ -1579,6 +1853,7 @@ bool initializeSystem() {
       []() -> bool {
         if (openaiProvider != nullptr) openaiProvider->clearMemory();
         if (geminiProvider != nullptr) geminiProvider->clearMemory();
+        if (hedgedProvider != nullptr) hedgedProvider->clearMemory();  // else its history is replayed
         return true;
       }
     );
@@ -1610,6 +1885,19 @@ void onTTSError(const char* error) {
   ttsCompleted = true;
 }
 
+// Audio library: the reply is audible now, closes the TTS span of the current turn
+void audio_first_samples() {
+  latencyTracer.end(LAT_TTS);
+}
+
+// Audio library, audio task: every buffer on its way to I2S is the far end of the echo canceller
+void audio_process_i2s(int16_t* outBuff, uint16_t validSamples, uint8_t bitsPerSample, uint8_t channels, bool* continueI2S) {
+  *continueI2S = true;
+  if (barge_in_enabled && bitsPerSample == 16) {
+    echoCanceller.pushReference(outBuff, validSamples, channels, audio.getSampleRate());
+  }
+}
+
 // ============================================================================
 // Continuous Conversation Mode Control Functions
 // ============================================================================
@@ -1640,7 +1928,7 @@ void startContinuousMode() {
     currentState = STATE_IDLE;
   }
 
-  if (vision_enabled && vision_on_conversation_start && visualContextMgr != nullptr) {
+  if (vision_enabled && vision_on_conversation_start && visualContextMgr != nullptr && !turnJobs.busy()) {
     String ctx = visualContextMgr->captureAndDescribe(vision_prompt);
     applyVisualContext(ctx, "conversation_start");
   }
@@ -1656,6 +1944,17 @@ void stopContinuousMode() {
   if (asrIsRecording()) {
     asrStopRecording();
   }
+  turnJobs.cancelAll();  // a reply or TTS download still in flight is discarded
+  speculation.jobId = 0;
+  if (currentState == STATE_PLAYING_TTS || currentState == STATE_WAIT_TTS_COMPLETE) {  // stop pressed mid-reply
+    if (subscription == "pro" && ttsChat != nullptr) {
+      if (ttsChat->isPlaying()) ttsChat->stop();
+    } else if (audio.isRunning()) {
+      audio.stopSong();
+    }
+  }
+  ackClips.stop(audio);
+  latencyTracer.cancelTurn();
   
   currentState = STATE_IDLE;
   Serial.println("\nPress BOOT button to start conversation");
@@ -1665,6 +1964,110 @@ void stopContinuousMode() {
 // ASR Result Processing Function
 // ============================================================================
 
+// After a failed or empty turn: listen again, end single-turn mode or go idle
+void resumeAfterTurn() {
+  ackClips.stop(audio);  // the turn failed before the reply, nothing to fade into
+  if (continuousMode && !single_turn_mode) {
+    delay(500);
+    currentState = STATE_LISTENING;
+    if (asrStartRecording()) {
+      Serial.println("\n[ASR] Listening... Please speak");
+    } else {
+      stopContinuousMode();
+    }
+  } else if (continuousMode && single_turn_mode) {
+    stopContinuousMode();
+  } else {
+    currentState = STATE_IDLE;
+  }
+}
+
+// Sample rate of the free version replies, the ack clips are prepared at it
+uint32_t replySampleRate() {
+  if (audio.getOutputSampleRate() > 0) return audio.getOutputSampleRate();
+  if (use_backend_tts || use_elevenlabs_tts) {  // "mp3_22050_32"
+    int a = elevenlabs_output_format.indexOf('_');
+    int b = elevenlabs_output_format.indexOf('_', a + 1);
+    long hz = a >= 0 ? elevenlabs_output_format.substring(a + 1, b >= 0 ? b : elevenlabs_output_format.length()).toInt() : 0;
+    if (hz >= 8000) return (uint32_t)hz;
+  }
+  return 24000;  // OpenAI TTS
+}
+
+// Acknowledgement clip for the wait until the reply is audible, predicted from the last turns: end of speech
+// to first audio, or only the TTS part if the reply is already there. Nothing before 3 turns are measured.
+void startAck(bool replyReady) {
+  if (subscription == "pro" || ack_threshold_ms <= 0 || ackClips.count() == 0) return;
+  uint32_t predicted = latencyTracer.percentileMs(replyReady ? LAT_TTS : LAT_RESPONSE, 75, 3);
+  if (predicted > 0) ackClips.play(audio, predicted);
+}
+
+// ============================================================================
+// Barge-in (free version)
+// ============================================================================
+
+bool bargeInMonitoring = false;
+int16_t bargeInFrame[AEC_FRAME];
+size_t bargeInFill = 0;
+
+// Stops the reply and listens; the residual of the last 300ms goes to the ByteDance ASR, so the
+// first words are not lost
+void bargeIn() {
+  Serial.printf("[Barge-in] speech over the reply (echo delay %dms, ERLE %.1fdB)\n",
+                echoCanceller.delayMs(), echoCanceller.erleDb());
+  bargeInMonitoring = false;
+  turnJobs.cancelAll();  // the rest of a streamed reply is discarded
+  speculation.jobId = 0;
+  audio.stopSong();
+  ackClips.stop(audio);
+  latencyTracer.endTurn(true);
+
+  currentState = STATE_LISTENING;
+  if (!asrStartRecording()) {
+    Serial.println("[Error] ASR restart failed");
+    stopContinuousMode();
+    return;
+  }
+  Serial.println("\n[ASR] Listening... Please speak");
+  if (!isGeminiASR() && !isBackendASR() && asrChat != nullptr) {
+    int16_t* preroll = (int16_t*)malloc(AEC_PREROLL * sizeof(int16_t));
+    if (preroll != nullptr) {
+      asrChat->feedAudioData(preroll, echoCanceller.preroll(preroll, AEC_PREROLL));
+      free(preroll);
+    }
+  }
+}
+
+// Mic through the echo canceller while the reply plays, every loop
+void monitorBargeIn() {
+  bool playing = (currentState == STATE_PLAYING_TTS || currentState == STATE_WAIT_TTS_COMPLETE) && audio.isRunning();
+  if (!barge_in_enabled || subscription == "pro" || !continuousMode || !playing) {
+    bargeInMonitoring = false;
+    return;
+  }
+  if (!bargeInMonitoring) {
+    // a new reply: the echo path starts over, and what the mic DMA kept since the last turn is old
+    bargeInMonitoring = true;
+    bargeInFill = 0;
+    echoCanceller.reset();
+    int16_t stale[256];
+    while (asrReadMicrophone(stale, 256) > 0) {
+    }
+  }
+  for (;;) {
+    size_t n = asrReadMicrophone(bargeInFrame + bargeInFill, AEC_FRAME - bargeInFill);
+    if (n == 0) return;
+    bargeInFill += n;
+    if (bargeInFill < AEC_FRAME) continue;
+    bargeInFill = 0;
+    echoCanceller.process(bargeInFrame);
+    if (echoCanceller.speechDetected()) {
+      bargeIn();
+      return;
+    }
+  }
+}
+
 void handleASRResult() {
   if (aiProvider == nullptr) {
     Serial.println("[Error] AI provider not initialized");
@@ -1673,7 +2076,7 @@ void handleASRResult() {
   }
 
   String transcribedText = asrGetRecognizedText();
-  String userInputRaw = transcribedText;
+  turnUserText = transcribedText;
   asrClearResult();
   
   if (transcribedText.length() > 0) {
@@ -1682,119 +2085,257 @@ void handleASRResult() {
     Serial.printf("%s\n", transcribedText.c_str());
     Serial.println("==============================");
     
-    // ========== Build contextual prompt ==========
+    // ========== Vision, recall and LLM on the worker ==========
     currentState = STATE_PROCESSING_LLM;
+    if (speculation.jobId != 0) {
+      if (sameUtterance(speculation.text, transcribedText)) {
+        Serial.println("\n[LLM] Final transcript matches, using the speculative request");
+        speculation.adopted = true;
+        startAck(speculation.done);
+        if (speculation.done) adoptSpeculation();
+        return;
+      }
+      Serial.println("\n[LLM] Final transcript differs, speculative request dropped");
+      dropSpeculation();
+    }
     Serial.println("\n[LLM] Sending request...");
-
-    if (vision_enabled && vision_capture_on_user_turn && visualContextMgr != nullptr) {
-      String ctx = visualContextMgr->captureAndDescribe(vision_prompt);
-      applyVisualContext(ctx, "user_turn");
+    startAck(false);
+    if (turnJobs.submit(JOB_THINK, thinkJob, transcribedText) == 0) {
+      Serial.println("[Error] Failed to get LLM response");
+      latencyTracer.endTurn(false);
+      resumeAfterTurn();
     }
+  } else {
+    Serial.println("[Warning] No text recognized");
+    dropSpeculation();
+    latencyTracer.endTurn(false);
+    resumeAfterTurn();
+  }
+}
 
-    String resolvedPrompt = system_prompt;
-    if (vision_enabled && lastVisualContext.length() > 0) {
-      resolvedPrompt = buildContextAwarePrompt(system_prompt, lastVisualContext);
-    }
-    aiProvider->setSystemPrompt(resolvedPrompt);
+// ============================================================================
+// Turn Jobs
+// ============================================================================
+// Everything that blocks on the network runs on the TurnJobs worker, the loop submits a job and
+// picks up its completion in dispatchTurnJobs(). Only one turn is in flight: the state machine
+// does not submit a new THINK before the previous turn is done or cancelled.
 
-    String recallText = "";
-    if (isRemoteMemoryMode(memory_mode)) {
-      recallText = remoteMemory.recall(transcribedText);
-      if (recallText.length() > 0) {
-        transcribedText += "\n\n[Relevant memory]\n" + recallText;
-      }
+// vision capture, prompt and memory recall; false if the job was cancelled meanwhile
+bool prepareLLMRequest(AsyncJob& job, String& text) {
+  text = job.input;
+
+  if (vision_enabled && vision_capture_on_user_turn && visualContextMgr != nullptr) {
+    latencyTracer.begin(LAT_VISION);
+    String ctx = visualContextMgr->captureAndDescribe(vision_prompt);
+    applyVisualContext(ctx, "user_turn");
+    latencyTracer.end(LAT_VISION);
+  }
+  if (job.cancelled()) return false;
+
+  String resolvedPrompt = system_prompt;
+  if (vision_enabled && lastVisualContext.length() > 0) {
+    resolvedPrompt = buildContextAwarePrompt(system_prompt, lastVisualContext);
+  }
+  aiProvider->setSystemPrompt(resolvedPrompt);
+
+  if (isRemoteMemoryMode(memory_mode)) {
+    latencyTracer.begin(LAT_RECALL);
+    String recallText = remoteMemory.recall(text);
+    latencyTracer.end(LAT_RECALL);
+    if (recallText.length() > 0) {
+      text += "\n\n[Relevant memory]\n" + recallText;
     }
+  }
+  return !job.cancelled();
+}
 
-    String response = aiProvider->sendMessage(transcribedText);
-    
-    if (response != "" && response.length() > 0) {
-      // ========== Display LLM Response ==========
-      Serial.println("\n=== LLM Response ===");
-      Serial.printf("%s\n", response.c_str());
-      Serial.println("========================");
-      
-      // ========== Convert to Speech and Play ==========
-      currentState = STATE_PLAYING_TTS;
-      bool success = false;
-
-      if (subscription == "pro") {
-        // Pro: Use MiniMax WebSocket TTS
-        Serial.println("\n[MiniMax TTS] Converting to speech (WebSocket)...");
-        ttsCompleted = false;  // Reset completion flag
-        success = ttsChat->speak(response.c_str());
-      } else {
-        // Free: Prefer backend proxy for stability, fallback to direct providers.
-        if (use_backend_tts && backendTTS.isConfigured()) {
-          Serial.println("\n[Backend TTS] Converting to speech...");
-          success = backendTTS.speak(response);
-        } else if (use_elevenlabs_tts) {
-          Serial.println("\n[ElevenLabs TTS] Converting to speech...");
-          success = elevenlabsTTS.speak(response);
-        } else {
-          Serial.println("\n[OpenAI TTS] Converting to speech...");
-          if (ttsProvider != nullptr) {
-            success = ttsProvider->client().textToSpeech(response);
-          }
-        }
-      }
-      
-      if (success) {
-        currentState = STATE_WAIT_TTS_COMPLETE;
-        ttsStartTime = millis();
-        ttsCheckTime = millis();
-      } else {
-        Serial.println("[Error] TTS playback failed");
+// vision capture, prompt, memory recall and LLM request; input: transcription, output: reply
+void thinkJob(AsyncJob& job) {
+  String text;
+  if (!prepareLLMRequest(job, text)) return;
+  latencyTracer.begin(LAT_LLM);
+  job.output = aiProvider->requestReply(text);
+  latencyTracer.end(LAT_LLM);
+  job.ok = job.output.length() > 0;
+  if (job.ok && !job.cancelled()) {  // a turn stopped while the request was on the wire is not recorded
+    aiProvider->appendExchange(text, job.output);
+  }
+}
 
-        if (continuousMode && !single_turn_mode) {
-          delay(500);
-          currentState = STATE_LISTENING;
-          if (asrStartRecording()) {
-            Serial.println("\n[ASR] Listening... Please speak");
-          } else {
-            stopContinuousMode();
-          }
-        } else if (continuousMode && single_turn_mode) {
-          stopContinuousMode();
-        } else {
-          currentState = STATE_IDLE;
-        }
-      }
+// the same for a partial transcript; the exchange is added to the conversation by adoptSpeculation()
+void speculateJob(AsyncJob& job) {
+  String text;
+  if (!prepareLLMRequest(job, text)) return;
+  latencyTracer.begin(LAT_LLM);
+  job.output = aiProvider->requestReply(text);
+  latencyTracer.end(LAT_LLM);
+  job.ok = job.output.length() > 0;
+}
 
-      if (isRemoteMemoryMode(memory_mode)) {
-        remoteMemory.storeConversation(userInputRaw, response, aiProvider->getProviderName(), lastVisualContext);
-      }
-    } else {
-      Serial.println("[Error] Failed to get LLM response");
+// free version TTS: synthesize and hand over to the Audio library (ElevenLabs streams while it plays); input: reply
+// Stop or a barge-in may cancel the job during the download, when there is no playback to stop yet: the
+// providers check the job before they start playback, and playback that started anyway is stopped here.
+void speakJob(AsyncJob& job) {
+  // Prefer backend proxy for stability, fallback to direct providers.
+  if (use_backend_tts && backendTTS.isConfigured()) {
+    Serial.println("\n[Backend TTS] Converting to speech...");
+    job.ok = backendTTS.speak(job.input, AsyncJob::isCancelled, &job);
+  } else if (use_elevenlabs_tts) {
+    Serial.println("\n[ElevenLabs TTS] Converting to speech...");
+    job.ok = elevenlabsTTS.speak(job.input, AsyncJob::isCancelled, &job);
+  } else {
+    Serial.println("\n[OpenAI TTS] Converting to speech...");
+    job.ok = ttsProvider != nullptr && ttsProvider->client().textToSpeech(job.input, AsyncJob::isCancelled, &job);
+  }
+  if (job.ok && job.cancelled()) {
+    audio.stopSong();
+    job.ok = false;
+  }
+}
 
-      if (continuousMode && !single_turn_mode) {
-        delay(500);
-        currentState = STATE_LISTENING;
-        if (asrStartRecording()) {
-          Serial.println("\n[ASR] Listening... Please speak");
-        } else {
-          stopContinuousMode();
-        }
-      } else if (continuousMode && single_turn_mode) {
-        stopContinuousMode();
-      } else {
-        currentState = STATE_IDLE;
-      }
-    }
+// remote memory store, not cancellable; input: user text, reply, provider and visual context, \x1F separated
+void storeJob(AsyncJob& job) {
+  String f[4];
+  int from = 0;
+  for (int i = 0; i < 4; i++) {
+    int sep = i < 3 ? job.input.indexOf('\x1F', from) : -1;
+    f[i] = sep >= 0 ? job.input.substring(from, sep) : job.input.substring(from);
+    from = sep + 1;
+    if (sep < 0) break;
+  }
+  job.ok = remoteMemory.storeConversation(f[0], f[1], f[2], f[3]);
+  if (job.ok && memory_local_index) {
+    remoteMemory.syncIndex();  // picks up this exchange and visual events stored since, with their embeddings
+  }
+}
+
+// local recall index sync, not cancellable
+void memorySyncJob(AsyncJob& job) {
+  job.ok = remoteMemory.syncIndex();
+}
+
+// conversation summary, dropped by cancelAll() and retried after the next reply
+void summarizeJob(AsyncJob& job) {
+  job.ok = aiProvider->summarizeHistory();
+  Serial.printf("[LLM] History summary %s\n", job.ok ? "updated" : "failed");
+}
+
+void onSpeechStarted(bool success) {
+  if (success) {
+    currentState = STATE_WAIT_TTS_COMPLETE;
+    ttsStartTime = millis();
+    ttsCheckTime = millis();
   } else {
-    Serial.println("[Warning] No text recognized");
+    Serial.println("[Error] TTS playback failed");
+    latencyTracer.endTurn(false);
+    resumeAfterTurn();
+  }
+}
 
-    if (continuousMode && !single_turn_mode) {
-      delay(500);
-      currentState = STATE_LISTENING;
-      if (asrStartRecording()) {
-        Serial.println("\n[ASR] Listening... Please speak");
-      } else {
-        stopContinuousMode();
-      }
-    } else if (continuousMode && single_turn_mode) {
-      stopContinuousMode();
-    } else {
-      currentState = STATE_IDLE;
+void onReplyReady(const AsyncJob& job) {
+  if (!job.ok) {
+    Serial.println("[Error] Failed to get LLM response");
+    latencyTracer.endTurn(false);
+    resumeAfterTurn();
+    return;
+  }
+
+  const String& response = job.output;
+  // ========== Display LLM Response ==========
+  Serial.println("\n=== LLM Response ===");
+  Serial.printf("%s\n", response.c_str());
+  Serial.println("========================");
+
+  // ========== Convert to Speech and Play ==========
+  currentState = STATE_PLAYING_TTS;
+  if (subscription == "pro") {
+    // Pro: MiniMax WebSocket TTS, only sends the text, its socket is serviced by this loop
+    Serial.println("\n[MiniMax TTS] Converting to speech (WebSocket)...");
+    ttsCompleted = false;  // Reset completion flag
+    onSpeechStarted(ttsChat->speak(response.c_str()));
+  } else if (turnJobs.submit(JOB_SPEAK, speakJob, response) == 0) {
+    onSpeechStarted(false);
+  }
+
+  if (isRemoteMemoryMode(memory_mode)) {  // queued behind the TTS download
+    String packed = turnUserText + '\x1F' + response + '\x1F' + aiProvider->getProviderName() + '\x1F' + lastVisualContext;
+    turnJobs.submit(JOB_STORE, storeJob, packed, false);
+  }
+  if (aiProvider->historyNeedsSummary()) {  // also behind the TTS download, runs while the reply plays
+    turnJobs.submit(JOB_SUMMARIZE, summarizeJob);
+  }
+}
+
+// ========== Speculative LLM request ==========
+
+// Letters and digits only, lower case: the final transcript often just adds punctuation or case
+bool sameUtterance(const String& a, const String& b) {
+  size_t i = 0;
+  size_t j = 0;
+  for (;;) {
+    while (i < a.length() && !isalnum((unsigned char)a[i])) i++;
+    while (j < b.length() && !isalnum((unsigned char)b[j])) j++;
+    if (i == a.length() || j == b.length()) return i == a.length() && j == b.length();
+    if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[j])) return false;
+    i++;
+    j++;
+  }
+}
+
+// ASR callback (loop task) while listening
+void onSpeculativeTranscript(const String& partial) {
+  if (currentState != STATE_LISTENING || aiProvider == nullptr) return;
+  if (speculation.jobId != 0 && !speculation.done) return;  // one at a time, the worker runs jobs in order
+  uint32_t id = turnJobs.submit(JOB_SPECULATE, speculateJob, partial);
+  if (id == 0) return;
+  speculation = {id, partial, false, false, "", false};
+}
+
+// The final transcript differs: skip the LLM call if the job is still in vision or recall. A request
+// already on the wire runs to its end on the worker (the reissued one queues behind it), its reply is dropped.
+void dropSpeculation() {
+  if (speculation.jobId == 0) return;
+  // besides the speculation only stores (not cancellable) and a summary can be queued while listening; a dropped
+  // summary is submitted again after the next reply
+  if (!speculation.done) turnJobs.cancelAll();
+  speculation.jobId = 0;
+}
+
+void adoptSpeculation() {
+  AsyncJob job;
+  job.kind = JOB_THINK;
+  job.ok = speculation.ok;
+  job.output = speculation.reply;
+  speculation.jobId = 0;
+  if (!job.ok) {  // failed on the partial, one regular try
+    Serial.println("\n[LLM] Speculative request failed, sending request...");
+    if (turnJobs.submit(JOB_THINK, thinkJob, turnUserText) != 0) return;
+  } else {
+    aiProvider->appendExchange(turnUserText, job.output);
+  }
+  onReplyReady(job);
+}
+
+// Completions of the turn jobs, called from loop(). Results of cancelled jobs never show up here.
+void dispatchTurnJobs() {
+  AsyncJob job;
+  while (turnJobs.poll(job)) {
+    switch (job.kind) {
+      case JOB_THINK:
+        if (currentState == STATE_PROCESSING_LLM) onReplyReady(job);
+        break;
+      case JOB_SPECULATE:
+        if (job.id != speculation.jobId) break;  // superseded or dropped
+        speculation.done = true;
+        speculation.ok = job.ok;
+        speculation.reply = job.output;
+        if (speculation.adopted && currentState == STATE_PROCESSING_LLM) adoptSpeculation();
+        break;
+      case JOB_SPEAK:
+        if (currentState == STATE_PLAYING_TTS) onSpeechStarted(job.ok);
+        break;
+      default:
+        break;
     }
   }
 }
@@ -1842,6 +2383,40 @@ void setup() {
 // Main Loop Function
 // ============================================================================
 
+// State changes and playback levels for the web dashboard. The bus coalesces and rate limits them,
+// the levels go out as CBOR {"type":"vu","l":0..127,"r":0..127}.
+void publishWebEvents() {
+  static int lastState = -1;
+  static bool lastContinuous = false;
+  if ((int)currentState != lastState || continuousMode != lastContinuous) {
+    lastState = (int)currentState;
+    lastContinuous = continuousMode;
+    String ev = "{\"type\":\"state\",\"state\":" + String(lastState) +
+                ",\"continuous_mode\":" + (continuousMode ? "true" : "false") + "}";
+    webControl->publish(WEB_EVENT_STATE, ev);
+  }
+
+  static unsigned long lastVuMs = 0;
+  static uint16_t lastVu = 0;
+  if (subscription != "pro" && millis() - lastVuMs >= 50) {
+    lastVuMs = millis();
+    uint16_t vu = audio.getVUlevel();
+    if (vu != lastVu) {
+      lastVu = vu;
+      uint8_t buf[24];
+      CborWriter cbor(buf, sizeof(buf));
+      cbor.writeMap(3);
+      cbor.writeText("type");
+      cbor.writeText("vu");
+      cbor.writeText("l");
+      cbor.writeUInt(vu >> 8);
+      cbor.writeText("r");
+      cbor.writeUInt(vu & 0xFF);
+      webControl->publishBinary(WEB_EVENT_VU, cbor.data(), cbor.length());
+    }
+  }
+}
+
 void loop() {
   // ========== Waiting for Config State ==========
   if (currentState == STATE_WAITING_CONFIG) {
@@ -1881,6 +2456,7 @@ void loop() {
   // Runtime command parsing is enabled only after system init.
   // This avoids consuming JSON provisioning input during WAITING_CONFIG.
   processRuntimeCommand();
+  systemTelemetry.loop();
   
   // ========== Process TTS/Audio Loop ==========
   if (subscription == "pro" && ttsChat != nullptr) {
@@ -1893,12 +2469,16 @@ void loop() {
 
   // ========== Process ASR Loop ==========
   asrLoop();
+  dispatchTurnJobs();
+  monitorBargeIn();
 
   if (webControl != nullptr) {
     webControl->loop();
+    publishWebEvents();
   }
 
-  if (vision_enabled && continuousMode && visualContextMgr != nullptr && currentState != STATE_PROCESSING_LLM) {
+  if (vision_enabled && continuousMode && visualContextMgr != nullptr && currentState != STATE_PROCESSING_LLM &&
+      !turnJobs.busy()) {  // the worker may still use the camera after a cancel
     if (millis() - lastVisionRefresh >= vision_refresh_interval) {
       String ctx = visualContextMgr->captureAndDescribe(vision_prompt);
       applyVisualContext(ctx, "periodic");
@@ -1953,6 +2533,7 @@ void loop() {
 
         if (playbackComplete) {
           Serial.println("[TTS] Playback completed");
+          latencyTracer.endTurn(true);
 
           if (continuousMode && !single_turn_mode) {
             delay(500);
@@ -1973,6 +2554,7 @@ void loop() {
           // Check timeout
           if (millis() - ttsStartTime > 60000) {
             Serial.println("[Warning] TTS timeout, forcing restart");
+            latencyTracer.endTurn(false);
 
             if (subscription == "pro" && ttsChat != nullptr) {
               ttsChat->stop();  // Stop WebSocket TTS
@@ -14,6 +14,20 @@ class AIProvider {
     virtual void setModel(const String& model) = 0;
     virtual String getModel() const = 0;
     virtual String getProviderName() const = 0;
+
+    // Used by HedgedProvider, which owns the conversation and races several providers.
+    // requestReply() sends with the current memory but does not record the exchange, appendExchange()
+    // records an exchange that may have been answered by another provider.
+    virtual String requestReply(const String& message) { return sendMessage(message); }
+    virtual void appendExchange(const String& userMessage, const String& reply) {}
+    virtual void setRequestTimeout(uint32_t ms) {}  // connect and read timeout per request, 0: HTTPClient default
+
+    // Memory is budgeted in approximate tokens (see ConversationHistory), exchanges that fall out of the
+    // budget are folded into a rolling summary. summarizeHistory() is that LLM request and blocks, run it
+    // off the turn path when historyNeedsSummary().
+    virtual void setHistoryBudget(size_t tokens) {}
+    virtual bool historyNeedsSummary() const { return false; }
+    virtual bool summarizeHistory() { return false; }
 };
 
 #endif
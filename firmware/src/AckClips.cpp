@@ -0,0 +1,191 @@
+#include "AckClips.h"
+#include <ArduinoJson.h>
+#include "resampler/resampler.h"
+
+AckClips::AckClips()
+  : _count(0),
+    _rate(0),
+    _threshold(ACK_THRESHOLD_MS),
+    _last(-1),
+    _played(0),
+    _skipped(0),
+    _lastPredictedMs(0) {}
+
+AckClips::~AckClips() {
+  _free();
+}
+
+void AckClips::_free() {
+  for (uint8_t i = 0; i < _count; i++) {
+    free(_clips[i].pcm);
+    _clips[i] = Clip();
+  }
+  _count = 0;
+  _last = -1;
+}
+
+size_t AckClips::load(fs::FS& fs, const char* dir, uint32_t sampleRate) {
+  _free();
+  _rate = sampleRate;
+  File root = fs.open(dir);
+  if (!root || !root.isDirectory()) {
+    Serial.printf("[Ack] no clip directory %s\n", dir);
+    return 0;
+  }
+  for (File f = root.openNextFile(); f && _count < ACK_MAX_CLIPS; f = root.openNextFile()) {
+    String name = f.name();
+    if (f.isDirectory() || !name.endsWith(".wav")) continue;
+    Clip clip = {name, nullptr, 0, 0};
+    if (!_decodeWav(f, clip)) {
+      Serial.printf("[Ack] %s skipped, 16 bit PCM wav expected\n", name.c_str());
+      continue;
+    }
+    int pos = _count++;
+    while (pos > 0 && _clips[pos - 1].ms > clip.ms) {
+      _clips[pos] = _clips[pos - 1];
+      pos--;
+    }
+    _clips[pos] = clip;
+    Serial.printf("[Ack] %s: %lums\n", name.c_str(), (unsigned long)clip.ms);
+  }
+  return _count;
+}
+
+static uint32_t readLE(File& f, uint8_t bytes) {
+  uint8_t b[4] = {0};
+  if (f.read(b, bytes) != bytes) return 0;
+  return b[0] | (b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+bool AckClips::_decodeWav(File& file, Clip& clip) {
+  char id[4];
+  if (file.read((uint8_t*)id, 4) != 4 || memcmp(id, "RIFF", 4) != 0) return false;
+  readLE(file, 4);
+  if (file.read((uint8_t*)id, 4) != 4 || memcmp(id, "WAVE", 4) != 0) return false;
+
+  uint16_t channels = 0;
+  uint32_t inRate = 0;
+  uint32_t dataBytes = 0;
+  for (;;) {
+    if (file.read((uint8_t*)id, 4) != 4) return false;
+    uint32_t size = readLE(file, 4);
+    if (memcmp(id, "fmt ", 4) == 0) {
+      if (size < 16) return false;
+      uint16_t format = readLE(file, 2);
+      channels = readLE(file, 2);
+      inRate = readLE(file, 4);
+      readLE(file, 4);                     // byte rate
+      readLE(file, 2);                     // block align
+      uint16_t bits = readLE(file, 2);
+      if (format != 1 || bits != 16 || channels < 1 || channels > 2 || inRate < 8000) return false;
+      if (!file.seek(file.position() + size - 16 + (size & 1))) return false;
+    } else if (memcmp(id, "data", 4) == 0) {
+      dataBytes = size;
+      break;
+    } else if (!file.seek(file.position() + size + (size & 1))) {
+      return false;
+    }
+  }
+  if (channels == 0) return false;           // data before fmt
+
+  uint32_t inFrames = min(dataBytes / (2 * channels), (uint32_t)((uint64_t)inRate * ACK_CLIP_MAX_MS / 1000));
+  uint32_t maxFrames = (uint64_t)inFrames * _rate / inRate + 2;
+  size_t bytes = maxFrames * sizeof(int16_t);
+  clip.pcm = (int16_t*)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+  if (clip.pcm == nullptr) return false;
+
+  Resampler src;
+  if (!src.init(inRate, _rate, 1, SRC_QUALITY_MEDIUM)) {
+    free(clip.pcm);
+    clip.pcm = nullptr;
+    return false;
+  }
+  int16_t in[256 * 2];
+  uint32_t done = 0;
+  while (done < inFrames && clip.frames < maxFrames) {
+    uint16_t n = min((uint32_t)256, inFrames - done);
+    if (file.read((uint8_t*)in, n * 2 * channels) != (size_t)(n * 2 * channels)) break;
+    if (channels == 2) {
+      for (uint16_t i = 0; i < n; i++) in[i] = ((int32_t)in[2 * i] + in[2 * i + 1]) / 2;
+    }
+    uint16_t used = 0;
+    while (used < n && clip.frames < maxFrames) {
+      uint16_t consumed = 0;
+      uint16_t room = min((uint32_t)UINT16_MAX, maxFrames - clip.frames);
+      clip.frames += src.process(in + used, n - used, clip.pcm + clip.frames, room, &consumed);
+      used += consumed;
+      if (consumed == 0) break;
+    }
+    done += n;
+  }
+  if (clip.frames == 0) {
+    free(clip.pcm);
+    clip.pcm = nullptr;
+    return false;
+  }
+  clip.ms = (uint64_t)clip.frames * 1000 / _rate;
+  return true;
+}
+
+void AckClips::setThreshold(uint32_t ms) {
+  _threshold = ms;
+}
+
+uint32_t AckClips::threshold() const {
+  return _threshold;
+}
+
+size_t AckClips::count() const {
+  return _count;
+}
+
+bool AckClips::play(Audio& audio, uint32_t predictedMs) {
+  _lastPredictedMs = predictedMs;
+  if (_count == 0 || predictedMs < _threshold) {
+    _skipped++;
+    return false;
+  }
+
+  // the longest clips that take at most half of the wait, the shortest one if the wait is shorter
+  int fit = -1;
+  for (int i = 0; i < _count; i++) {
+    if (_clips[i].ms * 2 <= predictedMs) fit = i;
+  }
+  if (fit < 0) {
+    if (_clips[0].ms > predictedMs) {
+      _skipped++;
+      return false;
+    }
+    fit = 0;
+  }
+  int first = fit;
+  while (first > 0 && _clips[first - 1].ms * 10 >= _clips[fit].ms * 7) first--;  // within 30%: same kind
+  int choices = fit - first + 1;
+  int pick = first + (int)(esp_random() % choices);
+  if (pick == _last && choices > 1) pick = first + (pick - first + 1) % choices;
+
+  if (!audio.playOverlay(_clips[pick].pcm, _clips[pick].frames, _rate)) return false;
+  _last = pick;
+  _played++;
+  Serial.printf("[Ack] %s for a predicted %lums\n", _clips[pick].name.c_str(), (unsigned long)predictedMs);
+  return true;
+}
+
+void AckClips::stop(Audio& audio) {
+  if (audio.isOverlayRunning()) audio.stopOverlay();
+}
+
+String AckClips::statsJson() const {
+  DynamicJsonDocument doc(1024);
+  doc["clips"] = _count;
+  doc["sample_rate"] = _rate;
+  doc["threshold_ms"] = _threshold;
+  doc["played"] = _played;
+  doc["skipped"] = _skipped;
+  doc["last_predicted_ms"] = _lastPredictedMs;
+  JsonArray arr = doc.createNestedArray("durations_ms");
+  for (uint8_t i = 0; i < _count; i++) arr.add(_clips[i].ms);
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
@@ -0,0 +1,57 @@
+#ifndef AckClips_h
+#define AckClips_h
+
+#include <Arduino.h>
+#include <FS.h>
+#include "Audio.h"
+
+// Short acknowledgement clips ("mm-hm", "let me see") that cover the silence between the end of speech
+// and the first audio of the reply. The .wav files of a flash directory are decoded once at load into
+// mono 16 bit PCM at the output rate and stay in memory (PSRAM when there is PSRAM), so starting one is
+// just Audio::playOverlay(). The player fades the clip out into the first samples of the reply.
+// Which clip plays depends on the predicted silence: the clip takes at most half of it, so a long wait
+// gets "let me see", a short one "mm-hm", and nothing plays below the threshold.
+
+#define ACK_MAX_CLIPS        8
+#define ACK_CLIP_MAX_MS      3000    // longer files are cut
+#define ACK_THRESHOLD_MS     1500    // default, predicted silence below this plays no clip
+
+class AckClips {
+  public:
+    AckClips();
+    ~AckClips();
+
+    // Every 16 bit PCM .wav in dir (mono or stereo, any rate), resampled to sampleRate; returns the clip count
+    size_t load(fs::FS& fs, const char* dir, uint32_t sampleRate);
+    void setThreshold(uint32_t ms);
+    uint32_t threshold() const;
+    size_t count() const;
+
+    // Picks a clip for the predicted silence and starts it; false if the wait is too short or none fits
+    bool play(Audio& audio, uint32_t predictedMs);
+    void stop(Audio& audio);
+
+    String statsJson() const;
+
+  private:
+    struct Clip {
+      String name;
+      int16_t* pcm;
+      uint32_t frames;
+      uint32_t ms;
+    };
+
+    Clip _clips[ACK_MAX_CLIPS];          // shortest first
+    uint8_t _count;
+    uint32_t _rate;
+    uint32_t _threshold;
+    int8_t _last;                        // not picked twice in a row if there is a choice
+    uint32_t _played;
+    uint32_t _skipped;
+    uint32_t _lastPredictedMs;
+
+    bool _decodeWav(File& file, Clip& clip);
+    void _free();
+};
+
+#endif
@@ -5,6 +5,8 @@
  */
 
 #include "ArduinoASRChat.h"
+#include "LatencyTracer.h"
+#include "SystemTelemetry.h"
 
 /**
  * @brief Constructor - Initialize ASR client
@@ -15,8 +17,11 @@ ArduinoASRChat::ArduinoASRChat(const char* apiKey, const char* cluster) {
   _apiKey = apiKey;
   _cluster = cluster;
 
-  // Allocate audio send buffer (3200 bytes = 200ms of 16kHz 16bit mono audio)
-  _sendBuffer = new int16_t[_sendBatchSize / 2];
+  // Allocate frame buffer, word aligned: headroom + protocol header + audio batch
+  // (3200 bytes = 200ms of 16kHz 16bit mono audio). Samples are collected right where they are sent from.
+  size_t frameWords = (ASR_FRAME_HEADROOM + ASR_PROTOCOL_HEADER + _sendBatchSize + 3) / 4;
+  _frameBuf = (uint8_t*)new uint32_t[frameWords];
+  _sendBuffer = (int16_t*)(framePayload() + ASR_PROTOCOL_HEADER);
 }
 
 /**
@@ -86,6 +91,7 @@ bool ArduinoASRChat::initPDMMicrophone(int pdmClkPin, int pdmDataPin) {
   }
 
   Serial.println("PDM microphone initialized");
+  systemTelemetry.attachI2S("mic", _I2S.rxChan(), false);  // overruns while recording
 
   // Wait for hardware to stabilize and clear buffer
   delay(500);
@@ -114,6 +120,7 @@ bool ArduinoASRChat::initINMP441Microphone(int i2sSckPin, int i2sWsPin, int i2sS
   }
 
   Serial.println("INMP441 microphone initialized");
+  systemTelemetry.attachI2S("mic", _I2S.rxChan(), false);  // overruns while recording
 
   // Wait for hardware to stabilize and clear buffer
   delay(500);
@@ -304,7 +311,13 @@ bool ArduinoASRChat::startRecording() {
   _recordingStartTime = millis(); // Recording start time
   _sendBufferPos = 0;           // Send buffer position
   _sameResultCount = 0;         // Same result count (for stability detection)
+  _speculatedText = "";         // Nothing speculated on in this recording yet
+  _samplesRead = 0;             // Microphone samples taken for upload
+  _recordingStartUs = micros(); // Reference for the send queue
   _lastDotTime = millis();      // Last time progress dot was printed
+  latencyTracer.beginTurn();    // A new conversation turn starts with the recording
+  systemTelemetry.setI2SArmed(_I2S.rxChan(), true);
+  latencyTracer.begin(LAT_ASR_CAPTURE);
 
   // Send new session request, start new recognition session
   sendFullRequest();
@@ -337,6 +350,13 @@ void ArduinoASRChat::stopRecording() {
   _isRecording = false;
   _shouldStop = true;
   _recognizedText = _lastResultText;  // Save final recognition result
+  systemTelemetry.setI2SArmed(_I2S.rxChan(), false);
+
+  // Streaming recognition: the last partial result is the final text, no transcribe span
+  latencyTracer.end(LAT_ASR_CAPTURE);
+  if (_hasSpeech && _lastSpeechTime > 0) {
+    latencyTracer.recordSince(LAT_ASR_ENDPOINT, _lastSpeechTime);
+  }
   _hasNewResult = true;               // Mark new result available
 
   sendEndMarker();                    // Send end marker to server
@@ -356,6 +376,21 @@ bool ArduinoASRChat::isRecording() {
   return _isRecording;
 }
 
+/**
+ * @brief Read microphone samples while not recording (barge-in monitoring during playback)
+ * @param out Destination for 16-bit signed PCM at the recording sample rate
+ * @param maxSamples Capacity of out
+ * @return Number of samples read, 0 while recording or without an I2S microphone
+ */
+size_t ArduinoASRChat::readMicrophone(int16_t* out, size_t maxSamples) {
+  if (_isRecording || _I2S.rxChan() == nullptr || out == nullptr || maxSamples == 0) {
+    return 0;
+  }
+  size_t bytes = 0;
+  i2s_channel_read(_I2S.rxChan(), out, maxSamples * sizeof(int16_t), &bytes, 0);
+  return bytes / sizeof(int16_t);
+}
+
 /**
  * @brief Main loop processing function - must be called in Arduino loop()
  * @details Handle audio sending, receive recognition results, check timeout and silence
@@ -366,6 +401,7 @@ void ArduinoASRChat::loop() {
     Serial.println("Connection lost");
     _wsConnected = false;
     _isRecording = false;
+    systemTelemetry.setI2SArmed(_I2S.rxChan(), false);
   }
 
   // If not connected, return directly
@@ -422,6 +458,7 @@ void ArduinoASRChat::processAudioSending() {
     }
 
     int sample = _I2S.read();
+    _samplesRead++;
 
     // Filter invalid data (0, -1, 1 are usually noise or initialization values)
     if (sample != 0 && sample != -1 && sample != 1) {
@@ -449,6 +486,8 @@ void ArduinoASRChat::feedAudioData(const int16_t* data, size_t samples) {
     return;
   }
 
+  _samplesRead += samples;
+
   // Process samples
   for (size_t i = 0; i < samples; i++) {
     int16_t sample = data[i];
@@ -480,6 +519,7 @@ void ArduinoASRChat::checkRecordingTimeout() {
     if (!_hasSpeech && _timeoutNoSpeechCallback != nullptr) {
       Serial.println("No speech detected during recording, exiting continuous mode");
       stopRecording();
+      latencyTracer.cancelTurn();
       _timeoutNoSpeechCallback();
     } else {
       Serial.println("Stopping recording");
@@ -500,10 +540,25 @@ void ArduinoASRChat::checkSilence() {
     if (silence >= _silenceDuration) {
       Serial.printf("\nSilence detected (%.1fs), stopping\n", silence / 1000.0);
       stopRecording();
+    } else if (silence >= _speculatePauseMs) {
+      speculate("pause");  // The speaker paused, the rest of the silence window overlaps the LLM request
     }
   }
 }
 
+/**
+ * @brief Hand the current partial result to the speculative callback
+ * @param reason Why the partial looks final, for the log
+ * @details Only once per distinct partial text and only while recording
+ */
+void ArduinoASRChat::speculate(const char* reason) {
+  if (_speculativeCallback == nullptr || !_isRecording || _shouldStop) return;
+  if (_lastResultText.length() == 0 || _lastResultText == _speculatedText) return;
+  _speculatedText = _lastResultText;
+  Serial.printf("\n[ASR] Speculating (%s): %s\n", reason, _speculatedText.c_str());
+  _speculativeCallback(_speculatedText);
+}
+
 /**
  * @brief Get recognized text
  * @return Final recognition result string
@@ -544,6 +599,55 @@ void ArduinoASRChat::setTimeoutNoSpeechCallback(TimeoutNoSpeechCallback callback
   _timeoutNoSpeechCallback = callback;
 }
 
+/**
+ * @brief Set speculative result callback function
+ * @param callback Callback function pointer, nullptr disables speculation
+ * @param stableResults Identical partial results before speculating
+ * @param pauseMs Silence before speculating
+ */
+void ArduinoASRChat::setSpeculativeCallback(SpeculativeCallback callback, int stableResults, unsigned long pauseMs) {
+  _speculativeCallback = callback;
+  _speculateStableResults = stableResults > 1 ? stableResults : 2;
+  _speculatePauseMs = pauseMs;
+}
+
+/**
+ * @brief Get upload statistics
+ * @return Counters since the last resetTxStats()
+ */
+const ArduinoASRChat::TxStats& ArduinoASRChat::getTxStats() const {
+  return _txStats;
+}
+
+/**
+ * @brief Upload statistics as JSON
+ * @return JSON string, send_us_per_audio_s is the write time per second of streamed audio
+ */
+String ArduinoASRChat::getTxStatsJson() const {
+  StaticJsonDocument<384> doc;
+  doc["frames"] = _txStats.frames;
+  doc["wire_bytes"] = _txStats.wireBytes;
+  doc["audio_bytes"] = _txStats.audioBytes;
+  doc["short_writes"] = _txStats.shortWrites;
+  doc["send_us"] = _txStats.sendUs;
+  doc["max_send_us"] = _txStats.maxSendUs;
+  doc["queue_bytes"] = _txStats.queueBytes;
+  doc["max_queue_bytes"] = _txStats.maxQueueBytes;
+  uint32_t audioBytesPerSecond = _sampleRate * (_bitsPerSample / 8) * _channels;
+  doc["send_us_per_audio_s"] = _txStats.audioBytes > 0
+      ? (uint32_t)((uint64_t)_txStats.sendUs * audioBytesPerSecond / _txStats.audioBytes) : 0;
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+/**
+ * @brief Reset upload statistics
+ */
+void ArduinoASRChat::resetTxStats() {
+  _txStats = {};
+}
+
 /**
  * @brief Send full session request (including configuration)
  * @details Build JSON configuration including audio parameters, workflow, etc., send to ASR server
@@ -579,50 +683,47 @@ void ArduinoASRChat::sendFullRequest() {
   Serial.println("Sending config:");
   Serial.println(json_str);
 
-  // ByteDance ASR protocol header (4 bytes)
-  uint8_t header[4] = {0x11, (CLIENT_FULL_REQUEST << 4) | NO_SEQUENCE, 0x10, 0x00};
   uint32_t payload_len = json_str.length();
-  // Length field (4 bytes, big-endian)
-  uint8_t len_bytes[4];
-  len_bytes[0] = (payload_len >> 24) & 0xFF;
-  len_bytes[1] = (payload_len >> 16) & 0xFF;
-  len_bytes[2] = (payload_len >> 8) & 0xFF;
-  len_bytes[3] = payload_len & 0xFF;
+  if (payload_len > (uint32_t)_sendBatchSize) {
+    Serial.println("Config too large for the frame buffer");
+    return;
+  }
 
-  // Assemble complete request (protocol header + length + JSON data)
-  uint8_t* full_request = new uint8_t[8 + payload_len];
-  memcpy(full_request, header, 4);
-  memcpy(full_request + 4, len_bytes, 4);
-  memcpy(full_request + 8, json_str.c_str(), payload_len);
+  // Assemble complete request (protocol header + length + JSON data) in the frame buffer,
+  // no audio is pending at the start of a session
+  uint8_t* full_request = framePayload();
+  putProtocolHeader(full_request, (CLIENT_FULL_REQUEST << 4) | NO_SEQUENCE, payload_len);
+  memcpy(full_request + ASR_PROTOCOL_HEADER, json_str.c_str(), payload_len);
 
-  sendWebSocketFrame(full_request, 8 + payload_len, 0x02);  // 0x02 = binary frame
-  delete[] full_request;
+  sendWebSocketFrame(full_request, ASR_PROTOCOL_HEADER + payload_len, 0x02);  // 0x02 = binary frame
 }
 
 /**
  * @brief Send audio data chunk
  * @param data Audio data pointer
  * @param len Data length (bytes)
- * @details Encapsulate audio data in ByteDance ASR protocol format and send via WebSocket
+ * @details Encapsulate audio data in ByteDance ASR protocol format and send via WebSocket.
+ *          Data from the send buffer already sits behind the protocol header, nothing is copied.
+ *          The data is masked in place, the caller starts a new batch afterwards.
  */
 void ArduinoASRChat::sendAudioChunk(uint8_t* data, size_t len) {
-  // Protocol header (audio-only request)
-  uint8_t header[4] = {0x11, (CLIENT_AUDIO_ONLY_REQUEST << 4) | NO_SEQUENCE, 0x10, 0x00};
-  // Length field (big-endian)
-  uint8_t len_bytes[4];
-  len_bytes[0] = (len >> 24) & 0xFF;
-  len_bytes[1] = (len >> 16) & 0xFF;
-  len_bytes[2] = (len >> 8) & 0xFF;
-  len_bytes[3] = len & 0xFF;
+  if (len > (size_t)_sendBatchSize) return;
 
   // Assemble audio request (protocol header + length + audio data)
-  uint8_t* audio_request = new uint8_t[8 + len];
-  memcpy(audio_request, header, 4);
-  memcpy(audio_request + 4, len_bytes, 4);
-  memcpy(audio_request + 8, data, len);
+  uint8_t* audio_request = framePayload();
+  if (data != audio_request + ASR_PROTOCOL_HEADER) {
+    memmove(audio_request + ASR_PROTOCOL_HEADER, data, len);
+  }
+  putProtocolHeader(audio_request, (CLIENT_AUDIO_ONLY_REQUEST << 4) | NO_SEQUENCE, len);
+
+  if (!sendWebSocketFrame(audio_request, ASR_PROTOCOL_HEADER + len, 0x02)) return;
+  _txStats.audioBytes += len;
 
-  sendWebSocketFrame(audio_request, 8 + len, 0x02);
-  delete[] audio_request;
+  // Send queue: audio the microphone produced that was not taken for upload yet
+  uint64_t due = (uint64_t)(micros() - _recordingStartUs) * _sampleRate / 1000000;
+  uint32_t queue = due > _samplesRead ? (uint32_t)(due - _samplesRead) * (_bitsPerSample / 8) : 0;
+  _txStats.queueBytes = queue;
+  if (queue > _txStats.maxQueueBytes) _txStats.maxQueueBytes = queue;
 }
 
 /**
@@ -631,13 +732,10 @@ void ArduinoASRChat::sendAudioChunk(uint8_t* data, size_t len) {
  *          Use negative sequence number (NEG_SEQUENCE) to identify end
  */
 void ArduinoASRChat::sendEndMarker() {
-  uint8_t header[4] = {0x11, (CLIENT_AUDIO_ONLY_REQUEST << 4) | NEG_SEQUENCE, 0x10, 0x00};
-  uint8_t len_bytes[4] = {0x00, 0x00, 0x00, 0x00};  // Length is 0
-  uint8_t end_request[8];
-  memcpy(end_request, header, 4);
-  memcpy(end_request + 4, len_bytes, 4);
+  uint8_t* end_request = framePayload();  // The last batch was flushed before
+  putProtocolHeader(end_request, (CLIENT_AUDIO_ONLY_REQUEST << 4) | NEG_SEQUENCE, 0);  // Length is 0
 
-  sendWebSocketFrame(end_request, 8, 0x02);
+  sendWebSocketFrame(end_request, ASR_PROTOCOL_HEADER, 0x02);
   Serial.println("End marker sent");
 }
 
@@ -650,19 +748,57 @@ void ArduinoASRChat::sendPong() {
   sendWebSocketFrame(pong_data, 0, 0x0A);  // 0x0A = Pong frame
 }
 
+/**
+ * @brief Payload area of the frame buffer
+ * @return Word aligned pointer with ASR_FRAME_HEADROOM bytes in front of it
+ */
+uint8_t* ArduinoASRChat::framePayload() {
+  return _frameBuf + ASR_FRAME_HEADROOM;
+}
+
+/**
+ * @brief Write the ByteDance protocol header
+ * @param dst Destination, ASR_PROTOCOL_HEADER bytes
+ * @param flags Message type (high nibble) and sequence flags (low nibble)
+ * @param payloadLen Payload length, stored big-endian
+ */
+void ArduinoASRChat::putProtocolHeader(uint8_t* dst, uint8_t flags, uint32_t payloadLen) {
+  dst[0] = 0x11;  // Protocol version 1, header size 1 (x4 bytes)
+  dst[1] = flags;
+  dst[2] = 0x10;  // JSON serialization, no compression
+  dst[3] = 0x00;
+  dst[4] = (payloadLen >> 24) & 0xFF;
+  dst[5] = (payloadLen >> 16) & 0xFF;
+  dst[6] = (payloadLen >> 8) & 0xFF;
+  dst[7] = payloadLen & 0xFF;
+}
+
 /**
  * @brief Send WebSocket frame
- * @param data Data to send
+ * @param data Data to send, masked in place
  * @param len Data length
  * @param opcode WebSocket opcode (0x01=text, 0x02=binary, 0x08=close, 0x09=Ping, 0x0A=Pong)
- * @details Encapsulate data frame according to WebSocket protocol, including frame header, mask, data
+ * @return true if the whole frame was written
+ * @details Encapsulate data frame according to WebSocket protocol, including frame header, mask, data.
+ *          Data built at framePayload() gets the header written into the headroom in front of it and
+ *          goes out with a single write, i.e. one TLS record. Other data (control frames, at most
+ *          125 bytes) is copied to a stack buffer first, the frame buffer may hold pending samples.
  */
-void ArduinoASRChat::sendWebSocketFrame(uint8_t* data, size_t len, uint8_t opcode) {
-  if (!_wsConnected || !_client.connected()) return;
+bool ArduinoASRChat::sendWebSocketFrame(uint8_t* data, size_t len, uint8_t opcode) {
+  if (!_wsConnected || !_client.connected()) return false;
 
-  // Build WebSocket frame header
-  uint8_t header[10];
-  int header_len = 2;
+  uint32_t start = micros();
+  uint32_t control[(ASR_FRAME_HEADROOM + 125 + 3) / 4];
+  uint8_t* payload = data;
+  if (data != framePayload()) {
+    if (len > 125) return false;
+    payload = (uint8_t*)control + ASR_FRAME_HEADROOM;
+    memcpy(payload, data, len);
+  }
+
+  // Build WebSocket frame header right in front of the payload
+  int header_len = len < 126 ? 2 : (len < 65536 ? 4 : 10);
+  uint8_t* header = payload - header_len - 4;
 
   header[0] = 0x80 | opcode;  // FIN=1 + opcode
   header[1] = 0x80;           // MASK=1
@@ -674,31 +810,42 @@ void ArduinoASRChat::sendWebSocketFrame(uint8_t* data, size_t len, uint8_t opcod
     header[1] |= 126;  // Use 16-bit extended length
     header[2] = (len >> 8) & 0xFF;
     header[3] = len & 0xFF;
-    header_len = 4;
   } else {
     header[1] |= 127;  // Use 64-bit extended length
     for (int i = 0; i < 8; i++) {
-      header[2 + i] = (len >> (56 - i * 8)) & 0xFF;
+      header[2 + i] = ((uint64_t)len >> (56 - i * 8)) & 0xFF;
     }
-    header_len = 10;
   }
 
-  // Generate random mask key (client to server must be masked)
-  uint8_t mask_key[4];
-  for (int i = 0; i < 4; i++) {
-    mask_key[i] = random(0, 256);
+  // Random mask key (client to server must be masked), stored in memory order so the
+  // word aligned payload can be XORed with it a word at a time
+  uint32_t mask = esp_random();
+  memcpy(header + header_len, &mask, 4);
+
+  uint32_t* words = (uint32_t*)payload;
+  size_t word_count = len / 4;
+  for (size_t i = 0; i < word_count; i++) {
+    words[i] ^= mask;
+  }
+  const uint8_t* mask_key = (const uint8_t*)&mask;
+  for (size_t i = word_count * 4; i < len; i++) {
+    payload[i] ^= mask_key[i & 3];
   }
-  memcpy(header + header_len, mask_key, 4);
-  header_len += 4;
 
-  // Send frame header
-  _client.write(header, header_len);
+  // Header, mask key and payload in one write
+  size_t frame_len = header_len + 4 + len;
+  size_t written = _client.write(header, frame_len);
 
-  // Mask data and send
-  for (size_t i = 0; i < len; i++) {
-    data[i] ^= mask_key[i % 4];
+  uint32_t elapsed = micros() - start;
+  _txStats.frames++;
+  _txStats.wireBytes += written;
+  _txStats.sendUs += elapsed;
+  if (elapsed > _txStats.maxSendUs) _txStats.maxSendUs = elapsed;
+  if (written != frame_len) {
+    _txStats.shortWrites++;
+    return false;
   }
-  _client.write(data, len);
+  return true;
 }
 
 /**
@@ -831,6 +978,7 @@ void ArduinoASRChat::parseResponse(uint8_t* data, size_t len) {
     if (current_text.length() > 0 && current_text != " ") {
       if (!_hasSpeech) {
         _hasSpeech = true;  // Mark speech detected
+        latencyTracer.first(LAT_ASR_CAPTURE);
         Serial.println("\nSpeech detected...");
       }
 
@@ -850,6 +998,8 @@ void ArduinoASRChat::parseResponse(uint8_t* data, size_t len) {
         if (_sameResultCount >= 10 && _isRecording && !_shouldStop) {
           Serial.println("\nResult stable, stopping recording");
           stopRecording();
+        } else if (_sameResultCount >= _speculateStableResults) {
+          speculate("stable");
         }
       } else {
         // Result changed, reset count
@@ -37,6 +37,11 @@ enum MicrophoneType {
 #define NO_SEQUENCE 0b0000             // No sequence
 #define NEG_SEQUENCE 0b0010            // Negative sequence
 
+// Outgoing frames are built in one buffer: WebSocket header (2-14 bytes, right-aligned), then the
+// protocol header and payload at a word boundary so the mask is applied 32 bits at a time
+#define ASR_FRAME_HEADROOM 16             // bytes reserved in front of the payload for the WebSocket header
+#define ASR_PROTOCOL_HEADER 8             // ByteDance protocol header + payload length
+
 /**
  * @class ArduinoASRChat
  * @brief ByteDance speech recognition chat class
@@ -158,6 +163,15 @@ class ArduinoASRChat {
      */
     void feedAudioData(const int16_t* data, size_t samples);
 
+    /**
+     * @brief Read microphone samples while not recording (barge-in monitoring during playback)
+     * @param out Destination for 16-bit signed PCM at the recording sample rate
+     * @param maxSamples Capacity of out
+     * @return Number of samples read, 0 while recording or without an I2S microphone
+     * @note Never blocks, returns what the I2S DMA buffers hold
+     */
+    size_t readMicrophone(int16_t* out, size_t maxSamples);
+
     /**
      * @brief Main loop processing function
      *
@@ -206,6 +220,57 @@ class ArduinoASRChat {
      */
     void setTimeoutNoSpeechCallback(TimeoutNoSpeechCallback callback);
 
+    /**
+     * @brief Speculative result callback function type
+     * @param partial Partial transcript that looks final
+     */
+    typedef void (*SpeculativeCallback)(const String& partial);
+
+    /**
+     * @brief Set speculative result callback function
+     * @param callback Callback function pointer, nullptr disables speculation
+     * @param stableResults Fire after this many identical partial results
+     * @param pauseMs Or after this much silence, well below the silence duration that ends the recording
+     * @details Lets the caller start the LLM request while the silence detection is still running.
+     *          Fires at most once per distinct partial; the final result still comes through the
+     *          result callback / hasNewResult() and may differ.
+     */
+    void setSpeculativeCallback(SpeculativeCallback callback, int stableResults = 4, unsigned long pauseMs = 400);
+
+    /**
+     * @brief Upload statistics since the last reset
+     * @details Frames and bytes on the wire, send time (framing, masking and write()), writes that came
+     *          back short, and the send queue: microphone audio produced but not yet taken for upload
+     *          when an audio frame went out, it grows while the TLS write blocks
+     */
+    struct TxStats {
+      uint32_t frames;
+      uint32_t wireBytes;
+      uint32_t audioBytes;
+      uint32_t shortWrites;
+      uint32_t sendUs;
+      uint32_t maxSendUs;
+      uint32_t queueBytes;
+      uint32_t maxQueueBytes;
+    };
+
+    /**
+     * @brief Get upload statistics
+     * @return Counters since the last resetTxStats()
+     */
+    const TxStats& getTxStats() const;
+
+    /**
+     * @brief Upload statistics as JSON, with the send time per second of streamed audio
+     * @return JSON string
+     */
+    String getTxStatsJson() const;
+
+    /**
+     * @brief Reset upload statistics
+     */
+    void resetTxStats();
+
   private:
     // WebSocket configuration
     const char* _apiKey;                    // API key
@@ -251,17 +316,27 @@ class ArduinoASRChat {
     unsigned long _lastDotTime = 0;            // Last dot time
 
     // Audio buffer
-    int16_t* _sendBuffer;                     // Send buffer
+    uint8_t* _frameBuf;                       // Outgoing frame: headroom + protocol header + batch
+    int16_t* _sendBuffer;                     // Send buffer, the payload area of _frameBuf
     int _sendBufferPos = 0;                    // Send buffer position
+    TxStats _txStats = {};                     // Upload statistics
+    uint32_t _samplesRead = 0;                 // Microphone samples taken in this recording
+    uint32_t _recordingStartUs = 0;            // micros() at the start of the recording
 
     // Callback functions
     ResultCallback _resultCallback = nullptr;           // Result callback function
     TimeoutNoSpeechCallback _timeoutNoSpeechCallback = nullptr;  // Timeout no speech callback function
+    SpeculativeCallback _speculativeCallback = nullptr;          // Speculative result callback function
+    int _speculateStableResults = 4;            // Identical partials before speculating
+    unsigned long _speculatePauseMs = 400;      // Silence before speculating
+    String _speculatedText = "";               // Partial last handed to the speculative callback
 
     // Private helper methods
     String generateWebSocketKey();            // Generate WebSocket key
     void handleWebSocketData();                // Handle WebSocket data
-    void sendWebSocketFrame(uint8_t* data, size_t len, uint8_t opcode);  // Send WebSocket frame
+    bool sendWebSocketFrame(uint8_t* data, size_t len, uint8_t opcode);  // Send WebSocket frame
+    uint8_t* framePayload();                   // Payload area of _frameBuf, frames built there are sent without a copy
+    void putProtocolHeader(uint8_t* dst, uint8_t flags, uint32_t payloadLen);  // ByteDance header + length
     void sendFullRequest();                   // Send full request
     void sendAudioChunk(uint8_t* data, size_t len);  // Send audio chunk
     void sendEndMarker();                      // Send end marker
@@ -270,6 +345,7 @@ class ArduinoASRChat {
     void processAudioSending();                // Process audio sending
     void checkRecordingTimeout();             // Check recording timeout
     void checkSilence();                       // Check silence
+    void speculate(const char* reason);        // Hand a stable partial to the speculative callback
 };
 
 #endif
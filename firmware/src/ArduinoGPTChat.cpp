@@ -1,6 +1,8 @@
 #include "ArduinoGPTChat.h"
 #include <SPIFFS.h>
 #include <cstring>
+#include "LatencyTracer.h"
+#include "LLMReply.h"
 
 // Default API configuration - users can modify these values or set their own configuration via setApiConfig()
 const char* DEFAULT_API_KEY = "";
@@ -568,7 +570,7 @@ void ArduinoGPTChat::enableMemory(bool enable) {
  * Clear all saved conversation history
  */
 void ArduinoGPTChat::clearMemory() {
-  _conversationHistory.clear();
+  _history.clear();
   Serial.println("Conversation memory cleared");
 }
 
@@ -626,85 +628,143 @@ bool ArduinoGPTChat::_extractHostAndPath(const String& url, String* host, String
  * Build HTTP request to send to GPT API, process response and manage conversation history
  */
 String ArduinoGPTChat::sendMessage(String message) {
+  latencyTracer.begin(LAT_LLM);
+  String assistantResponse = requestReply(message);
+  if (assistantResponse.length() > 0) {
+    latencyTracer.end(LAT_LLM);
+    appendExchange(message, assistantResponse);
+  }
+  return assistantResponse;
+}
+
+/**
+ * @brief Send text message without storing the exchange
+ * @param message User message
+ * @return GPT response text
+ *
+ * The conversation history is sent as context but not updated, see appendExchange()
+ */
+String ArduinoGPTChat::requestReply(String message) {
+  return _request(_buildPayload(_history.systemPrompt(_systemPrompt), message, true));
+}
+
+/**
+ * @brief Store a conversation pair in memory
+ * @param userMessage User message
+ * @param reply Assistant reply
+ */
+void ArduinoGPTChat::appendExchange(String userMessage, String reply) {
+  // If memory enabled, save to conversation history
+  if (!_memoryEnabled || reply.length() == 0) {
+    return;
+  }
+  _history.append(userMessage, reply);
+
+  Serial.printf("Memory: %d conversation pairs stored, ~%d tokens\n",
+                (int)_history.size(), (int)_history.tokens());
+}
+
+/**
+ * @brief Set the history budget
+ * @param tokens Approximate tokens of conversation history sent with each request
+ *
+ * Older exchanges are folded into a rolling summary by summarizeHistory()
+ */
+void ArduinoGPTChat::setHistoryBudget(size_t tokens) {
+  _history.setTokenBudget(tokens);
+}
+
+/**
+ * @brief Whether exchanges fell out of the history budget and wait for summarizeHistory()
+ */
+bool ArduinoGPTChat::historyNeedsSummary() const {
+  return _memoryEnabled && _history.needsSummary();
+}
+
+/**
+ * @brief Fold the evicted exchanges into the rolling summary
+ * @return Whether a summary came back
+ *
+ * One chat request without system prompt or history, blocks like sendMessage()
+ */
+bool ArduinoGPTChat::summarizeHistory() {
+  String request;
+  size_t folded = 0;
+  if (!_history.summaryRequest(request, folded)) {
+    return false;
+  }
+  String summary = _request(_buildPayload("", request, false));
+  _history.applySummary(summary, folded);
+  return summary.length() > 0;
+}
+
+/**
+ * @brief Set connect and read timeout of chat requests
+ * @param ms Timeout in milliseconds, 0 keeps the HTTPClient defaults
+ */
+void ArduinoGPTChat::setRequestTimeout(uint32_t ms) {
+  _requestTimeoutMs = ms;
+}
+
+String ArduinoGPTChat::_request(const String& payload) {
   HTTPClient http;
   http.begin(_apiUrl);
+  if (_requestTimeoutMs > 0) {
+    http.setConnectTimeout(_requestTimeoutMs);
+    http.setTimeout(_requestTimeoutMs > 0xFFFF ? 0xFFFF : _requestTimeoutMs);
+  }
   http.addHeader("Content-Type", "application/json");
   http.addHeader("Authorization", "Bearer " + String(_apiKey));
+  http.useHTTP10(true);  // plain body on the stream, no chunked encoding
 
-  String payload = _buildPayload(message);
   int httpResponseCode = http.POST(payload);
+  latencyTracer.first(LAT_LLM);
 
+  String outputText;
   if (httpResponseCode == 200) {
-    String response = http.getString();
-    String assistantResponse = _processResponse(response);
-
-    // If memory enabled, save to conversation history
-    if (_memoryEnabled && assistantResponse.length() > 0) {
-      _conversationHistory.push_back(std::make_pair(message, assistantResponse));
-
-      // Only keep last N conversation pairs to avoid memory overflow
-      while (_conversationHistory.size() > _maxHistoryPairs) {
-        _conversationHistory.erase(_conversationHistory.begin());
-      }
-
-      Serial.printf("Memory: %d/%d conversation pairs stored\n",
-                    _conversationHistory.size(), _maxHistoryPairs);
-    }
-
-    return assistantResponse;
+    outputText = readLLMReply(http.getStream(), http.getSize(), LLM_REPLY_OPENAI, "GPT");
+    // Replace newlines with spaces to preserve full response for TTS
+    outputText.replace("\n", " ");
+    outputText.replace("\r", "");
   }
-  return "";
+  http.end();
+  return outputText;
 }
 
 /**
  * @brief Build JSON payload for HTTP request
+ * @param systemPrompt System message, empty for none
  * @param message Current user message
+ * @param withHistory Send the conversation memory along
  * @return JSON formatted request string
  *
- * Build complete GPT request JSON based on system prompt and conversation history
- * Contains system message, conversation history and current user message
+ * Build complete GPT request JSON from system prompt, conversation history and current user message.
+ * Built by concatenation, the history is kept as ready JSON fragments
  */
-String ArduinoGPTChat::_buildPayload(String message) {
-  // Calculate required buffer size based on history
-  size_t bufferSize = 768;
-  if (_memoryEnabled && _conversationHistory.size() > 0) {
-    bufferSize = 768 + (_conversationHistory.size() * 512);  // Reserve extra space for history
-  }
-
-  DynamicJsonDocument doc(bufferSize);
-  doc["model"] = _chatModel;
-  JsonArray messages = doc.createNestedArray("messages");
+String ArduinoGPTChat::_buildPayload(const String& systemPrompt, const String& message, bool withHistory) {
+  String payload;
+  payload.reserve(128 + systemPrompt.length() + message.length() + (withHistory ? _history.tokens() * 5 : 0));
+  payload = "{\"model\":";
+  ConversationHistory::appendJsonString(payload, _chatModel);
+  payload += ",\"messages\":[";
 
   // If system prompt configured, add system message
-  if (_systemPrompt.length() > 0) {
-    JsonObject sysMsg = messages.createNestedObject();
-    sysMsg["role"] = "system";
-    sysMsg["content"] = _systemPrompt;
+  if (systemPrompt.length() > 0) {
+    payload += "{\"role\":\"system\",\"content\":";
+    ConversationHistory::appendJsonString(payload, systemPrompt);
+    payload += "},";
   }
 
   // If memory enabled, add conversation history
-  if (_memoryEnabled) {
-    for (size_t i = 0; i < _conversationHistory.size(); i++) {
-      // Add user message from history
-      JsonObject historyUserMsg = messages.createNestedObject();
-      historyUserMsg["role"] = "user";
-      historyUserMsg["content"] = _conversationHistory[i].first;
-
-      // Add assistant reply from history
-      JsonObject historyAssistantMsg = messages.createNestedObject();
-      historyAssistantMsg["role"] = "assistant";
-      historyAssistantMsg["content"] = _conversationHistory[i].second;
-    }
+  if (withHistory && _memoryEnabled && _history.appendFragments(payload)) {
+    payload += ",";
   }
 
   // Add current user message
-  JsonObject userMsg = messages.createNestedObject();
-  userMsg["role"] = "user";
-  userMsg["content"] = message;
-
-  String output;
-  serializeJson(doc, output);
-  return output;
+  payload += "{\"role\":\"user\",\"content\":";
+  ConversationHistory::appendJsonString(payload, message);
+  payload += "}]}";
+  return payload;
 }
 
 /**
@@ -712,13 +772,11 @@ String ArduinoGPTChat::_buildPayload(String message) {
  * @param response Raw JSON response
  * @return Extracted text reply
  *
- * Parse JSON response and extract assistant reply content
+ * Parse JSON response and extract assistant reply content (only that is kept in the document)
  * Remove newlines to get clean text output
  */
-String ArduinoGPTChat::_processResponse(String response) {
-  DynamicJsonDocument jsonDoc(1024);
-  deserializeJson(jsonDoc, response);
-  String outputText = jsonDoc["choices"][0]["message"]["content"];
+String ArduinoGPTChat::_processResponse(const String& response) {
+  String outputText = parseLLMReply(response, LLM_REPLY_OPENAI, "GPT");
   // Replace newlines with spaces to preserve full response for TTS
   outputText.replace("\n", " ");
   outputText.replace("\r", "");
@@ -728,14 +786,18 @@ String ArduinoGPTChat::_processResponse(String response) {
 /**
  * @brief Text to speech
  * @param text Text to convert
+ * @param cancelled Optional cancel predicate, checked before the request goes out
+ * @param cancelArg Argument of the predicate
  * @return Whether conversion succeeded
  *
  * Use Audio library's OpenAI speech function to convert text to speech
  * Uses gpt-4o-mini-tts model, alloy voice, mp3 format
  */
-bool ArduinoGPTChat::textToSpeech(String text) {
+bool ArduinoGPTChat::textToSpeech(String text, CancelCheck cancelled, void* cancelArg) {
   // Create temporary Audio object
   extern Audio audio;
+  if (cancelled != nullptr && cancelled(cancelArg)) return false;
+  latencyTracer.begin(LAT_TTS);  // ends with the first samples on I2S, see audio_first_samples()
 
   // Use Audio library's openai_speech function
   return audio.openai_speech(
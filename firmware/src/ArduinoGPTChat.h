@@ -9,6 +9,8 @@
 #include "SD.h"
 #include "ESP_I2S.h"
 #include <vector>
+#include "ConversationHistory.h"
+#include "AsyncJobRunner.h"
 
 class ArduinoGPTChat {
   public:
@@ -18,7 +20,13 @@ class ArduinoGPTChat {
     void enableMemory(bool enable);
     void clearMemory();
     String sendMessage(String message);
-    bool textToSpeech(String text);
+    String requestReply(String message);                    // like sendMessage, the exchange is not stored
+    void appendExchange(String userMessage, String reply);  // store an exchange answered elsewhere
+    void setRequestTimeout(uint32_t ms);                    // chat requests, 0: HTTPClient default
+    void setHistoryBudget(size_t tokens);                   // approximate tokens of history sent along
+    bool historyNeedsSummary() const;
+    bool summarizeHistory();                                // folds evicted exchanges into the summary, blocks
+    bool textToSpeech(String text, CancelCheck cancelled = nullptr, void* cancelArg = nullptr);  // false if cancelled first
     String speechToText(const char* audioFilePath);
     String speechToTextFromBuffer(uint8_t* audioBuffer, size_t bufferSize);
     String sendImageMessage(const char* imageFilePath, String question);
@@ -47,8 +55,9 @@ class ArduinoGPTChat {
     String _ttsApiUrl;
     String _sttApiUrl;
     String _systemPrompt;
-    String _buildPayload(String message);
-    String _processResponse(String response);
+    String _buildPayload(const String& systemPrompt, const String& message, bool withHistory);
+    String _request(const String& payload);
+    String _processResponse(const String& response);
     String _buildTTSPayload(String text);
     String _buildMultipartForm(const char* audioFilePath, String boundary);
     void _updateApiUrls();
@@ -61,8 +70,8 @@ class ArduinoGPTChat {
 
     // Conversation memory
     bool _memoryEnabled = false;
-    std::vector<std::pair<String, String>> _conversationHistory;  // pair<user_msg, assistant_msg>
-    const int _maxHistoryPairs = 5;  // Maximum conversation pairs to keep
+    ConversationHistory _history{HISTORY_OPENAI};  // token budgeted, with a rolling summary
+    uint32_t _requestTimeoutMs = 0;
 
     // WAV file handling
     uint8_t* createWAVBuffer(int16_t* samples, size_t numSamples);
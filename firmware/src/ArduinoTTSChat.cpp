@@ -5,6 +5,8 @@
  */
 
 #include "ArduinoTTSChat.h"
+#include "LatencyTracer.h"
+#include "SystemTelemetry.h"
 
 /**
  * @brief Constructor - Initialize TTS client
@@ -42,6 +44,10 @@ ArduinoTTSChat::~ArduinoTTSChat() {
     delete[] _msgBuffer;
     _msgBuffer = nullptr;
   }
+  if (_srcBuffer != nullptr) {
+    free(_srcBuffer);
+    _srcBuffer = nullptr;
+  }
 }
 
 /**
@@ -98,6 +104,40 @@ void ArduinoTTSChat::setPitch(int pitch) {
 void ArduinoTTSChat::setAudioParams(int sampleRate, int bitrate) {
   _sampleRate = sampleRate;
   _bitrate = bitrate;
+  if (_speakerInitialized && _outputSampleRate > 0) {
+    i2sSampleRate();  // I2S keeps its rate, only the resampler changes
+  }
+}
+
+/**
+ * @brief Set a fixed I2S output sample rate
+ * @param sampleRate I2S sample rate in Hz, 0 = follow the TTS sample rate
+ * @param quality Resampler quality
+ */
+void ArduinoTTSChat::setOutputSampleRate(int sampleRate, uint8_t quality) {
+  _outputSampleRate = sampleRate;
+  _srcQuality = quality;
+}
+
+/**
+ * @brief Get the I2S sample rate and set up the resampler if it differs from the TTS rate
+ * @return I2S sample rate in Hz
+ */
+int ArduinoTTSChat::i2sSampleRate() {
+  if (_outputSampleRate <= 0 || _outputSampleRate == _sampleRate) {
+    _resampler.deinit();
+    return _sampleRate;
+  }
+  if (_srcBuffer == nullptr) {
+    _srcBuffer = (int16_t*)malloc(SRC_BUFFER_FRAMES * sizeof(int16_t));
+  }
+  if (_srcBuffer == nullptr || !_resampler.init(_sampleRate, _outputSampleRate, 1, _srcQuality)) {
+    Serial.println("Resampler initialization failed, I2S uses the TTS sample rate");
+    _resampler.deinit();
+    return _sampleRate;
+  }
+  Serial.printf("Resampling %d Hz -> %d Hz\n", _sampleRate, _outputSampleRate);
+  return _outputSampleRate;
 }
 
 /**
@@ -112,12 +152,14 @@ bool ArduinoTTSChat::initMAX98357Speaker(int bclkPin, int lrclkPin, int doutPin)
   _I2S.setPins(bclkPin, lrclkPin, doutPin, -1);
 
   // Initialize I2S standard mode for output with configured sample rate
-  if (!_I2S.begin(I2S_MODE_STD, _sampleRate, I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO)) {
+  int i2sRate = i2sSampleRate();
+  if (!_I2S.begin(I2S_MODE_STD, i2sRate, I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO)) {
     Serial.println("MAX98357 I2S initialization failed!");
     return false;
   }
 
-  Serial.printf("MAX98357 speaker initialized at %d Hz\n", _sampleRate);
+  Serial.printf("MAX98357 speaker initialized at %d Hz\n", i2sRate);
+  systemTelemetry.attachI2S("tts", _I2S.txChan(), true);  // underruns while playing
   _speakerInitialized = true;
 
   // Create audio playback task on core 0 (WebSocket runs on core 1)
@@ -144,12 +186,13 @@ bool ArduinoTTSChat::initInternalDAC(int dacPin) {
   _speakerType = SPEAKER_TYPE_INTERNAL;
 
   // ESP32 internal DAC uses GPIO25 or GPIO26
-  if (!_I2S.begin(I2S_MODE_PDM_TX, _sampleRate, I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO)) {
+  if (!_I2S.begin(I2S_MODE_PDM_TX, i2sSampleRate(), I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO)) {
     Serial.println("Internal DAC initialization failed!");
     return false;
   }
 
   Serial.println("Internal DAC initialized");
+  systemTelemetry.attachI2S("tts", _I2S.txChan(), true);
   _speakerInitialized = true;
   return true;
 }
@@ -357,8 +400,11 @@ bool ArduinoTTSChat::speak(const char* text) {
   _audioWritePos = 0;
   _audioReadPos = 0;
   _audioDataSize = 0;
+  _srcValid = 0;
+  _srcPos = 0;
   _chunksReceived = 0;
   _playStartTime = millis();
+  latencyTracer.begin(LAT_TTS);
 
   // Send task_continue with text
   sendTaskContinue(text);
@@ -378,12 +424,15 @@ bool ArduinoTTSChat::isPlaying() {
  * @brief Stop current playback
  */
 void ArduinoTTSChat::stop() {
+  systemTelemetry.setI2SArmed(_I2S.txChan(), false);
   _shouldStop = true;
   _isPlaying = false;
   _receivingAudio = false;
   _audioWritePos = 0;
   _audioReadPos = 0;
   _audioDataSize = 0;
+  _srcValid = 0;
+  _srcPos = 0;
 }
 
 /**
@@ -752,6 +801,7 @@ void ArduinoTTSChat::parseJsonResponse(const char* json, size_t len) {
       _receivingAudio = true;
 
       if (_chunksReceived == 1) {
+        latencyTracer.first(LAT_TTS);
         unsigned long delay_ms = millis() - _playStartTime;
         Serial.printf("First audio chunk received (delay: %lums)\n", delay_ms);
       }
@@ -826,8 +876,11 @@ size_t ArduinoTTSChat::hexToBytes(const char* hex, size_t hexLen, uint8_t* outpu
  * @brief Process audio playback from ring buffer
  */
 void ArduinoTTSChat::processAudioPlayback() {
+  // Resampled frames the DMA did not take last time go out first
+  bool drained = _srcValid == 0 || writeResampled();
+
   // Play available audio data from ring buffer
-  while (_audioDataSize > 0) {
+  while (drained && _audioDataSize > 0) {
     // Calculate contiguous bytes available from read position
     size_t contiguous = AUDIO_BUFFER_SIZE - _audioReadPos;
     size_t dataSize = _audioDataSize;  // Copy volatile to local
@@ -847,6 +900,15 @@ void ArduinoTTSChat::processAudioPlayback() {
             written = toRead;
           }
         }
+      } else if (_resampler.isActive()) {
+        // Fixed I2S rate: the consumed input leaves the ring buffer, output the DMA does not take
+        // stays in _srcBuffer for the next call
+        uint16_t consumed = 0;
+        _srcValid = _resampler.process((const int16_t*)(_audioBuffer + _audioReadPos), toRead / 2,
+                                       _srcBuffer, SRC_BUFFER_FRAMES, &consumed);
+        _srcPos = 0;
+        written = consumed * sizeof(int16_t);
+        drained = writeResampled();
       } else {
         // MAX98357 or Internal DAC mode: use I2S write
         written = _I2S.write(_audioBuffer + _audioReadPos, toRead);
@@ -856,6 +918,8 @@ void ArduinoTTSChat::processAudioPlayback() {
         // Buffer full or callback failed, try again next loop
         break;
       }
+      systemTelemetry.setI2SArmed(_I2S.txChan(), true);  // from the first write to the end of the clip
+      latencyTracer.end(LAT_TTS);  // first audio out, later calls don't change the span
       _audioReadPos = (_audioReadPos + written) % AUDIO_BUFFER_SIZE;
       _audioDataSize -= written;
     } else {
@@ -864,13 +928,17 @@ void ArduinoTTSChat::processAudioPlayback() {
   }
 
   // Check if playback is complete
-  if (!_receivingAudio && _audioDataSize == 0 && _chunksReceived > 0) {
+  if (!_receivingAudio && _audioDataSize == 0 && _srcValid == 0 && _chunksReceived > 0) {
     Serial.println("Playback complete");
+    systemTelemetry.setI2SArmed(_I2S.txChan(), false);
     _isPlaying = false;
     _audioWritePos = 0;
     _audioReadPos = 0;
     _audioDataSize = 0;
     _chunksReceived = 0;
+    _resampler.reset();
+    _srcValid = 0;
+    _srcPos = 0;
 
 	// Keep task alive for subsequent speak() calls
 	// Don't reset _taskstarted - just send new task_continue messages
@@ -881,6 +949,19 @@ void ArduinoTTSChat::processAudioPlayback() {
   }
 }
 
+/**
+ * @brief Write the resampled frames still in _srcBuffer to I2S, without waiting for the DMA
+ * @return true if _srcBuffer is empty
+ */
+bool ArduinoTTSChat::writeResampled() {
+  if (_srcValid > 0) {
+    size_t w = _I2S.write((uint8_t*)(_srcBuffer + _srcPos), _srcValid * sizeof(int16_t)) / sizeof(int16_t);
+    _srcPos += w;
+    _srcValid -= w;
+  }
+  return _srcValid == 0;
+}
+
 /**
  * @brief Static wrapper for FreeRTOS task
  * @param param Pointer to ArduinoTTSChat instance
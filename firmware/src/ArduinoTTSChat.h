@@ -6,6 +6,7 @@
 #include <ArduinoJson.h>
 #include <ESP_I2S.h>
 #include <mbedtls/base64.h>
+#include "resampler/resampler.h"
 
 /**
  * @file ArduinoTTSChat.h
@@ -85,6 +86,15 @@ class ArduinoTTSChat {
      */
     void setAudioParams(int sampleRate = 32000, int bitrate = 128000);
 
+    /**
+     * @brief Set a fixed I2S output sample rate
+     * @param sampleRate I2S sample rate in Hz, 0 = run I2S at the TTS sample rate (default)
+     * @param quality Resampler quality (SRC_QUALITY_LOW, SRC_QUALITY_MEDIUM, SRC_QUALITY_HIGH)
+     * @note Call before initMAX98357Speaker()/initInternalDAC(). The received PCM is resampled,
+     *       later setAudioParams() calls do not restart I2S
+     */
+    void setOutputSampleRate(int sampleRate, uint8_t quality = SRC_QUALITY_MEDIUM);
+
     /**
      * @brief Initialize MAX98357 I2S speaker
      * @param bclkPin Bit clock pin
@@ -149,6 +159,12 @@ class ArduinoTTSChat {
      */
     void stop();
 
+    /**
+     * @brief Get the audio playback task handle (stack monitoring)
+     * @return Task handle, nullptr before the speaker is initialized
+     */
+    TaskHandle_t getAudioTaskHandle() const { return _audioTaskHandle; }
+
     /**
      * @brief Main loop processing function
      *
@@ -215,6 +231,15 @@ class ArduinoTTSChat {
     int _bitrate = 32000;                   // Bitrate (minimum 32k)
     const char* _format = "pcm";            // Audio format (pcm for direct playback)
     int _channels = 1;                      // Number of channels
+    int _outputSampleRate = 0;              // Fixed I2S rate, 0 = use _sampleRate
+    uint8_t _srcQuality = SRC_QUALITY_MEDIUM;  // Resampler quality
+
+    // Resampler (_sampleRate -> _outputSampleRate)
+    static const uint16_t SRC_BUFFER_FRAMES = 1024;  // Resampler output per I2S write
+    Resampler _resampler;                   // Polyphase resampler
+    int16_t* _srcBuffer = nullptr;          // Resampled PCM
+    uint16_t _srcValid = 0;                 // frames in _srcBuffer not yet written to I2S
+    uint16_t _srcPos = 0;                   // first frame in _srcBuffer to write
 
     // Speaker configuration
     SpeakerType _speakerType = SPEAKER_TYPE_MAX98357;  // Speaker type
@@ -269,8 +294,10 @@ class ArduinoTTSChat {
     void sendPong();                        // Send Pong response
     void parseJsonResponse(const char* json, size_t len);  // Parse JSON response
     void processAudioPlayback();            // Process audio playback
+    bool writeResampled();                  // Write _srcBuffer to I2S, true when all of it is out
     size_t hexToBytes(const char* hex, size_t hexLen, uint8_t* output, size_t outputSize);  // Convert hex to bytes
     size_t readBytesWithTimeout(uint8_t* buffer, size_t len, unsigned long timeout_ms); // Reliable read helper
+    int i2sSampleRate();                    // I2S rate, sets up the resampler if needed
 };
 
 #endif
@@ -0,0 +1,103 @@
+#include "AsyncJobRunner.h"
+
+AsyncJobRunner::AsyncJobRunner(const char* name, uint32_t stackSize, UBaseType_t priority, BaseType_t core)
+  : _name(name),
+    _stackSize(stackSize),
+    _priority(priority),
+    _core(core),
+    _task(nullptr),
+    _todo(nullptr),
+    _done(nullptr),
+    _generation(1),
+    _inFlight(0),
+    _nextId(0) {
+  portMUX_INITIALIZE(&_mux);
+}
+
+bool AsyncJobRunner::begin() {
+  if (_task != nullptr) return true;
+  _todo = xQueueCreate(ASYNC_JOB_QUEUE_LEN, sizeof(AsyncJob*));
+  _done = xQueueCreate(ASYNC_JOB_QUEUE_LEN + 1, sizeof(AsyncJob*));  // + the running one
+  if (_todo == nullptr || _done == nullptr) {
+    Serial.printf("[%s] queue allocation failed\n", _name);
+    return false;
+  }
+  if (xTaskCreatePinnedToCore(_taskFn, _name, _stackSize, this, _priority, &_task, _core) != pdPASS) {
+    Serial.printf("[%s] task creation failed\n", _name);
+    _task = nullptr;
+    return false;
+  }
+  return true;
+}
+
+uint32_t AsyncJobRunner::submit(uint8_t kind, AsyncJobFn fn, const String& input, bool cancellable) {
+  if (_task == nullptr || fn == nullptr) return 0;
+  AsyncJob* job = new AsyncJob();
+  job->id = ++_nextId;
+  job->kind = kind;
+  job->input = input;
+  job->ok = false;
+  job->_fn = fn;
+  job->_generation = _generation;
+  job->_current = cancellable ? &_generation : nullptr;
+
+  portENTER_CRITICAL(&_mux);
+  _inFlight++;
+  portEXIT_CRITICAL(&_mux);
+  if (xQueueSend(_todo, &job, 0) != pdTRUE) {
+    Serial.printf("[%s] queue full, job %lu dropped\n", _name, (unsigned long)job->id);
+    delete job;
+    _release();
+    return 0;
+  }
+  return job->id;
+}
+
+void AsyncJobRunner::_release() {
+  portENTER_CRITICAL(&_mux);
+  if (_inFlight > 0) _inFlight--;
+  portEXIT_CRITICAL(&_mux);
+}
+
+void AsyncJobRunner::_taskFn(void* arg) {
+  AsyncJobRunner* self = (AsyncJobRunner*)arg;
+  AsyncJob* job = nullptr;
+  for (;;) {
+    if (xQueueReceive(self->_todo, &job, portMAX_DELAY) != pdTRUE) continue;
+    if (!job->cancelled()) job->_fn(*job);
+    if (job->cancelled() || xQueueSend(self->_done, &job, 0) != pdTRUE) {
+      delete job;
+      self->_release();
+    }
+  }
+}
+
+bool AsyncJobRunner::poll(AsyncJob& done) {
+  if (_done == nullptr) return false;
+  AsyncJob* job = nullptr;
+  while (xQueueReceive(_done, &job, 0) == pdTRUE) {
+    bool live = !job->cancelled();
+    if (live) {
+      done.id = job->id;
+      done.kind = job->kind;
+      done.input = job->input;
+      done.output = job->output;
+      done.ok = job->ok;
+      done._fn = nullptr;
+      done._generation = job->_generation;
+      done._current = job->_current;
+    }
+    delete job;
+    _release();
+    if (live) return true;
+  }
+  return false;
+}
+
+void AsyncJobRunner::cancelAll() {
+  _generation++;  // queued jobs are skipped, finished ones are dropped by poll()
+}
+
+bool AsyncJobRunner::busy() const {
+  return _inFlight > 0;
+}
@@ -0,0 +1,72 @@
+#ifndef AsyncJobRunner_h
+#define AsyncJobRunner_h
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+// Runs blocking work (HTTP requests to the LLM, TTS or memory backends) on a worker task so the sketch
+// loop keeps serving audio, ASR, the web UI and the button. Jobs run one at a time in submit order, a
+// finished job comes back to the loop through poll().
+// Same priority as the Arduino loop by default so a TLS handshake on the worker shares the core with it.
+// cancelAll() drops queued jobs and marks the running one: it can check cancelled() between steps, its
+// result is discarded. A request that is already on the wire still runs to its end on the worker.
+
+#define ASYNC_JOB_QUEUE_LEN  4
+
+// Cancel predicate for blocking calls that know nothing about jobs, e.g. TTS before it starts playback.
+// With a job: AsyncJob::isCancelled and the job as arg.
+typedef bool (*CancelCheck)(void* arg);
+
+class AsyncJob {
+  public:
+    uint32_t id;
+    uint8_t kind;                 // caller defined, tells the completion handler what finished
+    String input;
+    String output;
+    bool ok;
+
+    AsyncJob() : id(0), kind(0), ok(false), _fn(nullptr), _generation(0), _current(nullptr) {}
+
+    bool cancelled() const { return _current != nullptr && _generation != *_current; }
+    static bool isCancelled(void* job) { return static_cast<AsyncJob*>(job)->cancelled(); }
+
+  private:
+    friend class AsyncJobRunner;
+    typedef void (*Fn)(AsyncJob& job);
+    Fn _fn;
+    uint32_t _generation;
+    const volatile uint32_t* _current;
+};
+
+typedef void (*AsyncJobFn)(AsyncJob& job);  // runs on the worker, fills output and ok
+
+class AsyncJobRunner {
+  public:
+    AsyncJobRunner(const char* name, uint32_t stackSize = 10240, UBaseType_t priority = 1, BaseType_t core = 1);
+
+    bool begin();
+    // job id, 0 if not queued. A job that is not cancellable also survives cancelAll(), e.g. a memory store.
+    uint32_t submit(uint8_t kind, AsyncJobFn fn, const String& input = "", bool cancellable = true);
+    bool poll(AsyncJob& done);    // loop side, the next finished job that was not cancelled
+    void cancelAll();
+    bool busy() const;            // queued, running or finished but not polled
+
+  private:
+    const char* _name;
+    uint32_t _stackSize;
+    UBaseType_t _priority;
+    BaseType_t _core;
+    TaskHandle_t _task;
+    QueueHandle_t _todo;
+    QueueHandle_t _done;
+    volatile uint32_t _generation;
+    volatile uint32_t _inFlight;
+    uint32_t _nextId;
+    portMUX_TYPE _mux;
+
+    static void _taskFn(void* arg);
+    void _release();
+};
+
+#endif
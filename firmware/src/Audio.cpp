@@ -9,11 +9,8 @@
  *
  */
 #include "Audio.h"
-#include "aac_decoder/aac_decoder.h"
-#include "flac_decoder/flac_decoder.h"
-#include "mp3_decoder/mp3_decoder.h"
-#include "opus_decoder/opus_decoder.h"
-#include "vorbis_decoder/vorbis_decoder.h"
+#include "mp3_decoder/mp3_decoder.h" // frame header tables for mp3_correctResumeFilePos()
+#include <esp_timer.h>              // overlay pacing, envelope stamps
 
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 AudioBuffer::AudioBuffer(size_t maxBlockSize) {
@@ -200,6 +197,9 @@ Audio::Audio(uint8_t i2sPort) {
     m_i2s_std_cfg.clk_cfg.clk_src        = I2S_CLK_SRC_DEFAULT;        // Select PLL_F160M as the default source clock
     m_i2s_std_cfg.clk_cfg.mclk_multiple  = I2S_MCLK_MULTIPLE_512;      // mclk = sample_rate * 256
     i2s_channel_init_std_mode(m_i2s_tx_handle, &m_i2s_std_cfg);
+    i2s_event_callbacks_t i2s_cbs = {};
+    i2s_cbs.on_send_q_ovf = i2sSendQueueOverflow; // underrun counter, must be registered before the channel is enabled
+    i2s_channel_register_event_callback(m_i2s_tx_handle, &i2s_cbs, this);
     I2Sstart(m_i2s_num);
     m_sampleRate = 44100;
 
@@ -218,6 +218,7 @@ Audio::~Audio() {
     // I2Sstop(m_i2s_num);
     // InBuff.~AudioBuffer(); #215 the AudioBuffer is automatically destroyed by the destructor
     setDefaults();
+    clearQueue();
 
     i2s_channel_disable(m_i2s_tx_handle);
     i2s_del_channel(m_i2s_tx_handle);
@@ -226,6 +227,7 @@ Audio::~Audio() {
     x_ps_free(&m_chbuf);
     x_ps_free(&m_lastHost);
     x_ps_free(&m_outBuff);
+    x_ps_free(&m_srcBuff);
     x_ps_free(&m_ibuff);
     x_ps_free(&m_lastM3U8host);
     x_ps_free(&m_speechtxt);
@@ -260,16 +262,20 @@ esp_err_t Audio::I2Sstart(uint8_t i2s_num) {
 esp_err_t Audio::I2Sstop(uint8_t i2s_num) {
     return i2s_channel_disable(m_i2s_tx_handle);
 }
+
+bool IRAM_ATTR Audio::i2sSendQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx) {
+    // all DMA buffers are sent and none was refilled, auto_clear plays silence. Idle or waiting for the
+    // first samples of a new source is not an underrun.
+    Audio* self = (Audio*)userCtx;
+    if(self->m_f_running && !self->m_f_firstSamples) self->m_i2sUnderruns++;
+    return false;
+}
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::setDefaults() {
     stopSong();
     initInBuff(); // initialize InputBuffer if not already done
     InBuff.resetBuffer();
-    MP3Decoder_FreeBuffers();
-    FLACDecoder_FreeBuffers();
-    AACDecoder_FreeBuffers();
-    OPUSDecoder_FreeBuffers();
-    VORBISDecoder_FreeBuffers();
+    audioCodecDeinitAll();
     memset(m_outBuff, 0, m_outbuffSize * sizeof(int16_t)); // Clear OutputBuffer
     x_ps_free(&m_playlistBuff);
     vector_clear_and_shrink(m_playlistURL);
@@ -284,6 +290,7 @@ void Audio::setDefaults() {
     ts_parsePacket(0, 0, 0);                     // reset ts routine
     x_ps_free(&m_lastM3U8host);
     x_ps_free(&m_speechtxt);
+    x_ps_free(&m_clipTag);  // the new source does not come from the queue
 
     AUDIO_INFO("buffers freed, free Heap: %lu bytes", (long unsigned int)ESP.getFreeHeap());
 
@@ -298,6 +305,7 @@ void Audio::setDefaults() {
     m_f_firstCurTimeCall = true; // InitSequence for computeAudioTime
     m_f_firstM3U8call = true;    // InitSequence for parsePlaylist_M3U8
     m_f_firstPlayCall = true;    // InitSequence for playAudioData
+    m_f_firstSamples = true;     // latency measurement, see audio_first_samples()
 //    m_f_running = false;       // already done in stopSong
     m_f_loop = false;     // Set if audio file should loop
     m_f_unsync = false;   // set within ID3 tag but not used
@@ -310,6 +318,7 @@ void Audio::setDefaults() {
     m_f_stream = false;
     m_f_decode_ready = false;
     m_f_eof = false;
+    m_f_pushEnd = false;
     m_f_ID3v1TagFound = false;
     m_f_lockInBuffer = false;
     m_f_acceptRanges = false;
@@ -337,6 +346,7 @@ void Audio::setDefaults() {
     m_ID3Size = 0;
     m_haveNewFilePos = 0;
     m_validSamples = 0;
+    m_outBuffPos = 0;
     m_M4A_chConfig = 0;
     m_M4A_objectType = 0;
     m_M4A_sampleRate = 0;
@@ -840,14 +850,7 @@ bool Audio::connecttoFS(fs::FS& fs, const char* path, int32_t fileStartPos) {
     if(dotPos == -1) {AUDIO_INFO("No file extension found"); goto exit;}  // guard
     setDefaults(); // free buffers an set defaults
 
-    if(endsWith(path, ".mp3"))  codec = CODEC_MP3;
-    if(endsWith(path, ".m4a"))  codec = CODEC_M4A;
-    if(endsWith(path, ".aac"))  codec = CODEC_AAC;
-    if(endsWith(path, ".wav"))  codec = CODEC_WAV;
-    if(endsWith(path, ".flac")) codec = CODEC_FLAC;
-    if(endsWith(path, ".opus")) codec = CODEC_OPUS;
-    if(endsWith(path, ".ogg"))  codec = CODEC_OGG;
-    if(endsWith(path, ".oga"))  codec = CODEC_OGG;
+    codec = codecFromFileExt(path);
     if(codec == CODEC_NONE) {AUDIO_INFO("The %s format is not supported", path + dotPos); goto exit;}   // guard
 
     audioPath = (char *)x_ps_calloc(strlen(path) + 2, sizeof(char));
@@ -872,6 +875,334 @@ exit:
     return res;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+uint8_t Audio::codecFromFileExt(const char* path) {
+    uint8_t codec = CODEC_NONE;
+    if(endsWith(path, ".mp3"))  codec = CODEC_MP3;
+    if(endsWith(path, ".m4a"))  codec = CODEC_M4A;
+    if(endsWith(path, ".aac"))  codec = CODEC_AAC;
+    if(endsWith(path, ".wav"))  codec = CODEC_WAV;
+    if(endsWith(path, ".flac")) codec = CODEC_FLAC;
+    if(endsWith(path, ".opus")) codec = CODEC_OPUS;
+    if(endsWith(path, ".ogg"))  codec = CODEC_OGG;
+    if(endsWith(path, ".oga"))  codec = CODEC_OGG;
+    if(codec == CODEC_NONE && audioCodecFindByExt(path)) codec = audioCodecFindByExt(path)->id; // registered decoder
+    return codec;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+/*
+    Clip queue, e.g. sentence by sentence TTS output:
+
+    audio.enqueueFS(SPIFFS, "/tts_0.mp3", "0");   // starts at once if nothing is playing
+    audio.enqueueFS(SPIFFS, "/tts_1.mp3", "1");   // starts when "/tts_0.mp3" is finished
+
+    Local files follow each other without a gap: the next file is opened while the current one drains, I2S is not
+    stopped, the decoder buffers are kept if the codec is the same and I2S is only reconfigured if the sample rate
+    changes. Host URLs need a new connection, they are chained via connecttohost().
+    audio_eof_clip(tag) is called at the end of every queued clip. connecttoFS()/connecttohost() leave the queue
+    untouched, use clearQueue() to drop the pending clips.
+*/
+bool Audio::enqueueFS(fs::FS& fs, const char* path, const char* tag) {
+
+    if(!path) {printProcessLog(AUDIOLOG_PATH_IS_NULL); return false;}  // guard
+    uint8_t codec = codecFromFileExt(path);
+    if(codec == CODEC_NONE) {AUDIO_INFO("The format of \"%s\" is not supported", path); return false;}   // guard
+
+    clip_t clip;
+    clip.fs    = &fs;
+    clip.path  = (char*)x_ps_calloc(strlen(path) + 2, sizeof(char));
+    clip.tag   = tag ? x_ps_strdup(tag) : NULL;
+    clip.codec = codec;
+    if(!clip.path) {x_ps_free(&clip.tag); printProcessLog(AUDIOLOG_OUT_OF_MEMORY); return false;}
+    if(path[0] != '/') clip.path[0] = '/';
+    strcat(clip.path, path);
+
+    xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    m_clipQueue.push_back(clip);
+    bool res = true;
+    if(!m_f_running) {x_ps_free(&m_clipTag); res = nextClip();}
+    xSemaphoreGiveRecursive(mutex_playAudioData);
+    return res;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::enqueueHost(const char* host, const char* tag) {
+
+    if(!host || !strlen(host)) {AUDIO_INFO("Hostaddress is empty"); return false;}  // guard
+
+    clip_t clip;
+    clip.fs    = NULL;
+    clip.path  = x_ps_strdup(host);
+    clip.tag   = tag ? x_ps_strdup(tag) : NULL;
+    clip.codec = CODEC_NONE; // determined by connecttohost()
+    if(!clip.path) {x_ps_free(&clip.tag); printProcessLog(AUDIOLOG_OUT_OF_MEMORY); return false;}
+
+    xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    m_clipQueue.push_back(clip);
+    bool res = true;
+    if(!m_f_running) {x_ps_free(&m_clipTag); res = nextClip();}
+    xSemaphoreGiveRecursive(mutex_playAudioData);
+    return res;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::clearQueue() {
+    xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    for(int i = 0; i < m_clipQueue.size(); i++) {
+        x_ps_free(&m_clipQueue[i].path);
+        x_ps_free(&m_clipQueue[i].tag);
+    }
+    m_clipQueue.clear();
+    m_clipQueue.shrink_to_fit();
+    if(m_nextFile) m_nextFile.close();
+    xSemaphoreGiveRecursive(mutex_playAudioData);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+/*
+    Pushed stream, the encoded audio arrives in pieces from another source (e.g. base64 chunks of a TTS websocket):
+
+    audio.connecttoPush("mp3");
+    while(...) audio.pushData(chunk, len);   // returns the bytes taken, retry the rest later
+    audio.pushEnd();                         // plays out what is buffered, then isRunning() becomes false
+
+    pushData() may be called from any task, it writes into the input buffer which is read by the audio task. The
+    audio starts once two blocks are buffered (or at pushEnd() for a short stream). pushData() returns 0 after
+    stopSong(), the producer can stop there.
+*/
+bool Audio::connecttoPush(const char* format) {
+
+    xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    bool res = false;
+    char ext[12] = ".";
+    uint8_t codec = CODEC_NONE;
+
+    if(!format) {printProcessLog(AUDIOLOG_PATH_IS_NULL); goto exit;}  // guard
+    strncat(ext, format, sizeof(ext) - 2);
+    codec = codecFromFileExt(ext);
+    if(codec == CODEC_NONE || codec == CODEC_M4A) {AUDIO_INFO("The %s format can't be pushed", format); goto exit;}   // guard, m4a needs seeking
+    setDefaults(); // free buffers an set defaults
+
+    AUDIO_INFO("Pushed stream: %s", format);
+    m_dataMode = AUDIO_PUSH;
+    m_controlCounter = 100; // no header to read, the decoder syncs on the frames
+    m_t0 = millis();
+    res = initializeDecoder(codec);
+    m_codec = codec;
+    if(res) m_f_running = true;
+
+exit:
+    xSemaphoreGiveRecursive(mutex_playAudioData);
+    return res;
+}
+
+size_t Audio::pushData(const uint8_t* data, size_t len) {
+    size_t done = 0;
+    if(!data || !len) return 0;  // guard
+    xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
+    if(m_dataMode == AUDIO_PUSH && m_f_running && !m_f_pushEnd) {
+        while(done < len) {  // writeSpace() ends at the buffer end, a second round continues at its start
+            size_t n = min(len - done, InBuff.writeSpace());
+            if(!n) break;
+            memcpy(InBuff.getWritePtr(), data + done, n);
+            InBuff.bytesWritten(n);
+            done += n;
+        }
+    }
+    xSemaphoreGiveRecursive(mutex_playAudioData);
+    return done;
+}
+
+size_t Audio::pushSpace() {
+    if(m_dataMode != AUDIO_PUSH || !m_f_running) return 0;
+    return InBuff.freeSpace();
+}
+
+void Audio::pushEnd() {
+    m_f_pushEnd = true;  // playAudioData() decodes the tail and sets m_f_eof
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+/*
+    Overlay, a short clip that stays in memory as 16 bit mono PCM (e.g. an acknowledgement while the reply is prepared):
+
+    audio.playOverlay(pcm, frames, 22050);   // the buffer is not copied, it must stay valid until the overlay ends
+    audio.connecttoPush("mp3");              // the overlay goes on until the first samples of the source are out,
+                                             // then it fades out (m_ovlFadeMs) mixed over the source
+
+    While no source writes samples the audio task writes the overlay itself, at most m_ovlLeadMs ahead of the
+    DAC so that the source is not queued behind it. The overlay follows the current I2S rate (linear
+    interpolation) and the volume. stopSong() and a new source leave it running, stopOverlay() ends it at once.
+*/
+bool Audio::playOverlay(const int16_t* pcm, uint32_t frames, uint32_t sampleRate) {
+    if(!pcm || !frames || sampleRate < 8000) return false;  // guard
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    m_ovlPcm = pcm;
+    m_ovlFrames = frames;
+    m_ovlRate = sampleRate;
+    m_ovlPos = 0;
+    m_ovlGain = 32768;
+    m_ovlFadeStep = 0;
+    m_ovlT0 = 0;
+    m_ovlValid = 0;
+    xSemaphoreGive(mutex_audioTask);
+    return true;
+}
+
+void Audio::fadeOverlay(uint16_t ms) {
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    startOverlayFade(ms);
+    xSemaphoreGive(mutex_audioTask);
+}
+
+void Audio::startOverlayFade(uint16_t ms) { // a fade that is already running keeps its speed
+    if(!m_ovlPcm || m_ovlFadeStep) return;
+    uint32_t fadeFrames = max((uint32_t)1, (uint32_t)ms * m_i2s_std_cfg.clk_cfg.sample_rate_hz / 1000);
+    m_ovlFadeStep = max((int32_t)1, (int32_t)(32768 / fadeFrames));
+}
+
+void Audio::stopOverlay() {
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    m_ovlPcm = NULL;
+    m_ovlValid = 0;
+    xSemaphoreGive(mutex_audioTask);
+}
+
+void Audio::mixOverlay(int16_t* buff, uint16_t frames, bool overSource) { // adds the overlay to interleaved L/R samples at the I2S rate
+    if(!m_ovlPcm) return;
+    if(overSource) {startOverlayFade(m_ovlFadeMs); m_ovlT0 = 0;} // the source is audible, blend over into it
+    uint32_t i2sRate = m_i2s_std_cfg.clk_cfg.sample_rate_hz;
+    uint32_t step = ((uint64_t)m_ovlRate << 16) / (i2sRate ? i2sRate : m_ovlRate);
+    float volL = m_limit_left;
+    float volR = m_limit_right;
+    for(uint16_t i = 0; i < frames; i++) {
+        uint32_t idx = m_ovlPos >> 16;
+        if(idx >= m_ovlFrames || m_ovlGain <= 0) {m_ovlPcm = NULL; return;}
+        int32_t a = m_ovlPcm[idx];
+        int32_t b = idx + 1 < m_ovlFrames ? m_ovlPcm[idx + 1] : 0;
+        int32_t s = a + (((b - a) * (int32_t)(m_ovlPos & 0xFFFF)) >> 16);
+        s = (s * m_ovlGain) >> 15;
+        int32_t l = buff[2 * i]     + (int32_t)(s * volL);
+        int32_t r = buff[2 * i + 1] + (int32_t)(s * volR);
+        buff[2 * i]     = (int16_t)constrain(l, -32768, 32767);
+        buff[2 * i + 1] = (int16_t)constrain(r, -32768, 32767);
+        m_ovlPos += step;
+        m_ovlGain -= m_ovlFadeStep;
+    }
+}
+
+void Audio::playOverlayIdle() { // no source writes to I2S, the overlay is written alone
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    const uint16_t buffFrames = sizeof(m_ovlBuff) / (2 * sizeof(int16_t));
+    uint32_t i2sRate = m_i2s_std_cfg.clk_cfg.sample_rate_hz;
+    int64_t now = esp_timer_get_time();
+    if(!m_ovlT0) {m_ovlT0 = now; m_ovlWritten = 0;}
+    uint32_t due = (uint64_t)(now - m_ovlT0) * i2sRate / 1000000 + (uint32_t)m_ovlLeadMs * i2sRate / 1000;
+    while(m_ovlPcm || m_ovlValid) {
+        if(!m_ovlValid) {
+            if(m_ovlWritten >= due) break;
+            uint16_t n = min((uint32_t)buffFrames, due - m_ovlWritten);
+            memset(m_ovlBuff, 0, n * 2 * sizeof(int16_t));
+            mixOverlay(m_ovlBuff, n, false);
+            m_ovlValid = n;
+            m_ovlOffset = 0;
+        }
+        size_t bytesWritten = 0;
+        esp_err_t err = i2s_channel_write(m_i2s_tx_handle, m_ovlBuff + m_ovlOffset * 2, m_ovlValid * 4, &bytesWritten, 0);
+        m_ovlValid -= bytesWritten / 4;
+        m_ovlOffset += bytesWritten / 4;
+        m_ovlWritten += bytesWritten / 4;
+        if(err != ESP_OK || m_ovlValid) break; // DMA full, the rest goes with the next call
+    }
+    xSemaphoreGive(mutex_audioTask);
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::nextClip() { // the current clip is finished (or nothing is playing), start the next one from the queue
+
+    bool res = false;
+    if(m_clipTag && audio_eof_clip) audio_eof_clip(m_clipTag);
+    x_ps_free(&m_clipTag);
+
+    while(!res && m_clipQueue.size()) {
+        clip_t clip = m_clipQueue.front();
+        m_clipQueue.erase(m_clipQueue.begin());
+        if(clip.fs && m_f_running && m_dataMode == AUDIO_LOCALFILE) {
+            res = switchLocalClip(*clip.fs, clip.path, clip.codec); // gapless
+        }
+        else {
+            if(m_nextFile) m_nextFile.close();
+            if(clip.fs) res = connecttoFS(*clip.fs, clip.path);
+            else        res = connecttohost(clip.path);
+        }
+        if(res) {
+            AUDIO_INFO("Next clip: \"%s\", %u more in queue", clip.path, (unsigned int)m_clipQueue.size());
+            m_clipTag = clip.tag; // is freed when the clip ends
+            clip.tag = NULL;
+        }
+        x_ps_free(&clip.path);
+        x_ps_free(&clip.tag);
+    }
+    return res;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::switchLocalClip(fs::FS& fs, const char* path, uint8_t codec) {
+    // local file -> local file without setDefaults(): I2S keeps running, the InBuffer and the decoder (if the codec
+    // is the same) are reused, reconfigI2S() does nothing if the new clip has the same sample rate
+    File f = m_nextFile ? m_nextFile : fs.open(path); // usually already opened in processLocalFile()
+    m_nextFile = File();
+    if(!f) {printProcessLog(AUDIOLOG_FILE_NOT_FOUND, path); return false;}
+
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    // hand over the tail of the last clip to the I2S DMA; with a full DMA queue that takes as long as the tail plays
+    uint32_t rate = getSampleRate();
+    uint32_t drainMs = (rate ? (uint32_t)m_validSamples * 1000 / rate : 0) + 20;
+    uint32_t t0 = millis();
+    while(m_validSamples && millis() - t0 < drainMs) playChunk();
+    m_validSamples = 0;
+    m_outBuffPos = 0;
+    m_srcValid = 0;
+    audiofile.close();
+    audiofile = f;
+
+    const audioCodec_t* dec = decoder();
+    bool f_reuse = (codec == m_codec) && (codec == CODEC_WAV || (dec && dec->reusable));
+    if(f_reuse) {
+        if(dec && dec->flush) dec->flush();
+    }
+    else {
+        if(dec) dec->deinit();
+    }
+    InBuff.resetBuffer();
+    m_f_firstCall = true;        // InitSequence for processLocalFile
+    m_f_firstCurTimeCall = true; // InitSequence for computeAudioTime
+    m_f_firstPlayCall = true;    // InitSequence for playAudioData
+    m_f_firstSamples = true;     // latency measurement, see audio_first_samples()
+    m_f_playing = false;         // seek for the first syncword, sets the decoder items again
+    m_f_stream = false;
+    m_f_decode_ready = false;
+    m_f_eof = false;
+    m_f_ID3v1TagFound = false;
+    m_f_m4aID3dataAreRead = false;
+    m_controlCounter = 0;
+    m_audioCurrentTime = 0;
+    m_audioFileDuration = 0;
+    m_audioDataStart = 0;
+    m_audioDataSize = 0;
+    m_avr_bitrate = 0;
+    m_bitRate = 0;
+    m_bytesNotDecoded = 0;
+    m_sumBytesDecoded = 0;
+    m_curSample = 0;
+    m_ID3Size = 0;
+    m_haveNewFilePos = 0;
+    m_resumeFilePos = -1;
+    m_fileStartPos = -1;
+    m_M4A_chConfig = 0;
+    m_M4A_objectType = 0;
+    m_M4A_sampleRate = 0;
+    m_fileSize = audiofile.size();
+    xSemaphoreGive(mutex_audioTask);
+
+    if(!f_reuse && !initializeDecoder(codec)) return false; // initializeDecoder() calls stopSong()
+    m_codec = codec;
+    return true;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool Audio::connecttospeech(const char* speech, const char* lang) {
     xSemaphoreTakeRecursive(mutex_playAudioData, 0.3 * configTICK_RATE_HZ);
 
@@ -1377,7 +1708,15 @@ int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
         m_controlCounter = FLAC_OKAY;
         m_audioDataStart = headerSize;
         m_audioDataSize = m_contentlength - m_audioDataStart;
-        FLACSetRawBlockParams(m_flacNumChannels, m_flacSampleRate, m_flacBitsPerSample, m_flacTotalSamplesInStream, m_audioDataSize);
+        if(decoder() && decoder()->setParams) {
+            audioCodecParams_t p = {};
+            p.channels = m_flacNumChannels;
+            p.sampleRate = m_flacSampleRate;
+            p.bitsPerSample = m_flacBitsPerSample;
+            p.totalSamples = m_flacTotalSamplesInStream;
+            p.audioDataLength = m_audioDataSize;
+            decoder()->setParams(&p);
+        }
         if(picLen) {
             size_t pos = audiofile.position();
             if(audio_id3image) audio_id3image(audiofile, picPos, picLen);
@@ -1414,8 +1753,8 @@ int Audio::read_FLAC_Header(uint8_t* data, size_t len) {
         uint8_t bps = (nextval & 0x01) << 4;
         bps += (*(data + 16) >> 4) + 1;
         m_flacBitsPerSample = bps;
-        if((bps != 8) && (bps != 16)) {
-            log_e("bits per sample must be 8 or 16, is %i", bps);
+        if((bps != 8) && (bps != 16) && (bps != 20) && (bps != 24)) { // 20/24 bit are rounded to 16 bit by the decoder
+            log_e("bits per sample must be 8, 16, 20 or 24, is %i", bps);
             stopSong();
             return -1;
         }
@@ -2220,6 +2559,9 @@ uint32_t Audio::stopSong() {
         }
         memset(m_filterBuff, 0, sizeof(m_filterBuff)); // Clear FilterBuffer
         m_validSamples = 0;
+        m_outBuffPos = 0;
+        m_srcValid = 0;
+        m_resampler.reset();
         m_audioCurrentTime = 0;
         m_audioFileDuration = 0;
         m_codec = CODEC_NONE;
@@ -2237,6 +2579,8 @@ bool Audio::pauseResume() {
         if(!m_f_running) {
             memset(m_outBuff, 0, m_outbuffSize * sizeof(int16_t)); // Clear OutputBuffer
             m_validSamples = 0;
+            m_outBuffPos = 0;
+            m_srcValid = 0;
         }
     }
     xSemaphoreGive(mutex_audioTask);
@@ -2246,7 +2590,6 @@ bool Audio::pauseResume() {
 void Audio::playChunk() {
 
     int16_t validSamples = 0;
-    static uint16_t count = 0;
     size_t i2s_bytesConsumed = 0;
     int16_t* sample[2] = {0};
     int16_t* s2;
@@ -2254,7 +2597,7 @@ void Audio::playChunk() {
     esp_err_t err = ESP_OK;
     int i= 0;
 
-    if(count > 0) goto i2swrite;
+    if(m_outBuffPos > 0 || m_srcValid > 0) goto i2swrite;
 
     if(getChannels() == 1){
         for (int i = m_validSamples - 1; i >= 0; --i) {
@@ -2266,6 +2609,7 @@ void Audio::playChunk() {
     }
 
     validSamples = m_validSamples;
+    if(m_f_envelope) publishEnvelope(m_outBuff, m_validSamples); // before EQ and volume
 
     while(validSamples) {
         *sample = m_outBuff + i;
@@ -2292,27 +2636,51 @@ void Audio::playChunk() {
         i += 2;
         validSamples -= 1;
     }
+    if(!m_resampler.isActive()) mixOverlay(m_outBuff, m_validSamples, true); // after the resampler otherwise
     if(audio_process_i2s) {
         // processing the audio samples from external before forwarding them to i2s
         bool continueI2S = false;
         audio_process_i2s((int16_t*)m_outBuff, m_validSamples, 16, 2, &continueI2S);
         if(!continueI2S) {
             m_validSamples = 0;
-            count = 0;
+            m_outBuffPos = 0;
             return;
         }
     }
 
 i2swrite:
 
+    if(m_resampler.isActive()) { // I2S runs at m_outputSampleRate, resample slice by slice
+        // m_validSamples counts the frames of m_outBuff that are not yet written, a slice is released when it is written completely
+        if(!m_srcValid) {
+            m_srcValid = m_resampler.process(m_outBuff + m_outBuffPos, m_validSamples, m_srcBuff, m_srcBuffFrames, &m_srcConsumed);
+            m_srcPos = 0;
+            mixOverlay(m_srcBuff, m_srcValid, true);
+        }
+        if(m_srcValid) {
+            err = i2s_channel_write(m_i2s_tx_handle, m_srcBuff + m_srcPos * 2, m_srcValid * sampleSize, &i2s_bytesConsumed, 10);
+            if( ! (err == ESP_OK || err == ESP_ERR_TIMEOUT)) goto exit;
+            if(m_f_firstSamples && i2s_bytesConsumed) {m_f_firstSamples = false; if(audio_first_samples) audio_first_samples();}
+            m_srcValid -= i2s_bytesConsumed / sampleSize;
+            m_srcPos   += i2s_bytesConsumed / sampleSize;
+        }
+        if(!m_srcValid) {
+            m_validSamples -= m_srcConsumed;
+            m_outBuffPos += m_srcConsumed * 2;
+            if(m_validSamples <= 0) { m_validSamples = 0; m_outBuffPos = 0; }
+        }
+        return;
+    }
+
     validSamples = m_validSamples;
 
-    err = i2s_channel_write(m_i2s_tx_handle, (int16_t*)m_outBuff + count, validSamples * sampleSize, &i2s_bytesConsumed, 10);
+    err = i2s_channel_write(m_i2s_tx_handle, (int16_t*)m_outBuff + m_outBuffPos, validSamples * sampleSize, &i2s_bytesConsumed, 10);
     if( ! (err == ESP_OK || err == ESP_ERR_TIMEOUT)) goto exit;
+    if(m_f_firstSamples && i2s_bytesConsumed) {m_f_firstSamples = false; if(audio_first_samples) audio_first_samples();}
     m_validSamples -= i2s_bytesConsumed / sampleSize;
-    count += i2s_bytesConsumed / 2;
+    m_outBuffPos += i2s_bytesConsumed / 2;
     if(m_validSamples < 0) { m_validSamples = 0; }
-    if(m_validSamples == 0) { count = 0; }
+    if(m_validSamples == 0) { m_outBuffPos = 0; }
 
 // ---- statistics, bytes written to I2S (every 10s)
     // static int cnt = 0;
@@ -2343,6 +2711,8 @@ void Audio::loop() {
         switch(m_dataMode) {
             case AUDIO_LOCALFILE:
                 processLocalFile(); break;
+            case AUDIO_PUSH:
+                processPushStream(); break;
             case HTTP_RESPONSE_HEADER:
                 static uint8_t count = 0;
                 if(!parseHttpResponseHeader()) {
@@ -3070,6 +3440,9 @@ void Audio::processLocalFile() {
     availableBytes = InBuff.writeSpace();
     int32_t bytesAddedToBuffer = audiofile.read(InBuff.getWritePtr(), availableBytes);
     if(bytesAddedToBuffer > 0) {InBuff.bytesWritten(bytesAddedToBuffer);}
+    if(!m_nextFile && m_clipQueue.size() && m_clipQueue[0].fs && audiofile.position() >= m_fileSize) {
+        m_nextFile = m_clipQueue[0].fs->open(m_clipQueue[0].path); // file is completely buffered, open the next clip while this one drains
+    }
     if(!m_f_stream) {
         if(m_codec == CODEC_OGG) { // log_i("determine correct codec here");
             uint8_t codec = determineOggCodec(InBuff.getReadPtr(), maxFrameSize);
@@ -3107,10 +3480,11 @@ void Audio::processLocalFile() {
 
         if(m_codec == CODEC_M4A) {m_resumeFilePos = m4a_correctResumeFilePos(m_resumeFilePos);   if(m_resumeFilePos == -1) goto exit;}
         if(m_codec == CODEC_WAV) {while((m_resumeFilePos % 4) != 0){m_resumeFilePos++; if(m_resumeFilePos >= m_fileSize)   goto exit;}}  // must divisible by four
-        if(m_codec == CODEC_FLAC) {m_resumeFilePos = flac_correctResumeFilePos(m_resumeFilePos); if(m_resumeFilePos == -1) goto exit; FLACDecoderReset();}
-        if(m_codec == CODEC_MP3) { m_resumeFilePos = mp3_correctResumeFilePos(m_resumeFilePos);  if(m_resumeFilePos == -1) goto exit; MP3Decoder_ClearBuffer();}
-        if(m_codec == CODEC_VORBIS){m_resumeFilePos = ogg_correctResumeFilePos(m_resumeFilePos); if(m_resumeFilePos == -1) goto exit; VORBISDecoder_ClearBuffers();}
-        if(m_codec == CODEC_OPUS){m_resumeFilePos = ogg_correctResumeFilePos(m_resumeFilePos);   if(m_resumeFilePos == -1) goto exit; OPUSDecoder_ClearBuffers();}
+        if(m_codec == CODEC_FLAC) {m_resumeFilePos = flac_correctResumeFilePos(m_resumeFilePos); if(m_resumeFilePos == -1) goto exit;}
+        if(m_codec == CODEC_MP3) { m_resumeFilePos = mp3_correctResumeFilePos(m_resumeFilePos);  if(m_resumeFilePos == -1) goto exit;}
+        if(m_codec == CODEC_VORBIS){m_resumeFilePos = ogg_correctResumeFilePos(m_resumeFilePos); if(m_resumeFilePos == -1) goto exit;}
+        if(m_codec == CODEC_OPUS){m_resumeFilePos = ogg_correctResumeFilePos(m_resumeFilePos);   if(m_resumeFilePos == -1) goto exit;}
+        if(decoder() && decoder()->flush) decoder()->flush();
 
         m_f_lockInBuffer = true;                          // lock the buffer, the InBuffer must not be re-entered in playAudioData()
             while(m_f_audioTaskIsDecoding) vTaskDelay(1); // We can't reset the InBuffer while the decoding is in progress
@@ -3118,7 +3492,7 @@ void Audio::processLocalFile() {
             InBuff.resetBuffer();
             m_sumBytesDecoded = m_haveNewFilePos = m_resumeFilePos;
             m_resumeFilePos = -1;
-            if(m_codec == CODEC_MP3) MP3Decoder_ClearBuffer();
+            if(m_codec == CODEC_MP3 && decoder()) decoder()->flush();
         m_f_lockInBuffer = false;
     }
 
@@ -3133,17 +3507,13 @@ void Audio::processLocalFile() {
             return;
         }
         if(m_f_ID3v1TagFound) readID3V1Tag();
+        if(nextClip()) return; // gapless, the next clip from the queue is running
 exit:
         char* afn = NULL;
         if(audiofile) afn = strdup(audiofile.name()); // store temporary the name
         stopSong();
 
-        if(m_codec == CODEC_MP3) MP3Decoder_FreeBuffers();
-        if(m_codec == CODEC_AAC) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_M4A) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_FLAC) FLACDecoder_FreeBuffers();
-        if(m_codec == CODEC_OPUS) OPUSDecoder_FreeBuffers();
-        if(m_codec == CODEC_VORBIS) VORBISDecoder_FreeBuffers();
+        if(decoder()) decoder()->deinit();
 
         m_audioCurrentTime = 0;
         m_audioFileDuration = 0;
@@ -3302,12 +3672,7 @@ void Audio::processWebFile() {
 
         m_f_running = false;
         m_streamType = ST_NONE;
-        if(m_codec == CODEC_MP3) MP3Decoder_FreeBuffers();
-        if(m_codec == CODEC_AAC) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_M4A) AACDecoder_FreeBuffers();
-        if(m_codec == CODEC_FLAC) FLACDecoder_FreeBuffers();
-        if(m_codec == CODEC_OPUS) OPUSDecoder_FreeBuffers();
-        if(m_codec == CODEC_VORBIS) VORBISDecoder_FreeBuffers();
+        if(decoder()) decoder()->deinit();
         m_codec = CODEC_NONE;
         if(m_f_tts) {
             AUDIO_INFO("End of speech \"%s\"", m_speechtxt);
@@ -3318,11 +3683,36 @@ void Audio::processWebFile() {
             AUDIO_INFO("End of webstream: \"%s\"", m_lastHost);
             if(audio_eof_stream) audio_eof_stream(m_lastHost);
         }
+        nextClip();
         return;
     }
     return;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::processPushStream() { // the data is written by pushData(), only start and end are handled here
+    if(m_dataMode != AUDIO_PUSH) return; // guard
+
+    if(!m_f_stream) {
+        uint32_t filled = InBuff.bufferFilled();
+        if(filled > 2 * InBuff.getMaxBlockSize() || (m_f_pushEnd && filled)) {
+            m_f_stream = true; // ready to play the audio data
+            AUDIO_INFO("Pushed stream ready after %lu ms", (long unsigned int)(millis() - m_t0));
+            return;
+        }
+        if(!m_f_pushEnd) return;
+        m_f_eof = true; // nothing was pushed
+    }
+
+    // end of the pushed stream reached? - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    if(m_f_eof) { // set in playAudioData() when the buffer ran empty after pushEnd()
+        m_f_running = false;
+        if(decoder()) decoder()->deinit();
+        m_codec = CODEC_NONE;
+        AUDIO_INFO("End of pushed stream");
+        nextClip();
+    }
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::processWebStreamTS() {
     uint32_t        availableBytes;                          // available bytes in stream
     static bool     f_firstPacket;
@@ -3582,10 +3972,15 @@ void Audio::playAudioData() {
         if(bytesToDecode < InBuff.getMaxBlockSize()) {lastFrame = true;}
         if(m_sumBytesDecoded >= m_audioDataSize && m_sumBytesDecoded != 0) { m_f_eof = true; goto exit; }
     }
-    if(!lastFrame) if(InBuff.bufferFilled() < InBuff.getMaxBlockSize()) goto exit;;
+    if(!lastFrame) if(InBuff.bufferFilled() < InBuff.getMaxBlockSize()) {
+        if(m_dataMode != AUDIO_PUSH || !m_f_pushEnd) goto exit;
+        if(!InBuff.bufferFilled()) {m_f_eof = true; goto exit;} // pushed stream is played out
+        lastFrame = true; // tail of a pushed stream
+    }
 
     bytesDecoded = sendBytes(InBuff.getReadPtr(), InBuff.getMaxBlockSize());
     if(!m_f_running) return;
+    if(m_dataMode == AUDIO_PUSH && lastFrame && bytesDecoded > (int)InBuff.bufferFilled()) bytesDecoded = InBuff.bufferFilled(); // stale bytes behind the tail
 
     if(bytesDecoded < 0) { // no syncword found or decode error, try next chunk
         next = 200;
@@ -3871,86 +4266,30 @@ lastToDo:
 bool Audio::initializeDecoder(uint8_t codec) {
     uint32_t gfH = 0;
     uint32_t hWM = 0;
+    const audioCodec_t* dec = NULL;
     switch(codec) {
-        case CODEC_MP3:
-            if(!MP3Decoder_IsInit()){
-                if(!MP3Decoder_AllocateBuffers()) {
-                    AUDIO_INFO("The MP3Decoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("MP3Decoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeMP3);
-            }
-            break;
-        case CODEC_AAC:
-            if(!AACDecoder_IsInit()) {
-                if(!AACDecoder_AllocateBuffers()) {
-                    AUDIO_INFO("The AACDecoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("AACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-            break;
-        case CODEC_M4A:
-            if(!AACDecoder_IsInit()) {
-                if(!AACDecoder_AllocateBuffers()) {
-                    AUDIO_INFO("The AACDecoder could not be initialized");
-                    goto exit;
-                }
-                gfH = ESP.getFreeHeap();
-                hWM = uxTaskGetStackHighWaterMark(NULL);
-                AUDIO_INFO("AACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-                InBuff.changeMaxBlockSize(m_frameSizeAAC);
-            }
-            break;
-        case CODEC_FLAC:
-            if(!psramFound()) {
-                AUDIO_INFO("FLAC works only with PSRAM!");
-                goto exit;
-            }
-            if(!FLACDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The FLACDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            InBuff.changeMaxBlockSize(m_frameSizeFLAC);
-            AUDIO_INFO("FLACDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            break;
-        case CODEC_OPUS:
-            if(!OPUSDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The OPUSDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            AUDIO_INFO("OPUSDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            InBuff.changeMaxBlockSize(m_frameSizeOPUS);
-            break;
-        case CODEC_VORBIS:
-            if(!psramFound()) {
-                AUDIO_INFO("VORBIS works only with PSRAM!");
-                goto exit;
-            }
-            if(!VORBISDecoder_AllocateBuffers()) {
-                AUDIO_INFO("The VORBISDecoder could not be initialized");
-                goto exit;
-            }
-            gfH = ESP.getFreeHeap();
-            hWM = uxTaskGetStackHighWaterMark(NULL);
-            AUDIO_INFO("VORBISDecoder has been initialized, free Heap: %lu bytes,  free stack %lu DWORDs", (long unsigned int)gfH, (long unsigned int)hWM);
-            InBuff.changeMaxBlockSize(m_frameSizeVORBIS);
-            break;
-        case CODEC_WAV: InBuff.changeMaxBlockSize(m_frameSizeWav); break;
-        case CODEC_OGG: // the decoder will be determined later (vorbis, flac, opus?)
-            break;
-        default: goto exit; break;
+        case CODEC_WAV: InBuff.changeMaxBlockSize(m_frameSizeWav); return true;
+        case CODEC_OGG: return true; // the decoder will be determined later (vorbis, flac, opus?)
+        case CODEC_NONE: goto exit;
+    }
+    dec = audioCodecFind(codec);
+    if(!dec) {
+        AUDIO_INFO("The %s decoder is not part of this build", codec < 10 ? codecname[codec] : "requested");
+        goto exit;
+    }
+    if(dec->isInit && dec->isInit()) return true;
+    if(dec->needsPSRAM && !psramFound()) {
+        AUDIO_INFO("%s works only with PSRAM!", dec->name);
+        goto exit;
+    }
+    if(!dec->init()) {
+        AUDIO_INFO("The %sDecoder could not be initialized", dec->name);
+        goto exit;
     }
+    gfH = ESP.getFreeHeap();
+    hWM = uxTaskGetStackHighWaterMark(NULL);
+    AUDIO_INFO("%sDecoder has been initialized, free Heap: %lu bytes , free stack %lu DWORDs", dec->name, (long unsigned int)gfH, (long unsigned int)hWM);
+    InBuff.changeMaxBlockSize(dec->maxBlockSize);
     return true;
 
 exit:
@@ -3999,6 +4338,11 @@ bool Audio::parseContentType(char* ct) {
     else if(!strcmp(ct, "application/octet-stream"))      ct_val = CT_TXT;  // ??? listen.radionomy.com/1oldies before redirection
     else if(!strcmp(ct, "text/html"))                     ct_val = CT_TXT;
     else if(!strcmp(ct, "text/plain"))                    ct_val = CT_TXT;
+    else if(audioCodecFindByMime(ct)) {                   // registered decoder
+        m_codec = audioCodecFindByMime(ct)->id;
+        if(m_f_Log) { log_i("ContentType %s, format is %s", ct, audioCodecFindByMime(ct)->name); }
+        return true;
+    }
     else if(ct_val == CT_NONE) {
         AUDIO_INFO("ContentType %s not supported", ct);
         return false; // nothing valid had been seen
@@ -4217,16 +4561,11 @@ void Audio::showCodecParams() {
     if(getBitRate()) { AUDIO_INFO("BitRate: %lu", (long unsigned int)getBitRate()); }
     else { AUDIO_INFO("BitRate: N/A"); }
 
-    if(m_codec == CODEC_AAC) {
-        uint8_t answ = AACGetFormat();
-        if(answ < 3) {
-            const char hf[4][8] = {"unknown", "ADIF", "ADTS"};
-            AUDIO_INFO("AAC HeaderFormat: %s", hf[answ])
-        }
-        answ = AACGetSBR();
-        if(answ > 0 && answ < 4) {
-            const char sbr[4][50] = {"without SBR", "upsampled SBR", "downsampled SBR", "no SBR used, but file is upsampled by a factor 2"};
-            AUDIO_INFO("Spectral band replication: %s", sbr[answ]);
+    const audioCodec_t* dec = decoder();
+    if(dec && dec->param) { // e.g. MPEG version and layer, AAC header format and SBR
+        const char* p = NULL;
+        for(uint8_t i = 0; (p = dec->param(i)) != NULL; i++) {
+            if(*p) AUDIO_INFO("%s", p);
         }
     }
 }
@@ -4237,101 +4576,48 @@ int Audio::findNextSync(uint8_t* data, size_t len) {
     // Wav files have no frames
     // Return: 0 the synchronous word was found at position 0
     //         > 0 is the offset to the next sync word
-    //         -1 the sync word was not found within the block with the length len
+    //         len the sync word was not found within the block with the length len
 
     int         nextSync = 0;
-    static uint32_t swnf = 0;
     if(m_codec == CODEC_WAV) {
         m_f_playing = true;
         nextSync = 0;
     }
-    if(m_codec == CODEC_MP3) {
-        nextSync = MP3FindSyncWord(data, len);
-        if(nextSync == -1) return len; // syncword not found, search next block
-    }
-    if(m_codec == CODEC_AAC) { nextSync = AACFindSyncWord(data, len); }
-    if(m_codec == CODEC_M4A) {
+    else if(m_codec == CODEC_M4A) {
         if(!m_M4A_chConfig)m_M4A_chConfig = 2; // guard
         if(!m_M4A_sampleRate)m_M4A_sampleRate = 44100;
         if(!m_M4A_objectType)m_M4A_objectType = 2;
-        AACSetRawBlockParams(m_M4A_chConfig, m_M4A_sampleRate, m_M4A_objectType);
+        if(decoder() && decoder()->setParams) {
+            audioCodecParams_t p = {};
+            p.channels = m_M4A_chConfig;
+            p.sampleRate = m_M4A_sampleRate;
+            p.objectType = m_M4A_objectType;
+            decoder()->setParams(&p);
+        }
         m_f_playing = true;
         nextSync = 0;
     }
-    if(m_codec == CODEC_FLAC) {
-        nextSync = FLACFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
-    }
-    if(m_codec == CODEC_OPUS) {
-        nextSync = OPUSFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
-    }
-    if(m_codec == CODEC_VORBIS) {
-        nextSync = VORBISFindSyncWord(data, len);
-        if(nextSync == -1) return len; // OggS not found, search next block
-    }
-    if(nextSync == -1) {
-        if(audio_info && swnf == 0) audio_info("syncword not found");
-        else {
-            swnf++; // syncword not found counter, can be multimediadata
-        }
+    else if(decoder()) {
+        nextSync = decoder()->probe(data, len);
+        if(nextSync == -1) return len; // syncword or OggS not found, search next block
     }
     if(nextSync == 0) {
-        if(audio_info && swnf > 0) {
-            sprintf(m_chbuf, "syncword not found %lu times", (long unsigned int)swnf);
-            audio_info(m_chbuf);
-            swnf = 0;
-        }
-        else {
-            if(audio_info) audio_info("syncword found at pos 0");
-            m_f_decode_ready = true;
-        }
+        if(audio_info) audio_info("syncword found at pos 0");
+        m_f_decode_ready = true;
     }
     if(nextSync > 0) { AUDIO_INFO("syncword found at pos %i", nextSync); }
     return nextSync;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::setDecoderItems() {
-    if(m_codec == CODEC_MP3) {
-        setChannels(MP3GetChannels());
-        setSampleRate(MP3GetSampRate());
-        setBitsPerSample(MP3GetBitsPerSample());
-        setBitrate(MP3GetBitrate());
-        AUDIO_INFO("MPEG-%s, Layer %s",(MP3GetVersion()==0) ? "2.5" : (MP3GetVersion()==2) ? "2" : "1", (MP3GetLayer()==1) ? "III" : (MP3GetLayer()==2) ? "II" : "I");
-    }
-    if(m_codec == CODEC_AAC || m_codec == CODEC_M4A) {
-        setChannels(AACGetChannels());
-        setSampleRate(AACGetSampRate());
-        setBitsPerSample(AACGetBitsPerSample());
-        setBitrate(AACGetBitrate());
-    }
-    if(m_codec == CODEC_FLAC) {
-        setChannels(FLACGetChannels());
-        setSampleRate(FLACGetSampRate());
-        setBitsPerSample(FLACGetBitsPerSample());
-        setBitrate(FLACGetBitRate());
-        if(FLACGetAudioDataStart() > 0){ // only flac-ogg, native flac sets audioDataStart in readFlacHeader()
-            m_audioDataStart = FLACGetAudioDataStart();
-            if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
-        }
-    }
-    if(m_codec == CODEC_OPUS) {
-        setChannels(OPUSGetChannels());
-        setSampleRate(OPUSGetSampRate());
-        setBitsPerSample(OPUSGetBitsPerSample());
-        setBitrate(OPUSGetBitRate());
-        if(OPUSGetAudioDataStart() > 0){
-            m_audioDataStart = OPUSGetAudioDataStart();
-            if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
-        }
-    }
-    if(m_codec == CODEC_VORBIS) {
-        setChannels(VORBISGetChannels());
-        setSampleRate(VORBISGetSampRate());
-        setBitsPerSample(VORBISGetBitsPerSample());
-        setBitrate(VORBISGetBitRate());
-        if(VORBISGetAudioDataStart() > 0){
-            m_audioDataStart = VORBISGetAudioDataStart();
+    const audioCodec_t* dec = decoder();
+    if(dec) {
+        setChannels(dec->channels());
+        setSampleRate(dec->sampleRate());
+        setBitsPerSample(dec->bitsPerSample());
+        setBitrate(dec->bitRate());
+        if(dec->audioDataStart && dec->audioDataStart() > 0){ // only ogg, native flac sets audioDataStart in readFlacHeader()
+            m_audioDataStart = dec->audioDataStart();
             if(getFileSize()) m_audioDataSize = getFileSize() - m_audioDataStart;
         }
     }
@@ -4367,44 +4653,33 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
     if(m_codec == CODEC_NONE && m_playlistFormat == FORMAT_M3U8) return 0; // can happen when the m3u8 playlist is loaded
     if(!m_f_decode_ready) return 0; // find sync first
 
-    switch(m_codec) {
-        case CODEC_WAV:  m_decodeError = 0; bytesLeft = 0; break;
-        case CODEC_MP3:  m_decodeError = MP3Decode(data, &bytesLeft, m_outBuff, 0); break;
-        case CODEC_AAC:  m_decodeError = AACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_M4A:  m_decodeError = AACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_FLAC: m_decodeError = FLACDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_OPUS: m_decodeError = OPUSDecode(data, &bytesLeft, m_outBuff); break;
-        case CODEC_VORBIS: m_decodeError = VORBISDecode(data, &bytesLeft, m_outBuff); break;
-        default: {
-            log_e("no valid codec found codec = %d", m_codec);
-            stopSong();
-        }
+    const audioCodec_t* dec = decoder();
+    if(m_codec == CODEC_WAV) {m_decodeError = 0; bytesLeft = 0;}
+    else if(dec) {
+        uint32_t t0 = micros();
+        m_decodeError = dec->decode(data, &bytesLeft, m_outBuff);
+        uint32_t us = micros() - t0;
+        m_decodeUsSum += us;
+        if(us > m_decodeUsMax) m_decodeUsMax = us;
+        m_decodeCalls++;
+    }
+    else {
+        log_e("no valid codec found codec = %d", m_codec);
+        stopSong();
+        return 0;
     }
 
     // m_decodeError - possible values are:
     //                   0: okay, no error
-    //                 100: the decoder needs more data
+    //                 100: the decoder needs more data (AUDIO_CODEC_NO_OUTPUT)
     //                 < 0: there has been an error
 
     if(m_decodeError < 0) { // Error, skip the frame...
 
         printDecodeError(m_decodeError);
         m_f_playing = false; // seek for new syncword
-        if(m_codec == CODEC_FLAC) {
-        //    if(m_decodeError == ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG) stopSong();
-        //    if(m_decodeError == ERR_FLAC_RESERVED_CHANNEL_ASSIGNMENT) stopSong();
-        }
-        if(m_codec == CODEC_OPUS) {
-            if(m_decodeError == ERR_OPUS_HYBRID_MODE_UNSUPPORTED) stopSong();
-            if(m_decodeError == ERR_OPUS_SILK_MODE_UNSUPPORTED) stopSong();
-            if(m_decodeError == ERR_OPUS_NARROW_BAND_UNSUPPORTED) stopSong();
-            if(m_decodeError == ERR_OPUS_WIDE_BAND_UNSUPPORTED) stopSong();
-            if(m_decodeError == ERR_OPUS_SUPER_WIDE_BAND_UNSUPPORTED) stopSong();
-            if(m_decodeError == ERR_OPUS_INVALID_SAMPLERATE) stopSong();
-            return 0;
-        }
-
-        return 1; // skip one byte and seek for the next sync word
+        if(dec->isFatal && dec->isFatal(m_decodeError)) stopSong();
+        return dec->resyncSkip; // skip one byte (ogg: none) and seek for the next sync word
     }
     bytesDecoded = len - bytesLeft;
 
@@ -4417,81 +4692,39 @@ int Audio::sendBytes(uint8_t* data, size_t len) {
     // status: bytesDecoded > 0 and m_decodeError >= 0
     char* st = NULL;
     std::vector<uint32_t> vec;
-    switch(m_codec) {
-        case CODEC_WAV:     if(getBitsPerSample() == 16){
-                                memmove(m_outBuff, data, len); // copy len data in outbuff and set validsamples and bytesdecoded=len
-                                m_validSamples = len / (2 * getChannels());
-                            }
-                            else{
-                                for(int i = 0; i < len; i++) {
-                                    int16_t sample1 = (data[i] & 0x00FF)      - 128;
-                                    int16_t sample2 = (data[i] & 0xFF00 >> 8) - 128;
-                                    m_outBuff[i * 2 + 0] = sample1 << 8;
-                                    m_outBuff[i * 2 + 1] = sample2 << 8;
-                                }
-                                m_validSamples = len;
-                            }
-                            break;
-        case CODEC_MP3:     m_validSamples = MP3GetOutputSamps() / getChannels();
-                            break;
-        case CODEC_AAC:     m_validSamples = AACGetOutputSamps() / getChannels();
-                            static uint8_t isPS = 0;
-                            if(!isPS && AACGetParametricStereo()){ // only change 0 -> 1
-                                isPS = 1;
-                                AUDIO_INFO("Parametric Stereo");
-                            }
-                            else isPS = AACGetParametricStereo();
-                            break;
-        case CODEC_M4A:     m_validSamples = AACGetOutputSamps() / getChannels();
-                            break;
-        case CODEC_FLAC:    if(m_decodeError == FLAC_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = FLACGetOutputSamps() / getChannels();
-                            st = FLACgetStreamTitle();
-                            if(st) {
-                                AUDIO_INFO(st);
-                                if(audio_showstreamtitle) audio_showstreamtitle(st);
-                            }
-                            vec = FLACgetMetadataBlockPicture();
-                            if(vec.size() > 0){ // get blockpic data
-                                // log_i("---------------------------------------------------------------------------");
-                                // log_i("ogg metadata blockpicture found:");
-                                // for(int i = 0; i < vec.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, vec[i], vec[i + 1]); }
-                                // log_i("---------------------------------------------------------------------------");
-                                if(audio_oggimage) audio_oggimage(audiofile, vec);
-                            }
-                            break;
-        case CODEC_OPUS:    if(m_decodeError == OPUS_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = OPUSGetOutputSamps();
-                            st = OPUSgetStreamTitle();
-                            if(st){
-                                AUDIO_INFO(st);
-                                if(audio_showstreamtitle) audio_showstreamtitle(st);
-                            }
-                            vec = OPUSgetMetadataBlockPicture();
-                            if(vec.size() > 0){ // get blockpic data
-                                // log_i("---------------------------------------------------------------------------");
-                                // log_i("ogg metadata blockpicture found:");
-                                // for(int i = 0; i < vec.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, vec[i], vec[i + 1]); }
-                                // log_i("---------------------------------------------------------------------------");
-                                if(audio_oggimage) audio_oggimage(audiofile, vec);
-                            }
-                            break;
-        case CODEC_VORBIS:  if(m_decodeError == VORBIS_PARSE_OGG_DONE) return bytesDecoded; // nothing to play
-                            m_validSamples = VORBISGetOutputSamps();
-                            st = VORBISgetStreamTitle();
-                            if(st) {
-                                AUDIO_INFO(st);
-                                if(audio_showstreamtitle) audio_showstreamtitle(st);
-                            }
-                            vec = VORBISgetMetadataBlockPicture();
-                            if(vec.size() > 0){ // get blockpic data
-                                // log_i("---------------------------------------------------------------------------");
-                                // log_i("ogg metadata blockpicture found:");
-                                // for(int i = 0; i < vec.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, vec[i], vec[i + 1]); }
-                                // log_i("---------------------------------------------------------------------------");
-                                if(audio_oggimage) audio_oggimage(audiofile, vec);
-                            }
-                            break;
+    if(m_codec == CODEC_WAV) {
+        if(getBitsPerSample() == 16){
+            memmove(m_outBuff, data, len); // copy len data in outbuff and set validsamples and bytesdecoded=len
+            m_validSamples = len / (2 * getChannels());
+        }
+        else{
+            for(int i = 0; i < len; i++) {
+                int16_t sample1 = (data[i] & 0x00FF)      - 128;
+                int16_t sample2 = (data[i] & 0xFF00 >> 8) - 128;
+                m_outBuff[i * 2 + 0] = sample1 << 8;
+                m_outBuff[i * 2 + 1] = sample2 << 8;
+            }
+            m_validSamples = len;
+        }
+    }
+    else {
+        if(m_decodeError == AUDIO_CODEC_NO_OUTPUT) return bytesDecoded; // ogg header, nothing to play
+        m_validSamples = dec->outputFrames();
+        const char* notice = dec->notice ? dec->notice() : NULL; // e.g. AAC "Parametric Stereo"
+        if(notice) AUDIO_INFO("%s", notice);
+        st = dec->streamTitle ? dec->streamTitle() : NULL;
+        if(st) {
+            AUDIO_INFO(st);
+            if(audio_showstreamtitle) audio_showstreamtitle(st);
+        }
+        if(dec->metadataPicture) vec = dec->metadataPicture();
+        if(vec.size() > 0){ // get blockpic data
+            // log_i("---------------------------------------------------------------------------");
+            // log_i("ogg metadata blockpicture found:");
+            // for(int i = 0; i < vec.size(); i += 2) { log_i("segment %02i, pos %07i, len %05i", i / 2, vec[i], vec[i + 1]); }
+            // log_i("---------------------------------------------------------------------------");
+            if(audio_oggimage) audio_oggimage(audiofile, vec);
+        }
     }
     if(f_setDecodeParamsOnce && m_validSamples) {
         f_setDecodeParamsOnce = false;
@@ -4531,9 +4764,10 @@ void Audio::computeAudioTime(uint16_t bytesDecoderIn, uint16_t bytesDecoderOut)
         deltaBytesIn = 0;
         nominalBitRate = 0;
 
-        if(m_codec == CODEC_FLAC && FLACGetAudioFileDuration()){
-            m_audioFileDuration = FLACGetAudioFileDuration();
-            nominalBitRate = (m_audioDataSize / FLACGetAudioFileDuration()) * 8;
+        const audioCodec_t* dec = decoder();
+        if(dec && dec->duration && dec->duration()){
+            m_audioFileDuration = dec->duration();
+            nominalBitRate = (m_audioDataSize / m_audioFileDuration) * 8;
             m_avr_bitrate = nominalBitRate;
         }
         if(m_codec == CODEC_WAV){
@@ -4602,92 +4836,10 @@ void Audio::computeAudioTime(uint16_t bytesDecoderIn, uint16_t bytesDecoderOut)
  }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::printDecodeError(int r) {
-    const char* e;
-
-    if(m_codec == CODEC_MP3) {
-        switch(r) {
-            case ERR_MP3_NONE: e = "NONE"; break;
-            case ERR_MP3_INDATA_UNDERFLOW: e = "INDATA_UNDERFLOW"; break;
-            case ERR_MP3_MAINDATA_UNDERFLOW: e = "MAINDATA_UNDERFLOW"; break;
-            case ERR_MP3_FREE_BITRATE_SYNC: e = "FREE_BITRATE_SYNC"; break;
-            case ERR_MP3_OUT_OF_MEMORY: e = "OUT_OF_MEMORY"; break;
-            case ERR_MP3_NULL_POINTER: e = "NULL_POINTER"; break;
-            case ERR_MP3_INVALID_FRAMEHEADER: e = "INVALID_FRAMEHEADER"; break;
-            case ERR_MP3_INVALID_SIDEINFO: e = "INVALID_SIDEINFO"; break;
-            case ERR_MP3_INVALID_SCALEFACT: e = "INVALID_SCALEFACT"; break;
-            case ERR_MP3_INVALID_HUFFCODES: e = "INVALID_HUFFCODES"; break;
-            case ERR_MP3_INVALID_DEQUANTIZE: e = "INVALID_DEQUANTIZE"; break;
-            case ERR_MP3_INVALID_IMDCT: e = "INVALID_IMDCT"; break;
-            case ERR_MP3_INVALID_SUBBAND: e = "INVALID_SUBBAND"; break;
-            default: e = "ERR_UNKNOWN";
-        }
-        AUDIO_INFO("MP3 decode error %d : %s", r, e);
-    }
-    if(m_codec == CODEC_AAC || m_codec == CODEC_M4A) {
-        e = AACGetErrorMessage(abs(r));
-        AUDIO_INFO("AAC decode error %d : %s", r, e);
-    }
-    if(m_codec == CODEC_FLAC) {
-        switch(r) {
-            case ERR_FLAC_NONE: e = "NONE"; break;
-            case ERR_FLAC_BLOCKSIZE_TOO_BIG: e = "BLOCKSIZE TOO BIG"; break;
-            case ERR_FLAC_RESERVED_BLOCKSIZE_UNSUPPORTED: e = "Reserved Blocksize unsupported"; break;
-            case ERR_FLAC_SYNC_CODE_NOT_FOUND: e = "SYNC CODE NOT FOUND"; break;
-            case ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT: e = "UNKNOWN CHANNEL ASSIGNMENT"; break;
-            case ERR_FLAC_RESERVED_CHANNEL_ASSIGNMENT: e = "RESERVED CHANNEL ASSIGNMENT"; break;
-            case ERR_FLAC_RESERVED_SUB_TYPE: e = "RESERVED SUB TYPE"; break;
-            case ERR_FLAC_PREORDER_TOO_BIG: e = "PREORDER TOO BIG"; break;
-            case ERR_FLAC_RESERVED_RESIDUAL_CODING: e = "RESERVED RESIDUAL CODING"; break;
-            case ERR_FLAC_WRONG_RICE_PARTITION_NR: e = "WRONG RICE PARTITION NR"; break;
-            case ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG: e = "BITS PER SAMPLE > 16"; break;
-            case ERR_FLAC_BITS_PER_SAMPLE_UNKNOWN: e = "BITS PER SAMPLE UNKNOWN"; break;
-            case ERR_FLAC_DECODER_ASYNC: e = "DECODER ASYNCHRON"; break;
-            case ERR_FLAC_BITREADER_UNDERFLOW: e = "BITREADER ERROR"; break;
-            case ERR_FLAC_OUTBUFFER_TOO_SMALL: e = "OUTBUFFER TOO SMALL"; break;
-            default: e = "ERR_UNKNOWN";
-        }
-        AUDIO_INFO("FLAC decode error %d : %s", r, e);
-    }
-    if(m_codec == CODEC_OPUS) {
-        switch(r) {
-            case ERR_OPUS_NONE: e = "NONE"; break;
-            case ERR_OPUS_CHANNELS_OUT_OF_RANGE: e = "UNKNOWN CHANNEL ASSIGNMENT"; break;
-            case ERR_OPUS_INVALID_SAMPLERATE: e = "SAMPLERATE IS NOT 48000Hz"; break;
-            case ERR_OPUS_EXTRA_CHANNELS_UNSUPPORTED: e = "EXTRA CHANNELS UNSUPPORTED"; break;
-            case ERR_OPUS_SILK_MODE_UNSUPPORTED: e = "SILK MODE UNSUPPORTED"; break;
-            case ERR_OPUS_HYBRID_MODE_UNSUPPORTED: e = "HYBRID MODE UNSUPPORTED"; break;
-            case ERR_OPUS_NARROW_BAND_UNSUPPORTED: e = "NARROW_BAND_UNSUPPORTED"; break;
-            case ERR_OPUS_WIDE_BAND_UNSUPPORTED: e = "WIDE_BAND_UNSUPPORTED"; break;
-            case ERR_OPUS_SUPER_WIDE_BAND_UNSUPPORTED: e = "SUPER_WIDE_BAND_UNSUPPORTED"; break;
-            case ERR_OPUS_CELT_BAD_ARG: e = "CELT_DECODER_BAD_ARG"; break;
-            case ERR_OPUS_CELT_INTERNAL_ERROR: e = "CELT DECODER INTERNAL ERROR"; break;
-            case ERR_OPUS_CELT_UNIMPLEMENTED: e = "CELT DECODER UNIMPLEMENTED ARG"; break;
-            case ERR_OPUS_CELT_ALLOC_FAIL: e = "CELT DECODER INIT ALLOC FAIL"; break;
-            case ERR_OPUS_CELT_UNKNOWN_REQUEST: e = "CELT_UNKNOWN_REQUEST FAIL"; break;
-            case ERR_OPUS_CELT_GET_MODE_REQUEST: e = "CELT_GET_MODE_REQUEST FAIL"; break;
-            case ERR_OPUS_CELT_CLEAR_REQUEST: e = "CELT_CLEAR_REAUEST_FAIL"; break;
-            case ERR_OPUS_CELT_SET_CHANNELS: e = "CELT_SET_CHANNELS_FAIL"; break;
-            case ERR_OPUS_CELT_END_BAND: e = "CELT_END_BAND_REQUEST_FAIL"; break;
-            case ERR_CELT_OPUS_INTERNAL_ERROR: e = "CELT_INTERNAL_ERROR"; break;
-            default: e = "ERR_UNKNOWN";
-        }
-        AUDIO_INFO("OPUS decode error %d : %s", r, e);
-    }
-    if(m_codec == CODEC_VORBIS) {
-        switch(r) {
-            case ERR_VORBIS_NONE: e = "NONE"; break;
-            case ERR_VORBIS_CHANNELS_OUT_OF_RANGE: e = "CHANNELS OUT OF RANGE"; break;
-            case ERR_VORBIS_INVALID_SAMPLERATE: e = "INVALID SAMPLERATE"; break;
-            case ERR_VORBIS_EXTRA_CHANNELS_UNSUPPORTED: e = "EXTRA CHANNELS UNSUPPORTED"; break;
-            case ERR_VORBIS_DECODER_ASYNC: e = "DECODER ASYNC"; break;
-            case ERR_VORBIS_OGG_SYNC_NOT_FOUND: e = "SYNC NOT FOUND"; break;
-            case ERR_VORBIS_BAD_HEADER: e = "BAD HEADER"; break;
-            case ERR_VORBIS_NOT_AUDIO: e = "NOT AUDIO"; break;
-            case ERR_VORBIS_BAD_PACKET: e = "BAD PACKET"; break;
-            default: e = "ERR_UNKNOWN";
-        }
-        AUDIO_INFO("VORBIS decode error %d : %s", r, e);
-    }
+    const audioCodec_t* dec = decoder();
+    if(!dec) return;
+    const char* e = dec->errorString ? dec->errorString(r) : NULL;
+    AUDIO_INFO("%s decode error %d : %s", dec->name, r, e ? e : "ERR_UNKNOWN");
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 bool Audio::setPinout(uint8_t BCLK, uint8_t LRC, uint8_t DOUT, int8_t MCLK) {
@@ -4816,6 +4968,7 @@ bool Audio::setFilePos(uint32_t pos) {
     if(m_codec == CODEC_AAC) return false;   // not impl. yet
     memset(m_outBuff, 0, m_outbuffSize * sizeof(int16_t));
     m_validSamples = 0;
+    m_outBuffPos = 0;
     m_haveNewFilePos = pos; // used in computeAudioCurrentTime()
     if(m_dataMode == AUDIO_LOCALFILE){
         m_resumeFilePos = pos;  // used in processLocalFile()
@@ -4856,10 +5009,24 @@ uint8_t Audio::getChannels() {
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::reconfigI2S(){
 
+    uint32_t sampleRate = getSampleRate();
+    if(getBitsPerSample() == 8 && getChannels() == 2) sampleRate *= 2;
+    if(m_outputSampleRate) { // fixed I2S clock, the resampler converts the source rate
+        bool res = true;
+        if(sampleRate != m_resampler.getInRate() || m_outputSampleRate != m_resampler.getOutRate()) {
+            res = m_resampler.init(sampleRate, m_outputSampleRate, 2, m_srcQuality);
+            if(res) AUDIO_INFO("resampling %lu Hz -> %lu Hz", (long unsigned int)sampleRate, (long unsigned int)m_outputSampleRate);
+            else    log_e("resampler could not be initialized, I2S follows the source");
+            memset(m_filterBuff, 0, sizeof(m_filterBuff)); // Clear FilterBuffer
+            IIR_calculateCoefficients(m_gain0, m_gain1, m_gain2); // the filters run at the source samplerate
+        }
+        if(res) sampleRate = m_outputSampleRate;
+    }
+    if(sampleRate == m_i2s_std_cfg.clk_cfg.sample_rate_hz) return; // nothing to do, I2S keeps running (gapless clips)
+
     I2Sstop(0);
 
-    if(getBitsPerSample() == 8 && getChannels() == 2) m_i2s_std_cfg.clk_cfg.sample_rate_hz = getSampleRate() * 2;
-    else m_i2s_std_cfg.clk_cfg.sample_rate_hz = getSampleRate();
+    m_i2s_std_cfg.clk_cfg.sample_rate_hz = sampleRate;
 
     if(!m_f_commFMT) m_i2s_std_cfg.slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO);
     else             m_i2s_std_cfg.slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO);
@@ -4886,6 +5053,27 @@ uint32_t Audio::getBitRate(bool avg) {
     return m_bitRate;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::setOutputSampleRate(uint32_t hz, uint8_t quality) {
+    // hz > 0: the I2S clock is set once to hz, all sources are converted by the polyphase resampler, a change of the
+    //         source samplerate no longer stops I2S (no DMA flush, no click)
+    // hz = 0: I2S follows the samplerate of the source (default)
+    if(hz && (hz < 8000 || hz > 96000)) {log_e("output samplerate %lu Hz is out of range", (long unsigned int)hz); return false;}
+
+    xSemaphoreTake(mutex_audioTask, 0.3 * configTICK_RATE_HZ);
+    if(hz && !m_srcBuff) m_srcBuff = (int16_t*)x_ps_malloc(m_srcBuffFrames * 2 * sizeof(int16_t));
+    bool res = (!hz || m_srcBuff);
+    if(res) {
+        m_outputSampleRate = hz;
+        m_srcQuality = quality;
+        m_srcValid = 0;
+        m_resampler.deinit(); // will be set up in reconfigI2S()
+        if(!hz) x_ps_free(&m_srcBuff);
+        reconfigI2S();
+    }
+    xSemaphoreGive(mutex_audioTask);
+    return res;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void Audio::setI2SCommFMT_LSB(bool commFMT) {
     // false: I2S communication format is by default I2S_COMM_FORMAT_I2S_MSB, right->left (AC101, PCM5102A)
     // true:  changed to I2S_COMM_FORMAT_I2S_LSB for some DACs (PT8211)
@@ -4968,6 +5156,63 @@ void Audio::computeVUlevel(int16_t sample[2]) {
     cnt1++;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void Audio::publishEnvelope(const int16_t* buff, uint16_t frames) {
+    // one block per ~10ms of a fresh m_outBuff (interleaved L/R at the source rate). A block leaves the DAC when
+    // everything published before it has played, or now if the DMA ran dry; while the DMA queue is full the
+    // cursor runs ahead of the clock by its length, so the stamps include the I2S latency
+    uint32_t rate = getSampleRate();
+    if(!rate || !frames) return;
+    int64_t now = esp_timer_get_time();
+    if(m_envCursorUs < now) m_envCursorUs = now;
+    uint16_t block = rate / 100;
+    for(uint16_t pos = 0; pos < frames; pos += block) {
+        uint16_t n = min((uint16_t)(frames - pos), block);
+        const int16_t* s = buff + 2 * pos;
+        int64_t sq = 0;
+        uint16_t zc = 0;
+        int32_t prev = ((int32_t)s[0] + s[1]) >> 1;
+        for(int i = 0; i < n; i++) {
+            int32_t m = ((int32_t)s[2 * i] + s[2 * i + 1]) >> 1;
+            sq += m * m;
+            zc += (m ^ prev) < 0;
+            prev = m;
+        }
+        float db = sq > 0 ? 10.0f * log10f((float)sq / n / (32768.0f * 32768.0f)) : -96.0f;
+        int32_t level = (int32_t)((db + 60.0f) * 255.0f / 60.0f);
+        level = level < 0 ? 0 : (level > 255 ? 255 : level);
+        uint32_t zcr = (uint32_t)zc * rate / n;    // zero crossings per second, hiss is above 3k
+        uint8_t viseme = level < 85 ? VISEME_REST : zcr > 3000 ? VISEME_NARROW : level < 153 ? VISEME_MID : VISEME_OPEN;
+
+        uint32_t head = m_envHead.load(std::memory_order_relaxed);
+        envFrame_t& f = m_env[head & (m_envFrames - 1)];
+        f.startMs = (uint32_t)(m_envCursorUs / 1000);
+        f.lenMs = (uint8_t)((n * 1000 + rate - 1) / rate);
+        f.level = (uint8_t)level;
+        f.viseme = viseme;
+        m_envHead.store(head + 1, std::memory_order_release);
+        m_envCursorUs += (int64_t)n * 1000000 / rate;
+    }
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool Audio::getEnvelope(uint32_t atMs, uint8_t* level, uint8_t* viseme) {
+    // newest first, the latest block that has started at atMs; the writer may reuse a slot while it is copied,
+    // so the head is read again after the copy
+    uint32_t head = m_envHead.load(std::memory_order_acquire);
+    for(uint32_t k = 1; k <= head && k < m_envFrames; k++) {
+        uint32_t idx = head - k;
+        envFrame_t f = m_env[idx & (m_envFrames - 1)];
+        if(m_envHead.load(std::memory_order_acquire) - idx >= m_envFrames) break;
+        if((int32_t)(atMs - f.startMs) < 0) continue;                       // still in the DMA queue
+        bool playing = (int32_t)(atMs - f.startMs) < f.lenMs;
+        if(level) *level = playing ? f.level : 0;
+        if(viseme) *viseme = playing ? f.viseme : VISEME_REST;
+        return playing;
+    }
+    if(level) *level = 0;
+    if(viseme) *viseme = VISEME_REST;
+    return false;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 uint16_t Audio::getVUlevel() {
     // avg 0 ... 127
     if(!m_f_running) return 0;
@@ -6124,7 +6369,7 @@ int32_t Audio::mp3_correctResumeFilePos(uint32_t resumeFilePos) {
             uint32_t bitrate = ((int32_t) bitrateTab[mpegVers][layer - 1][brIdx]) * 1000;
             uint32_t samplerate = samplerateTab[mpegVers][srIdx];
         //    log_e("%02X, %02X bitrate %i, samplerate %i", syncH, syncL, bitrate, samplerate);
-            if(MP3GetBitrate() == bitrate && getSampleRate() == samplerate) break;
+            if(decoder()->bitRate() == bitrate && getSampleRate() == samplerate) break;
         }
         pos++;
     }
@@ -6210,6 +6455,7 @@ void Audio::audioTask() {
 }
 
 void Audio::performAudioTask() {
+    if(m_ovlPcm && (!m_f_running || m_f_firstSamples) && !m_validSamples && !m_srcValid) playOverlayIdle(); // no source samples out yet
     if(!m_f_running) return;
     if(!m_f_stream) return;
     if(m_codec == CODEC_NONE) return; // wait for codec is  set
@@ -6223,3 +6469,11 @@ uint32_t Audio::getHighWatermark(){
     UBaseType_t highWaterMark = uxTaskGetStackHighWaterMark(m_audioTaskHandle);
     return highWaterMark; // dwords
 }
+void Audio::getDecodeTime(uint32_t* avgUs, uint32_t* maxUs){ // written by the audio task, a torn window is harmless
+    uint32_t calls = m_decodeCalls;
+    if(avgUs) *avgUs = calls ? m_decodeUsSum / calls : 0;
+    if(maxUs) *maxUs = m_decodeUsMax;
+    m_decodeUsSum = 0;
+    m_decodeUsMax = 0;
+    m_decodeCalls = 0;
+}
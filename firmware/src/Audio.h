@@ -26,6 +26,8 @@
 #include <atomic>
 #include <codecvt>
 #include <locale>
+#include "resampler/resampler.h"
+#include "audio_codec/audio_codec.h"
 
 #if ESP_ARDUINO_VERSION_MAJOR >= 3
 #include <NetworkClient.h>
@@ -59,6 +61,8 @@ extern __attribute__((weak)) void audio_icydescription(const char*);
 extern __attribute__((weak)) void audio_lasthost(const char*);
 extern __attribute__((weak)) void audio_eof_speech(const char*);
 extern __attribute__((weak)) void audio_eof_stream(const char*); // The webstream comes to an end
+extern __attribute__((weak)) void audio_eof_clip(const char*); // end of a queued clip, returns the tag given in enqueueFS/enqueueHost
+extern __attribute__((weak)) void audio_first_samples(); // the first samples of a new source or queued clip were written to I2S
 extern __attribute__((weak)) void audio_process_i2s(int16_t* outBuff, uint16_t validSamples, uint8_t bitsPerSample, uint8_t channels, bool *continueI2S); // record audiodata or send via BT
 extern __attribute__((weak)) void audio_log(uint8_t logLevel, const char* msg, const char* arg);
 
@@ -149,6 +153,14 @@ public:
     bool connecttohost(const char* host, const char* user = "", const char* pwd = "");
     bool connecttospeech(const char* speech, const char* lang);
     bool connecttoFS(fs::FS &fs, const char* path, int32_t m_fileStartPos = -1);
+    bool enqueueFS(fs::FS &fs, const char* path, const char* tag = NULL); // gapless clip queue, starts at once if idle
+    bool enqueueHost(const char* host, const char* tag = NULL);
+    void clearQueue();
+    bool connecttoPush(const char* format = "mp3");            // the encoded stream comes from pushData(), e.g. a TTS websocket
+    size_t pushData(const uint8_t* data, size_t len);           // any task, copies what fits, 0 if full or not pushing
+    size_t pushSpace();                                         // free bytes in the input buffer
+    void pushEnd();                                             // no more data, the buffered rest is played out
+    uint8_t getQueueSize() {return m_clipQueue.size();}
     bool setFileLoop(bool input);//TEST loop
     void setConnectionTimeout(uint16_t timeout_ms, uint16_t timeout_ms_ssl);
     bool setAudioPlayPosition(uint16_t sec);
@@ -184,8 +196,18 @@ public:
     uint32_t inBufferSize();   // returns the size of the inputbuffer in bytes
     void setTone(int8_t gainLowPass, int8_t gainBandPass, int8_t gainHighPass);
     void setI2SCommFMT_LSB(bool commFMT);
+    bool setOutputSampleRate(uint32_t hz, uint8_t quality = SRC_QUALITY_MEDIUM); // fixed I2S rate for all sources, 0: I2S follows the source
+    uint32_t getOutputSampleRate() {return m_outputSampleRate;}
+    bool playOverlay(const int16_t* pcm, uint32_t frames, uint32_t sampleRate); // resident mono PCM over the sources, not copied
+    void fadeOverlay(uint16_t ms);                              // fade out and end
+    void stopOverlay();                                         // end at once
+    bool isOverlayRunning() {return m_ovlPcm != NULL;}
+    // Envelope for lip sync: level and mouth shape per ~10ms of output, stamped with the millis() it is audible
+    enum : uint8_t { VISEME_REST = 0, VISEME_NARROW = 1, VISEME_MID = 2, VISEME_OPEN = 3 }; // closed, s/f/sh, e/o, a
+    void enableEnvelope(bool enable) {m_f_envelope = enable;}
+    bool getEnvelope(uint32_t atMs, uint8_t* level, uint8_t* viseme = NULL); // lock free, any task; level 0..255 over 60dB
     int getCodec() {return m_codec;}
-    const char *getCodecname() {return codecname[m_codec];}
+    const char *getCodecname() {return m_codec < 10 ? codecname[m_codec] : decoder() ? decoder()->name : "unknown";}
 
 private:
 
@@ -207,6 +229,7 @@ private:
   void            processLocalFile();
   void            processWebStream();
   void            processWebFile();
+  void            processPushStream();
   void            processWebStreamTS();
   void            processWebStreamHLS();
   void            playAudioData();
@@ -238,15 +261,27 @@ private:
   void            reconfigI2S();
   bool            setBitrate(int br);
   void            playChunk();
+  void            startOverlayFade(uint16_t ms);
+  void            mixOverlay(int16_t* buff, uint16_t frames, bool overSource);
+  void            playOverlayIdle();
   void            computeVUlevel(int16_t sample[2]);
+  void            publishEnvelope(const int16_t* buff, uint16_t frames);
   void            computeLimit();
   void            Gain(int16_t* sample);
   void            showstreamtitle(const char* ml);
   bool            parseContentType(char* ct);
   bool            parseHttpResponseHeader();
   bool            initializeDecoder(uint8_t codec);
+  uint8_t         codecFromFileExt(const char* path);
+  const audioCodec_t* decoder() {                 // decoder of m_codec, NULL for WAV, OGG (not determined yet) and NONE
+                      if(!m_decoder || m_decoder->id != m_codec) m_decoder = audioCodecFind(m_codec);
+                      return m_decoder;
+                  }
+  bool            nextClip();
+  bool            switchLocalClip(fs::FS &fs, const char* path, uint8_t codec);
   esp_err_t       I2Sstart(uint8_t i2s_num);
   esp_err_t       I2Sstop(uint8_t i2s_num);
+  static bool     i2sSendQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx);
   void            IIR_filterChain0(int16_t iir_in[2], bool clear = false);
   void            IIR_filterChain1(int16_t iir_in[2], bool clear = false);
   void            IIR_filterChain2(int16_t iir_in[2], bool clear = false);
@@ -259,6 +294,9 @@ private:
 public:
   void            setAudioTaskCore(uint8_t coreID);
   uint32_t        getHighWatermark();
+  TaskHandle_t    getAudioTaskHandle() {return m_audioTaskHandle;}
+  uint32_t        getI2SUnderruns() {return m_i2sUnderruns;}        // the TX DMA ran dry during playback, since boot
+  void            getDecodeTime(uint32_t* avgUs, uint32_t* maxUs); // per decode() call since the last query
 private:
   void            startAudioTask(); // starts a task for decode and play
   void            stopAudioTask();  // stops task for audio
@@ -532,7 +570,7 @@ private:
     enum : int { EXTERNAL_I2S = 0, INTERNAL_DAC = 1, INTERNAL_PDM = 2 };
     enum : int { FORMAT_NONE = 0, FORMAT_M3U = 1, FORMAT_PLS = 2, FORMAT_ASX = 3, FORMAT_M3U8 = 4};
     enum : int { AUDIO_NONE, HTTP_RESPONSE_HEADER, AUDIO_DATA, AUDIO_LOCALFILE,
-                 AUDIO_PLAYLISTINIT, AUDIO_PLAYLISTHEADER,  AUDIO_PLAYLISTDATA};
+                 AUDIO_PLAYLISTINIT, AUDIO_PLAYLISTHEADER,  AUDIO_PLAYLISTDATA, AUDIO_PUSH};
     enum : int { FLAC_BEGIN = 0, FLAC_MAGIC = 1, FLAC_MBH =2, FLAC_SINFO = 3, FLAC_PADDING = 4, FLAC_APP = 5,
                  FLAC_SEEK = 6, FLAC_VORBIS = 7, FLAC_CUESHEET = 8, FLAC_PICTURE = 9, FLAC_OKAY = 100};
     enum : int { M4A_BEGIN = 0, M4A_FTYP = 1, M4A_CHK = 2, M4A_MOOV = 3, M4A_FREE = 4, M4A_TRAK = 5, M4A_MDAT = 6,
@@ -551,6 +589,13 @@ private:
         float b2;
     } filter_t;
 
+    typedef struct _clip{
+        fs::FS*  fs;       // NULL: path is a host URL
+        char*    path;
+        char*    tag;      // user data, passed to audio_eof_clip()
+        uint8_t  codec;
+    } clip_t;
+
     typedef struct _pis_array{
         int number;
         int pids[4];
@@ -585,14 +630,12 @@ private:
     std::vector<char*>    m_playlistContent;  // m3u8 playlist buffer
     std::vector<char*>    m_playlistURL;      // m3u8 streamURLs buffer
     std::vector<uint32_t> m_hashQueue;
+    std::vector<clip_t>   m_clipQueue;        // pending clips, see enqueueFS()
+    File                  m_nextFile;         // opened ahead of time, belongs to m_clipQueue[0]
 
     const size_t    m_frameSizeWav    = 4096;
-    const size_t    m_frameSizeMP3    = 1600;
-    const size_t    m_frameSizeAAC    = 1600;
-    const size_t    m_frameSizeFLAC   = 4096 * 4;
-    const size_t    m_frameSizeOPUS   = 1024;
-    const size_t    m_frameSizeVORBIS = 4096 * 2;
     const size_t    m_outbuffSize     = 4096 * 2;
+    const uint16_t  m_srcBuffFrames   = 1024;       // resampler output, stereo frames
 
     static const uint8_t m_tsPacketSize  = 188;
     static const uint8_t m_tsHeaderSize  = 4;
@@ -605,6 +648,8 @@ private:
     char*           m_lastM3U8host = NULL;
     char*           m_playlistBuff = NULL;          // stores playlistdata
     char*           m_speechtxt = NULL;             // stores tts text
+    char*           m_clipTag = NULL;               // tag of the running clip (from the queue)
+    const audioCodec_t* m_decoder = NULL;           // see decoder()
     const uint16_t  m_plsBuffEntryLen = 256;        // length of each entry in playlistBuff
     filter_t        m_filter[3];                    // digital filters
     int             m_LFcount = 0;                  // Detection of end of header
@@ -639,9 +684,46 @@ private:
     uint16_t        m_M4A_sampleRate = 0;           // set in read_M4A_Header
     int16_t*        m_outBuff = NULL;               // Interleaved L/R
     int16_t         m_validSamples = {0};           // #144
+    uint16_t        m_outBuffPos = 0;               // samples of m_outBuff already written to I2S, reset with m_validSamples
+    Resampler       m_resampler;                    // source rate -> m_outputSampleRate
+    int16_t*        m_srcBuff = NULL;               // resampled samples, interleaved L/R
+    uint16_t        m_srcValid = 0;                 // frames in m_srcBuff not yet written to I2S
+    uint16_t        m_srcPos = 0;                   // first frame in m_srcBuff to write
+    uint16_t        m_srcConsumed = 0;              // frames of m_outBuff used for the content of m_srcBuff
+    uint32_t        m_outputSampleRate = 0;         // 0: I2S runs at the source sample rate
+    uint8_t         m_srcQuality = SRC_QUALITY_MEDIUM;
+    const int16_t*  m_ovlPcm = NULL;                // overlay clip (mono, owned by the caller), see playOverlay()
+    uint32_t        m_ovlFrames = 0;
+    uint32_t        m_ovlRate = 0;
+    uint32_t        m_ovlPos = 0;                   // position in m_ovlPcm, Q16
+    int32_t         m_ovlGain = 0;                  // Q15
+    int32_t         m_ovlFadeStep = 0;              // gain decrement per output frame, 0: no fade
+    int64_t         m_ovlT0 = 0;                    // esp_timer at the first idle write, 0: not pacing
+    uint32_t        m_ovlWritten = 0;               // frames written by playOverlayIdle() since m_ovlT0
+    int16_t         m_ovlBuff[2 * 256];             // idle output, interleaved L/R
+    uint16_t        m_ovlValid = 0;                 // frames in m_ovlBuff not yet written to I2S
+    uint16_t        m_ovlOffset = 0;
+    const uint16_t  m_ovlLeadMs = 60;               // idle writes stay this far ahead of the DAC
+    const uint16_t  m_ovlFadeMs = 120;              // fade into the first samples of a source
+
+    typedef struct _envFrame{
+        uint32_t startMs;                           // millis() when the block leaves the DAC
+        uint8_t  lenMs;
+        uint8_t  level;
+        uint8_t  viseme;
+    } envFrame_t;
+    static const uint16_t m_envFrames = 128;        // ring of published blocks, more than the I2S DMA queue holds
+    envFrame_t      m_env[m_envFrames];
+    std::atomic<uint32_t> m_envHead{0};             // blocks published, written by the audio task only
+    int64_t         m_envCursorUs = 0;              // esp_timer when everything published so far has played
+    bool            m_f_envelope = false;
     int16_t         m_curSample{0};
     uint16_t        m_dataMode{0};                  // Statemaschine
     int16_t         m_decodeError = 0;              // Stores the return value of the decoder
+    uint32_t        m_decodeUsSum = 0;              // decoder time, getDecodeTime()
+    uint32_t        m_decodeUsMax = 0;
+    uint32_t        m_decodeCalls = 0;
+    volatile uint32_t m_i2sUnderruns = 0;           // counted in the I2S ISR
     uint16_t        m_streamTitleHash = 0;          // remember streamtitle, ignore multiple occurence in metadata
     uint16_t        m_timeout_ms = 250;
     uint16_t        m_timeout_ms_ssl = 2700;
@@ -673,6 +755,7 @@ private:
     bool            m_f_firstCall = false;          // InitSequence for processWebstream and processLokalFile
     bool            m_f_firstCurTimeCall = false;   // InitSequence for computeAudioTime
     bool            m_f_firstPlayCall = false;      // InitSequence for playAudioData
+    bool            m_f_firstSamples = false;       // audio_first_samples() is due with the next I2S write
     bool            m_f_firstM3U8call = false;      // InitSequence for m3u8 parsing
     bool            m_f_ID3v1TagFound = false;      // ID3v1 tag found
     bool            m_f_chunked = false ;           // Station provides chunked transfer
@@ -694,6 +777,7 @@ private:
     bool            m_f_stream = false;             // stream ready for output?
     bool            m_f_decode_ready = false;       // if true data for decode are ready
     bool            m_f_eof = false;                // end of file
+    volatile bool   m_f_pushEnd = false;            // pushEnd() was called, set by the pushing task
     bool            m_f_lockInBuffer = false;       // lock inBuffer for manipulation
     bool            m_f_audioTaskIsDecoding = false;
     bool            m_f_acceptRanges = false;
@@ -2,6 +2,8 @@
 
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
+#include "LatencyTracer.h"
+#include "SystemTelemetry.h"
 
 BackendASRChat::BackendASRChat(const char* apiUrl, const char* apiKey)
     : _apiUrl(apiUrl == nullptr ? "" : apiUrl),
@@ -39,6 +41,7 @@ bool BackendASRChat::initINMP441Microphone(int i2sSckPin, int i2sWsPin, int i2sS
     return false;
   }
   _micInitialized = true;
+  systemTelemetry.attachI2S("mic", _I2S.rxChan(), false);  // overruns while recording
   Serial.println("INMP441 microphone initialized");
 
   delay(300);
@@ -177,6 +180,7 @@ String BackendASRChat::_stopStreamSessionAndTranscribe() {
   }
 
   int code = http.POST("");
+  latencyTracer.first(LAT_ASR_TRANSCRIBE);
   if (code != 200) {
     String err = http.getString();
     Serial.printf("[Backend ASR] stop HTTP %d: %s\n", code, err.c_str());
@@ -221,6 +225,9 @@ bool BackendASRChat::startRecording() {
   _lastSpeechMs = _recordingStartMs;
   _lastDotMs = _recordingStartMs;
   _isRecording = true;
+  latencyTracer.beginTurn();
+  systemTelemetry.setI2SArmed(_I2S.rxChan(), true);
+  latencyTracer.begin(LAT_ASR_CAPTURE);
 
   Serial.println("========================================");
   Serial.println("Recording started...");
@@ -230,6 +237,7 @@ bool BackendASRChat::startRecording() {
 
 void BackendASRChat::stopRecording() {
   _isRecording = false;
+  systemTelemetry.setI2SArmed(_I2S.rxChan(), false);
   _pendingFinalize = false;
   _txChunkLen = 0;
   _totalSamples = 0;
@@ -248,7 +256,19 @@ bool BackendASRChat::isRecording() {
   return _isRecording;
 }
 
+size_t BackendASRChat::readMicrophone(int16_t* out, size_t maxSamples) {
+  if (_isRecording || !_micInitialized || out == nullptr || maxSamples == 0) return 0;
+  size_t bytes = 0;
+  i2s_channel_read(_I2S.rxChan(), out, maxSamples * sizeof(int16_t), &bytes, 0);
+  return bytes / sizeof(int16_t);
+}
+
 String BackendASRChat::_finalizeCurrentRecording() {
+  systemTelemetry.setI2SArmed(_I2S.rxChan(), false);
+  latencyTracer.end(LAT_ASR_CAPTURE);
+  if (_hasSpeech) latencyTracer.recordSince(LAT_ASR_ENDPOINT, _lastSpeechMs);
+  latencyTracer.begin(LAT_ASR_TRANSCRIBE);
+
   if (_txChunkLen > 0) {
     if (!_sendStreamChunk(_txChunk, _txChunkLen)) {
       return "";
@@ -258,6 +278,7 @@ String BackendASRChat::_finalizeCurrentRecording() {
 
   if (!_hasSpeech || _totalSamples < (size_t)(_sampleRate / 8)) {
     Serial.println("[Backend ASR] No speech detected");
+    latencyTracer.cancelTurn();
     if (_timeoutNoSpeechCallback != nullptr) _timeoutNoSpeechCallback();
     _abortStreamSession();
     return "";
@@ -269,6 +290,7 @@ String BackendASRChat::_finalizeCurrentRecording() {
     return "";
   }
 
+  latencyTracer.end(LAT_ASR_TRANSCRIBE);
   _recognizedText = result;
   _hasNewResult = true;
   if (_resultCallback != nullptr) _resultCallback(result);
@@ -299,6 +321,7 @@ void BackendASRChat::loop() {
     if (_txChunkLen + 2 > sizeof(_txChunk)) {
       if (!_sendStreamChunk(_txChunk, _txChunkLen)) {
         _isRecording = false;
+        systemTelemetry.setI2SArmed(_I2S.rxChan(), false);
         _pendingFinalize = false;
         _abortStreamSession();
         return;
@@ -311,6 +334,7 @@ void BackendASRChat::loop() {
     _totalSamples++;
 
     if (abs((int)s) >= _speechThreshold) {
+      if (!_hasSpeech) latencyTracer.first(LAT_ASR_CAPTURE);
       _hasSpeech = true;
       _lastSpeechMs = now;
     }
@@ -24,6 +24,7 @@ class BackendASRChat {
     bool finalizeRecording();
     bool isRecording();
     void loop();
+    size_t readMicrophone(int16_t* out, size_t maxSamples);  // while not recording, never blocks
 
     String getRecognizedText();
     bool hasNewResult();
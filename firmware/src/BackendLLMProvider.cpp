@@ -2,11 +2,14 @@
 
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
+#include "LatencyTracer.h"
+#include "LLMReply.h"
 
 BackendLLMProvider::BackendLLMProvider(const char* baseUrl, const char* apiKey)
   : _baseUrl(baseUrl == nullptr ? "" : baseUrl),
     _apiKey(apiKey == nullptr ? "" : apiKey),
-    _model("gemini-2.0-flash") {}
+    _model("gemini-2.0-flash"),
+    _history(HISTORY_BACKEND) {}
 
 void BackendLLMProvider::setApiConfig(const char* baseUrl, const char* apiKey) {
   if (baseUrl != nullptr) _baseUrl = baseUrl;
@@ -14,39 +17,67 @@ void BackendLLMProvider::setApiConfig(const char* baseUrl, const char* apiKey) {
 }
 
 String BackendLLMProvider::sendMessage(const String& message) {
-  DynamicJsonDocument doc(8192);
-  doc["model"] = _model;
-  doc["system_prompt"] = _systemPrompt;
-  doc["user_message"] = message;
-
-  if (_memoryEnabled && !_history.empty()) {
-    JsonArray h = doc.createNestedArray("history");
-    for (size_t i = 0; i < _history.size(); ++i) {
-      JsonObject p = h.createNestedObject();
-      p["user"] = _history[i].first;
-      p["assistant"] = _history[i].second;
-    }
-  }
+  latencyTracer.begin(LAT_LLM);
+  String text = requestReply(message);
+  if (text.length() == 0) return "";
+  latencyTracer.end(LAT_LLM);
+  appendExchange(message, text);
+  return text;
+}
 
-  String payload;
-  serializeJson(doc, payload);
-  String body = _postJson("/v1/llm/chat", payload);
-  if (body.length() == 0) return "";
+String BackendLLMProvider::requestReply(const String& message) {
+  String payload = _buildPayload(_history.systemPrompt(_systemPrompt), message, true);
+  String text = _postForText("/v1/llm/chat", payload);
+  text.trim();
+  return text;
+}
 
-  DynamicJsonDocument out(8192);
-  if (deserializeJson(out, body) != DeserializationError::Ok) {
-    return "";
+// Built by concatenation, the history is kept as ready JSON fragments
+String BackendLLMProvider::_buildPayload(const String& systemPrompt, const String& userMessage, bool withHistory) const {
+  String payload;
+  payload.reserve(128 + systemPrompt.length() + userMessage.length() + (withHistory ? _history.tokens() * 5 : 0));
+  payload = "{\"model\":";
+  ConversationHistory::appendJsonString(payload, _model);
+  payload += ",\"system_prompt\":";
+  ConversationHistory::appendJsonString(payload, systemPrompt);
+  payload += ",\"user_message\":";
+  ConversationHistory::appendJsonString(payload, userMessage);
+  if (withHistory && _memoryEnabled && _history.size() > 0) {
+    payload += ",\"history\":[";
+    _history.appendFragments(payload);
+    payload += "]";
   }
-  String text = out["text"].as<String>();
-  text.trim();
+  payload += "}";
+  return payload;
+}
 
-  if (_memoryEnabled && text.length() > 0) {
-    _history.push_back(std::make_pair(message, text));
-    while (_history.size() > _maxHistoryPairs) {
-      _history.erase(_history.begin());
-    }
+void BackendLLMProvider::appendExchange(const String& userMessage, const String& reply) {
+  if (_memoryEnabled && reply.length() > 0) {
+    _history.append(userMessage, reply);
   }
-  return text;
+}
+
+void BackendLLMProvider::setHistoryBudget(size_t tokens) {
+  _history.setTokenBudget(tokens);
+}
+
+bool BackendLLMProvider::historyNeedsSummary() const {
+  return _memoryEnabled && _history.needsSummary();
+}
+
+// One request without system prompt or history
+bool BackendLLMProvider::summarizeHistory() {
+  String request;
+  size_t folded = 0;
+  if (!_history.summaryRequest(request, folded)) return false;
+  String summary = _postForText("/v1/llm/chat", _buildPayload("", request, false));
+  summary.trim();
+  _history.applySummary(summary, folded);
+  return summary.length() > 0;
+}
+
+void BackendLLMProvider::setRequestTimeout(uint32_t ms) {
+  _requestTimeoutMs = ms;
 }
 
 String BackendLLMProvider::sendVisionMessage(const uint8_t* imageData, size_t imageSize, const String& question, const char* mimeType) {
@@ -62,14 +93,9 @@ String BackendLLMProvider::sendVisionMessage(const uint8_t* imageData, size_t im
 
   String payload;
   serializeJson(doc, payload);
-  String body = _postJson("/v1/llm/chat", payload);
-  if (body.length() == 0) return "";
-
-  DynamicJsonDocument out(8192);
-  if (deserializeJson(out, body) != DeserializationError::Ok) {
-    return "";
-  }
-  String text = out["text"].as<String>();
+  doc.clear();
+  b64 = String();
+  String text = _postForText("/v1/llm/chat", payload);
   text.trim();
   return text;
 }
@@ -99,23 +125,31 @@ String BackendLLMProvider::getProviderName() const {
   return "backend";
 }
 
-String BackendLLMProvider::_postJson(const String& endpoint, const String& payload) {
+String BackendLLMProvider::_postForText(const String& endpoint, const String& payload) {
   if (_baseUrl.length() == 0 || _apiKey.length() == 0) {
     return "";
   }
   HTTPClient http;
   String url = _baseUrl + endpoint;
   http.begin(url);
+  if (_requestTimeoutMs > 0) {
+    http.setConnectTimeout(_requestTimeoutMs);
+    http.setTimeout(_requestTimeoutMs > 0xFFFF ? 0xFFFF : _requestTimeoutMs);
+  }
   http.addHeader("Content-Type", "application/json");
   http.addHeader("x-api-key", _apiKey);
+  http.useHTTP10(true);  // plain body on the stream, no chunked encoding
   int code = http.POST(payload);
-  String body = http.getString();
-  http.end();
+  latencyTracer.first(LAT_LLM);  // no-op for the vision requests, they run outside the LLM span
   if (code < 200 || code >= 300) {
+    String body = http.getString();
+    http.end();
     Serial.printf("[BackendLLM] HTTP %d: %s\n", code, body.c_str());
     return "";
   }
-  return body;
+  String text = readLLMReply(http.getStream(), http.getSize(), LLM_REPLY_BACKEND, "BackendLLM");
+  http.end();
+  return text;
 }
 
 String BackendLLMProvider::_base64Encode(const uint8_t* data, size_t len) const {
@@ -2,8 +2,8 @@
 #define BackendLLMProvider_h
 
 #include <Arduino.h>
-#include <vector>
 #include "AIProvider.h"
+#include "ConversationHistory.h"
 
 class BackendLLMProvider : public AIProvider {
   public:
@@ -19,6 +19,12 @@ class BackendLLMProvider : public AIProvider {
     void setModel(const String& model) override;
     String getModel() const override;
     String getProviderName() const override;
+    String requestReply(const String& message) override;
+    void appendExchange(const String& userMessage, const String& reply) override;
+    void setRequestTimeout(uint32_t ms) override;
+    void setHistoryBudget(size_t tokens) override;
+    bool historyNeedsSummary() const override;
+    bool summarizeHistory() override;
 
   private:
     String _baseUrl;
@@ -26,10 +32,11 @@ class BackendLLMProvider : public AIProvider {
     String _model;
     String _systemPrompt;
     bool _memoryEnabled = true;
-    size_t _maxHistoryPairs = 5;
-    std::vector<std::pair<String, String>> _history;
+    ConversationHistory _history;
+    uint32_t _requestTimeoutMs = 0;
 
-    String _postJson(const String& endpoint, const String& payload);
+    String _buildPayload(const String& systemPrompt, const String& userMessage, bool withHistory) const;
+    String _postForText(const String& endpoint, const String& payload);  // reply text, parsed from the stream
     String _base64Encode(const uint8_t* data, size_t len) const;
 };
 
@@ -4,6 +4,7 @@
 #include <HTTPClient.h>
 #include <SPIFFS.h>
 #include "Audio.h"
+#include "LatencyTracer.h"
 
 BackendTTS::BackendTTS() {}
 
@@ -23,7 +24,7 @@ bool BackendTTS::isConfigured() const {
   return _baseUrl.length() > 0 && _apiKey.length() > 0;
 }
 
-bool BackendTTS::speak(const String& text) {
+bool BackendTTS::speak(const String& text, CancelCheck cancelled, void* cancelArg) {
   if (!isConfigured() || text.length() == 0) return false;
 
   if (!SPIFFS.begin(true)) {
@@ -31,6 +32,8 @@ bool BackendTTS::speak(const String& text) {
     return false;
   }
 
+  latencyTracer.begin(LAT_TTS);  // ends with the first samples on I2S, see audio_first_samples()
+
   DynamicJsonDocument doc(2048);
   doc["text"] = text;
   doc["voice_id"] = _voiceId;
@@ -65,10 +68,15 @@ bool BackendTTS::speak(const String& text) {
   size_t total = 0;
   unsigned long lastDataMs = millis();
   while (http.connected() || stream->available()) {
+    if (cancelled != nullptr && cancelled(cancelArg)) {
+      total = 0;
+      break;
+    }
     int available = stream->available();
     if (available > 0) {
       int n = stream->readBytes(buf, (available > (int)sizeof(buf)) ? sizeof(buf) : available);
       if (n > 0) {
+        if (total == 0) latencyTracer.first(LAT_TTS);
         f.write(buf, n);
         total += (size_t)n;
         lastDataMs = millis();
@@ -82,6 +90,7 @@ bool BackendTTS::speak(const String& text) {
   f.close();
   http.end();
 
+  if (cancelled != nullptr && cancelled(cancelArg)) return false;
   if (total == 0) {
     Serial.println("[BackendTTS] Empty audio response");
     return false;
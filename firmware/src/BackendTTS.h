@@ -2,6 +2,7 @@
 #define BackendTTS_h
 
 #include <Arduino.h>
+#include "AsyncJobRunner.h"
 
 class BackendTTS {
   public:
@@ -14,7 +15,8 @@ class BackendTTS {
                    const char* outputFormat = "mp3_22050_32");
 
     bool isConfigured() const;
-    bool speak(const String& text);
+    // Downloads, then plays; cancelled() is checked during the download and before playback starts
+    bool speak(const String& text, CancelCheck cancelled = nullptr, void* cancelArg = nullptr);
 
   private:
     String _baseUrl;
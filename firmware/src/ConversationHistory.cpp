@@ -0,0 +1,207 @@
+#include "ConversationHistory.h"
+
+ConversationHistory::ConversationHistory(HistoryFormat format, size_t tokenBudget)
+  : _format(format),
+    _budget(tokenBudget),
+    _tokens(0),
+    _evictedBase(0),
+    _lock(xSemaphoreCreateMutex()) {}
+
+ConversationHistory::~ConversationHistory() {
+  if (_lock != nullptr) vSemaphoreDelete(_lock);
+}
+
+void ConversationHistory::_lockTake() const {
+  if (_lock != nullptr) xSemaphoreTake(_lock, portMAX_DELAY);
+}
+
+void ConversationHistory::_lockGive() const {
+  if (_lock != nullptr) xSemaphoreGive(_lock);
+}
+
+size_t ConversationHistory::estimateTokens(const String& text) {
+  return (text.length() + 3) / 4;
+}
+
+void ConversationHistory::appendJsonString(String& out, const String& text) {
+  static const char* hex = "0123456789abcdef";
+  out.reserve(out.length() + text.length() + 2);
+  out += '"';
+  for (size_t i = 0; i < text.length(); i++) {
+    char c = text[i];
+    switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if ((uint8_t)c < 0x20) {
+          out += "\\u00";
+          out += hex[(uint8_t)c >> 4];
+          out += hex[(uint8_t)c & 0x0F];
+        } else {
+          out += c;  // UTF-8 goes through as it is
+        }
+    }
+  }
+  out += '"';
+}
+
+void ConversationHistory::setTokenBudget(size_t tokens) {
+  _lockTake();
+  _budget = tokens;
+  _evict();
+  _lockGive();
+}
+
+void ConversationHistory::append(const String& userMessage, const String& reply) {
+  Entry e;
+  switch (_format) {
+    case HISTORY_OPENAI:
+      e.fragment = "{\"role\":\"user\",\"content\":";
+      appendJsonString(e.fragment, userMessage);
+      e.fragment += "},{\"role\":\"assistant\",\"content\":";
+      appendJsonString(e.fragment, reply);
+      e.fragment += "}";
+      break;
+    case HISTORY_GEMINI:
+      e.fragment = "{\"role\":\"user\",\"parts\":[{\"text\":";
+      appendJsonString(e.fragment, userMessage);
+      e.fragment += "}]},{\"role\":\"model\",\"parts\":[{\"text\":";
+      appendJsonString(e.fragment, reply);
+      e.fragment += "}]}";
+      break;
+    case HISTORY_BACKEND:
+      e.fragment = "{\"user\":";
+      appendJsonString(e.fragment, userMessage);
+      e.fragment += ",\"assistant\":";
+      appendJsonString(e.fragment, reply);
+      e.fragment += "}";
+      break;
+  }
+  size_t t = estimateTokens(userMessage) + estimateTokens(reply);
+  e.tokens = t > 0xFFFF ? 0xFFFF : t;
+
+  _lockTake();
+  _entries.push_back(e);
+  _tokens += e.tokens;
+  _evict();
+  _lockGive();
+}
+
+// Lock held. The newest exchange stays even if it alone is over the budget.
+void ConversationHistory::_evict() {
+  size_t drop = 0;
+  while (_entries.size() - drop > 1 && _tokens > _budget) {
+    Entry& e = _entries[drop++];
+    _tokens -= e.tokens;
+    if (_evicted.length() > 0) _evicted += ',';
+    _evicted += e.fragment;
+  }
+  if (drop > 0) _entries.erase(_entries.begin(), _entries.begin() + drop);
+
+  if (_evicted.length() > HISTORY_FOLD_MAX_CHARS) {  // summaries keep failing, forget the oldest
+    int cut = _evicted.indexOf(",{", _evicted.length() - HISTORY_FOLD_MAX_CHARS);
+    size_t keepFrom = cut >= 0 ? cut + 1 : _evicted.length();
+    _evicted = _evicted.substring(keepFrom);
+    _evictedBase += keepFrom;
+  }
+}
+
+void ConversationHistory::clear() {
+  _lockTake();
+  _entries.clear();
+  _tokens = 0;
+  _evictedBase += _evicted.length();
+  _evicted = "";
+  _summary = "";
+  _lockGive();
+}
+
+size_t ConversationHistory::size() const {
+  _lockTake();
+  size_t n = _entries.size();
+  _lockGive();
+  return n;
+}
+
+size_t ConversationHistory::tokens() const {
+  _lockTake();
+  size_t n = _tokens;
+  _lockGive();
+  return n;
+}
+
+bool ConversationHistory::appendFragments(String& out) const {
+  _lockTake();
+  size_t len = 0;
+  for (const Entry& e : _entries) len += e.fragment.length() + 1;
+  out.reserve(out.length() + len);
+  for (size_t i = 0; i < _entries.size(); i++) {
+    if (i > 0) out += ',';
+    out += _entries[i].fragment;
+  }
+  bool any = !_entries.empty();
+  _lockGive();
+  return any;
+}
+
+String ConversationHistory::systemPrompt(const String& base) const {
+  _lockTake();
+  String out = base;
+  if (_summary.length() > 0) {
+    if (out.length() > 0) out += "\n\n";
+    out += "[Earlier in this conversation]\n";
+    out += _summary;
+  }
+  _lockGive();
+  return out;
+}
+
+bool ConversationHistory::needsSummary() const {
+  _lockTake();
+  bool pending = _evicted.length() > 0;
+  _lockGive();
+  return pending;
+}
+
+bool ConversationHistory::summaryRequest(String& request, size_t& folded) const {
+  _lockTake();
+  if (_evicted.length() == 0) {
+    _lockGive();
+    return false;
+  }
+  folded = _evictedBase + _evicted.length();
+  request = "Update the summary of an ongoing voice conversation with the messages below. Keep what you "
+            "should remember as the assistant: facts about the user, preferences, open topics, promises. "
+            "At most ";
+  request += String(HISTORY_SUMMARY_WORDS);
+  request += " words, plain text, no preamble.\n\nCurrent summary: ";
+  request += _summary.length() > 0 ? _summary : String("(none)");
+  request += "\n\nMessages (JSON): [";
+  request += _evicted;
+  request += "]";
+  _lockGive();
+  return true;
+}
+
+void ConversationHistory::applySummary(const String& summary, size_t folded) {
+  String text = summary;
+  text.trim();
+  if (text.length() == 0) return;
+  if (text.length() > HISTORY_SUMMARY_MAX_CHARS) text = text.substring(0, HISTORY_SUMMARY_MAX_CHARS);
+
+  _lockTake();
+  if (folded <= _evictedBase) {  // cleared (or trimmed past it) while the request ran
+    _lockGive();
+    return;
+  }
+  _summary = text;
+  // exchanges evicted while the request ran stay for the next fold
+  size_t done = folded - _evictedBase;
+  size_t drop = done < _evicted.length() ? done + 1 : _evicted.length();  // + the separating comma
+  _evicted = _evicted.substring(drop);
+  _evictedBase += drop;
+  _lockGive();
+}
@@ -0,0 +1,74 @@
+#ifndef ConversationHistory_h
+#define ConversationHistory_h
+
+#include <Arduino.h>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Conversation memory of the LLM clients. Budgeted in approximate tokens (UTF-8 bytes / 4) instead of
+// pairs. Each exchange is kept as its JSON fragment in the client's wire format, so a payload is built
+// by concatenation instead of re-serializing the history every turn.
+// Exchanges pushed out of the budget are not lost: their fragments wait until summaryRequest() /
+// applySummary() fold them into a rolling summary that goes into the system prompt. That is one extra
+// LLM call, the owner makes it off the turn path (see AIProvider::summarizeHistory()).
+// Exchanges are recorded from the turn worker and the loop, all calls take the lock.
+
+#define HISTORY_TOKEN_BUDGET     768    // exchanges kept verbatim
+#define HISTORY_SUMMARY_WORDS    80     // asked for, the reply is cut at HISTORY_SUMMARY_MAX_CHARS
+#define HISTORY_SUMMARY_MAX_CHARS 640
+#define HISTORY_FOLD_MAX_CHARS   4096   // evicted fragments waiting for the summary, the oldest go beyond this
+
+enum HistoryFormat : uint8_t {
+  HISTORY_OPENAI = 0,  // {"role":"user","content":..},{"role":"assistant","content":..}
+  HISTORY_GEMINI,      // {"role":"user","parts":[{"text":..}]},{"role":"model","parts":[{"text":..}]}
+  HISTORY_BACKEND      // {"user":..,"assistant":..}
+};
+
+class ConversationHistory {
+  public:
+    ConversationHistory(HistoryFormat format, size_t tokenBudget = HISTORY_TOKEN_BUDGET);
+    ~ConversationHistory();
+
+    void setTokenBudget(size_t tokens);     // evicts right away if the history is over it
+    void append(const String& userMessage, const String& reply);
+    void clear();                            // summary included
+
+    size_t size() const;
+    size_t tokens() const;
+
+    // The fragments, comma separated, appended to out; false if there are none
+    bool appendFragments(String& out) const;
+    // base + the rolling summary, if there is one
+    String systemPrompt(const String& base) const;
+
+    bool needsSummary() const;
+    // Prompt that asks for the updated summary, and the position in the evicted text it covers up to
+    bool summaryRequest(String& request, size_t& folded) const;
+    // "" (failed request) keeps the evicted text for the next try
+    void applySummary(const String& summary, size_t folded);
+
+    static size_t estimateTokens(const String& text);
+    static void appendJsonString(String& out, const String& text);  // quoted and escaped
+
+  private:
+    struct Entry {
+      String fragment;
+      uint16_t tokens;
+    };
+
+    HistoryFormat _format;
+    size_t _budget;
+    std::vector<Entry> _entries;
+    size_t _tokens;
+    String _evicted;
+    size_t _evictedBase;                     // chars dropped from the front of _evicted so far
+    String _summary;
+    SemaphoreHandle_t _lock;
+
+    void _evict();
+    void _lockTake() const;
+    void _lockGive() const;
+};
+
+#endif
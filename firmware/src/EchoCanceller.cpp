@@ -0,0 +1,380 @@
+#include "EchoCanceller.h"
+#include <ArduinoJson.h>
+#include <math.h>
+
+#define AEC_DEC_LAGS  (AEC_MAX_DELAY_MS * AEC_SAMPLE_RATE / 1000 / AEC_DECIMATE)
+
+static void* aecAlloc(size_t bytes) {
+  return psramFound() ? ps_malloc(bytes) : malloc(bytes);
+}
+
+static inline int16_t clamp16(int32_t v) {
+  return v > 32767 ? 32767 : (v < -32768 ? -32768 : (int16_t)v);
+}
+
+EchoCanceller::EchoCanceller()
+  : _ref(nullptr),
+    _refWrite(0),
+    _refRate(0),
+    _refDc(0),
+    _w(nullptr),
+    _x(nullptr),
+    _muQ15(9830),
+    _locked(false),
+    _base(0),
+    _micCount(0),
+    _dc(0),
+    _micDec(nullptr),
+    _refDec(nullptr),
+    _micDecPos(0),
+    _micDecCount(0),
+    _decAcc(0),
+    _decLen(0),
+    _nextEstimate(0),
+    _delaySamples(-1),
+    _lastCorr(0),
+    _noise(0),
+    _speechRun(0),
+    _bargeInFrames(AEC_BARGE_IN_MS * AEC_SAMPLE_RATE / 1000 / AEC_FRAME),
+    _hangover(0),
+    _adaptedFrames(0),
+    _erleIn(0),
+    _erleOut(0),
+    _preroll(nullptr),
+    _prerollPos(0),
+    _prerollFull(false),
+    _usSum(0),
+    _frames(0) {}
+
+EchoCanceller::~EchoCanceller() {
+  free(_ref);
+  free(_w);
+  free(_x);
+  free(_micDec);
+  free(_refDec);
+  free(_preroll);
+}
+
+bool EchoCanceller::begin() {
+  if (_ref != nullptr) return true;
+  _ref = (int16_t*)aecAlloc(AEC_REF_RING * sizeof(int16_t));
+  _w = (int32_t*)malloc(AEC_TAPS * sizeof(int32_t));                     // internal RAM, read every sample
+  _x = (int16_t*)malloc((AEC_TAPS - 1 + AEC_FRAME) * sizeof(int16_t));
+  _micDec = (float*)malloc(AEC_EST_WINDOW * sizeof(float));
+  _refDec = (float*)aecAlloc((AEC_DEC_LAGS + AEC_EST_WINDOW) * sizeof(float));
+  _preroll = (int16_t*)aecAlloc(AEC_PREROLL * sizeof(int16_t));
+  if (_ref == nullptr || _w == nullptr || _x == nullptr || _micDec == nullptr || _refDec == nullptr || _preroll == nullptr) {
+    Serial.println("[AEC] out of memory");
+    free(_ref);
+    free(_w);
+    free(_x);
+    free(_micDec);
+    free(_refDec);
+    free(_preroll);
+    _ref = nullptr;
+    _w = nullptr;
+    _x = nullptr;
+    _micDec = nullptr;
+    _refDec = nullptr;
+    _preroll = nullptr;
+    return false;
+  }
+  memset(_ref, 0, AEC_REF_RING * sizeof(int16_t));
+  _refWrite = 0;
+  _refDc = 0;
+  reset();
+  return true;
+}
+
+void EchoCanceller::reset() {
+  if (_w != nullptr) memset(_w, 0, AEC_TAPS * sizeof(int32_t));
+  _locked = false;
+  _base = 0;
+  _micCount = 0;
+  _dc = 0;
+  _micDecPos = 0;
+  _micDecCount = 0;
+  _decAcc = 0;
+  _decLen = 0;
+  _nextEstimate = AEC_EST_WINDOW * AEC_DECIMATE;
+  _delaySamples = -1;
+  _lastCorr = 0;
+  _noise = 0;
+  _speechRun = 0;
+  _hangover = 0;
+  _adaptedFrames = 0;
+  _erleIn = 0;
+  _erleOut = 0;
+  _prerollPos = 0;
+  _prerollFull = false;
+  _usSum = 0;
+  _frames = 0;
+}
+
+void EchoCanceller::setBargeInMs(uint16_t ms) {
+  _bargeInFrames = max(1, (int)((uint32_t)ms * AEC_SAMPLE_RATE / 1000 / AEC_FRAME));
+}
+
+void EchoCanceller::setStepSize(float mu) {
+  _muQ15 = (int32_t)(constrain(mu, 0.05f, 1.0f) * 32768);
+}
+
+void EchoCanceller::pushReference(const int16_t* pcm, uint16_t frames, uint8_t channels, uint32_t sampleRate) {
+  if (_ref == nullptr || pcm == nullptr || frames == 0 || channels == 0 || sampleRate < 8000) return;
+  if (sampleRate != _refRate) {
+    if (!_refSrc.init(sampleRate, AEC_SAMPLE_RATE, 1, SRC_QUALITY_LOW)) return;
+    _refRate = sampleRate;
+  }
+
+  int16_t mono[128];
+  int16_t out[2 * 128 + 2];              // 8kHz sources double
+  uint16_t done = 0;
+  while (done < frames) {
+    uint16_t n = min(128, frames - done);
+    for (uint16_t i = 0; i < n; i++) {
+      const int16_t* f = pcm + (size_t)(done + i) * channels;
+      mono[i] = channels == 2 ? ((int32_t)f[0] + f[1]) / 2 : f[0];
+    }
+    uint16_t used = 0;
+    while (used < n) {
+      uint16_t consumed = 0;
+      uint16_t k = _refSrc.process(mono + used, n - used, out, sizeof(out) / sizeof(out[0]), &consumed);
+      uint32_t w = _refWrite;
+      for (uint16_t i = 0; i < k; i++) {
+        // the same DC removal as the mic, so the filter does not have to learn it; stored at half scale,
+        // a full scale step would clip and the echo of clipped samples is not linear any more
+        int32_t x = out[i];
+        _refDc += (x * 4096 - _refDc) >> 8;
+        _ref[(w + i) & (AEC_REF_RING - 1)] = clamp16((x - (_refDc >> 12)) / 2);
+      }
+      __sync_synchronize();              // samples before the index, the reader is on the other core
+      _refWrite = w + k;
+      used += consumed;
+      if (consumed == 0 && k == 0) break;
+    }
+    done += n;
+  }
+}
+
+bool EchoCanceller::_fetchReference(uint32_t first, size_t count, int16_t* out) const {
+  uint32_t w = _refWrite;
+  __sync_synchronize();
+  if ((int32_t)(w - (first + count)) < 0) return false;    // not written yet
+  if ((int32_t)(w - first) > AEC_REF_RING) return false;   // overwritten
+  for (size_t i = 0; i < count; i++) out[i] = _ref[(first + i) & (AEC_REF_RING - 1)];
+  return true;
+}
+
+void EchoCanceller::_decimateMic(const int16_t* frame) {
+  for (int i = 0; i < AEC_FRAME; i++) {
+    _decAcc += frame[i];
+    if (++_decLen == AEC_DECIMATE) {
+      _micDec[_micDecPos] = (float)_decAcc / AEC_DECIMATE;
+      _micDecPos = (_micDecPos + 1) % AEC_EST_WINDOW;
+      _micDecCount++;
+      _decAcc = 0;
+      _decLen = 0;
+    }
+  }
+}
+
+// Normalized cross-correlation of the last 128ms of mic with the far end at every lag up to AEC_MAX_DELAY_MS,
+// both decimated (box filter), so the echo of the audible band below 1kHz lines up
+void EchoCanceller::_estimateDelay() {
+  const int lags = AEC_DEC_LAGS;
+  const int n = lags + AEC_EST_WINDOW;
+  uint32_t mics = _micCount + AEC_FRAME;                   // the current frame is decimated already
+  uint32_t w = _refWrite;
+  uint32_t first = w - (uint32_t)n * AEC_DECIMATE;
+  for (int i = 0; i < n; i++) {
+    int32_t acc = 0;
+    for (int k = 0; k < AEC_DECIMATE; k++) acc += _ref[(first + i * AEC_DECIMATE + k) & (AEC_REF_RING - 1)];
+    _refDec[i] = (float)acc / AEC_DECIMATE;
+  }
+
+  float m[AEC_EST_WINDOW];
+  float em = 0;
+  for (int i = 0; i < AEC_EST_WINDOW; i++) {
+    m[i] = _micDec[(_micDecPos + i) % AEC_EST_WINDOW];     // oldest first
+    em += m[i] * m[i];
+  }
+  if (em < (float)AEC_EST_WINDOW * 100) return;            // mic silent, nothing to line up
+
+  // lag c: the newest mic sample goes with _refDec[n - 1 - c]
+  int start = n - AEC_EST_WINDOW;
+  float er = 0;
+  for (int i = 0; i < AEC_EST_WINDOW; i++) er += _refDec[start + i] * _refDec[start + i];
+  float best = 0;
+  int bestLag = -1;
+  for (int c = 0; c <= lags; c++) {
+    start = n - AEC_EST_WINDOW - c;
+    if (c > 0) er += _refDec[start] * _refDec[start] - _refDec[start + AEC_EST_WINDOW] * _refDec[start + AEC_EST_WINDOW];
+    if (er < (float)AEC_EST_WINDOW * 100) continue;        // far end silent at this lag
+    float dot = 0;
+    for (int i = 0; i < AEC_EST_WINDOW; i++) dot += m[i] * _refDec[start + i];
+    float corr = fabsf(dot) / sqrtf(em * er);
+    if (corr > best) {
+      best = corr;
+      bestLag = c;
+    }
+  }
+  _lastCorr = best;
+  if (bestLag < 0 || best < AEC_LOCK_CORR) return;
+
+  uint32_t base = w - (uint32_t)bestLag * AEC_DECIMATE - mics + AEC_TAP_MARGIN;
+  int32_t shift = (int32_t)(base - _base);
+  if (!_locked || shift > AEC_TAP_MARGIN / 2 || shift < -AEC_TAP_MARGIN / 2) {
+    if (_locked) Serial.printf("[AEC] delay moved by %ld samples\n", (long)shift);
+    memset(_w, 0, AEC_TAPS * sizeof(int32_t));
+    _base = base;
+    _locked = true;
+    _adaptedFrames = 0;
+  }
+  _delaySamples = bestLag * AEC_DECIMATE;
+}
+
+void EchoCanceller::process(int16_t* frame) {
+  if (_ref == nullptr || frame == nullptr) return;
+  uint32_t t0 = micros();
+
+  // DC removal, the mic has an offset: one pole at ~10Hz with the estimate in Q12, a plain
+  // y = x - x' + a*y' in 16 bits leaves a DC of its own from the truncation
+  for (int i = 0; i < AEC_FRAME; i++) {
+    int32_t x = frame[i];
+    _dc += (x * 4096 - _dc) >> 8;
+    frame[i] = clamp16(x - (_dc >> 12));
+  }
+
+  _decimateMic(frame);
+  if (_micCount + AEC_FRAME >= _nextEstimate && _micDecCount >= AEC_EST_WINDOW) {
+    _estimateDelay();
+    _nextEstimate = _micCount + AEC_FRAME + (_locked ? AEC_SAMPLE_RATE : AEC_EST_WINDOW * AEC_DECIMATE / 2);
+  }
+
+  int64_t ed = 0;
+  int64_t ee = 0;
+  int64_t ey = 0;
+  bool filtered = _locked && _fetchReference(_base + _micCount - (AEC_TAPS - 1), AEC_TAPS - 1 + AEC_FRAME, _x);
+  bool adapted = false;
+  if (filtered) {
+    int64_t p = 0;
+    for (int j = 0; j < AEC_TAPS; j++) p += (int32_t)_x[j] * _x[j];
+    const int64_t delta = (int64_t)AEC_TAPS * 1024;
+    adapted = p >= (int64_t)AEC_TAPS * AEC_FAR_MIN_POWER / 4;
+    // near-end speech: a slow step instead of none, a false detection must not freeze a bad filter for good
+    int32_t mu = _hangover > 0 ? _muQ15 / 8 : _muQ15;
+    const float gScale = (float)mu * (1 << 21);
+    for (int n = 0; n < AEC_FRAME; n++) {
+      const int16_t* x = _x + n;
+      // 32 bit MAC on Q12 taps: the sum wraps on the way but the result, |y| < 2^19, fits, so it is exact
+      uint32_t acc = 0;
+      for (int j = 0; j < AEC_TAPS; j++) acc += (uint32_t)(_w[j] >> 8) * (uint32_t)(int32_t)x[j];
+      int32_t y = (int32_t)acc >> 12;
+      int32_t d = frame[n];
+      int32_t e = d - y;
+      if (adapted) {
+        // w += mu * e * x / (|x|^2 + delta), g in Q36 of the taps per unit of x, cut to 16 bits and an
+        // exponent so the update is a 32 bit multiply too
+        float gf = (float)e * gScale / (float)(p + delta);
+        int32_t g = (int32_t)constrain(gf, -(float)(1 << 27), (float)(1 << 27));
+        int sh = 16;
+        while (g > 32767 || g < -32768) {
+          g >>= 1;
+          sh--;
+        }
+        for (int j = 0; j < AEC_TAPS; j++) _w[j] += (g * x[j]) >> sh;
+      }
+      if (n < AEC_FRAME - 1) p += (int32_t)x[AEC_TAPS] * x[AEC_TAPS] - (int32_t)x[0] * x[0];
+      ed += (int64_t)d * d;
+      ee += (int64_t)e * e;
+      ey += (int64_t)y * y;
+      frame[n] = clamp16(e);
+    }
+    if (adapted && mu == _muQ15 && _adaptedFrames < UINT16_MAX) _adaptedFrames++;
+  } else {
+    for (int n = 0; n < AEC_FRAME; n++) ed += (int32_t)frame[n] * frame[n];
+    ee = ed;
+  }
+
+  // detector, mean squares of the frame
+  float pd = (float)ed / AEC_FRAME;
+  float pe = (float)ee / AEC_FRAME;
+  float py = (float)ey / AEC_FRAME;
+  if (_noise <= 0 || pe < _noise) {
+    _noise = max(pe, 1.0f);
+  } else {
+    _noise *= 1.004f;                                      // slow rise, x1.6 per second
+  }
+  bool trusted = filtered && _adaptedFrames >= AEC_TRUST_FRAMES;
+  // echo the filter leaves: its estimate scaled by the measured loss, so a quiet talker over a loud reply counts
+  float leak = _erleIn > 0 ? max(_erleOut / _erleIn, 0.001f) : 1.0f;
+  bool speech = trusted && pe > _noise * 8 && pe > AEC_SPEECH_MIN_POWER && pe > py * leak * 4;
+  if (speech) {
+    _speechRun++;
+    _hangover = 12;                                        // ~100ms of slow adaptation
+  } else {
+    _speechRun = _speechRun > 2 ? _speechRun - 2 : 0;
+    if (_hangover > 0) _hangover--;
+  }
+  if (adapted && _hangover == 0) {
+    _erleIn = 0.98f * _erleIn + pd;
+    _erleOut = 0.98f * _erleOut + pe;
+  }
+
+  for (int n = 0; n < AEC_FRAME; n++) {
+    _preroll[_prerollPos] = frame[n];
+    if (++_prerollPos == AEC_PREROLL) {
+      _prerollPos = 0;
+      _prerollFull = true;
+    }
+  }
+
+  _micCount += AEC_FRAME;
+  _usSum += micros() - t0;
+  _frames++;
+}
+
+bool EchoCanceller::speechDetected() const {
+  return _speechRun >= _bargeInFrames;
+}
+
+bool EchoCanceller::locked() const {
+  return _locked;
+}
+
+size_t EchoCanceller::preroll(int16_t* out, size_t maxSamples) const {
+  if (_preroll == nullptr || out == nullptr) return 0;
+  size_t have = _prerollFull ? AEC_PREROLL : _prerollPos;
+  size_t n = min(have, maxSamples);
+  size_t from = (_prerollPos + AEC_PREROLL - n) % AEC_PREROLL;
+  for (size_t i = 0; i < n; i++) out[i] = _preroll[(from + i) % AEC_PREROLL];
+  return n;
+}
+
+int EchoCanceller::delayMs() const {
+  return _delaySamples < 0 ? -1 : _delaySamples * 1000 / AEC_SAMPLE_RATE;
+}
+
+float EchoCanceller::erleDb() const {
+  if (_erleOut <= 0 || _erleIn <= 0) return 0;
+  return 10.0f * log10f(_erleIn / _erleOut);
+}
+
+uint32_t EchoCanceller::frameUs() const {
+  return _frames ? _usSum / _frames : 0;
+}
+
+String EchoCanceller::statsJson() const {
+  DynamicJsonDocument doc(384);
+  doc["locked"] = _locked;
+  doc["delay_ms"] = delayMs();
+  doc["correlation"] = _lastCorr;
+  doc["erle_db"] = erleDb();
+  doc["frame_us"] = frameUs();
+  doc["frames"] = _frames;
+  doc["noise_floor"] = _noise;
+  doc["speech_frames"] = _speechRun;
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
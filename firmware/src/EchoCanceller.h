@@ -0,0 +1,107 @@
+#ifndef EchoCanceller_h
+#define EchoCanceller_h
+
+#include <Arduino.h>
+#include "resampler/resampler.h"
+
+// Echo canceller and near-end speech detector for barge-in: the mic keeps running while the reply plays.
+// The far end is what the Audio library hands to I2S (audio_process_i2s), resampled to the mic rate into
+// a ring. That audio is written up to one I2S DMA queue ahead of the speaker, so the bulk delay between
+// the ring and the mic is found by cross-correlation (decimated by 8, refreshed every second). The echo
+// path after it is a fixed-point NLMS filter that adapts while the far end is active, with an eighth of
+// the step during near-end speech. Taps are kept in Q20 and filter in Q12, so the MAC and the update are
+// 32 bit: the LX6 has no 64 bit multiply-accumulate.
+// Speech: the residual is well above its noise floor and above the echo the filter is measured to leave.
+// pushReference() runs on the audio task, process() on one other task; the ring is single producer,
+// single consumer.
+
+#define AEC_SAMPLE_RATE     16000
+#define AEC_FRAME           128     // samples per VAD/adaptation step, 8ms
+#define AEC_TAPS            256     // 16ms of echo path after the bulk delay
+#define AEC_TAP_MARGIN      32      // taps before the estimated bulk delay, for jitter
+#define AEC_REF_RING        16384   // 1s of far end, power of two
+#define AEC_MAX_DELAY_MS    480     // far end written ahead of the mic: I2S DMA queue + acoustic path
+#define AEC_DECIMATE        8
+#define AEC_EST_WINDOW      256     // decimated samples correlated, 128ms
+#define AEC_LOCK_CORR       0.35f   // normalized correlation needed to accept a delay
+#define AEC_FAR_MIN_POWER   10000   // mean square of the far end window before the filter adapts, -50 dBFS
+#define AEC_SPEECH_MIN_POWER 2500   // mean square of the residual that can be speech, -56 dBFS
+#define AEC_TRUST_FRAMES    62      // adaptation frames after a lock before the detector trusts the filter
+#define AEC_PREROLL         4800    // residual kept for the ASR, 300ms
+#define AEC_BARGE_IN_MS     200     // default, near-end speech needed to barge in
+
+class EchoCanceller {
+  public:
+    EchoCanceller();
+    ~EchoCanceller();
+
+    bool begin();                        // allocates, PSRAM for the rings when there is PSRAM
+    void reset();                        // a new playback: filter, delay and detector start over
+
+    // Far end, interleaved 16 bit PCM at its own rate, any task
+    void pushReference(const int16_t* pcm, uint16_t frames, uint8_t channels, uint32_t sampleRate);
+    // Near end, AEC_FRAME mic samples at AEC_SAMPLE_RATE, replaced by the residual; one task
+    void process(int16_t* frame);
+
+    bool speechDetected() const;         // near-end speech for the barge-in time
+    bool locked() const;                 // bulk delay known, the filter runs
+    void setBargeInMs(uint16_t ms);
+    void setStepSize(float mu);          // NLMS step, 0.05 .. 1, default 0.3
+
+    size_t preroll(int16_t* out, size_t maxSamples) const;  // latest residual, oldest first
+
+    int delayMs() const;
+    float erleDb() const;                // echo return loss enhancement while the far end talks alone
+    uint32_t frameUs() const;            // average process() time per AEC_FRAME
+    String statsJson() const;
+
+  private:
+    // far end ring, written by pushReference()
+    int16_t* _ref;
+    volatile uint32_t _refWrite;         // samples written since begin(), wraps
+    Resampler _refSrc;
+    uint32_t _refRate;
+    int32_t _refDc;                      // DC estimate of the far end, Q12
+
+    // filter
+    int32_t* _w;                         // taps, reversed: _w[j] goes with the oldest sample of the window
+    int16_t* _x;                         // far end window of a frame, AEC_TAPS - 1 + AEC_FRAME
+    int32_t _muQ15;
+    bool _locked;
+    uint32_t _base;                      // far end index of mic sample 0 (+ AEC_TAP_MARGIN)
+    uint32_t _micCount;                  // mic samples processed since reset()
+    int32_t _dc;                         // DC estimate of the mic, Q12
+
+    // delay estimation
+    float* _micDec;                      // ring of AEC_EST_WINDOW decimated mic samples
+    float* _refDec;
+    uint16_t _micDecPos;
+    uint32_t _micDecCount;
+    int32_t _decAcc;
+    uint8_t _decLen;
+    uint32_t _nextEstimate;              // _micCount of the next estimate
+    int32_t _delaySamples;               // far end written this long before the mic hears it, -1: unknown
+    float _lastCorr;
+
+    // detector
+    float _noise;                        // residual noise floor, mean square
+    uint16_t _speechRun;                 // frames, speech counts up, silence down by 2
+    uint16_t _bargeInFrames;
+    uint16_t _hangover;                  // frames without adaptation after speech
+    uint16_t _adaptedFrames;             // frames adapted since the lock, see AEC_TRUST_FRAMES
+    float _erleIn;
+    float _erleOut;
+
+    int16_t* _preroll;
+    uint16_t _prerollPos;
+    bool _prerollFull;
+
+    uint32_t _usSum;
+    uint32_t _frames;
+
+    bool _fetchReference(uint32_t first, size_t count, int16_t* out) const;
+    void _decimateMic(const int16_t* frame);
+    void _estimateDelay();
+};
+
+#endif
@@ -2,10 +2,27 @@
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <SPIFFS.h>
-#include <WiFiClientSecure.h>
+#include <mbedtls/base64.h>
 #include "Audio.h"
+#include "LatencyTracer.h"
 
-ElevenLabsTTS::ElevenLabsTTS() {}
+extern Audio audio;
+
+static const char* ELEVENLABS_HOST = "api.elevenlabs.io";
+
+ElevenLabsTTS::ElevenLabsTTS()
+  : _streaming(true),
+    _wsOpen(false),
+    _final(false),
+    _pushing(false),
+    _audioBytes(0),
+    _lastRxMs(0),
+    _stopped(false),
+    _cancel(nullptr),
+    _cancelArg(nullptr),
+    _mp3Len(0) {
+  _scanReset();
+}
 
 void ElevenLabsTTS::setConfig(const char* apiKey,
                               const char* voiceId,
@@ -17,20 +34,464 @@ void ElevenLabsTTS::setConfig(const char* apiKey,
   _outputFormat = outputFormat == nullptr ? "mp3_22050_32" : outputFormat;
 }
 
+void ElevenLabsTTS::setStreaming(bool enable) {
+  _streaming = enable;
+}
+
 bool ElevenLabsTTS::isConfigured() const {
   return _apiKey.length() > 0 && _voiceId.length() > 0;
 }
 
-bool ElevenLabsTTS::speak(const String& text) {
+bool ElevenLabsTTS::isStreaming() const {
+  return _streaming && _outputFormat.startsWith("mp3");  // pcm/ulaw have no frames the decoder could sync on
+}
+
+bool ElevenLabsTTS::speak(const String& text, CancelCheck cancelled, void* cancelArg) {
   if (!isConfigured() || text.length() == 0) {
     return false;
   }
+  _cancel = cancelled;
+  _cancelArg = cancelArg;
+  bool ok = false;
+  if (isStreaming()) {
+    ok = _speakStream(text);
+    if (!ok && _audioBytes == 0 && !_cancelled()) {  // once a part played, the HTTP request would repeat it
+      Serial.println("[ElevenLabsTTS] Streaming failed, using HTTP");
+      ok = _speakHttp(text);
+    }
+  } else {
+    ok = _speakHttp(text);
+  }
+  _cancel = nullptr;
+  _cancelArg = nullptr;
+  return ok;
+}
+
+bool ElevenLabsTTS::_cancelled() const {
+  return _cancel != nullptr && _cancel(_cancelArg);
+}
+
+// ---------------- websocket stream-input ----------------
+
+bool ElevenLabsTTS::_speakStream(const String& text) {
+  if (!beginStream()) return false;
+
+  // sentence sized pieces, the service starts with the first one instead of waiting for the whole text
+  int n = text.length();
+  int from = 0;
+  while (from < n) {
+    int end = from;
+    while (end < n && !(strchr(".!?\n", text[end]) != nullptr && (end + 1 == n || isspace((unsigned char)text[end + 1])))) {
+      end++;
+    }
+    end = end + 2 < n ? end + 2 : n;  // keep the space after the punctuation
+    if (!streamText(text.substring(from, end))) {
+      abortStream();
+      return false;
+    }
+    from = end;
+  }
+  return endStream();
+}
+
+bool ElevenLabsTTS::beginStream() {
+  if (!isConfigured()) return false;
+  if (_wsOpen) _close();
+  _final = false;
+  _pushing = false;
+  _stopped = false;
+  _audioBytes = 0;
+  _mp3Len = 0;
+  _scanReset();
+
+  latencyTracer.begin(LAT_TTS);  // ends with the first samples on I2S, see audio_first_samples()
+  if (!_wsConnect()) return false;
+
+  // first message opens the stream; a short first chunk gets the first audio out early
+  String bos = "{\"text\":\" \",\"generation_config\":{\"chunk_length_schedule\":[50,120,160,250]}}";
+  if (!_wsSend((const uint8_t*)bos.c_str(), bos.length())) {
+    _close();
+    return false;
+  }
+  _lastRxMs = millis();
+  return true;
+}
+
+bool ElevenLabsTTS::streamText(const String& text) {
+  if (!_wsOpen || _stopped) return false;
+  if (text.length() == 0) return true;
+
+  DynamicJsonDocument doc(text.length() + 64);
+  doc["text"] = text;
+  String msg;
+  serializeJson(doc, msg);
+  if (!_wsSend((const uint8_t*)msg.c_str(), msg.length())) {
+    Serial.println("[ElevenLabsTTS] Send failed");
+    _close();
+    return false;
+  }
+  return _poll(0) && !_stopped;  // take what audio is there, don't wait for more
+}
+
+bool ElevenLabsTTS::endStream() {
+  static const char eos[] = "{\"text\":\"\"}";  // flushes the rest and closes the stream after isFinal
+  bool sent = _wsOpen && !_stopped && _wsSend((const uint8_t*)eos, sizeof(eos) - 1);
+  while (sent && !_final && !_stopped) {
+    if (!_poll(50)) break;
+    if (millis() - _lastRxMs > ELEVENLABS_WS_IDLE_MS) {
+      Serial.println("[ElevenLabsTTS] Stream timeout");
+      break;
+    }
+  }
+  _close();
+  if (_pushing && !_stopped) audio.pushEnd();
+  if (!_final && !_stopped) {
+    Serial.printf("[ElevenLabsTTS] Stream ended early after %u audio bytes\n", (unsigned)_audioBytes);
+  }
+  return _audioBytes > 0 && !_stopped;
+}
+
+void ElevenLabsTTS::abortStream() {
+  _close();
+  if (_pushing && !_stopped) audio.pushEnd();
+}
 
+bool ElevenLabsTTS::_wsConnect() {
+  _ws.setInsecure();
+  if (!_ws.connect(ELEVENLABS_HOST, 443)) {
+    Serial.println("[ElevenLabsTTS] Connection failed");
+    return false;
+  }
+  _ws.setNoDelay(true);
+
+  uint8_t nonce[16];
+  for (int i = 0; i < 16; i++) nonce[i] = random(0, 256);
+  unsigned char key[32];
+  size_t keyLen = 0;
+  mbedtls_base64_encode(key, sizeof(key), &keyLen, nonce, sizeof(nonce));
+  key[keyLen] = '\0';
+
+  String request = "GET /v1/text-to-speech/" + _voiceId + "/stream-input?model_id=" + _modelId;
+  request += "&output_format=" + _outputFormat + " HTTP/1.1\r\n";
+  request += String("Host: ") + ELEVENLABS_HOST + "\r\n";
+  request += "Upgrade: websocket\r\n";
+  request += "Connection: Upgrade\r\n";
+  request += String("Sec-WebSocket-Key: ") + (const char*)key + "\r\n";
+  request += "Sec-WebSocket-Version: 13\r\n";
+  request += "xi-api-key: " + _apiKey + "\r\n";
+  request += "\r\n";
+  _ws.print(request);
+
+  unsigned long start = millis();
+  while (_ws.connected() && !_ws.available()) {
+    if (millis() - start > 5000) {
+      Serial.println("[ElevenLabsTTS] Handshake timeout");
+      _ws.stop();
+      return false;
+    }
+    delay(5);
+  }
+  String status = _ws.readStringUntil('\n');
+  while (_ws.connected() || _ws.available()) {
+    String line = _ws.readStringUntil('\n');
+    if (line == "\r" || line.length() == 0) break;
+  }
+  if (status.indexOf(" 101") < 0) {
+    Serial.printf("[ElevenLabsTTS] Handshake failed: %s\n", status.c_str());
+    _ws.stop();
+    return false;
+  }
+  _wsOpen = true;
+  return true;
+}
+
+void ElevenLabsTTS::_close() {
+  if (_wsOpen && _ws.connected()) {
+    _wsSend(nullptr, 0, 0x08);
+  }
+  _ws.stop();
+  _wsOpen = false;
+}
+
+// Client frames are masked. Header, mask and payload go out in one write, one TLS record.
+bool ElevenLabsTTS::_wsSend(const uint8_t* data, size_t len, uint8_t opcode) {
+  size_t headerLen = len < 126 ? 2 : (len <= 0xFFFF ? 4 : 10);
+  size_t total = headerLen + 4 + len;
+  uint8_t* frame = (uint8_t*)malloc(total);
+  if (frame == nullptr) return false;
+
+  frame[0] = 0x80 | opcode;  // FIN + opcode
+  if (len < 126) {
+    frame[1] = 0x80 | (uint8_t)len;
+  } else if (len <= 0xFFFF) {
+    frame[1] = 0x80 | 126;
+    frame[2] = (uint8_t)(len >> 8);
+    frame[3] = (uint8_t)len;
+  } else {
+    frame[1] = 0x80 | 127;
+    for (int i = 0; i < 8; i++) frame[2 + i] = (uint8_t)((uint64_t)len >> (56 - 8 * i));
+  }
+  uint8_t* mask = frame + headerLen;
+  uint32_t r = esp_random();
+  memcpy(mask, &r, 4);
+  uint8_t* payload = mask + 4;
+  for (size_t i = 0; i < len; i++) payload[i] = data[i] ^ mask[i & 3];
+
+  size_t written = _ws.write(frame, total);
+  free(frame);
+  return written == total;
+}
+
+static bool readExact(WiFiClientSecure& client, uint8_t* buf, size_t len) {
+  size_t got = 0;
+  unsigned long last = millis();
+  while (got < len) {
+    int avail = client.available();
+    if (avail > 0) {
+      int n = client.read(buf + got, min((size_t)avail, len - got));
+      if (n > 0) {
+        got += n;
+        last = millis();
+        continue;
+      }
+    }
+    if (!client.connected() || millis() - last > 5000) return false;
+    delay(1);
+  }
+  return true;
+}
+
+// Handles the frames that arrived, waits up to waitMs for the next one. false when the socket is gone.
+bool ElevenLabsTTS::_poll(uint32_t waitMs) {
+  unsigned long start = millis();
+  while (_wsOpen) {
+    if (_ws.available() > 0) {
+      if (!_readFrame()) {
+        _close();
+        return false;
+      }
+      _lastRxMs = millis();
+      if (_final || _stopped) return true;
+      continue;
+    }
+    if (!_ws.connected()) {
+      _wsOpen = false;
+      return false;
+    }
+    if (millis() - start >= waitMs) return true;
+    delay(2);
+  }
+  return false;
+}
+
+bool ElevenLabsTTS::_readFrame() {
+  uint8_t head[2];
+  if (!readExact(_ws, head, 2)) return false;
+  bool fin = head[0] & 0x80;
+  uint8_t opcode = head[0] & 0x0F;
+  bool masked = head[1] & 0x80;
+  uint64_t len = head[1] & 0x7F;
+  if (len >= 126) {
+    uint8_t ext[8];
+    size_t n = len == 126 ? 2 : 8;
+    if (!readExact(_ws, ext, n)) return false;
+    len = 0;
+    for (size_t i = 0; i < n; i++) len = (len << 8) | ext[i];
+  }
+  uint8_t mask[4] = {0};
+  if (masked && !readExact(_ws, mask, 4)) return false;
+
+  if (opcode == 0x08) {  // close
+    _wsOpen = false;
+    return false;
+  }
+  if (opcode == 0x09 || opcode == 0x0A) {  // ping, pong
+    uint8_t ctl[125];
+    if (len > sizeof(ctl) || !readExact(_ws, ctl, (size_t)len)) return false;
+    for (size_t i = 0; masked && i < len; i++) ctl[i] ^= mask[i & 3];
+    if (opcode == 0x09) _wsSend(ctl, (size_t)len, 0x0A);
+    return true;
+  }
+
+  if (opcode != 0x00) _scanReset();  // a new message, continuation frames keep the scan state
+  uint8_t buf[512];
+  uint64_t done = 0;
+  while (done < len) {
+    size_t n = len - done > sizeof(buf) ? sizeof(buf) : (size_t)(len - done);
+    if (!readExact(_ws, buf, n)) return false;
+    for (size_t i = 0; masked && i < n; i++) buf[i] ^= mask[(done + i) & 3];
+    _scan(buf, n);
+    done += n;
+  }
+  if (fin) _scanEnd();
+  return true;
+}
+
+// ---------------- message scan ----------------
+// {"audio":"<base64 mp3>","isFinal":false,"normalizedAlignment":{...},"alignment":{...}}, the last
+// message has "isFinal":true. Errors come as {"message":...,"error":...}.
+
+static int8_t b64Value(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;  // '\' of an escaped "\/" and anything else is skipped
+}
+
+static uint8_t matchStep(uint8_t matched, char c, const char* pattern) {
+  if (c == pattern[matched]) return matched + 1;
+  return c == '"' ? 1 : 0;
+}
+
+void ElevenLabsTTS::_scanReset() {
+  _matchAudio = 0;
+  _matchFinal = 0;
+  _key = 0;
+  _colon = false;
+  _inAudio = false;
+  _msgAudio = false;
+  _quadLen = 0;
+  _msgHeadLen = 0;
+  _msgHead[0] = '\0';
+}
+
+void ElevenLabsTTS::_scan(const uint8_t* data, size_t len) {
+  static const char AUDIO_KEY[] = "\"audio\"";
+  static const char FINAL_KEY[] = "\"isFinal\"";
+
+  for (size_t i = 0; i < len; i++) {
+    char c = (char)data[i];
+    if (_msgHeadLen < sizeof(_msgHead) - 1) {
+      _msgHead[_msgHeadLen++] = c;
+      _msgHead[_msgHeadLen] = '\0';
+    }
+
+    if (_inAudio) {
+      if (c == '"') {
+        _b64Tail();
+        _inAudio = false;
+      } else if (c == '=') {
+        _b64Tail();
+      } else {
+        _b64(c);
+      }
+      continue;
+    }
+
+    if (_key != 0) {
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+      if (!_colon) {
+        _colon = c == ':';
+        if (!_colon) _key = 0;
+        continue;
+      }
+      if (_key == 1 && c == '"') {
+        _inAudio = true;
+        _msgAudio = true;
+      } else if (_key == 2) {
+        _final = c == 't';
+      }
+      _key = 0;  // "audio":null and "isFinal":false end here
+      continue;
+    }
+
+    _matchAudio = matchStep(_matchAudio, c, AUDIO_KEY);
+    _matchFinal = matchStep(_matchFinal, c, FINAL_KEY);
+    if (_matchAudio == sizeof(AUDIO_KEY) - 1) {
+      _key = 1;
+    } else if (_matchFinal == sizeof(FINAL_KEY) - 1) {
+      _key = 2;
+    }
+    if (_key != 0) {
+      _colon = false;
+      _matchAudio = 0;
+      _matchFinal = 0;
+    }
+  }
+}
+
+void ElevenLabsTTS::_scanEnd() {
+  if (_inAudio) {  // cut off, decode what came
+    _b64Tail();
+    _inAudio = false;
+  }
+  _flushAudio();
+  if (!_msgAudio && !_final && (strstr(_msgHead, "\"error\"") != nullptr || strstr(_msgHead, "\"message\"") != nullptr)) {
+    Serial.printf("[ElevenLabsTTS] %s\n", _msgHead);
+  }
+}
+
+void ElevenLabsTTS::_b64(char c) {
+  int8_t v = b64Value(c);
+  if (v < 0 || _stopped) return;
+  _quad[_quadLen++] = (uint8_t)v;
+  if (_quadLen < 4) return;
+  _mp3[_mp3Len++] = (_quad[0] << 2) | (_quad[1] >> 4);
+  _mp3[_mp3Len++] = (_quad[1] << 4) | (_quad[2] >> 2);
+  _mp3[_mp3Len++] = (_quad[2] << 6) | _quad[3];
+  _quadLen = 0;
+  if (_mp3Len + 3 > sizeof(_mp3)) _flushAudio();
+}
+
+void ElevenLabsTTS::_b64Tail() {  // 2 or 3 chars before the padding
+  if (_quadLen >= 2 && !_stopped) _mp3[_mp3Len++] = (_quad[0] << 2) | (_quad[1] >> 4);
+  if (_quadLen >= 3 && !_stopped) _mp3[_mp3Len++] = (_quad[1] << 4) | (_quad[2] >> 2);
+  _quadLen = 0;
+}
+
+// Hands the decoded bytes to the Audio library, waits while its input buffer is full.
+bool ElevenLabsTTS::_flushAudio() {
+  if (!_stopped && _cancelled()) {
+    if (_pushing) audio.stopSong();     // cancelled while it plays, e.g. by a barge-in
+    _stopped = true;
+  }
+  if (_mp3Len == 0 || _stopped) {
+    _mp3Len = 0;
+    return !_stopped;
+  }
+  if (!_pushing) {
+    if (!audio.connecttoPush("mp3")) {
+      Serial.println("[ElevenLabsTTS] audio.connecttoPush failed");
+      _stopped = true;
+      _mp3Len = 0;
+      return false;
+    }
+    _pushing = true;
+    latencyTracer.first(LAT_TTS);
+  }
+
+  size_t off = 0;
+  unsigned long last = millis();
+  while (off < _mp3Len) {
+    size_t n = audio.pushData(_mp3 + off, _mp3Len - off);
+    if (n > 0) {
+      off += n;
+      last = millis();
+      continue;
+    }
+    if (!audio.isRunning() || millis() - last > ELEVENLABS_WS_IDLE_MS) {  // stopped, e.g. by the button
+      _stopped = true;
+      break;
+    }
+    delay(5);
+  }
+  _audioBytes += off;
+  _mp3Len = 0;
+  return !_stopped;
+}
+
+// ---------------- HTTP ----------------
+
+bool ElevenLabsTTS::_speakHttp(const String& text) {
   if (!SPIFFS.begin(true)) {
     Serial.println("[ElevenLabsTTS] SPIFFS init failed");
     return false;
   }
 
+  latencyTracer.begin(LAT_TTS);  // ends with the first samples on I2S, see audio_first_samples()
+
   DynamicJsonDocument doc(1024);
   doc["text"] = text;
   doc["model_id"] = _modelId;
@@ -38,7 +499,7 @@ bool ElevenLabsTTS::speak(const String& text) {
   String payload;
   serializeJson(doc, payload);
 
-  String url = "https://api.elevenlabs.io/v1/text-to-speech/" + _voiceId;
+  String url = String("https://") + ELEVENLABS_HOST + "/v1/text-to-speech/" + _voiceId;
   if (_outputFormat.length() > 0) {
     url += "?output_format=" + _outputFormat;
   }
@@ -71,10 +532,15 @@ bool ElevenLabsTTS::speak(const String& text) {
   size_t total = 0;
   unsigned long lastDataMs = millis();
   while (http.connected() || stream->available()) {
+    if (_cancelled()) {
+      total = 0;
+      break;
+    }
     int available = stream->available();
     if (available > 0) {
       int n = stream->readBytes(buf, (available > (int)sizeof(buf)) ? sizeof(buf) : available);
       if (n > 0) {
+        if (total == 0) latencyTracer.first(LAT_TTS);
         f.write(buf, n);
         total += (size_t)n;
         lastDataMs = millis();
@@ -90,12 +556,12 @@ bool ElevenLabsTTS::speak(const String& text) {
   f.close();
   http.end();
 
+  if (_cancelled()) return false;
   if (total == 0) {
     Serial.println("[ElevenLabsTTS] Empty audio response");
     return false;
   }
 
-  extern Audio audio;
   bool ok = audio.connecttoFS(SPIFFS, "/elevenlabs_tts.mp3");
   if (!ok) {
     Serial.println("[ElevenLabsTTS] audio.connecttoFS failed");
@@ -2,6 +2,15 @@
 #define ElevenLabsTTS_h
 
 #include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include "AsyncJobRunner.h"
+
+// ElevenLabs TTS. Streaming mode uses the websocket stream-input API: text goes up in pieces, the base64
+// audio chunks that come back are decoded straight into the Audio input buffer (Audio::pushData), no
+// file on SPIFFS and no wait for the whole synthesis. Needs an mp3 output format, else speak() uses the
+// HTTP endpoint. Runs on the calling task, the Audio library plays from its own task meanwhile.
+
+#define ELEVENLABS_WS_IDLE_MS  10000   // no message from the service for this long ends the stream
 
 class ElevenLabsTTS {
   public:
@@ -11,15 +20,66 @@ class ElevenLabsTTS {
                    const char* voiceId,
                    const char* modelId = "eleven_flash_v2_5",
                    const char* outputFormat = "mp3_22050_32");
+    void setStreaming(bool enable);
 
     bool isConfigured() const;
-    bool speak(const String& text);
+    bool isStreaming() const;
+    // cancelled() is checked before playback starts and while audio is handed over
+    bool speak(const String& text, CancelCheck cancelled = nullptr, void* cancelArg = nullptr);
+
+    // Incremental input, e.g. text from a streaming LLM. The pieces are joined as they are, so keep the
+    // spaces between words. streamText() does not wait for audio, endStream() returns when all audio is
+    // handed to the Audio library.
+    bool beginStream();
+    bool streamText(const String& text);
+    bool endStream();
+    void abortStream();                 // closes the socket, audio that was already pushed still plays
 
   private:
     String _apiKey;
     String _voiceId;
     String _modelId;
     String _outputFormat;
+    bool _streaming;
+
+    WiFiClientSecure _ws;
+    bool _wsOpen;
+    bool _final;                        // isFinal received
+    bool _pushing;                      // audio.connecttoPush() done for this stream
+    size_t _audioBytes;
+    unsigned long _lastRxMs;
+
+    // incremental scan of a server message, an audio chunk is too big to buffer the whole payload
+    uint8_t _matchAudio;                // chars of "audio" matched
+    uint8_t _matchFinal;                // chars of "isFinal" matched
+    uint8_t _key;                       // 0 none, 1 "audio", 2 "isFinal": waiting for its value
+    bool _colon;
+    bool _inAudio;                      // inside the base64 string
+    bool _msgAudio;                     // the current message carried audio
+    bool _stopped;                      // playback was stopped, drop the rest
+    CancelCheck _cancel;                // of the current speak(), nullptr for the stream API
+    void* _cancelArg;
+    uint8_t _quad[4];
+    uint8_t _quadLen;
+    uint8_t _mp3[768];                  // decoded bytes waiting for the Audio buffer
+    size_t _mp3Len;
+    char _msgHead[96];                  // start of the current message, logged if it is an error
+    size_t _msgHeadLen;
+
+    bool _cancelled() const;
+    bool _speakHttp(const String& text);
+    bool _speakStream(const String& text);
+    bool _wsConnect();
+    bool _wsSend(const uint8_t* data, size_t len, uint8_t opcode = 0x01);
+    bool _poll(uint32_t waitMs);
+    bool _readFrame();
+    void _scanReset();
+    void _scan(const uint8_t* data, size_t len);
+    void _scanEnd();
+    void _b64(char c);
+    void _b64Tail();
+    bool _flushAudio();
+    void _close();
 };
 
 #endif
@@ -3,6 +3,8 @@
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
+#include "LatencyTracer.h"
+#include "SystemTelemetry.h"
 
 GeminiASRChat::GeminiASRChat(const char* apiKey, const char* model, const char* baseUrl)
     : _apiKey(apiKey == nullptr ? "" : apiKey),
@@ -28,6 +30,7 @@ bool GeminiASRChat::initINMP441Microphone(int i2sSckPin, int i2sWsPin, int i2sSd
     return false;
   }
   _micInitialized = true;
+  systemTelemetry.attachI2S("mic", _I2S.rxChan(), false);  // overruns while recording
   Serial.println("INMP441 microphone initialized");
 
   delay(300);
@@ -119,6 +122,9 @@ bool GeminiASRChat::startRecording() {
   _lastSpeechMs = _recordingStartMs;
   _lastDotMs = _recordingStartMs;
   _isRecording = true;
+  latencyTracer.beginTurn();
+  systemTelemetry.setI2SArmed(_I2S.rxChan(), true);
+  latencyTracer.begin(LAT_ASR_CAPTURE);
 
   Serial.println("========================================");
   Serial.println("Recording started...");
@@ -128,12 +134,20 @@ bool GeminiASRChat::startRecording() {
 
 void GeminiASRChat::stopRecording() {
   _isRecording = false;
+  systemTelemetry.setI2SArmed(_I2S.rxChan(), false);
 }
 
 bool GeminiASRChat::isRecording() {
   return _isRecording;
 }
 
+size_t GeminiASRChat::readMicrophone(int16_t* out, size_t maxSamples) {
+  if (_isRecording || !_micInitialized || out == nullptr || maxSamples == 0) return 0;
+  size_t bytes = 0;
+  i2s_channel_read(_I2S.rxChan(), out, maxSamples * sizeof(int16_t), &bytes, 0);
+  return bytes / sizeof(int16_t);
+}
+
 void GeminiASRChat::loop() {
   if (!_isRecording) {
     return;
@@ -157,6 +171,7 @@ void GeminiASRChat::loop() {
     }
 
     if (abs((int)s) >= _speechThreshold) {
+      if (!_hasSpeech) latencyTracer.first(LAT_ASR_CAPTURE);
       _hasSpeech = true;
       _lastSpeechMs = now;
     }
@@ -172,17 +187,23 @@ void GeminiASRChat::loop() {
   }
 
   _isRecording = false;
+  systemTelemetry.setI2SArmed(_I2S.rxChan(), false);
   Serial.println();
+  latencyTracer.end(LAT_ASR_CAPTURE);
 
   if (!_hasSpeech || _pcmSamples < (size_t)(_sampleRate / 6)) {
     Serial.println("[Gemini ASR] No speech detected");
+    latencyTracer.cancelTurn();
     if (_timeoutNoSpeechCallback != nullptr) {
       _timeoutNoSpeechCallback();
     }
     return;
   }
 
+  latencyTracer.recordSince(LAT_ASR_ENDPOINT, _lastSpeechMs);
+  latencyTracer.begin(LAT_ASR_TRANSCRIBE);
   String result = transcribeCurrentBuffer();
+  latencyTracer.end(LAT_ASR_TRANSCRIBE);
   if (result.length() == 0) {
     Serial.println("[Gemini ASR] Empty transcription result");
     return;
@@ -220,6 +241,7 @@ String GeminiASRChat::postTranscription(const String& payload) {
 
   http.addHeader("Content-Type", "application/json");
   int code = http.POST(payload);
+  latencyTracer.first(LAT_ASR_TRANSCRIBE);
   if (code != 200) {
     String err = http.getString();
     Serial.printf("[Gemini ASR] HTTP %d: %s\n", code, err.c_str());
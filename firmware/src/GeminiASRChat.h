@@ -26,6 +26,7 @@ class GeminiASRChat {
     void stopRecording();
     bool isRecording();
     void loop();
+    size_t readMicrophone(int16_t* out, size_t maxSamples);  // while not recording, never blocks
 
     String getRecognizedText();
     bool hasNewResult();
@@ -1,11 +1,14 @@
 #include "GeminiProvider.h"
 #include <ArduinoJson.h>
 #include <WiFiClientSecure.h>
+#include "LatencyTracer.h"
+#include "LLMReply.h"
 
 GeminiProvider::GeminiProvider(const char* apiKey, const char* baseUrl)
   : _apiKey(apiKey == nullptr ? "" : apiKey),
     _baseUrl(baseUrl == nullptr ? "https://generativelanguage.googleapis.com" : baseUrl),
-    _model("gemini-2.0-flash") {}
+    _model("gemini-2.0-flash"),
+    _history(HISTORY_GEMINI) {}
 
 void GeminiProvider::setApiConfig(const char* apiKey, const char* baseUrl) {
   if (apiKey != nullptr) {
@@ -17,18 +20,46 @@ void GeminiProvider::setApiConfig(const char* apiKey, const char* baseUrl) {
 }
 
 String GeminiProvider::sendMessage(const String& message) {
-  String payload = _buildPayload(message);
-  String response = _postJson(_buildEndpoint(false), payload);
-  String text = _extractTextFromResponse(response);
-
-  if (_memoryEnabled && text.length() > 0) {
-    _history.push_back(std::make_pair(message, text));
-    while (_history.size() > _maxHistoryPairs) {
-      _history.erase(_history.begin());
-    }
+  latencyTracer.begin(LAT_LLM);
+  String text = requestReply(message);
+  latencyTracer.end(LAT_LLM);
+  appendExchange(message, text);
+  return text;
+}
+
+String GeminiProvider::requestReply(const String& message) {
+  String payload = _buildPayload(_history.systemPrompt(_systemPrompt), message, true);
+  return _postForText(_buildEndpoint(false), payload);
+}
+
+void GeminiProvider::appendExchange(const String& userMessage, const String& reply) {
+  if (_memoryEnabled && reply.length() > 0) {
+    _history.append(userMessage, reply);
   }
+}
 
-  return text;
+void GeminiProvider::setHistoryBudget(size_t tokens) {
+  _history.setTokenBudget(tokens);
+}
+
+bool GeminiProvider::historyNeedsSummary() const {
+  return _memoryEnabled && _history.needsSummary();
+}
+
+// One request without system prompt or history
+bool GeminiProvider::summarizeHistory() {
+  String request;
+  size_t folded = 0;
+  if (!_history.summaryRequest(request, folded)) {
+    return false;
+  }
+  String summary = _postForText(_buildEndpoint(false), _buildPayload("", request, false));
+  _history.applySummary(summary, folded);
+  return summary.length() > 0;
+}
+
+void GeminiProvider::setRequestTimeout(uint32_t ms) {
+  _requestTimeoutMs = ms;
 }
 
 String GeminiProvider::sendVisionMessage(const uint8_t* imageData, size_t imageSize, const String& question, const char* mimeType) {
@@ -38,8 +69,8 @@ String GeminiProvider::sendVisionMessage(const uint8_t* imageData, size_t imageS
   }
 
   String payload = _buildVisionPayload(question, b64, mimeType);
-  String response = _postJson(_buildEndpoint(false), payload);
-  return _extractTextFromResponse(response);
+  b64 = String();  // the payload has a copy
+  return _postForText(_buildEndpoint(false), payload);
 }
 
 void GeminiProvider::setSystemPrompt(const String& prompt) {
@@ -78,7 +109,7 @@ String GeminiProvider::_buildEndpoint(bool stream) const {
   return path;
 }
 
-String GeminiProvider::_postJson(const String& endpointPath, const String& payload) {
+String GeminiProvider::_postForText(const String& endpointPath, const String& payload) {
   if (_apiKey.length() == 0) {
     return "";
   }
@@ -88,8 +119,14 @@ String GeminiProvider::_postJson(const String& endpointPath, const String& paylo
   HTTPClient http;
   String url = _baseUrl + endpointPath;
   http.begin(client, url);
+  if (_requestTimeoutMs > 0) {
+    http.setConnectTimeout(_requestTimeoutMs);
+    http.setTimeout(_requestTimeoutMs > 0xFFFF ? 0xFFFF : _requestTimeoutMs);
+  }
   http.addHeader("Content-Type", "application/json");
+  http.useHTTP10(true);  // plain body on the stream, no chunked encoding
   int code = http.POST(payload);
+  latencyTracer.first(LAT_LLM);  // no-op for the vision requests, they run outside the LLM span
   if (code != 200) {
     String err = http.getString();
     http.end();
@@ -97,72 +134,33 @@ String GeminiProvider::_postJson(const String& endpointPath, const String& paylo
     return "";
   }
 
-  String response = http.getString();
+  String out = readLLMReply(http.getStream(), http.getSize(), LLM_REPLY_GEMINI, "Gemini");
   http.end();
-  return response;
-}
-
-String GeminiProvider::_extractTextFromResponse(const String& response) const {
-  DynamicJsonDocument doc(8192);
-  if (deserializeJson(doc, response) != DeserializationError::Ok) {
-    return "";
-  }
-
-  if (!doc["candidates"].is<JsonArray>() || doc["candidates"].size() == 0) {
-    return "";
-  }
-
-  JsonVariant parts = doc["candidates"][0]["content"]["parts"];
-  if (!parts.is<JsonArray>() || parts.size() == 0) {
-    return "";
-  }
-
-  String out = parts[0]["text"].as<String>();
   out.replace("\n", " ");
   out.replace("\r", "");
   return out;
 }
 
-String GeminiProvider::_buildPayload(const String& userMessage) const {
-  DynamicJsonDocument doc(8192);
-
-  if (_systemPrompt.length() > 0) {
-    JsonObject sys = doc.createNestedObject("systemInstruction");
-    JsonArray parts = sys.createNestedArray("parts");
-    JsonObject part = parts.createNestedObject();
-    part["text"] = _systemPrompt;
+// Built by concatenation, the history is kept as ready JSON fragments
+String GeminiProvider::_buildPayload(const String& systemPrompt, const String& userMessage, bool withHistory) const {
+  String payload;
+  payload.reserve(192 + systemPrompt.length() + userMessage.length() + (withHistory ? _history.tokens() * 5 : 0));
+  payload = "{";
+  if (systemPrompt.length() > 0) {
+    payload += "\"systemInstruction\":{\"parts\":[{\"text\":";
+    ConversationHistory::appendJsonString(payload, systemPrompt);
+    payload += "}]},";
   }
 
-  JsonArray contents = doc.createNestedArray("contents");
-
-  if (_memoryEnabled) {
-    for (size_t i = 0; i < _history.size(); i++) {
-      JsonObject user = contents.createNestedObject();
-      user["role"] = "user";
-      JsonArray userParts = user.createNestedArray("parts");
-      JsonObject userText = userParts.createNestedObject();
-      userText["text"] = _history[i].first;
-
-      JsonObject model = contents.createNestedObject();
-      model["role"] = "model";
-      JsonArray modelParts = model.createNestedArray("parts");
-      JsonObject modelText = modelParts.createNestedObject();
-      modelText["text"] = _history[i].second;
-    }
+  payload += "\"contents\":[";
+  if (withHistory && _memoryEnabled && _history.appendFragments(payload)) {
+    payload += ",";
   }
+  payload += "{\"role\":\"user\",\"parts\":[{\"text\":";
+  ConversationHistory::appendJsonString(payload, userMessage);
+  payload += "}]}],";
 
-  JsonObject current = contents.createNestedObject();
-  current["role"] = "user";
-  JsonArray currentParts = current.createNestedArray("parts");
-  JsonObject currentText = currentParts.createNestedObject();
-  currentText["text"] = userMessage;
-
-  JsonObject generationConfig = doc.createNestedObject("generationConfig");
-  generationConfig["temperature"] = 0.8;
-  generationConfig["maxOutputTokens"] = 256;
-
-  String payload;
-  serializeJson(doc, payload);
+  payload += "\"generationConfig\":{\"temperature\":0.8,\"maxOutputTokens\":256}}";
   return payload;
 }
 
@@ -3,8 +3,8 @@
 
 #include <Arduino.h>
 #include <HTTPClient.h>
-#include <vector>
 #include "AIProvider.h"
+#include "ConversationHistory.h"
 
 class GeminiProvider : public AIProvider {
   public:
@@ -20,6 +20,12 @@ class GeminiProvider : public AIProvider {
     void setModel(const String& model) override;
     String getModel() const override;
     String getProviderName() const override;
+    String requestReply(const String& message) override;
+    void appendExchange(const String& userMessage, const String& reply) override;
+    void setRequestTimeout(uint32_t ms) override;
+    void setHistoryBudget(size_t tokens) override;
+    bool historyNeedsSummary() const override;
+    bool summarizeHistory() override;
 
   private:
     String _apiKey;
@@ -27,13 +33,12 @@ class GeminiProvider : public AIProvider {
     String _model;
     String _systemPrompt;
     bool _memoryEnabled = true;
-    size_t _maxHistoryPairs = 5;
-    std::vector<std::pair<String, String>> _history;
+    ConversationHistory _history;
+    uint32_t _requestTimeoutMs = 0;
 
     String _buildEndpoint(bool stream = false) const;
-    String _postJson(const String& endpointPath, const String& payload);
-    String _extractTextFromResponse(const String& response) const;
-    String _buildPayload(const String& userMessage) const;
+    String _postForText(const String& endpointPath, const String& payload);  // reply text, parsed from the stream
+    String _buildPayload(const String& systemPrompt, const String& userMessage, bool withHistory) const;
     String _buildVisionPayload(const String& question, const String& base64Image, const char* mimeType) const;
     String _base64Encode(const uint8_t* data, size_t len) const;
 };
@@ -0,0 +1,396 @@
+#include "HedgedProvider.h"
+#include <ArduinoJson.h>
+#include "LatencyTracer.h"
+
+static const float HEDGE_EWMA_ALPHA = 0.2f;
+static const float HEDGE_UNKNOWN_MS = 3000.0f;  // score of a member without samples
+static const float HEDGE_PREFER_BIAS = 0.8f;    // the configured provider wins close calls
+
+HedgedProvider::HedgedProvider()
+  : _count(0),
+    _preferred(0),
+    _lastWinner(-1),
+    _results(nullptr),
+    _turn(0),
+    _deadlineMs(15000),
+    _hedgePct(90),
+    _hedgeMinMs(800),
+    _hedgeDefaultMs(2500),
+    _memoryEnabled(true),
+    _promptVersion(0) {
+  memset(_members, 0, sizeof(_members));
+  memset(_lanes, 0, sizeof(_lanes));
+}
+
+bool HedgedProvider::addProvider(AIProvider* provider) {
+  if (provider == nullptr) return false;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_members[i].provider == provider) return true;
+  }
+  if (_count >= HEDGE_MAX_MEMBERS) return false;
+  Member& m = _members[_count++];
+  memset(&m, 0, sizeof(m));
+  m.provider = provider;
+  provider->clearMemory();          // drop whatever it remembers from before
+  m.promptSynced = 0;               // keeps its own prompt until setSystemPrompt()
+  return true;
+}
+
+void HedgedProvider::prefer(AIProvider* provider) {
+  if (!addProvider(provider)) return;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (_members[i].provider == provider) _preferred = i;
+  }
+}
+
+void HedgedProvider::setDeadline(uint32_t ms) {
+  _deadlineMs = ms < 1000 ? 1000 : ms;
+}
+
+void HedgedProvider::setHedgePercentile(uint8_t pct) {
+  _hedgePct = pct > 99 ? 99 : pct;
+}
+
+void HedgedProvider::setHedgeDelayLimits(uint32_t minMs, uint32_t defaultMs) {
+  _hedgeMinMs = minMs;
+  _hedgeDefaultMs = defaultMs;
+}
+
+// ---------------- routing ----------------
+
+int HedgedProvider::_pick(int exclude) const {
+  uint32_t now = millis();
+  int best = -1;
+  float bestScore = 0;
+  for (int pass = 0; pass < 2 && best < 0; pass++) {  // second pass: all cooling down, take one anyway
+    for (uint8_t i = 0; i < _count; i++) {
+      const Member& m = _members[i];
+      if ((int)i == exclude || m.busy) continue;
+      if (pass == 0 && (int32_t)(m.cooldownUntil - now) > 0) continue;
+      float score = (m.successes > 0 ? m.ewmaMs : HEDGE_UNKNOWN_MS) * (1.0f + 3.0f * m.errRate);
+      if (i == _preferred) score *= HEDGE_PREFER_BIAS;
+      if (best < 0 || score < bestScore) {
+        best = i;
+        bestScore = score;
+      }
+    }
+  }
+  return best;
+}
+
+// p-th percentile of the member's recent latencies (nearest rank), clamped to [min, deadline/2]
+uint32_t HedgedProvider::_hedgeDelay(uint8_t member) const {
+  const Member& m = _members[member];
+  uint32_t delay = _hedgeDefaultMs;
+  if (m.windowCount >= 4) {
+    uint32_t v[HEDGE_LATENCY_WINDOW];
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < m.windowCount; i++) {  // insertion sort, at most 16 values
+      uint32_t x = m.window[i];
+      uint8_t j = n++;
+      while (j > 0 && v[j - 1] > x) {
+        v[j] = v[j - 1];
+        j--;
+      }
+      v[j] = x;
+    }
+    uint16_t rank = ((uint16_t)_hedgePct * n + 99) / 100;
+    delay = v[rank > 0 ? rank - 1 : 0];
+  }
+  if (delay < _hedgeMinMs) delay = _hedgeMinMs;
+  if (delay > _deadlineMs / 2) delay = _deadlineMs / 2;
+  return delay;
+}
+
+// ---------------- lanes ----------------
+
+void HedgedProvider::_laneTask(void* arg) {
+  Lane* lane = (Lane*)arg;
+  Call* c = nullptr;
+  for (;;) {
+    if (xQueueReceive(lane->inbox, &c, portMAX_DELAY) != pdTRUE) continue;
+    c->reply = c->provider->requestReply(c->message);
+    c->elapsedMs = millis() - c->startMs;
+    xQueueSend(lane->results, &c, portMAX_DELAY);  // sized for every lane, never full
+  }
+}
+
+// the system prompt, if it changed since the member's last request; it is idle here
+void HedgedProvider::_sync(Member& m) {
+  if (m.promptSynced != _promptVersion) {
+    m.provider->setSystemPrompt(_systemPrompt);
+    m.promptSynced = _promptVersion;
+  }
+}
+
+bool HedgedProvider::_laneFree() const {
+  for (uint8_t i = 0; i < HEDGE_LANES; i++) {
+    if (!_lanes[i].busy) return true;
+  }
+  return false;
+}
+
+bool HedgedProvider::_dispatch(uint8_t member, const String& message, uint32_t timeoutMs) {
+  if (_results == nullptr) {
+    _results = xQueueCreate(HEDGE_LANES, sizeof(Call*));
+    if (_results == nullptr) return false;
+  }
+  int slot = -1;
+  for (uint8_t i = 0; i < HEDGE_LANES && slot < 0; i++) {
+    if (!_lanes[i].busy) slot = i;
+  }
+  if (slot < 0) return false;
+
+  Lane& lane = _lanes[slot];
+  if (lane.task == nullptr) {
+    lane.inbox = xQueueCreate(1, sizeof(Call*));
+    lane.results = _results;
+    char name[12];
+    snprintf(name, sizeof(name), "LLMLane%d", slot);
+    if (lane.inbox == nullptr ||
+        xTaskCreatePinnedToCore(_laneTask, name, HEDGE_LANE_STACK, &lane, 1, &lane.task, tskNO_AFFINITY) != pdPASS) {
+      Serial.println("[Hedge] lane task creation failed");
+      lane.task = nullptr;
+      return false;
+    }
+  }
+
+  Member& m = _members[member];
+  _sync(m);
+  m.provider->setRequestTimeout(timeoutMs);
+
+  Call* c = new Call();
+  c->turn = _turn;
+  c->member = member;
+  c->lane = slot;
+  c->provider = m.provider;
+  c->message = message;
+  c->startMs = millis();
+  c->elapsedMs = 0;
+  m.busy = true;
+  lane.busy = true;
+  xQueueSend(lane.inbox, &c, portMAX_DELAY);  // the lane is idle, its inbox is empty
+  return true;
+}
+
+// next finished request, frees its lane and member and updates the member stats
+bool HedgedProvider::_receive(uint32_t waitMs, Call** out) {
+  if (_results == nullptr) return false;
+  Call* c = nullptr;
+  if (xQueueReceive(_results, &c, pdMS_TO_TICKS(waitMs)) != pdTRUE) return false;
+  _lanes[c->lane].busy = false;
+  _members[c->member].busy = false;
+  c->provider->setRequestTimeout(0);  // the turn deadline is over, e.g. for a later summarizeHistory()
+  _account(*c);
+  *out = c;
+  return true;
+}
+
+void HedgedProvider::_account(const Call& c) {
+  Member& m = _members[c.member];
+  bool ok = c.reply.length() > 0;
+  m.errRate += HEDGE_EWMA_ALPHA * ((ok ? 0.0f : 1.0f) - m.errRate);
+  if (!ok) {
+    m.failures++;
+    if (++m.failStreak >= 3) {
+      m.cooldownUntil = millis() + HEDGE_COOLDOWN_MS;
+      Serial.printf("[Hedge] %s failed %d times, cooling down\n",
+                    m.provider->getProviderName().c_str(), m.failStreak);
+    }
+    return;
+  }
+  m.failStreak = 0;
+  m.ewmaMs = m.successes == 0 ? (float)c.elapsedMs : m.ewmaMs + HEDGE_EWMA_ALPHA * ((float)c.elapsedMs - m.ewmaMs);
+  m.successes++;
+  m.window[m.windowHead] = c.elapsedMs;
+  m.windowHead = (m.windowHead + 1) % HEDGE_LATENCY_WINDOW;
+  if (m.windowCount < HEDGE_LATENCY_WINDOW) m.windowCount++;
+}
+
+// ---------------- AIProvider ----------------
+
+String HedgedProvider::sendMessage(const String& message) {
+  String reply = _hedgedRequest(message);
+  if (reply.length() > 0) _recordExchange(message, reply);
+  return reply;
+}
+
+// e.g. a speculative reply to a partial transcript: the caller records the exchange it keeps
+String HedgedProvider::requestReply(const String& message) {
+  return _hedgedRequest(message);
+}
+
+void HedgedProvider::appendExchange(const String& userMessage, const String& reply) {
+  if (reply.length() > 0) _recordExchange(userMessage, reply);
+}
+
+String HedgedProvider::_hedgedRequest(const String& message) {
+  if (_count == 0) return "";
+  latencyTracer.begin(LAT_LLM);
+  uint32_t t0 = millis();
+  _turn++;
+
+  Call* c = nullptr;
+  while (_receive(0, &c)) delete c;  // late answers of earlier turns: stats only
+
+  // every member still runs an abandoned request, or the lanes do while a member is idle: wait for one to end
+  int primary = _pick(-1);
+  while ((primary < 0 || !_laneFree()) && millis() - t0 < _deadlineMs) {
+    if (_receive(50, &c)) delete c;
+    primary = _pick(-1);
+  }
+  uint32_t spent = millis() - t0;
+  if (primary < 0 || spent >= _deadlineMs || !_dispatch(primary, message, _deadlineMs - spent)) {
+    Serial.println("[Hedge] no provider available");
+    return "";
+  }
+
+  int hedge = _hedgePct > 0 && _count > 1 ? -1 : -2;  // -1: not sent yet, -2: none this turn
+  uint32_t hedgeAt = _hedgeDelay(primary);
+  uint8_t inFlight = 1;
+  int winner = -1;
+  String reply;
+
+  while (winner < 0 && (inFlight > 0 || hedge == -1)) {
+    uint32_t elapsed = millis() - t0;
+    if (elapsed >= _deadlineMs) break;
+    uint32_t wait = _deadlineMs - elapsed;
+
+    if (hedge == -1) {
+      if (elapsed >= hedgeAt) {
+        hedge = -2;
+        int h = _pick(primary);
+        if (h >= 0 && ESP.getMaxAllocHeap() >= HEDGE_MIN_FREE_HEAP && _dispatch(h, message, wait)) {
+          Serial.printf("[Hedge] %s after %lums, hedging with %s\n", _members[primary].provider->getProviderName().c_str(),
+                        (unsigned long)elapsed, _members[h].provider->getProviderName().c_str());
+          hedge = h;
+          inFlight++;
+        }
+        continue;
+      }
+      if (hedgeAt - elapsed < wait) wait = hedgeAt - elapsed;
+    }
+
+    if (!_receive(wait, &c)) continue;
+    if (c->turn == _turn) {
+      inFlight--;
+      if (c->reply.length() > 0) {
+        winner = c->member;
+        reply = c->reply;
+      } else if (hedge == -1) {
+        hedgeAt = 0;  // the first request failed early, fail over right away
+      }
+    }
+    delete c;
+  }
+
+  if (winner < 0) {
+    Serial.printf("[Hedge] no answer within %lums\n", (unsigned long)(millis() - t0));
+    return "";
+  }
+  if (winner == hedge) _members[winner].hedgesWon++;
+  _lastWinner = winner;
+  latencyTracer.end(LAT_LLM);
+  return reply;
+}
+
+// into every member's history, busy or not: the history store has its own lock
+void HedgedProvider::_recordExchange(const String& userMessage, const String& reply) {
+  if (!_memoryEnabled) return;
+  for (uint8_t i = 0; i < _count; i++) {
+    _members[i].provider->appendExchange(userMessage, reply);
+  }
+}
+
+String HedgedProvider::sendVisionMessage(const uint8_t* imageData, size_t imageSize, const String& question, const char* mimeType) {
+  int i = _pick(-1);  // not hedged, the image request is a side job of the turn
+  if (i < 0) return "";
+  AIProvider* p = _members[i].provider;
+  _sync(_members[i]);
+  p->setRequestTimeout(_deadlineMs);
+  String reply = p->sendVisionMessage(imageData, imageSize, question, mimeType);
+  p->setRequestTimeout(0);
+  return reply;
+}
+
+void HedgedProvider::setSystemPrompt(const String& prompt) {
+  if (prompt == _systemPrompt) return;
+  _systemPrompt = prompt;
+  _promptVersion++;  // members pick it up before their next request
+}
+
+void HedgedProvider::enableMemory(bool enable) {
+  _memoryEnabled = enable;
+  for (uint8_t i = 0; i < _count; i++) {
+    if (!_members[i].busy) _members[i].provider->enableMemory(enable);
+  }
+  if (!enable) clearMemory();
+}
+
+void HedgedProvider::clearMemory() {
+  for (uint8_t i = 0; i < _count; i++) {
+    _members[i].provider->clearMemory();
+  }
+}
+
+void HedgedProvider::setHistoryBudget(size_t tokens) {
+  for (uint8_t i = 0; i < _count; i++) {
+    _members[i].provider->setHistoryBudget(tokens);  // the history store has its own lock
+  }
+}
+
+bool HedgedProvider::historyNeedsSummary() const {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (!_members[i].busy && _members[i].provider->historyNeedsSummary()) return true;
+  }
+  return false;
+}
+
+bool HedgedProvider::summarizeHistory() {
+  bool any = false;
+  for (uint8_t i = 0; i < _count; i++) {
+    Member& m = _members[i];
+    if (m.busy || !m.provider->historyNeedsSummary()) continue;
+    any = m.provider->summarizeHistory() || any;
+  }
+  return any;
+}
+
+void HedgedProvider::setModel(const String& model) {
+  if (_count > 0 && !_members[_preferred].busy) _members[_preferred].provider->setModel(model);
+}
+
+String HedgedProvider::getModel() const {
+  return _count > 0 ? _members[_preferred].provider->getModel() : "";
+}
+
+String HedgedProvider::getProviderName() const {
+  if (_count == 0) return "hedged";
+  return _members[_lastWinner >= 0 ? _lastWinner : _preferred].provider->getProviderName();
+}
+
+String HedgedProvider::statsJson() const {
+  DynamicJsonDocument doc(256 + 256 * HEDGE_MAX_MEMBERS);
+  doc["deadline_ms"] = _deadlineMs;
+  doc["hedge_pct"] = _hedgePct;
+  JsonArray arr = doc.createNestedArray("providers");
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < _count; i++) {
+    const Member& m = _members[i];
+    JsonObject o = arr.createNestedObject();
+    o["name"] = m.provider->getProviderName();
+    o["model"] = m.provider->getModel();
+    o["preferred"] = i == _preferred;
+    o["ewma_ms"] = (uint32_t)m.ewmaMs;
+    o["err_rate"] = m.errRate;
+    o["hedge_after_ms"] = _hedgeDelay(i);
+    o["ok"] = m.successes;
+    o["failed"] = m.failures;
+    o["hedges_won"] = m.hedgesWon;
+    o["busy"] = m.busy;
+    o["cooling"] = (int32_t)(m.cooldownUntil - now) > 0;
+  }
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
@@ -0,0 +1,115 @@
+#ifndef HedgedProvider_h
+#define HedgedProvider_h
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include "AIProvider.h"
+
+// AIProvider over several providers. Each turn goes to the fastest healthy member (EWMA latency
+// weighted by its error rate). If no answer came after the member's p90 latency, a hedged request
+// goes to the next member and the first answer wins. Everything has to finish within the turn deadline.
+// Requests run on lane tasks, the calling task only waits. HTTPClient can't be interrupted, so the
+// loser is abandoned: its request is bounded by the deadline, its late result only feeds the stats
+// and the member is skipped until it returned.
+// Every member records every exchange as it happens, in its own ConversationHistory with its token
+// budget and rolling summary, so switching between them does not lose context. The system prompt is
+// handed to a member before its next request.
+// Two TLS requests in flight need about 2x45KB of heap, no hedge is sent below HEDGE_MIN_FREE_HEAP.
+
+#define HEDGE_MAX_MEMBERS      4
+#define HEDGE_LANES            2
+#define HEDGE_LANE_STACK       8192
+#define HEDGE_LATENCY_WINDOW   16      // successful latencies kept per member for the percentile
+#define HEDGE_MIN_FREE_HEAP    60000
+#define HEDGE_COOLDOWN_MS      30000   // after 3 failures in a row
+
+class HedgedProvider : public AIProvider {
+  public:
+    HedgedProvider();
+
+    bool addProvider(AIProvider* provider);   // the first one is preferred
+    void prefer(AIProvider* provider);        // adds it if needed
+    void setDeadline(uint32_t ms);            // whole turn, default 15000
+    void setHedgePercentile(uint8_t pct);     // default 90, 0 disables hedging
+    void setHedgeDelayLimits(uint32_t minMs, uint32_t defaultMs);  // floor, and the delay before enough samples
+
+    String sendMessage(const String& message) override;
+    String requestReply(const String& message) override;  // hedged, the exchange is not recorded
+    void appendExchange(const String& userMessage, const String& reply) override;
+    String sendVisionMessage(const uint8_t* imageData, size_t imageSize, const String& question, const char* mimeType = "image/jpeg") override;
+    void setSystemPrompt(const String& prompt) override;
+    void enableMemory(bool enable) override;
+    void clearMemory() override;
+    void setModel(const String& model) override;  // of the preferred member
+    String getModel() const override;
+    String getProviderName() const override;      // member that gave the last answer
+    void setHistoryBudget(size_t tokens) override;
+    bool historyNeedsSummary() const override;
+    bool summarizeHistory() override;             // of each idle member that needs it, one request each
+
+    String statsJson() const;
+
+  private:
+    struct Member {
+      AIProvider* provider;
+      float ewmaMs;
+      float errRate;
+      uint32_t successes;
+      uint32_t failures;
+      uint32_t hedgesWon;
+      uint8_t failStreak;
+      uint32_t cooldownUntil;
+      uint32_t window[HEDGE_LATENCY_WINDOW];
+      uint8_t windowHead;
+      uint8_t windowCount;
+      bool busy;                  // a lane runs a request on it
+      uint32_t promptSynced;
+    };
+    struct Call {
+      uint32_t turn;
+      uint8_t member;
+      uint8_t lane;
+      AIProvider* provider;
+      String message;
+      String reply;
+      uint32_t startMs;
+      uint32_t elapsedMs;
+    };
+    struct Lane {
+      TaskHandle_t task;
+      QueueHandle_t inbox;
+      QueueHandle_t results;
+      bool busy;
+    };
+
+    Member _members[HEDGE_MAX_MEMBERS];
+    uint8_t _count;
+    uint8_t _preferred;
+    int8_t _lastWinner;
+    Lane _lanes[HEDGE_LANES];
+    QueueHandle_t _results;
+    uint32_t _turn;
+
+    uint32_t _deadlineMs;
+    uint8_t _hedgePct;
+    uint32_t _hedgeMinMs;
+    uint32_t _hedgeDefaultMs;
+
+    bool _memoryEnabled;
+    String _systemPrompt;
+    uint32_t _promptVersion;
+
+    int _pick(int exclude) const;
+    uint32_t _hedgeDelay(uint8_t member) const;
+    String _hedgedRequest(const String& message);
+    bool _dispatch(uint8_t member, const String& message, uint32_t timeoutMs);
+    bool _laneFree() const;
+    void _sync(Member& m);
+    bool _receive(uint32_t waitMs, Call** out);
+    void _account(const Call& c);
+    void _recordExchange(const String& userMessage, const String& reply);
+    static void _laneTask(void* arg);
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "LLMReply.h"
+#include <ArduinoJson.h>
+
+static void buildFilter(JsonDocument& filter, LLMReplyFormat format) {
+  switch (format) {
+    case LLM_REPLY_OPENAI:
+      filter["choices"][0]["message"]["content"] = true;
+      break;
+    case LLM_REPLY_GEMINI:
+      filter["candidates"][0]["content"]["parts"][0]["text"] = true;  // [0] applies to every element
+      break;
+    case LLM_REPLY_BACKEND:
+      filter["text"] = true;
+      break;
+  }
+}
+
+static size_t docCapacity(int contentLength) {
+  if (contentLength <= 0) return LLM_REPLY_DOC_UNKNOWN;
+  size_t capacity = (size_t)contentLength + 256;  // + the slots of the few filtered nodes
+  if (capacity < LLM_REPLY_DOC_MIN) capacity = LLM_REPLY_DOC_MIN;
+  if (capacity > LLM_REPLY_DOC_MAX) capacity = LLM_REPLY_DOC_MAX;
+  return capacity;
+}
+
+static String extractText(JsonDocument& doc, LLMReplyFormat format) {
+  String out;
+  if (format == LLM_REPLY_GEMINI) {
+    JsonArray parts = doc["candidates"][0]["content"]["parts"];
+    for (JsonVariant part : parts) {
+      const char* text = part["text"];
+      if (text != nullptr) out += text;
+    }
+    return out;
+  }
+  const char* text = nullptr;
+  if (format == LLM_REPLY_OPENAI) {
+    text = doc["choices"][0]["message"]["content"];
+  } else {
+    text = doc["text"];
+  }
+  if (text != nullptr) out = text;
+  return out;
+}
+
+template <typename TInput>
+static String parseReply(TInput& input, size_t capacity, LLMReplyFormat format, const char* tag) {
+  StaticJsonDocument<192> filter;
+  buildFilter(filter, format);
+
+  DynamicJsonDocument doc(capacity);
+  if (doc.capacity() == 0) {
+    Serial.printf("[%s] no heap for a %u byte reply document\n", tag, (unsigned)capacity);
+    return "";
+  }
+  DeserializationError error = deserializeJson(doc, input, DeserializationOption::Filter(filter));
+  if (error) {
+    Serial.printf("[%s] reply parse failed: %s\n", tag, error.c_str());
+    return "";
+  }
+  return extractText(doc, format);
+}
+
+String readLLMReply(Stream& body, int contentLength, LLMReplyFormat format, const char* tag) {
+  return parseReply(body, docCapacity(contentLength), format, tag);
+}
+
+String parseLLMReply(const String& body, LLMReplyFormat format, const char* tag) {
+  return parseReply(body, docCapacity(body.length()), format, tag);
+}
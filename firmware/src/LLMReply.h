@@ -0,0 +1,25 @@
+#ifndef LLMReply_h
+#define LLMReply_h
+
+#include <Arduino.h>
+
+// Reply text of the LLM HTTP APIs. The response is parsed straight from the socket through an ArduinoJson
+// filter, so only the text fields end up in the document and the body is never held as a String.
+// The HTTPClient has to be set to HTTP/1.0 (useHTTP10(true)) before the request, the stream then carries
+// no chunk markers. The document is sized from Content-Length: the text can't be longer than the body.
+
+#define LLM_REPLY_DOC_MIN       1024
+#define LLM_REPLY_DOC_MAX       16384
+#define LLM_REPLY_DOC_UNKNOWN   8192   // no Content-Length
+
+enum LLMReplyFormat : uint8_t {
+  LLM_REPLY_OPENAI = 0,  // choices[0].message.content
+  LLM_REPLY_GEMINI,      // candidates[0].content.parts[].text, joined
+  LLM_REPLY_BACKEND      // text
+};
+
+// "" if the body is not JSON, has no text or does not fit LLM_REPLY_DOC_MAX
+String readLLMReply(Stream& body, int contentLength, LLMReplyFormat format, const char* tag);
+String parseLLMReply(const String& body, LLMReplyFormat format, const char* tag);
+
+#endif
@@ -0,0 +1,291 @@
+#include "LatencyTracer.h"
+#include <esp_timer.h>
+
+LatencyTracer latencyTracer;
+
+static const uint32_t LAT_NONE = 0xFFFFFFFF;
+
+static const char* const s_stageNames[LAT_STAGE_COUNT] = {
+  "asr_capture", "asr_endpoint", "asr_transcribe", "vision", "recall", "llm", "tts", "response"
+};
+
+LatencyTracer::LatencyTracer() {
+  portMUX_INITIALIZE(&_mux);
+  reset();
+}
+
+void LatencyTracer::reset() {
+  portENTER_CRITICAL(&_mux);
+  _isOpen = false;
+  _t0 = 0;
+  _clearTurn(_open);
+  portEXIT_CRITICAL(&_mux);
+  _head = 0;
+  _count = 0;
+  _turns = 0;
+  memset(_hist, 0, sizeof(_hist));
+  memset(_sumUs, 0, sizeof(_sumUs));
+  memset(_maxUs, 0, sizeof(_maxUs));
+  memset(_samples, 0, sizeof(_samples));
+}
+
+void LatencyTracer::beginTurn() {
+  uint32_t startMs = millis();
+  portENTER_CRITICAL(&_mux);
+  _clearTurn(_open);
+  _open.id = _turns + 1;
+  _open.startMs = startMs;
+  _t0 = esp_timer_get_time();
+  _isOpen = true;
+  portEXIT_CRITICAL(&_mux);
+}
+
+void LatencyTracer::cancelTurn() {
+  portENTER_CRITICAL(&_mux);
+  _isOpen = false;
+  portEXIT_CRITICAL(&_mux);
+}
+
+bool LatencyTracer::turnOpen() const {
+  return _isOpen;
+}
+
+void LatencyTracer::begin(LatencyStage stage) {
+  if (!_isOpen || stage >= LAT_STAGE_COUNT) return;
+  portENTER_CRITICAL(&_mux);
+  if (_isOpen) {
+    Span& s = _open.span[stage];
+    s.first = LAT_NONE;
+    s.end = LAT_NONE;
+    s.start = _now();
+  }
+  portEXIT_CRITICAL(&_mux);
+}
+
+void LatencyTracer::first(LatencyStage stage) {
+  if (!_isOpen || stage >= LAT_STAGE_COUNT) return;
+  portENTER_CRITICAL(&_mux);
+  Span& s = _open.span[stage];
+  if (_isOpen && s.start != LAT_NONE && s.first == LAT_NONE && s.end == LAT_NONE) s.first = _now();
+  portEXIT_CRITICAL(&_mux);
+}
+
+void LatencyTracer::end(LatencyStage stage) {
+  if (!_isOpen || stage >= LAT_STAGE_COUNT) return;
+  portENTER_CRITICAL(&_mux);
+  Span& s = _open.span[stage];
+  if (_isOpen && s.start != LAT_NONE && s.end == LAT_NONE) s.end = _now();
+  portEXIT_CRITICAL(&_mux);
+}
+
+void LatencyTracer::recordSince(LatencyStage stage, unsigned long startMs) {
+  if (!_isOpen || stage >= LAT_STAGE_COUNT) return;
+  uint64_t ago = (uint64_t)(millis() - startMs) * 1000;
+  portENTER_CRITICAL(&_mux);
+  if (_isOpen) {
+    uint32_t now = _now();
+    Span& s = _open.span[stage];
+    s.start = ago < now ? now - (uint32_t)ago : 0;
+    s.first = LAT_NONE;
+    s.end = now;
+  }
+  portEXIT_CRITICAL(&_mux);
+}
+
+void LatencyTracer::endTurn(bool ok) {
+  if (!_isOpen) return;
+  Turn t;
+  portENTER_CRITICAL(&_mux);
+  bool open = _isOpen;
+  _isOpen = false;  // later marks are dropped
+  t = _open;
+  portEXIT_CRITICAL(&_mux);
+  if (!open) return;
+
+  t.ok = ok;
+  const Span& cap = t.span[LAT_ASR_CAPTURE];
+  const Span& tts = t.span[LAT_TTS];
+  if (cap.end != LAT_NONE && tts.end != LAT_NONE && tts.end >= cap.end) {
+    t.span[LAT_RESPONSE].start = cap.end;
+    t.span[LAT_RESPONSE].end = tts.end;
+  }
+
+  for (uint8_t i = 0; i < LAT_STAGE_COUNT; i++) {
+    const Span& s = t.span[i];
+    if (s.start == LAT_NONE || s.end == LAT_NONE) continue;
+    uint32_t d = s.end - s.start;
+    _hist[i][0][_bucket(d)]++;
+    if (s.first != LAT_NONE) _hist[i][1][_bucket(s.first - s.start)]++;
+    _sumUs[i] += d;
+    if (d > _maxUs[i]) _maxUs[i] = d;
+    _samples[i]++;
+  }
+
+  _ring[_head] = t;
+  _head = (_head + 1) % LATENCY_TRACE_TURNS;
+  if (_count < LATENCY_TRACE_TURNS) _count++;
+  _turns++;
+}
+
+uint32_t LatencyTracer::turnCount() const {
+  return _turns;
+}
+
+const char* LatencyTracer::stageName(LatencyStage stage) {
+  return stage < LAT_STAGE_COUNT ? s_stageNames[stage] : "unknown";
+}
+
+uint32_t LatencyTracer::_now() const {
+  int64_t d = esp_timer_get_time() - _t0;
+  if (d < 0) d = 0;
+  if (d >= (int64_t)LAT_NONE) d = LAT_NONE - 1;
+  return (uint32_t)d;
+}
+
+void LatencyTracer::_clearTurn(Turn& t) {
+  t.id = 0;
+  t.startMs = 0;
+  t.ok = false;
+  for (uint8_t i = 0; i < LAT_STAGE_COUNT; i++) {
+    t.span[i].start = LAT_NONE;
+    t.span[i].first = LAT_NONE;
+    t.span[i].end = LAT_NONE;
+  }
+}
+
+uint8_t LatencyTracer::_bucket(uint32_t us) {
+  uint32_t ms = us / 1000;
+  uint32_t bound = 50;
+  uint8_t b = 0;
+  while (b < LATENCY_HIST_BUCKETS - 1 && ms >= bound) {
+    b++;
+    bound <<= 1;
+  }
+  return b;
+}
+
+// durations (or time to first byte) of the turns in the ring, sorted ascending
+uint8_t LatencyTracer::_window(LatencyStage stage, bool firstByte, uint32_t* out) const {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    const Span& s = _ring[i].span[stage];
+    if (s.start == LAT_NONE || s.end == LAT_NONE) continue;
+    if (firstByte && s.first == LAT_NONE) continue;
+    uint32_t v = (firstByte ? s.first : s.end) - s.start;
+    uint8_t j = n++;
+    while (j > 0 && out[j - 1] > v) {
+      out[j] = out[j - 1];
+      j--;
+    }
+    out[j] = v;
+  }
+  return n;
+}
+
+static uint32_t percentile(const uint32_t* sorted, uint8_t n, uint8_t p) {
+  if (n == 0) return 0;
+  uint16_t rank = ((uint16_t)p * n + 99) / 100;  // nearest rank
+  if (rank == 0) rank = 1;
+  return sorted[rank - 1];
+}
+
+uint32_t LatencyTracer::percentileMs(LatencyStage stage, uint8_t pct, uint8_t minSamples) const {
+  if (stage >= LAT_STAGE_COUNT) return 0;
+  uint32_t v[LATENCY_TRACE_TURNS];
+  uint8_t n = _window(stage, false, v);
+  if (n == 0 || n < minSamples) return 0;
+  return percentile(v, n, pct) / 1000;
+}
+
+String LatencyTracer::metricsJson() const {
+  DynamicJsonDocument doc(6144);
+  doc["turns"] = _turns;
+  doc["window"] = _count;
+  JsonArray bounds = doc.createNestedArray("buckets_ms");
+  for (uint32_t b = 0, ms = 50; b < LATENCY_HIST_BUCKETS - 1; b++, ms <<= 1) {
+    bounds.add(ms);
+  }
+
+  JsonObject stages = doc.createNestedObject("stages");
+  uint32_t v[LATENCY_TRACE_TURNS];
+  for (uint8_t i = 0; i < LAT_STAGE_COUNT; i++) {
+    LatencyStage st = (LatencyStage)i;
+    JsonObject o = stages.createNestedObject(s_stageNames[i]);
+    o["count"] = _samples[i];
+    o["mean_us"] = _samples[i] ? (uint32_t)(_sumUs[i] / _samples[i]) : 0;
+    o["max_us"] = _maxUs[i];
+    uint8_t n = _window(st, false, v);
+    o["p50_us"] = percentile(v, n, 50);
+    o["p90_us"] = percentile(v, n, 90);
+    o["p99_us"] = percentile(v, n, 99);
+    JsonArray h = o.createNestedArray("hist");
+    for (uint8_t b = 0; b < LATENCY_HIST_BUCKETS; b++) h.add(_hist[i][0][b]);
+
+    n = _window(st, true, v);
+    if (n == 0) continue;
+    JsonObject f = o.createNestedObject("first");
+    f["p50_us"] = percentile(v, n, 50);
+    f["p90_us"] = percentile(v, n, 90);
+    f["p99_us"] = percentile(v, n, 99);
+    JsonArray fh = f.createNestedArray("hist");
+    for (uint8_t b = 0; b < LATENCY_HIST_BUCKETS; b++) fh.add(_hist[i][1][b]);
+  }
+
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+void LatencyTracer::printSummary(Print& out) const {
+  out.printf("[Latency] turns=%lu window=%u\n", (unsigned long)_turns, (unsigned)_count);
+  uint32_t v[LATENCY_TRACE_TURNS];
+  for (uint8_t i = 0; i < LAT_STAGE_COUNT; i++) {
+    uint8_t n = _window((LatencyStage)i, false, v);
+    if (n == 0) continue;
+    out.printf("[Latency] %-14s p50=%lums p90=%lums max=%lums", s_stageNames[i],
+               (unsigned long)(percentile(v, n, 50) / 1000), (unsigned long)(percentile(v, n, 90) / 1000),
+               (unsigned long)(_maxUs[i] / 1000));
+    n = _window((LatencyStage)i, true, v);
+    if (n > 0) out.printf(" first_p50=%lums", (unsigned long)(percentile(v, n, 50) / 1000));
+    out.println();
+  }
+}
+
+void LatencyTracer::_turnToJson(const Turn& t, JsonObject obj) const {
+  obj["id"] = t.id;
+  obj["at_ms"] = t.startMs;
+  obj["ok"] = t.ok;
+  JsonObject spans = obj.createNestedObject("spans");
+  for (uint8_t i = 0; i < LAT_STAGE_COUNT; i++) {
+    const Span& s = t.span[i];
+    if (s.start == LAT_NONE) continue;
+    JsonObject o = spans.createNestedObject(s_stageNames[i]);
+    o["start_us"] = s.start;
+    if (s.first != LAT_NONE) o["first_us"] = s.first;
+    if (s.end != LAT_NONE) o["end_us"] = s.end;
+  }
+}
+
+String LatencyTracer::traceJson(uint8_t maxTurns) const {
+  uint8_t n = maxTurns < _count ? maxTurns : _count;
+  DynamicJsonDocument doc(768 * (size_t)n + 256);
+  doc["turns"] = _turns;
+  JsonArray arr = doc.createNestedArray("trace");
+  for (uint8_t i = 0; i < n; i++) {  // newest first
+    uint8_t idx = (_head + LATENCY_TRACE_TURNS - 1 - i) % LATENCY_TRACE_TURNS;
+    _turnToJson(_ring[idx], arr.createNestedObject());
+  }
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+String LatencyTracer::lastTurnJson() const {
+  if (_count == 0) return "{}";
+  DynamicJsonDocument doc(1024);
+  doc["type"] = "trace";
+  _turnToJson(_ring[(_head + LATENCY_TRACE_TURNS - 1) % LATENCY_TRACE_TURNS], doc.createNestedObject("turn"));
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
@@ -0,0 +1,92 @@
+#ifndef LatencyTracer_h
+#define LatencyTracer_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+
+// Where a conversation turn spends its time. The ASR clients open a turn when recording starts, the
+// providers and TTS engines add their spans, the sketch closes the turn when the reply is playing (or failed).
+// Timestamps are esp_timer microseconds, a turn stores them relative to its own start.
+// Marks come from several tasks (the TurnJobs worker, the LLM lanes, the audio task) while the loop task opens
+// and closes the turn: every access to the open turn takes a spinlock. The ring, the histograms and the JSON
+// are loop task only.
+
+#define LATENCY_TRACE_TURNS   16   // closed turns kept for /trace and the percentiles
+#define LATENCY_HIST_BUCKETS  10   // 50ms .. 12.8s, doubling, the last one is open
+
+enum LatencyStage : uint8_t {
+  LAT_ASR_CAPTURE = 0,  // recording start .. end of speech detected, first: speech onset
+  LAT_ASR_ENDPOINT,     // last voiced audio .. end of speech detected
+  LAT_ASR_TRANSCRIBE,   // end of speech .. final text, first: first response byte
+  LAT_VISION,           // camera capture and description
+  LAT_RECALL,           // remote memory lookup
+  LAT_LLM,              // request .. reply parsed, first: first response byte
+  LAT_TTS,              // request .. first audio out, first: first audio byte received
+  LAT_RESPONSE,         // end of speech .. first audio out, filled in by endTurn()
+  LAT_STAGE_COUNT
+};
+
+class LatencyTracer {
+  public:
+    LatencyTracer();
+
+    void beginTurn();               // a turn that is still open is dropped
+    void endTurn(bool ok = true);   // commit to the ring and the histograms
+    void cancelTurn();
+    bool turnOpen() const;
+
+    // ignored if no turn is open; first() and end() only count for a span that is begun and not ended yet
+    void begin(LatencyStage stage);
+    void first(LatencyStage stage);
+    void end(LatencyStage stage);
+    void recordSince(LatencyStage stage, unsigned long startMs);  // closed span from a millis() time until now
+
+    uint32_t turnCount() const;     // turns committed since boot
+    uint32_t percentileMs(LatencyStage stage, uint8_t pct, uint8_t minSamples = 1) const;  // 0 below minSamples
+    String metricsJson() const;
+    String traceJson(uint8_t maxTurns = LATENCY_TRACE_TURNS) const;
+    String lastTurnJson() const;
+    void printSummary(Print& out) const;  // one line per stage, p50/p90/max in ms
+    void reset();
+
+    static const char* stageName(LatencyStage stage);
+
+  private:
+    struct Span {
+      uint32_t start;
+      uint32_t first;
+      uint32_t end;
+    };
+    struct Turn {
+      uint32_t id;
+      uint32_t startMs;             // millis() at beginTurn, to line the turn up with the serial log
+      bool ok;
+      Span span[LAT_STAGE_COUNT];
+    };
+
+    Turn _open;                     // guarded by _mux
+    volatile bool _isOpen;
+    int64_t _t0;
+    portMUX_TYPE _mux;
+
+    Turn _ring[LATENCY_TRACE_TURNS];
+    uint8_t _head;                  // next slot to write
+    uint8_t _count;
+    uint32_t _turns;
+
+    uint32_t _hist[LAT_STAGE_COUNT][2][LATENCY_HIST_BUCKETS];  // [stage][duration, first byte][bucket]
+    uint64_t _sumUs[LAT_STAGE_COUNT];
+    uint32_t _maxUs[LAT_STAGE_COUNT];
+    uint32_t _samples[LAT_STAGE_COUNT];
+
+    uint32_t _now() const;
+    static void _clearTurn(Turn& t);
+    static uint8_t _bucket(uint32_t us);
+    uint8_t _window(LatencyStage stage, bool firstByte, uint32_t* out) const;
+    void _turnToJson(const Turn& t, JsonObject obj) const;
+};
+
+extern LatencyTracer latencyTracer;
+
+#endif
@@ -0,0 +1,136 @@
+#include "MemoryIndex.h"
+
+MemoryIndex::MemoryIndex()
+  : _vectors(nullptr),
+    _items(nullptr),
+    _dim(0),
+    _count(0),
+    _cursor(0) {}
+
+MemoryIndex::~MemoryIndex() {
+  free(_vectors);
+  delete[] _items;
+}
+
+bool MemoryIndex::begin(uint16_t dim) {
+  if (dim == 0 || dim > MEMORY_INDEX_MAX_DIM || dim % 4 != 0) return false;
+  if (_vectors != nullptr && dim == _dim) return true;
+
+  free(_vectors);
+  size_t bytes = (size_t)MEMORY_INDEX_CAPACITY * dim;
+  _vectors = (int8_t*)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+  if (_vectors == nullptr) {
+    Serial.printf("[MemoryIndex] no memory for %u bytes of vectors\n", (unsigned)bytes);
+    _dim = 0;
+    return false;
+  }
+  if (_items == nullptr) _items = new Item[MEMORY_INDEX_CAPACITY];
+  _dim = dim;
+  clear();
+  return true;
+}
+
+void MemoryIndex::clear() {
+  for (size_t i = 0; i < _count; i++) _items[i].text = String();
+  _count = 0;
+  _cursor = 0;
+}
+
+bool MemoryIndex::ready() const {
+  return _vectors != nullptr;
+}
+
+uint16_t MemoryIndex::dim() const {
+  return _dim;
+}
+
+size_t MemoryIndex::size() const {
+  return _count;
+}
+
+uint64_t MemoryIndex::cursor() const {
+  return _cursor;
+}
+
+bool MemoryIndex::add(char kind, const String& text, uint64_t createdMs, const int8_t* vector, float scale) {
+  if (_vectors == nullptr || vector == nullptr) return false;
+  size_t slot = _count;
+  if (_count == MEMORY_INDEX_CAPACITY) {  // items may come newest first (cold sync), so not the ring order
+    slot = 0;
+    for (size_t i = 1; i < _count; i++) {
+      if (_items[i].createdMs < _items[slot].createdMs) slot = i;
+    }
+    if (_items[slot].createdMs > createdMs) return false;  // older than everything kept
+  }
+  Item& item = _items[slot];
+  item.kind = kind;
+  item.scale = scale;
+  item.createdMs = createdMs;
+  item.text = text.length() > MEMORY_INDEX_TEXT_MAX ? text.substring(0, MEMORY_INDEX_TEXT_MAX) : text;
+  memcpy(_vectors + slot * _dim, vector, _dim);
+  if (_count < MEMORY_INDEX_CAPACITY) _count++;
+  if (createdMs > _cursor) _cursor = createdMs;
+  return true;
+}
+
+// Four independent accumulators so the multiply-adds of consecutive elements don't wait on each other
+int32_t MemoryIndex::dot(const int8_t* a, const int8_t* b, size_t n) {
+  int32_t acc0 = 0;
+  int32_t acc1 = 0;
+  int32_t acc2 = 0;
+  int32_t acc3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc0 += (int32_t)a[i] * b[i];
+    acc1 += (int32_t)a[i + 1] * b[i + 1];
+    acc2 += (int32_t)a[i + 2] * b[i + 2];
+    acc3 += (int32_t)a[i + 3] * b[i + 3];
+  }
+  for (; i < n; i++) acc0 += (int32_t)a[i] * b[i];
+  return acc0 + acc1 + acc2 + acc3;
+}
+
+String MemoryIndex::search(const int8_t* query, float queryScale, int topConversations, int topVisualEvents) const {
+  int topC = constrain(topConversations, 0, MEMORY_INDEX_TOP_MAX);
+  int topV = constrain(topVisualEvents, 0, MEMORY_INDEX_TOP_MAX);
+  if (_vectors == nullptr || query == nullptr || _count == 0) return "";
+
+  // kept sorted, best first
+  int16_t bestC[MEMORY_INDEX_TOP_MAX];
+  int16_t bestV[MEMORY_INDEX_TOP_MAX];
+  float scoreC[MEMORY_INDEX_TOP_MAX];
+  float scoreV[MEMORY_INDEX_TOP_MAX];
+  int countC = 0;
+  int countV = 0;
+
+  for (size_t i = 0; i < _count; i++) {
+    bool visual = _items[i].kind == 'v';
+    int top = visual ? topV : topC;
+    int16_t* best = visual ? bestV : bestC;
+    float* score = visual ? scoreV : scoreC;
+    int& count = visual ? countV : countC;
+    if (top == 0) continue;
+
+    float s = dot(query, _vectors + i * _dim, _dim) * queryScale * _items[i].scale;
+    if (count == top && s <= score[count - 1]) continue;
+    int pos = count < top ? count++ : top - 1;
+    while (pos > 0 && score[pos - 1] < s) {
+      score[pos] = score[pos - 1];
+      best[pos] = best[pos - 1];
+      pos--;
+    }
+    score[pos] = s;
+    best[pos] = (int16_t)i;
+  }
+
+  String out;
+  for (int i = 0; i < countC; i++) {
+    if (out.length() > 0) out += "\n";
+    out += "[C" + String(i + 1) + "] " + _items[bestC[i]].text;
+  }
+  for (int i = 0; i < countV; i++) {
+    if (out.length() > 0) out += "\n";
+    out += "[V" + String(i + 1) + "] " + _items[bestV[i]].text;
+  }
+  return out;
+}
@@ -0,0 +1,52 @@
+#ifndef MemoryIndex_h
+#define MemoryIndex_h
+
+#include <Arduino.h>
+
+// Local copy of the device's recent memory items for RemoteMemory::recall(): text plus the item's
+// embedding as int8 (L2-normalized, per-item scale, see /v1/memory/sync), so the similarity is
+// dot(qa, qb) * sa * sb. Vectors live in one PSRAM block when there is PSRAM. Full: the oldest item
+// (by creation time, whatever the order of add()) is replaced. Not persisted, RemoteMemory resyncs from the backend after a reboot.
+// Not locked, RemoteMemory syncs and searches from the same task (the turn worker).
+
+#define MEMORY_INDEX_CAPACITY   256     // items, 192KB of vectors at 768 dimensions
+#define MEMORY_INDEX_MAX_DIM    1024
+#define MEMORY_INDEX_TEXT_MAX   480
+#define MEMORY_INDEX_TOP_MAX    10
+
+class MemoryIndex {
+  public:
+    MemoryIndex();
+    ~MemoryIndex();
+
+    bool begin(uint16_t dim);            // allocates; another dimension drops the items
+    void clear();
+    bool ready() const;
+    uint16_t dim() const;
+    size_t size() const;
+    uint64_t cursor() const;             // creation time (ms) of the newest item, for the next sync
+
+    bool add(char kind, const String& text, uint64_t createdMs, const int8_t* vector, float scale);  // false: full and older
+
+    // Best items per kind ('c' conversation, 'v' visual event) in the format of the server recall:
+    // "[C1] ...\n[V1] ...", "" if there are none
+    String search(const int8_t* query, float queryScale, int topConversations, int topVisualEvents) const;
+
+    static int32_t dot(const int8_t* a, const int8_t* b, size_t n);  // plain C, four accumulators
+
+  private:
+    struct Item {
+      char kind;
+      float scale;
+      uint64_t createdMs;
+      String text;
+    };
+
+    int8_t* _vectors;
+    Item* _items;
+    uint16_t _dim;
+    size_t _count;
+    uint64_t _cursor;
+};
+
+#endif
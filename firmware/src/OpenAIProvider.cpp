@@ -61,6 +61,30 @@ String OpenAIProvider::getProviderName() const {
   return "openai";
 }
 
+String OpenAIProvider::requestReply(const String& message) {
+  return _chat.requestReply(message);
+}
+
+void OpenAIProvider::appendExchange(const String& userMessage, const String& reply) {
+  _chat.appendExchange(userMessage, reply);
+}
+
+void OpenAIProvider::setRequestTimeout(uint32_t ms) {
+  _chat.setRequestTimeout(ms);
+}
+
+void OpenAIProvider::setHistoryBudget(size_t tokens) {
+  _chat.setHistoryBudget(tokens);
+}
+
+bool OpenAIProvider::historyNeedsSummary() const {
+  return _chat.historyNeedsSummary();
+}
+
+bool OpenAIProvider::summarizeHistory() {
+  return _chat.summarizeHistory();
+}
+
 ArduinoGPTChat& OpenAIProvider::client() {
   return _chat;
 }
@@ -19,6 +19,12 @@ class OpenAIProvider : public AIProvider {
     void setModel(const String& model) override;
     String getModel() const override;
     String getProviderName() const override;
+    String requestReply(const String& message) override;
+    void appendExchange(const String& userMessage, const String& reply) override;
+    void setRequestTimeout(uint32_t ms) override;
+    void setHistoryBudget(size_t tokens) override;
+    bool historyNeedsSummary() const override;
+    bool summarizeHistory() override;
 
     ArduinoGPTChat& client();
 
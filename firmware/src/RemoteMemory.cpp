@@ -1,21 +1,37 @@
 #include "RemoteMemory.h"
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
+#include <mbedtls/base64.h>
 
 RemoteMemory::RemoteMemory()
-  : _enabled(false) {}
+  : _enabled(false),
+    _localIndex(true),
+    _backfilled(false),
+    _backfillBefore(0),
+    _caughtUp(false),
+    _truncated(false),
+    _queryVector(nullptr),
+    _queryScale(0) {}
 
 RemoteMemory::RemoteMemory(const char* baseUrl, const char* apiKey, const char* deviceId)
   : _baseUrl(baseUrl == nullptr ? "" : baseUrl),
     _apiKey(apiKey == nullptr ? "" : apiKey),
     _deviceId(deviceId == nullptr ? "" : deviceId),
-    _enabled(true) {}
+    _enabled(true),
+    _localIndex(true),
+    _backfilled(false),
+    _backfillBefore(0),
+    _caughtUp(false),
+    _truncated(false),
+    _queryVector(nullptr),
+    _queryScale(0) {}
 
 void RemoteMemory::setConfig(const char* baseUrl, const char* apiKey, const char* deviceId) {
   _baseUrl = baseUrl == nullptr ? "" : baseUrl;
   _apiKey = apiKey == nullptr ? "" : apiKey;
-  if (deviceId != nullptr) {
+  if (deviceId != nullptr && _deviceId != deviceId) {
     _deviceId = deviceId;
+    _resetSync();  // items of another device
   }
 }
 
@@ -46,7 +62,9 @@ bool RemoteMemory::storeConversation(const String& userMessage,
 
   String payload;
   serializeJson(doc, payload);
-  return _postJson("/v1/memory/conversations", payload, nullptr);
+  if (!_postJson("/v1/memory/conversations", payload, nullptr)) return false;
+  _caughtUp = false;  // the local index misses it until the next sync
+  return true;
 }
 
 bool RemoteMemory::storeVisualEvent(const String& description,
@@ -62,7 +80,9 @@ bool RemoteMemory::storeVisualEvent(const String& description,
 
   String payload;
   serializeJson(doc, payload);
-  return _postJson("/v1/memory/visual-events", payload, nullptr);
+  if (!_postJson("/v1/memory/visual-events", payload, nullptr)) return false;
+  _caughtUp = false;
+  return true;
 }
 
 String RemoteMemory::recall(const String& query, int topConversations, int topVisualEvents) {
@@ -70,6 +90,13 @@ String RemoteMemory::recall(const String& query, int topConversations, int topVi
     return "";
   }
 
+  if (_localIndex && indexComplete() && _index.size() > 0 && _embedQuery(query)) {
+    uint32_t start = micros();
+    String local = _index.search(_queryVector, _queryScale, topConversations, topVisualEvents);
+    Serial.printf("[RemoteMemory] local recall over %u items: %luus\n", (unsigned)_index.size(), (unsigned long)(micros() - start));
+    return local;
+  }
+
   DynamicJsonDocument doc(512);
   doc["query"] = query;
   doc["device_id"] = _deviceId;
@@ -86,6 +113,176 @@ String RemoteMemory::recall(const String& query, int topConversations, int topVi
   return response;
 }
 
+void RemoteMemory::setLocalIndex(bool enabled) {
+  _localIndex = enabled;
+}
+
+size_t RemoteMemory::indexSize() const {
+  return _index.size();
+}
+
+bool RemoteMemory::indexComplete() const {
+  return _backfilled && _caughtUp;  // truncated too: the newest items, the fill and add() keep those
+}
+
+void RemoteMemory::_resetSync() {
+  _index.clear();
+  _backfilled = false;
+  _backfillBefore = 0;
+  _caughtUp = false;
+  _truncated = false;
+}
+
+bool RemoteMemory::syncIndex() {
+  if (!isEnabled() || !_localIndex) {
+    return false;
+  }
+
+  int8_t* vector = nullptr;
+  size_t added = 0;
+  bool ok = true;
+  bool more = true;
+  uint64_t next = 0;
+
+  // cold index: newest first, so recall has the recent items even if a request fails halfway
+  for (int page = 0; !_backfilled && page < MEMORY_BACKFILL_MAX_PAGES; page++) {
+    ok = _syncPage(true, _backfillBefore, vector, added, more, next);
+    if (!ok) break;
+    _backfillBefore = next;
+    if (!more || _truncated) _backfilled = true;
+  }
+
+  // then everything stored since the newest item
+  more = true;
+  for (int page = 0; ok && _backfilled && more && page < MEMORY_SYNC_MAX_PAGES; page++) {
+    ok = _syncPage(false, _index.cursor(), vector, added, more, next);
+  }
+  _caughtUp = ok && _backfilled && !more;
+  free(vector);
+
+  if (added > 0) {
+    Serial.printf("[RemoteMemory] local index +%u, %u items%s\n", (unsigned)added, (unsigned)_index.size(),
+                  _truncated ? ", the newest of the device's items" : "");
+  }
+  return ok;
+}
+
+// One /v1/memory/sync page into the index: items after `from` oldest first, or before `from` (0: the newest)
+// newest first. next: creation time of the last item of the page.
+bool RemoteMemory::_syncPage(bool newestFirst, uint64_t from, int8_t*& vector, size_t& added, bool& more, uint64_t& next) {
+  StaticJsonDocument<128> filter;
+  filter["dim"] = true;
+  filter["next"] = true;
+  filter["more"] = true;
+  JsonObject itemFilter = filter["items"].createNestedObject();
+  itemFilter["kind"] = true;
+  itemFilter["text"] = true;
+  itemFilter["t"] = true;
+  itemFilter["q"] = true;
+  itemFilter["s"] = true;
+
+  DynamicJsonDocument request(256);
+  request["device_id"] = _deviceId;
+  if (newestFirst) {
+    request["order"] = "desc";
+    request["before"] = from;
+  } else {
+    request["since"] = from;
+  }
+  request["limit"] = MEMORY_SYNC_PAGE;
+  request["max_text"] = MEMORY_INDEX_TEXT_MAX;
+  String payload;
+  serializeJson(request, payload);
+
+  HTTPClient http;
+  http.begin(_baseUrl + "/v1/memory/sync");
+  http.useHTTP10(true);  // plain body on the stream, parsed as it arrives
+  http.addHeader("Content-Type", "application/json");
+  http.addHeader("x-api-key", _apiKey);
+  http.addHeader("x-device-id", _deviceId);
+  int code = http.POST(payload);
+  if (code != 200) {
+    Serial.printf("[RemoteMemory] sync failed: %d\n", code);
+    http.end();
+    return false;
+  }
+
+  // a page of base64 vectors and texts; the filter keeps the rest of the response out
+  DynamicJsonDocument doc(MEMORY_SYNC_PAGE * (MEMORY_INDEX_MAX_DIM * 4 / 3 + MEMORY_INDEX_TEXT_MAX + 128));
+  DeserializationError error = deserializeJson(doc, http.getStream(), DeserializationOption::Filter(filter));
+  http.end();
+  if (error) {
+    Serial.printf("[RemoteMemory] sync parse failed: %s\n", error.c_str());
+    return false;
+  }
+
+  uint16_t dim = doc["dim"] | 0;
+  if (_index.size() > 0 && dim != _index.dim()) {
+    _resetSync();  // another embedding model, start over next time
+    return false;
+  }
+  if (!_index.begin(dim)) return false;
+  if (vector == nullptr) vector = (int8_t*)malloc(MEMORY_INDEX_MAX_DIM);
+  if (vector == nullptr) return false;
+
+  for (JsonObject item : doc["items"].as<JsonArray>()) {
+    const char* kind = item["kind"] | "c";
+    if (!_decodeVector(item["q"] | "", vector, dim)) continue;
+    if (_index.size() == MEMORY_INDEX_CAPACITY) _truncated = true;  // an item is replaced or left out
+    if (_index.add(kind[0], item["text"].as<String>(), item["t"].as<uint64_t>(), vector, item["s"] | 0.0f)) added++;
+  }
+  more = doc["more"] | false;
+  next = doc["next"] | from;
+  return true;
+}
+
+bool RemoteMemory::_decodeVector(const char* base64, int8_t* out, size_t dim) {
+  size_t len = 0;
+  if (mbedtls_base64_decode((unsigned char*)out, dim, &len, (const unsigned char*)base64, strlen(base64)) != 0) {
+    return false;
+  }
+  return len == dim;
+}
+
+bool RemoteMemory::_embedQuery(const String& query) {
+  uint16_t dim = _index.dim();
+  if (_queryVector != nullptr && query == _embeddedQuery) return true;
+  if (_queryVector == nullptr) {
+    _queryVector = (int8_t*)malloc(MEMORY_INDEX_MAX_DIM);
+    if (_queryVector == nullptr) return false;
+  }
+  _embeddedQuery = "";
+
+  DynamicJsonDocument request(1024);
+  request["text"] = query;
+  String payload;
+  serializeJson(request, payload);
+
+  HTTPClient http;
+  http.begin(_baseUrl + "/v1/memory/embed");
+  http.setConnectTimeout(MEMORY_EMBED_TIMEOUT_MS);
+  http.setTimeout(MEMORY_EMBED_TIMEOUT_MS);
+  http.useHTTP10(true);
+  http.addHeader("Content-Type", "application/json");
+  http.addHeader("x-api-key", _apiKey);
+  http.addHeader("x-device-id", _deviceId);
+  int code = http.POST(payload);
+  if (code != 200) {
+    http.end();
+    Serial.printf("[RemoteMemory] query embedding unavailable (%d), server recall\n", code);
+    return false;
+  }
+  DynamicJsonDocument doc(MEMORY_INDEX_MAX_DIM * 4 / 3 + 256);
+  DeserializationError error = deserializeJson(doc, http.getStream());
+  http.end();
+  if (error || (doc["dim"] | 0) != dim || !_decodeVector(doc["q"] | "", _queryVector, dim)) {
+    return false;
+  }
+  _queryScale = doc["s"] | 0.0f;
+  _embeddedQuery = query;
+  return true;
+}
+
 bool RemoteMemory::_postJson(const String& endpoint,
                              const String& payload,
                              String* response) {
@@ -2,6 +2,19 @@
 #define RemoteMemory_h
 
 #include <Arduino.h>
+#include "MemoryIndex.h"
+
+// recall() answers from the local index (MemoryIndex) when it is in sync with the backend and the query
+// embedding could be fetched (/v1/memory/embed, small and without the Atlas search); otherwise the server
+// recall answers: while a cold index fills and while it is behind a store. A device with more items than
+// MEMORY_INDEX_CAPACITY is recalled from its newest MEMORY_INDEX_CAPACITY items.
+// syncIndex() fills a cold index newest first, so the recent items are there first, then pulls new items
+// incrementally. Call it off the turn path from the task that calls recall().
+
+#define MEMORY_SYNC_PAGE          8       // items per sync request
+#define MEMORY_SYNC_MAX_PAGES     8       // per syncIndex() call, new items
+#define MEMORY_BACKFILL_MAX_PAGES (MEMORY_INDEX_CAPACITY / MEMORY_SYNC_PAGE)  // per call, cold index
+#define MEMORY_EMBED_TIMEOUT_MS   2000
 
 class RemoteMemory {
   public:
@@ -22,13 +35,32 @@ class RemoteMemory {
 
     String recall(const String& query, int topConversations = 5, int topVisualEvents = 3);
 
+    void setLocalIndex(bool enabled);
+    bool syncIndex();                    // false if a request failed
+    size_t indexSize() const;
+    bool indexComplete() const;          // recall() can answer locally
+
   private:
     String _baseUrl;
     String _apiKey;
     String _deviceId;
     bool _enabled;
 
+    bool _localIndex;
+    MemoryIndex _index;
+    bool _backfilled;                    // the newest-first fill reached the oldest item (or the capacity)
+    uint64_t _backfillBefore;            // creation time of the oldest item fetched so far, 0: none yet
+    bool _caughtUp;                      // the last sync saw no newer items and nothing was stored since
+    bool _truncated;                     // the device has more items than the index holds, it keeps the newest
+    String _embeddedQuery;               // last query embedding, a speculative recall and the final one often match
+    int8_t* _queryVector;
+    float _queryScale;
+
+    void _resetSync();
+    bool _syncPage(bool newestFirst, uint64_t from, int8_t*& vector, size_t& added, bool& more, uint64_t& next);
     bool _postJson(const String& endpoint, const String& payload, String* response = nullptr);
+    bool _embedQuery(const String& query);
+    static bool _decodeVector(const char* base64, int8_t* out, size_t dim);
 };
 
 #endif
@@ -0,0 +1,215 @@
+#include "SystemTelemetry.h"
+#include <esp_heap_caps.h>
+#include "Audio.h"
+
+SystemTelemetry systemTelemetry;
+
+SystemTelemetry::SystemTelemetry()
+  : _audio(nullptr),
+    _taskCount(0),
+    _i2sCount(0),
+    _intervalMs(5000),
+    _serialIntervalMs(0),
+    _lastSampleMs(0),
+    _lastSerialMs(0) {
+  memset(&_last, 0, sizeof(_last));
+}
+
+void SystemTelemetry::setAudio(Audio* audio) {
+  _audio = audio;
+}
+
+bool SystemTelemetry::watchTask(const char* name, TaskHandle_t handle) {
+  if (handle == nullptr) handle = xTaskGetCurrentTaskHandle();
+  for (uint8_t i = 0; i < _taskCount; i++) {
+    if (_tasks[i] == handle) {
+      _taskNames[i] = name;
+      return true;
+    }
+  }
+  if (_taskCount >= TELEMETRY_MAX_TASKS || handle == nullptr) return false;
+  _taskNames[_taskCount] = name;
+  _tasks[_taskCount] = handle;
+  _taskCount++;
+  return true;
+}
+
+bool IRAM_ATTR SystemTelemetry::_onQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx) {
+  I2SSlot* slot = (I2SSlot*)userCtx;
+  if (slot->armed) slot->events++;
+  return false;
+}
+
+bool SystemTelemetry::attachI2S(const char* name, i2s_chan_handle_t handle, bool tx) {
+  if (handle == nullptr) return false;
+  for (uint8_t i = 0; i < _i2sCount; i++) {
+    if (_i2s[i].handle == handle) return true;
+  }
+  if (_i2sCount >= TELEMETRY_MAX_I2S) return false;
+
+  I2SSlot* slot = &_i2s[_i2sCount];
+  slot->name = name;
+  slot->handle = handle;
+  slot->tx = tx;
+  slot->armed = false;
+  slot->events = 0;
+
+  i2s_event_callbacks_t cbs = {};
+  if (tx) {
+    cbs.on_send_q_ovf = _onQueueOverflow;
+  } else {
+    cbs.on_recv_q_ovf = _onQueueOverflow;
+  }
+  esp_err_t err = i2s_channel_register_event_callback(handle, &cbs, slot);
+  if (err == ESP_ERR_INVALID_STATE) {  // callbacks can only be set on a stopped channel
+    i2s_channel_disable(handle);
+    err = i2s_channel_register_event_callback(handle, &cbs, slot);
+    i2s_channel_enable(handle);
+  }
+  if (err != ESP_OK) {
+    Serial.printf("[Telemetry] I2S %s: callback not registered (%d)\n", name, (int)err);
+    return false;
+  }
+  _i2sCount++;
+  return true;
+}
+
+void SystemTelemetry::setI2SArmed(i2s_chan_handle_t handle, bool armed) {
+  for (uint8_t i = 0; i < _i2sCount; i++) {
+    if (_i2s[i].handle == handle) _i2s[i].armed = armed;
+  }
+}
+
+void SystemTelemetry::setInterval(uint32_t ms) {
+  _intervalMs = ms < 250 ? 250 : ms;
+}
+
+void SystemTelemetry::setSerialInterval(uint32_t ms) {
+  _serialIntervalMs = ms;
+  _lastSerialMs = millis();
+}
+
+void SystemTelemetry::loop() {
+  uint32_t now = millis();
+  if (_last.seq == 0 || now - _lastSampleMs >= _intervalMs) {
+    sampleNow();
+  }
+  if (_serialIntervalMs > 0 && now - _lastSerialMs >= _serialIntervalMs) {
+    _lastSerialMs = now;
+    printRecord(Serial);
+  }
+}
+
+void SystemTelemetry::sampleNow() {
+  Sample& s = _last;
+  s.seq++;
+  s.uptimeMs = millis();
+  _lastSampleMs = s.uptimeMs;
+
+  s.heapFree = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  s.heapLargest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  s.heapMin = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  s.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+  s.psramLargest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+  s.psramMin = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+
+  for (uint8_t i = 0; i < _taskCount; i++) {
+    s.stackFree[i] = uxTaskGetStackHighWaterMark(_tasks[i]);  // bytes on ESP-IDF
+  }
+  for (uint8_t i = 0; i < _i2sCount; i++) {
+    s.i2sEvents[i] = _i2s[i].events;
+  }
+
+  if (_audio != nullptr) {
+    TaskHandle_t at = _audio->getAudioTaskHandle();
+    s.audioStackFree = at != nullptr ? uxTaskGetStackHighWaterMark(at) : 0;
+    s.audioUnderruns = _audio->getI2SUnderruns();
+    s.inBuffFilled = _audio->inBufferFilled();
+    s.inBuffSize = _audio->inBufferSize();
+    _audio->getDecodeTime(&s.decodeAvgUs, &s.decodeMaxUs);
+  }
+}
+
+const SystemTelemetry::Sample& SystemTelemetry::last() const {
+  return _last;
+}
+
+String SystemTelemetry::json() const {
+  const Sample& s = _last;
+  DynamicJsonDocument doc(1536);
+  doc["seq"] = s.seq;
+  doc["uptime_ms"] = s.uptimeMs;
+
+  JsonObject heap = doc.createNestedObject("heap");
+  heap["free"] = s.heapFree;
+  heap["largest"] = s.heapLargest;
+  heap["min"] = s.heapMin;
+  heap["frag_pct"] = s.heapFree ? 100 - (uint32_t)((uint64_t)s.heapLargest * 100 / s.heapFree) : 0;
+
+  if (s.psramFree > 0) {
+    JsonObject psram = doc.createNestedObject("psram");
+    psram["free"] = s.psramFree;
+    psram["largest"] = s.psramLargest;
+    psram["min"] = s.psramMin;
+    psram["frag_pct"] = 100 - (uint32_t)((uint64_t)s.psramLargest * 100 / s.psramFree);
+  }
+
+  JsonObject stacks = doc.createNestedObject("stack_free");
+  if (_audio != nullptr && s.audioStackFree > 0) {
+    stacks["audio"] = s.audioStackFree;
+  }
+  for (uint8_t i = 0; i < _taskCount; i++) {
+    stacks[_taskNames[i]] = s.stackFree[i];
+  }
+
+  JsonObject i2s = doc.createNestedObject("i2s");
+  if (_audio != nullptr) {
+    i2s["audio_tx_underruns"] = s.audioUnderruns;
+  }
+  for (uint8_t i = 0; i < _i2sCount; i++) {
+    String key = String(_i2s[i].name) + (_i2s[i].tx ? "_tx_underruns" : "_rx_overruns");
+    i2s[key] = s.i2sEvents[i];
+  }
+
+  if (_audio != nullptr) {
+    JsonObject audio = doc.createNestedObject("audio");
+    audio["inbuf_filled"] = s.inBuffFilled;
+    audio["inbuf_size"] = s.inBuffSize;
+    audio["inbuf_pct"] = s.inBuffSize ? (uint32_t)((uint64_t)s.inBuffFilled * 100 / s.inBuffSize) : 0;
+    audio["decode_avg_us"] = s.decodeAvgUs;
+    audio["decode_max_us"] = s.decodeMaxUs;
+  }
+
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+// one line, e.g. [TEL] 3605s heap 81234/45056 min 60312 psram 4012345/3997696 stk loop=5120 ttsAudio=2900
+//                i2s audio=0 mic=3 inbuf 42% dec 812/1930us
+void SystemTelemetry::printRecord(Print& out) const {
+  const Sample& s = _last;
+  out.printf("[TEL] %lus heap %lu/%lu min %lu", (unsigned long)(s.uptimeMs / 1000),
+             (unsigned long)s.heapFree, (unsigned long)s.heapLargest, (unsigned long)s.heapMin);
+  if (s.psramFree > 0) {
+    out.printf(" psram %lu/%lu", (unsigned long)s.psramFree, (unsigned long)s.psramLargest);
+  }
+  if (_taskCount > 0 || _audio != nullptr) out.print(" stk");
+  if (_audio != nullptr && s.audioStackFree > 0) {
+    out.printf(" audio=%lu", (unsigned long)s.audioStackFree);
+  }
+  for (uint8_t i = 0; i < _taskCount; i++) {
+    out.printf(" %s=%lu", _taskNames[i], (unsigned long)s.stackFree[i]);
+  }
+  if (_audio != nullptr || _i2sCount > 0) out.print(" i2s");
+  if (_audio != nullptr) out.printf(" audio=%lu", (unsigned long)s.audioUnderruns);
+  for (uint8_t i = 0; i < _i2sCount; i++) {
+    out.printf(" %s=%lu", _i2s[i].name, (unsigned long)s.i2sEvents[i]);
+  }
+  if (_audio != nullptr) {
+    out.printf(" inbuf %lu%% dec %lu/%luus",
+               (unsigned long)(s.inBuffSize ? (uint64_t)s.inBuffFilled * 100 / s.inBuffSize : 0),
+               (unsigned long)s.decodeAvgUs, (unsigned long)s.decodeMaxUs);
+  }
+  out.println();
+}
@@ -0,0 +1,86 @@
+#ifndef SystemTelemetry_h
+#define SystemTelemetry_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <driver/i2s_std.h>
+
+// Periodic health samples to line up audio glitches with heap fragmentation and starved tasks:
+// internal heap and PSRAM (free, largest block, minimum ever), stack high-water marks of the watched tasks,
+// I2S underruns/overruns, Audio InBuff fill and decoder time per frame.
+// Call loop() from the sketch loop, it samples every setInterval() ms and can print a compact serial record.
+
+#define TELEMETRY_MAX_TASKS 6
+#define TELEMETRY_MAX_I2S   4
+
+class Audio;
+
+class SystemTelemetry {
+  public:
+    struct Sample {
+      uint32_t seq;
+      uint32_t uptimeMs;
+      uint32_t heapFree;
+      uint32_t heapLargest;
+      uint32_t heapMin;
+      uint32_t psramFree;           // 0 without PSRAM
+      uint32_t psramLargest;
+      uint32_t psramMin;
+      uint32_t stackFree[TELEMETRY_MAX_TASKS];  // bytes that were never used
+      uint32_t audioStackFree;      // Audio library task
+      uint32_t i2sEvents[TELEMETRY_MAX_I2S];    // underruns (TX) or overruns (RX) since boot
+      uint32_t audioUnderruns;
+      uint32_t inBuffFilled;
+      uint32_t inBuffSize;
+      uint32_t decodeAvgUs;         // per decode() call since the previous sample
+      uint32_t decodeMaxUs;
+    };
+
+    SystemTelemetry();
+
+    void setAudio(Audio* audio);
+    bool watchTask(const char* name, TaskHandle_t handle = nullptr);  // nullptr: the calling task
+
+    // Counts the queue overflow events of an I2S channel, TX: the DMA ran dry, RX: samples were dropped.
+    // The channel is disabled for a moment if it is running. Only armed channels count, an idle microphone
+    // overflows all the time.
+    bool attachI2S(const char* name, i2s_chan_handle_t handle, bool tx);
+    void setI2SArmed(i2s_chan_handle_t handle, bool armed);
+
+    void setInterval(uint32_t ms);
+    void setSerialInterval(uint32_t ms);  // 0: no serial records
+    void loop();
+    void sampleNow();
+
+    const Sample& last() const;
+    String json() const;
+    void printRecord(Print& out) const;
+
+  private:
+    struct I2SSlot {
+      const char* name;
+      i2s_chan_handle_t handle;
+      bool tx;
+      volatile bool armed;
+      volatile uint32_t events;
+    };
+
+    Audio* _audio;
+    const char* _taskNames[TELEMETRY_MAX_TASKS];
+    TaskHandle_t _tasks[TELEMETRY_MAX_TASKS];
+    uint8_t _taskCount;
+    I2SSlot _i2s[TELEMETRY_MAX_I2S];
+    uint8_t _i2sCount;
+
+    uint32_t _intervalMs;
+    uint32_t _serialIntervalMs;
+    uint32_t _lastSampleMs;
+    uint32_t _lastSerialMs;
+    Sample _last;
+
+    static bool _onQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx);
+};
+
+extern SystemTelemetry systemTelemetry;
+
+#endif
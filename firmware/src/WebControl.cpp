@@ -1,9 +1,14 @@
 #include "WebControl.h"
 #include <ArduinoJson.h>
+#include "LatencyTracer.h"
+#include "SystemTelemetry.h"
 
 WebControl::WebControl(uint16_t port, uint16_t wsPort)
   : _port(port),
     _wsPort(wsPort),
+    _tracedTurns(0),
+    _healthSeq(0),
+    _eventTask(nullptr),
     _statusHandler(nullptr),
     _configGet(nullptr),
     _configSet(nullptr),
@@ -18,6 +23,8 @@ WebControl::WebControl(uint16_t port, uint16_t wsPort)
 #endif
 #if DAZI_WEBCTRL_HAS_WS
     , _ws(wsPort)
+    , _sendBuf(nullptr)
+    , _sendCap(0)
 #endif
 {}
 
@@ -38,6 +45,14 @@ bool WebControl::begin() {
   _server.begin();
 #if DAZI_WEBCTRL_HAS_WS
   _ws.begin();
+  _ws.onEvent([this](uint8_t num, WStype_t type, uint8_t* payload, size_t length) {
+    if (type == WStype_CONNECTED) _events.resendLatest();  // state, health, levels right away
+  });
+  if (_events.begin() && _eventTask == nullptr) {
+    // the socket belongs to this task from here on, a slow client blocks it and not the loop or audio
+    xTaskCreatePinnedToCore(_eventTaskFn, "WebEvents", WEBCTRL_EVENT_TASK_STACK, this, 1, &_eventTask, 0);
+  }
+  if (_eventTask == nullptr) Serial.println("[WebControl] No event task, the WebSocket is serviced by loop()");
 #endif
   return true;
 #endif
@@ -48,7 +63,15 @@ void WebControl::loop() {
   _server.handleClient();
 #endif
 #if DAZI_WEBCTRL_HAS_WS
-  _ws.loop();
+  if (_eventTask == nullptr) _serviceSocket();  // no lock or no task: connects and pings still work
+  if (_tracedTurns != latencyTracer.turnCount()) {  // push every finished turn to the dashboard
+    _tracedTurns = latencyTracer.turnCount();
+    publish(WEB_EVENT_TRACE, latencyTracer.lastTurnJson());
+  }
+  if (_healthSeq != systemTelemetry.last().seq) {  // one health sample per telemetry interval
+    _healthSeq = systemTelemetry.last().seq;
+    publish(WEB_EVENT_HEALTH, "{\"type\":\"health\",\"sample\":" + systemTelemetry.json() + "}");
+  }
 #endif
 }
 
@@ -60,13 +83,59 @@ void WebControl::setModelHandler(WebControlModelHandler fn) { _modelHandler = fn
 void WebControl::setMemoryHandlers(WebControlMemoryGetter getFn, WebControlMemoryClearer clearFn) { _memoryGet = getFn; _memoryClear = clearFn; }
 
 void WebControl::broadcastEvent(const String& eventJson) {
+  publish(WEB_EVENT_GENERIC, eventJson);
+}
+
+bool WebControl::publish(WebEventTopic topic, const String& json) {
+#if DAZI_WEBCTRL_HAS_WS
+  if (!_events.publish(topic, json)) return false;
+  if (_eventTask != nullptr) xTaskNotifyGive(_eventTask);
+  return true;
+#else
+  (void)topic;
+  (void)json;
+  return false;
+#endif
+}
+
+bool WebControl::publishBinary(WebEventTopic topic, const uint8_t* data, size_t len) {
 #if DAZI_WEBCTRL_HAS_WS
-  _ws.broadcastTXT(eventJson);
+  if (!_events.publishBinary(topic, data, len)) return false;
+  if (_eventTask != nullptr) xTaskNotifyGive(_eventTask);
+  return true;
 #else
-  (void)eventJson;
+  (void)topic;
+  (void)data;
+  (void)len;
+  return false;
 #endif
 }
 
+#if DAZI_WEBCTRL_HAS_WS
+void WebControl::_eventTaskFn(void* arg) {
+  WebControl* self = (WebControl*)arg;
+  for (;;) {
+    self->_serviceSocket();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(WEBCTRL_EVENT_POLL_MS));
+  }
+}
+
+// from the event task, or from loop() when there is none
+void WebControl::_serviceSocket() {
+  size_t len = 0;
+  bool binary = false;
+  _ws.loop();
+  for (uint8_t n = 0; n < 8 && _events.take(millis(), &_sendBuf, &_sendCap, &len, &binary); n++) {
+    if (_ws.connectedClients() == 0) continue;  // drain anyway, nothing piles up without clients
+    if (binary) {
+      _ws.broadcastBIN(_sendBuf, len);
+    } else {
+      _ws.broadcastTXT(_sendBuf, len);
+    }
+  }
+}
+#endif
+
 #if DAZI_WEBCTRL_HAS_WEBSERVER
 void WebControl::_registerRoutes() {
   _server.on("/", HTTP_GET, [this]() {
@@ -123,6 +192,22 @@ void WebControl::_registerRoutes() {
     _server.send(ok ? 200 : 400, "application/json", ok ? "{\"ok\":true}" : "{\"ok\":false}");
   });
 
+  _server.on("/metrics", HTTP_GET, [this]() {
+    _server.send(200, "application/json", latencyTracer.metricsJson());
+  });
+
+  _server.on("/trace", HTTP_GET, [this]() {
+    int n = _server.hasArg("n") ? _server.arg("n").toInt() : LATENCY_TRACE_TURNS;
+    if (n < 1) n = 1;
+    if (n > LATENCY_TRACE_TURNS) n = LATENCY_TRACE_TURNS;
+    _server.send(200, "application/json", latencyTracer.traceJson((uint8_t)n));
+  });
+
+  _server.on("/api/health", HTTP_GET, [this]() {
+    if (_server.hasArg("fresh")) systemTelemetry.sampleNow();
+    _server.send(200, "application/json", systemTelemetry.json());
+  });
+
   _server.on("/api/memory", HTTP_GET, [this]() {
     String body = _memoryGet ? _memoryGet() : "{\"items\":[]}";
     _server.send(200, "application/json", body);
@@ -2,6 +2,7 @@
 #define WebControl_h
 
 #include <Arduino.h>
+#include "WebEventBus.h"
 
 #if __has_include(<WebServer.h>)
 #include <WebServer.h>
@@ -13,6 +14,9 @@
 #define DAZI_WEBCTRL_HAS_WS 1
 #endif
 
+#define WEBCTRL_EVENT_TASK_STACK  4096
+#define WEBCTRL_EVENT_POLL_MS     10    // socket service and rate limited topics, publish() wakes the task earlier
+
 typedef String (*WebControlStatusHandler)();
 typedef String (*WebControlConfigGetter)();
 typedef bool (*WebControlConfigSetter)(const String& configJson);
@@ -37,11 +41,19 @@ class WebControl {
     void setModelHandler(WebControlModelHandler fn);
     void setMemoryHandlers(WebControlMemoryGetter getFn, WebControlMemoryClearer clearFn);
 
-    void broadcastEvent(const String& eventJson);
+    // Events go through the bus and are sent by the WebControl task (loop() without it), never from the caller.
+    void broadcastEvent(const String& eventJson);  // queued on WEB_EVENT_GENERIC
+    bool publish(WebEventTopic topic, const String& json);
+    bool publishBinary(WebEventTopic topic, const uint8_t* data, size_t len);
+    WebEventBus& events() { return _events; }
 
   private:
     uint16_t _port;
     uint16_t _wsPort;
+    uint32_t _tracedTurns;
+    uint32_t _healthSeq;
+    WebEventBus _events;
+    TaskHandle_t _eventTask;
 
     WebControlStatusHandler _statusHandler;
     WebControlConfigGetter _configGet;
@@ -58,11 +70,17 @@ class WebControl {
 #endif
 #if DAZI_WEBCTRL_HAS_WS
     WebSocketsServer _ws;
+    uint8_t* _sendBuf;                   // swapped with the bus buffers, grows to the largest event
+    size_t _sendCap;
 #endif
 
 #if DAZI_WEBCTRL_HAS_WEBSERVER
     void _registerRoutes();
 #endif
+#if DAZI_WEBCTRL_HAS_WS
+    static void _eventTaskFn(void* arg);
+    void _serviceSocket();
+#endif
 };
 
 #endif
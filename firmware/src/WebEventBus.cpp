@@ -0,0 +1,215 @@
+#include "WebEventBus.h"
+
+static const char* const s_topicNames[WEB_EVENT_TOPIC_COUNT] = {
+  "event", "state", "trace", "health", "vu"
+};
+
+// ---------------- CborWriter ----------------
+
+CborWriter::CborWriter(uint8_t* buf, size_t cap)
+  : _buf(buf), _cap(cap), _len(0), _overflow(false) {}
+
+void CborWriter::_put(const void* p, size_t n) {
+  if (_overflow || _len + n > _cap) {
+    _overflow = true;
+    return;
+  }
+  memcpy(_buf + _len, p, n);
+  _len += n;
+}
+
+// initial byte: major type in the top 3 bits, the argument inline below 24, else 1/2/4/8 big endian bytes
+void CborWriter::_head(uint8_t major, uint64_t v) {
+  uint8_t b[9];
+  size_t n;
+  major <<= 5;
+  if (v < 24) {
+    b[0] = major | (uint8_t)v;
+    n = 1;
+  } else if (v <= 0xFF) {
+    b[0] = major | 24;
+    n = 2;
+  } else if (v <= 0xFFFF) {
+    b[0] = major | 25;
+    n = 3;
+  } else if (v <= 0xFFFFFFFFULL) {
+    b[0] = major | 26;
+    n = 5;
+  } else {
+    b[0] = major | 27;
+    n = 9;
+  }
+  for (size_t i = n - 1; i >= 1; i--) {
+    b[i] = (uint8_t)v;
+    v >>= 8;
+  }
+  _put(b, n);
+}
+
+void CborWriter::writeMap(uint32_t pairs) { _head(5, pairs); }
+void CborWriter::writeArray(uint32_t items) { _head(4, items); }
+void CborWriter::writeUInt(uint64_t v) { _head(0, v); }
+
+void CborWriter::writeInt(int64_t v) {
+  if (v >= 0) {
+    _head(0, (uint64_t)v);
+  } else {
+    _head(1, (uint64_t)(-(v + 1)));
+  }
+}
+
+void CborWriter::writeText(const char* s) {
+  size_t n = s ? strlen(s) : 0;
+  _head(3, n);
+  _put(s, n);
+}
+
+void CborWriter::writeFloat(float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, 4);
+  uint8_t b[5] = {0xFA, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits};
+  _put(b, 5);
+}
+
+void CborWriter::writeBool(bool v) {
+  uint8_t b = v ? 0xF5 : 0xF4;
+  _put(&b, 1);
+}
+
+// ---------------- WebEventBus ----------------
+
+WebEventBus::WebEventBus()
+  : _lock(nullptr), _qHead(0), _qCount(0), _rr(0), _dropped(0) {
+  memset(_topics, 0, sizeof(_topics));
+  memset(_queue, 0, sizeof(_queue));
+  setPolicy(WEB_EVENT_GENERIC, 0, false);
+  setPolicy(WEB_EVENT_STATE, 0, true);
+  setPolicy(WEB_EVENT_TRACE, 0, false);
+  setPolicy(WEB_EVENT_HEALTH, 1000, true);
+  setPolicy(WEB_EVENT_VU, 50, true);
+}
+
+bool WebEventBus::begin() {
+  if (_lock == nullptr) _lock = xSemaphoreCreateMutex();
+  return _lock != nullptr;
+}
+
+void WebEventBus::setPolicy(WebEventTopic topic, uint32_t minIntervalMs, bool coalesce) {
+  if (topic >= WEB_EVENT_TOPIC_COUNT) return;
+  _topics[topic].minIntervalMs = minIntervalMs;
+  _topics[topic].coalesce = coalesce;
+}
+
+const char* WebEventBus::topicName(WebEventTopic topic) {
+  return topic < WEB_EVENT_TOPIC_COUNT ? s_topicNames[topic] : "unknown";
+}
+
+bool WebEventBus::_grow(uint8_t** buf, size_t* cap, size_t need) {
+  if (*cap >= need) return true;
+  size_t n = need < 256 ? 256 : need;
+  uint8_t* p = (uint8_t*)realloc(*buf, n);
+  if (p == nullptr) return false;
+  *buf = p;
+  *cap = n;
+  return true;
+}
+
+bool WebEventBus::_store(Buf& b, const uint8_t* data, size_t len, bool binary) {
+  if (!_grow(&b.data, &b.cap, len)) return false;
+  memcpy(b.data, data, len);
+  b.len = len;
+  b.binary = binary;
+  return true;
+}
+
+bool WebEventBus::publish(WebEventTopic topic, const String& json) {
+  return _publish(topic, (const uint8_t*)json.c_str(), json.length(), false);
+}
+
+bool WebEventBus::publishBinary(WebEventTopic topic, const uint8_t* data, size_t len) {
+  return _publish(topic, data, len, true);
+}
+
+bool WebEventBus::_publish(WebEventTopic topic, const uint8_t* data, size_t len, bool binary) {
+  if (_lock == nullptr || topic >= WEB_EVENT_TOPIC_COUNT || len == 0 || len > WEB_EVENT_MAX_PAYLOAD) return false;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  Topic& t = _topics[topic];
+  bool ok;
+  if (t.coalesce) {
+    ok = _store(t.latest, data, len, binary);  // latest value wins
+    if (ok) t.pending = true;
+  } else {
+    if (_qCount == WEB_EVENT_QUEUE_LEN) {  // the sender fell behind, drop the oldest
+      _qHead = (_qHead + 1) % WEB_EVENT_QUEUE_LEN;
+      _qCount--;
+      _dropped++;
+    }
+    Queued& q = _queue[(_qHead + _qCount) % WEB_EVENT_QUEUE_LEN];
+    ok = _store(q.buf, data, len, binary);
+    if (ok) {
+      q.topic = topic;
+      _qCount++;
+    }
+  }
+  if (!ok) _dropped++;
+  xSemaphoreGive(_lock);
+  return ok;
+}
+
+bool WebEventBus::take(uint32_t nowMs, uint8_t** buf, size_t* cap, size_t* len, bool* binary) {
+  if (_lock == nullptr) return false;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+
+  if (_qCount > 0) {
+    Queued& q = _queue[_qHead];
+    Topic& t = _topics[q.topic];
+    if (t.minIntervalMs == 0 || nowMs - t.lastSentMs >= t.minIntervalMs) {
+      uint8_t* data = q.buf.data;  // hand the event over, keep the caller's old buffer for the next one
+      size_t c = q.buf.cap;
+      q.buf.data = *buf;
+      q.buf.cap = *cap;
+      *buf = data;
+      *cap = c;
+      *len = q.buf.len;
+      *binary = q.buf.binary;
+      q.buf.len = 0;
+      t.lastSentMs = nowMs;
+      _qHead = (_qHead + 1) % WEB_EVENT_QUEUE_LEN;
+      _qCount--;
+      xSemaphoreGive(_lock);
+      return true;
+    }
+  }
+
+  for (uint8_t i = 0; i < WEB_EVENT_TOPIC_COUNT; i++) {
+    uint8_t k = (_rr + i) % WEB_EVENT_TOPIC_COUNT;
+    Topic& t = _topics[k];
+    if (!t.coalesce || !t.pending) continue;
+    if (t.minIntervalMs > 0 && nowMs - t.lastSentMs < t.minIntervalMs) continue;
+    if (!_grow(buf, cap, t.latest.len)) break;
+    memcpy(*buf, t.latest.data, t.latest.len);
+    *len = t.latest.len;
+    *binary = t.latest.binary;
+    t.pending = false;
+    t.lastSentMs = nowMs;
+    _rr = (k + 1) % WEB_EVENT_TOPIC_COUNT;
+    xSemaphoreGive(_lock);
+    return true;
+  }
+
+  xSemaphoreGive(_lock);
+  return false;
+}
+
+void WebEventBus::resendLatest() {
+  if (_lock == nullptr) return;
+  xSemaphoreTake(_lock, portMAX_DELAY);
+  for (uint8_t i = 0; i < WEB_EVENT_TOPIC_COUNT; i++) {
+    Topic& t = _topics[i];
+    if (t.coalesce && t.latest.len > 0) {
+      t.pending = true;
+      t.lastSentMs = 0;
+    }
+  }
+  xSemaphoreGive(_lock);
+}
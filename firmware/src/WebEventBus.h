@@ -0,0 +1,102 @@
+#ifndef WebEventBus_h
+#define WebEventBus_h
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Events for the WebControl socket, published from any task and sent by the WebControl task.
+// A topic is either queued (every event is delivered, in order) or coalesced (only the latest value
+// waits, at most one send per minimum interval). Payloads are JSON text or binary CBOR frames for the
+// high rate topics. Publishing only copies into a topic buffer, it never touches the network.
+
+#define WEB_EVENT_QUEUE_LEN     8     // queued events waiting for the sender, the oldest is dropped
+#define WEB_EVENT_MAX_PAYLOAD   4096  // larger events are refused
+
+enum WebEventTopic : uint8_t {
+  WEB_EVENT_GENERIC = 0,  // WebControl::broadcastEvent(), queued JSON
+  WEB_EVENT_STATE,        // conversation state changes, coalesced
+  WEB_EVENT_TRACE,        // finished latency turns, queued
+  WEB_EVENT_HEALTH,       // telemetry samples, coalesced, 1/s
+  WEB_EVENT_VU,           // playback levels, coalesced CBOR, 20/s
+  WEB_EVENT_TOPIC_COUNT
+};
+
+// Minimal CBOR (RFC 8949) encoder into a caller buffer, enough for flat maps of numbers and strings.
+// Writes past the end are dropped and ok() turns false.
+class CborWriter {
+  public:
+    CborWriter(uint8_t* buf, size_t cap);
+
+    void writeMap(uint32_t pairs);
+    void writeArray(uint32_t items);
+    void writeText(const char* s);
+    void writeUInt(uint64_t v);
+    void writeInt(int64_t v);
+    void writeFloat(float v);
+    void writeBool(bool v);
+
+    const uint8_t* data() const { return _buf; }
+    size_t length() const { return _len; }
+    bool ok() const { return !_overflow; }
+
+  private:
+    uint8_t* _buf;
+    size_t _cap;
+    size_t _len;
+    bool _overflow;
+
+    void _head(uint8_t major, uint64_t v);
+    void _put(const void* p, size_t n);
+};
+
+class WebEventBus {
+  public:
+    WebEventBus();
+
+    bool begin();  // creates the lock, publish() fails before
+    void setPolicy(WebEventTopic topic, uint32_t minIntervalMs, bool coalesce);
+
+    bool publish(WebEventTopic topic, const String& json);
+    bool publishBinary(WebEventTopic topic, const uint8_t* data, size_t len);
+
+    // Sender side: hands out the next due event in *buf, queued events swap buffers, coalesced ones are
+    // copied so a new client can get them again. The caller keeps the buffer for the next call.
+    bool take(uint32_t nowMs, uint8_t** buf, size_t* cap, size_t* len, bool* binary);
+    void resendLatest();  // a new client gets the current value of every coalesced topic
+    uint32_t dropped() const { return _dropped; }
+    static const char* topicName(WebEventTopic topic);
+
+  private:
+    struct Buf {
+      uint8_t* data;
+      size_t cap;
+      size_t len;
+      bool binary;
+    };
+    struct Topic {
+      uint32_t minIntervalMs;
+      uint32_t lastSentMs;
+      bool coalesce;
+      bool pending;               // coalesced value not sent yet
+      Buf latest;                 // coalesced topics only, kept after sending
+    };
+    struct Queued {
+      WebEventTopic topic;
+      Buf buf;
+    };
+
+    SemaphoreHandle_t _lock;
+    Topic _topics[WEB_EVENT_TOPIC_COUNT];
+    Queued _queue[WEB_EVENT_QUEUE_LEN];
+    uint8_t _qHead;
+    uint8_t _qCount;
+    uint8_t _rr;                  // next coalesced topic to look at, keeps a busy topic from starving the others
+    uint32_t _dropped;
+
+    bool _publish(WebEventTopic topic, const uint8_t* data, size_t len, bool binary);
+    static bool _store(Buf& b, const uint8_t* data, size_t len, bool binary);
+    static bool _grow(uint8_t** buf, size_t* cap, size_t need);
+};
+
+#endif
@@ -2,7 +2,7 @@
  *  aac_decoder.cpp
  *  faad2 - ESP32 adaptation
  *  Created on: 12.09.2023
- *  Updated on: 04.10.2024
+ *  Updated on: 18.10.2026
 */
 
 #include "Arduino.h"
@@ -32,6 +32,10 @@ static uint16_t validSamples = 0;
 clock_t before;
 float compressionRatio = 1;
 mp4AudioSpecificConfig* mp4ASC;
+uint32_t aacFreeRam = 0;   // free heap before NeAACDecOpen
+uint32_t aacFreePsram = 0;
+int32_t  aacRamUsage = -1; // measured after the first decoded frame (lazy SBR/PS state included)
+int32_t  aacPsramUsage = -1;
 
 //----------------------------------------------------------------------------------------------------------------------
 bool AACDecoder_IsInit(){
@@ -40,6 +44,9 @@ bool AACDecoder_IsInit(){
 //----------------------------------------------------------------------------------------------------------------------
 bool AACDecoder_AllocateBuffers(){
     before = clock();
+    aacFreeRam   = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    aacFreePsram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    aacRamUsage = aacPsramUsage = -1;
     hAac = NeAACDecOpen();
     conf = NeAACDecGetCurrentConfiguration(hAac);
 
@@ -153,9 +160,39 @@ int AACDecode(uint8_t *inbuf, int32_t *bytesLeft, short *outbuf){
     validSamples = frameInfo.samples;
     int8_t err = 0 - frameInfo.error;
     compressionRatio = (float)frameInfo.samples * 2 / frameInfo.bytesconsumed;
+    if(aacRamUsage < 0 && frameInfo.samples){ // all decoder buffers exist now, other tasks may blur the numbers a bit
+        aacRamUsage   = aacFreeRam   - heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        aacPsramUsage = aacFreePsram - heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+        log_i("AAC decoder, profile %s, SBR %i, PS %i: %li bytes RAM, %li bytes PSRAM", AACGetProfile(), frameInfo.sbr,
+              frameInfo.isPS, (long)aacRamUsage, (long)aacPsramUsage);
+    }
     return err;
 }
 //----------------------------------------------------------------------------------------------------------------------
+const char* AACGetProfile(){ // compile time profile, see AAC_PROFILE in neaacdec.h
+#if AAC_PROFILE == AAC_PROFILE_LC
+    return "LC";
+#elif AAC_PROFILE == AAC_PROFILE_HE
+    return "HE";
+#elif AAC_PROFILE == AAC_PROFILE_FULL
+    return "FULL";
+#else
+    #ifdef SBR_DEC
+        return "AUTO (SBR/PS)";
+    #else
+        return "AUTO (no SBR/PS)";
+    #endif
+#endif
+}
+//----------------------------------------------------------------------------------------------------------------------
+int32_t AACGetRamUsage(){   // heap used by the decoder, -1 until the first frame is decoded
+    return aacRamUsage;
+}
+//----------------------------------------------------------------------------------------------------------------------
+int32_t AACGetPsramUsage(){
+    return aacPsramUsage;
+}
+//----------------------------------------------------------------------------------------------------------------------
 const char* AACGetErrorMessage(int8_t err){
     return NeAACDecGetErrorMessage(abs(err));
 }
@@ -32,3 +32,6 @@ int         AACGetSampRate();
 int         AACGetBitsPerSample();
 int         AACDecode(uint8_t *inbuf, int32_t *bytesLeft, short *outbuf);
 const char* AACGetErrorMessage(int8_t err);
+const char* AACGetProfile();
+int32_t     AACGetRamUsage();
+int32_t     AACGetPsramUsage();
@@ -358,7 +358,7 @@ real_t log2_fix(uint32_t val) {
 }
 #endif
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
-const char *err_msg[] = {
+const char* const err_msg[] = {
     "No error",
     "Gain control not yet implemented",
     "Pulse coding not allowed in short blocks",
@@ -3385,20 +3385,20 @@ int8_t huffman_scale_factor(bitfile* ld) {
     return hcb_sf[offset][0];
 }
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
-const hcb* hcb_table[] = {0, hcb1_1, hcb2_1, 0, hcb4_1, 0, hcb6_1, 0, hcb8_1, 0, hcb10_1, hcb11_1};
-const hcb_2_quad* hcb_2_quad_table[] = {0, hcb1_2, hcb2_2, 0, hcb4_2, 0, 0, 0, 0, 0, 0, 0};
-const hcb_2_pair* hcb_2_pair_table[] = {0, 0, 0, 0, 0, 0, hcb6_2, 0, hcb8_2, 0, hcb10_2, hcb11_2};
-const hcb_bin_pair* hcb_bin_table[] = {0, 0, 0, 0, 0, hcb5, 0, hcb7, 0, hcb9, 0, 0};
-uint8_t hcbN[] = {0, 5, 5, 0, 5, 0, 5, 0, 5, 0, 6, 5};
+const hcb* const hcb_table[] = {0, hcb1_1, hcb2_1, 0, hcb4_1, 0, hcb6_1, 0, hcb8_1, 0, hcb10_1, hcb11_1};
+const hcb_2_quad* const hcb_2_quad_table[] = {0, hcb1_2, hcb2_2, 0, hcb4_2, 0, 0, 0, 0, 0, 0, 0};
+const hcb_2_pair* const hcb_2_pair_table[] = {0, 0, 0, 0, 0, 0, hcb6_2, 0, hcb8_2, 0, hcb10_2, hcb11_2};
+const hcb_bin_pair* const hcb_bin_table[] = {0, 0, 0, 0, 0, hcb5, 0, hcb7, 0, hcb9, 0, 0};
+const uint8_t hcbN[] = {0, 5, 5, 0, 5, 0, 5, 0, 5, 0, 6, 5};
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 /* defines whether a huffman codebook is unsigned or not */
 /* Table 4.6.2 */
-uint8_t unsigned_cb[] = {
+const uint8_t unsigned_cb[] = {
     0, 0, 0, 1, 1, 0, 0, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
 };
-int hcb_2_quad_table_size[] = {0, 114, 86, 0, 185, 0, 0, 0, 0, 0, 0, 0};
-int hcb_2_pair_table_size[] = {0, 0, 0, 0, 0, 0, 126, 0, 83, 0, 210, 373};
-int hcb_bin_table_size[] = {0, 0, 0, 161, 0, 161, 0, 127, 0, 337, 0, 0};
+const int hcb_2_quad_table_size[] = {0, 114, 86, 0, 185, 0, 0, 0, 0, 0, 0, 0};
+const int hcb_2_pair_table_size[] = {0, 0, 0, 0, 0, 0, 126, 0, 83, 0, 210, 373};
+const int hcb_bin_table_size[] = {0, 0, 0, 161, 0, 161, 0, 127, 0, 337, 0, 0};
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 void huffman_sign_bits(bitfile* ld, int16_t* sp, uint8_t len) {
     uint8_t i;
@@ -6700,7 +6700,7 @@ void ic_prediction(ic_stream* ics, real_t* spec, pred_state* state, uint16_t fra
 #endif
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #ifdef LD_DEC
-static const uint16_t* swb_offset_512_window[] = {
+static const uint16_t* const swb_offset_512_window[] = {
     0,                 /* 96000 */
     0,                 /* 88200 */
     0,                 /* 64000 */
@@ -6717,7 +6717,7 @@ static const uint16_t* swb_offset_512_window[] = {
 #endif // LD_DEC
 // ——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #ifdef LD_DEC
-static const uint16_t* swb_offset_480_window[] = {
+static const uint16_t* const swb_offset_480_window[] = {
     0,                 /* 96000 */
     0,                 /* 88200 */
     0,                 /* 64000 */
@@ -6733,7 +6733,7 @@ static const uint16_t* swb_offset_480_window[] = {
 };
 #endif // LD_DEC
 // ——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
-static const uint16_t* swb_offset_128_window[] = {
+static const uint16_t* const swb_offset_128_window[] = {
     swb_offset_128_96, /* 96000 */
     swb_offset_128_96, /* 88200 */
     swb_offset_128_64, /* 64000 */
@@ -9605,7 +9605,7 @@ static uint8_t rvlc_decode_sf_reverse(ic_stream *ics, bitfile *ld_sf, bitfile *l
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #ifdef ERROR_RESILIENCE
 /* index == 99 means not allowed codeword */
-static rvlc_huff_table book_rvlc[] = {
+static const rvlc_huff_table book_rvlc[] = {
     /*index  length  codeword */
     {0, 1, 0},    /*         0 */
     {-1, 3, 5},   /*       101 */
@@ -9639,7 +9639,7 @@ int8_t rvlc_huffman_sf(bitfile* ld_sf, bitfile* ld_esc, int8_t direction) {
     uint8_t          i, j;
     int8_t           index;
     uint32_t         cw;
-    rvlc_huff_table* h = book_rvlc;
+    const rvlc_huff_table* h = book_rvlc;
     i = h->len;
     if (direction > 0)
         cw = faad_getbits(ld_sf, i);
@@ -9680,7 +9680,7 @@ int8_t rvlc_huffman_sf(bitfile* ld_sf, bitfile* ld_esc, int8_t direction) {
 int8_t rvlc_huffman_esc(bitfile* ld, int8_t direction) {
     uint8_t          i, j;
     uint32_t         cw;
-    rvlc_huff_table* h = book_escape;
+    const rvlc_huff_table* h = book_escape;
     i = h->len;
     if (direction > 0)
         cw = faad_getbits(ld, i);
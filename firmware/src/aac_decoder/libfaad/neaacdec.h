@@ -49,6 +49,41 @@
 // #define SBR_LOW_POWER
 #define ALLOW_SMALL_FRAMELENGTH
 // #define LC_ONLY_DECODER // if you want a pure AAC LC decoder (independant of SBR_DEC and PS_DEC)
+// footprint profile, overrides the selection above, e.g. build_flags = -DAAC_PROFILE=AAC_PROFILE_LC
+//   AAC_PROFILE_AUTO  as above, SBR/PS only on ESP32-S3 with PSRAM
+//   AAC_PROFILE_LC    AAC-LC only, no SBR/PS/LTP/LD/ER code or state, no implicit SBR upsampling (smallest)
+//   AAC_PROFILE_HE    AAC-LC and HE-AAC v1/v2 (SBR, PS) on every target, no LTP/LD/ER
+//   AAC_PROFILE_FULL  everything above on every target
+// SBR and PS state is allocated when the first SBR/PS frame arrives, not in AACDecoder_AllocateBuffers()
+#define AAC_PROFILE_AUTO 0
+#define AAC_PROFILE_LC   1
+#define AAC_PROFILE_HE   2
+#define AAC_PROFILE_FULL 3
+#ifndef AAC_PROFILE
+    #define AAC_PROFILE AAC_PROFILE_AUTO
+#endif
+#if AAC_PROFILE == AAC_PROFILE_LC
+    #define LC_ONLY_DECODER
+    #undef SBR_DEC
+    #undef PS_DEC
+#elif AAC_PROFILE == AAC_PROFILE_HE
+    #undef LD_DEC
+    #undef LTP_DEC
+    #undef ERROR_RESILIENCE
+    #ifndef SBR_DEC
+        #define SBR_DEC
+    #endif
+    #ifndef PS_DEC
+        #define PS_DEC
+    #endif
+#elif AAC_PROFILE == AAC_PROFILE_FULL
+    #ifndef SBR_DEC
+        #define SBR_DEC
+    #endif
+    #ifndef PS_DEC
+        #define PS_DEC
+    #endif
+#endif
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #ifdef DRM_SUPPORT // Allow decoding of Digital Radio Mondiale (DRM)
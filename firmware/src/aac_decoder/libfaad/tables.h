@@ -935,7 +935,7 @@ const complex_t cfft_tab_128[] = {{FRAC_CONST(1.000000000000000), FRAC_CONST(0.0
 #endif // FIXED_POINT
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #ifdef FIXED_POINT
-static real_t drc_pow2_table[] = {COEF_CONST(0.5146511183), COEF_CONST(0.5297315472), COEF_CONST(0.5452538663), COEF_CONST(0.5612310242), COEF_CONST(0.5776763484), COEF_CONST(0.5946035575),
+static const real_t drc_pow2_table[] = {COEF_CONST(0.5146511183), COEF_CONST(0.5297315472), COEF_CONST(0.5452538663), COEF_CONST(0.5612310242), COEF_CONST(0.5776763484), COEF_CONST(0.5946035575),
                                   COEF_CONST(0.6120267717), COEF_CONST(0.6299605249), COEF_CONST(0.6484197773), COEF_CONST(0.6674199271), COEF_CONST(0.6869768237), COEF_CONST(0.7071067812),
                                   COEF_CONST(0.7278265914), COEF_CONST(0.7491535384), COEF_CONST(0.7711054127), COEF_CONST(0.7937005260), COEF_CONST(0.8169577266), COEF_CONST(0.8408964153),
                                   COEF_CONST(0.8655365610), COEF_CONST(0.8908987181), COEF_CONST(0.9170040432), COEF_CONST(0.9438743127), COEF_CONST(0.9715319412), COEF_CONST(1.0000000000),
@@ -4932,7 +4932,7 @@ static const real_t ld_mid_480[] = {FRAC_CONST(0),
 #endif
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #ifdef FIXED_POINT
-static real_t pow05_table[] = {
+static const real_t pow05_table[] = {
     COEF_CONST(1.68179283050743), /* 0.5^(-3/4) */
     COEF_CONST(1.41421356237310), /* 0.5^(-2/4) */
     COEF_CONST(1.18920711500272), /* 0.5^(-1/4) */
@@ -5252,7 +5252,7 @@ static const uint16_t  swb_offset_128_16[] = {0, 4, 8, 12, 16, 20, 24, 28, 32, 4
 static const uint16_t  swb_offset_1024_8[] = {0,   12,  24,  36,  48,  60,  72,  84,  96,  108, 120, 132, 144, 156, 172, 188, 204, 220, 236, 252, 268,
                                                     288, 308, 328, 348, 372, 396, 420, 448, 476, 508, 544, 580, 620, 664, 712, 764, 820, 880, 944, 1024};
 static const uint16_t  swb_offset_128_8[] = {0, 4, 8, 12, 16, 20, 24, 28, 36, 44, 52, 60, 72, 88, 108, 128};
-static const uint16_t* swb_offset_1024_window[] = {
+static const uint16_t* const swb_offset_1024_window[] = {
     swb_offset_1024_96, /* 96000 */
     swb_offset_1024_96, /* 88200 */
     swb_offset_1024_64, /* 64000 */
@@ -21664,21 +21664,21 @@ static const real_t iq_table[IQ_TABLE_SIZE] = {REAL_CONST(0.0),
 };
 #endif
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
-static real_t tns_coef_0_3[] = {COEF_CONST(0.0),           COEF_CONST(0.4338837391),  COEF_CONST(0.7818314825),  COEF_CONST(0.9749279122),  COEF_CONST(-0.9848077530), COEF_CONST(-0.8660254038),
+static const real_t tns_coef_0_3[] = {COEF_CONST(0.0),           COEF_CONST(0.4338837391),  COEF_CONST(0.7818314825),  COEF_CONST(0.9749279122),  COEF_CONST(-0.9848077530), COEF_CONST(-0.8660254038),
                                 COEF_CONST(-0.6427876097), COEF_CONST(-0.3420201433), COEF_CONST(-0.4338837391), COEF_CONST(-0.7818314825), COEF_CONST(-0.9749279122), COEF_CONST(-0.9749279122),
                                 COEF_CONST(-0.9848077530), COEF_CONST(-0.8660254038), COEF_CONST(-0.6427876097), COEF_CONST(-0.3420201433)};
-static real_t tns_coef_0_4[] = {COEF_CONST(0.0),           COEF_CONST(0.2079116908),  COEF_CONST(0.4067366431),  COEF_CONST(0.5877852523),  COEF_CONST(0.7431448255),  COEF_CONST(0.8660254038),
+static const real_t tns_coef_0_4[] = {COEF_CONST(0.0),           COEF_CONST(0.2079116908),  COEF_CONST(0.4067366431),  COEF_CONST(0.5877852523),  COEF_CONST(0.7431448255),  COEF_CONST(0.8660254038),
                                 COEF_CONST(0.9510565163),  COEF_CONST(0.9945218954),  COEF_CONST(-0.9957341763), COEF_CONST(-0.9618256432), COEF_CONST(-0.8951632914), COEF_CONST(-0.7980172273),
                                 COEF_CONST(-0.6736956436), COEF_CONST(-0.5264321629), COEF_CONST(-0.3612416662), COEF_CONST(-0.1837495178)};
-static real_t tns_coef_1_3[] = {COEF_CONST(0.0),           COEF_CONST(0.4338837391),  COEF_CONST(-0.6427876097), COEF_CONST(-0.3420201433), COEF_CONST(0.9749279122),  COEF_CONST(0.7818314825),
+static const real_t tns_coef_1_3[] = {COEF_CONST(0.0),           COEF_CONST(0.4338837391),  COEF_CONST(-0.6427876097), COEF_CONST(-0.3420201433), COEF_CONST(0.9749279122),  COEF_CONST(0.7818314825),
                                 COEF_CONST(-0.6427876097), COEF_CONST(-0.3420201433), COEF_CONST(-0.4338837391), COEF_CONST(-0.7818314825), COEF_CONST(-0.6427876097), COEF_CONST(-0.3420201433),
                                 COEF_CONST(-0.7818314825), COEF_CONST(-0.4338837391), COEF_CONST(-0.6427876097), COEF_CONST(-0.3420201433)};
-static real_t tns_coef_1_4[] = {COEF_CONST(0.0),           COEF_CONST(0.2079116908),  COEF_CONST(0.4067366431),  COEF_CONST(0.5877852523), COEF_CONST(-0.6736956436), COEF_CONST(-0.5264321629),
+static const real_t tns_coef_1_4[] = {COEF_CONST(0.0),           COEF_CONST(0.2079116908),  COEF_CONST(0.4067366431),  COEF_CONST(0.5877852523), COEF_CONST(-0.6736956436), COEF_CONST(-0.5264321629),
                                 COEF_CONST(-0.3612416662), COEF_CONST(-0.1837495178), COEF_CONST(0.9945218954),  COEF_CONST(0.9510565163), COEF_CONST(0.8660254038),  COEF_CONST(0.7431448255),
                                 COEF_CONST(-0.6736956436), COEF_CONST(-0.5264321629), COEF_CONST(-0.3612416662), COEF_CONST(-0.1837495178)};
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #ifdef ERROR_RESILIENCE
-static rvlc_huff_table book_escape[] = {
+static const rvlc_huff_table book_escape[] = {
     /*index  length  codeword */
     {1, 2, 0},        {0, 2, 2},        {3, 3, 2},        {2, 3, 6},        {4, 4, 14},       {7, 5, 13},       {6, 5, 15},       {5, 5, 31},       {11, 6, 24},      {10, 6, 25},
     {9, 6, 29},       {8, 6, 61},       {13, 7, 56},      {12, 7, 120},     {15, 8, 114},     {14, 8, 242},     {17, 9, 230},     {16, 9, 486},     {19, 10, 463},    {18, 10, 974},
@@ -21889,13 +21889,13 @@ static const real_t dct4_64_tab[] = {COEF_CONST(0.999924719333649),
 #endif // SBR_DEC
 #ifdef SSR_DEC
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
-static real_t sine_short_32[] = {0.0245412290, 0.0735645667, 0.1224106774, 0.1709618866, 0.2191012502, 0.2667127550, 0.3136817515, 0.3598950505, 0.4052413106, 0.4496113360, 0.4928981960,
+static const real_t sine_short_32[] = {0.0245412290, 0.0735645667, 0.1224106774, 0.1709618866, 0.2191012502, 0.2667127550, 0.3136817515, 0.3598950505, 0.4052413106, 0.4496113360, 0.4928981960,
                                  0.5349976420, 0.5758082271, 0.6152316332, 0.6531728506, 0.6895405650, 0.7242470980, 0.7572088838, 0.7883464694, 0.8175848126, 0.8448535800, 0.8700870275,
                                  0.8932242990, 0.9142097831, 0.9329928160, 0.9495282173, 0.9637760520, 0.9757021666, 0.9852776527, 0.9924795628, 0.9972904325, 0.9996988177};
 #ifdef SSR_DEC
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #endif /*SSR_DEC*/
-static real_t sine_long_256[] = {
+static const real_t sine_long_256[] = {
     0.0030679568, 0.0092037553, 0.0153392069, 0.0214740802, 0.0276081469, 0.0337411724, 0.0398729295, 0.0460031852, 0.0521317050, 0.0582582653, 0.0643826351, 0.0705045760, 0.0766238645, 0.0827402696,
     0.0888535529, 0.0949634984, 0.1010698676, 0.1071724296, 0.1132709533, 0.1193652153, 0.1254549921, 0.1315400302, 0.1376201212, 0.1436950415, 0.1497645378, 0.1558284014, 0.1618863940, 0.1679383069,
     0.1739838719, 0.1800229102, 0.1860551536, 0.1920804083, 0.1980984211, 0.2041089684, 0.2101118416, 0.2161068022, 0.2220936269, 0.2280720919, 0.2340419590, 0.2400030345, 0.2459550500, 0.2518978119,
@@ -21918,7 +21918,7 @@ static real_t sine_long_256[] = {
 #ifdef SSR_DEC
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #endif /*SSR_DEC*/
-static real_t kbd_short_32[] = {0.0000875914060105, 0.0009321760265333, 0.0032114611466596, 0.0081009893216786, 0.0171240286619181, 0.0320720743527833, 0.0548307856028528, 0.0871361822564870,
+static const real_t kbd_short_32[] = {0.0000875914060105, 0.0009321760265333, 0.0032114611466596, 0.0081009893216786, 0.0171240286619181, 0.0320720743527833, 0.0548307856028528, 0.0871361822564870,
                                 0.1302923415174603, 0.1848955425508276, 0.2506163195331889, 0.3260874142923209, 0.4089316830907141, 0.4959414909423747, 0.5833939894958904, 0.6674601983218376,
                                 0.7446454751465113, 0.8121892962974020, 0.8683559394406505, 0.9125649996381605, 0.9453396205809574, 0.9680864942677585, 0.9827581789763112, 0.9914756203467121,
                                 0.9961964092194694, 0.9984956609571091, 0.9994855586984285, 0.9998533730714648, 0.9999671864476404, 0.9999948432453556, 0.9999995655238333, 0.9999999961638728};
@@ -21926,7 +21926,7 @@ static real_t kbd_short_32[] = {0.0000875914060105, 0.0009321760265333, 0.003211
 #ifdef SSR_DEC
 //——————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————————
 #endif /*SSR_DEC*/
-static real_t kbd_long_256[] = {
+static const real_t kbd_long_256[] = {
     0.0005851230124487, 0.0009642149851497, 0.0013558207534965, 0.0017771849644394, 0.0022352533849672, 0.0027342299070304, 0.0032773001022195, 0.0038671998069216, 0.0045064443384152,
     0.0051974336885144, 0.0059425050016407, 0.0067439602523141, 0.0076040812644888, 0.0085251378135895, 0.0095093917383048, 0.0105590986429280, 0.0116765080854300, 0.0128638627792770,
     0.0141233971318631, 0.0154573353235409, 0.0168678890600951, 0.0183572550877256, 0.0199276125319803, 0.0215811201042484, 0.0233199132076965, 0.0251461009666641, 0.0270617631981826,
@@ -22475,7 +22475,7 @@ static const complex_t Q_Fract_allpass_SubQmf34[][3] = {
     {{FRAC_CONST(0.8910064697), FRAC_CONST(0.4539906085)}, {FRAC_CONST(0.7071067691), FRAC_CONST(-0.7071067691)}, {FRAC_CONST(0.6730125546), FRAC_CONST(-0.7396310568)}},
     {{FRAC_CONST(-0.6129069924), FRAC_CONST(-0.7901550531)}, {FRAC_CONST(0.7071067691), FRAC_CONST(0.7071067691)}, {FRAC_CONST(-0.9917160273), FRAC_CONST(-0.1284494549)}}};
 #if 0
-static float quant_rho[8] =
+static const float quant_rho[8] =
 {
     FRAC_CONST(1.0), FRAC_CONST(0.937), FRAC_CONST(0.84118), FRAC_CONST(0.60092),
     FRAC_CONST(0.36764), FRAC_CONST(0.0), FRAC_CONST(-0.589), FRAC_CONST(-1.0)
@@ -22803,7 +22803,7 @@ static const real_t sf_iid_fine[] = {COEF_CONST(1.4142065048), COEF_CONST(1.4141
 #ifdef SSR_DEC
 void gc_set_protopqf(real_t* p_proto) {
     int           j;
-    static real_t a_half[48] = {1.2206911375946939E-05,  1.7261986723798209E-05,  1.2300093657077942E-05,  -1.0833943097791965E-05, -5.7772498639901686E-05, -1.2764767618947719E-04,
+    static const real_t a_half[48] = {1.2206911375946939E-05,  1.7261986723798209E-05,  1.2300093657077942E-05,  -1.0833943097791965E-05, -5.7772498639901686E-05, -1.2764767618947719E-04,
                                 -2.0965186675013334E-04, -2.8166673689263850E-04, -3.1234860429017460E-04, -2.6738519958452353E-04, -1.1949424681824722E-04, 1.3965139412648678E-04,
                                 4.8864136409185725E-04,  8.7044629275148344E-04,  1.1949430269934793E-03,  1.3519708175026700E-03,  1.2346314373964412E-03,  7.6953209114159191E-04,
                                 -5.2242432579537141E-05, -1.1516092887213454E-03, -2.3538469841711277E-03, -3.4033123072127277E-03, -4.0028551071986133E-03, -3.8745415659693259E-03,
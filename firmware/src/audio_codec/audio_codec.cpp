@@ -0,0 +1,346 @@
+/*
+ * audio_codec.cpp
+ *
+ * adapters between the decoder free functions and audioCodec_t, and the registry itself
+ */
+#include "audio_codec.h"
+#if AUDIO_CODEC_MP3
+    #include "../mp3_decoder/mp3_decoder.h"
+#endif
+#if AUDIO_CODEC_AAC
+    #include "../aac_decoder/aac_decoder.h"
+#endif
+#if AUDIO_CODEC_FLAC
+    #include "../flac_decoder/flac_decoder.h"
+#endif
+#if AUDIO_CODEC_OPUS
+    #include "../opus_decoder/opus_decoder.h"
+#endif
+#if AUDIO_CODEC_VORBIS
+    #include "../vorbis_decoder/vorbis_decoder.h"
+#endif
+
+static char s_paramBuff[64];
+
+//----------------------------------------------------------------------------------------------------------------------
+//                                                      M P 3
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_MP3
+static int32_t  mp3Decode(uint8_t* data, int32_t* bytesLeft, int16_t* out) {return MP3Decode(data, bytesLeft, out, 0);}
+static uint16_t mp3OutputFrames() {return MP3GetChannels() ? MP3GetOutputSamps() / MP3GetChannels() : 0;}
+static uint8_t  mp3Channels()     {return MP3GetChannels();}
+static uint32_t mp3SampleRate()   {return MP3GetSampRate();}
+static uint8_t  mp3BitsPerSample(){return MP3GetBitsPerSample();}
+static uint32_t mp3BitRate()      {return MP3GetBitrate();}
+
+static const char* mp3Param(uint8_t idx) {
+    if(idx > 0) return NULL;
+    snprintf(s_paramBuff, sizeof(s_paramBuff), "MPEG-%s, Layer %s", (MP3GetVersion() == 0) ? "2.5" : (MP3GetVersion() == 2) ? "2" : "1",
+             (MP3GetLayer() == 1) ? "III" : (MP3GetLayer() == 2) ? "II" : "I");
+    return s_paramBuff;
+}
+
+static const char* mp3ErrorString(int32_t err) {
+    switch(err) {
+        case ERR_MP3_NONE: return "NONE";
+        case ERR_MP3_INDATA_UNDERFLOW: return "INDATA_UNDERFLOW";
+        case ERR_MP3_MAINDATA_UNDERFLOW: return "MAINDATA_UNDERFLOW";
+        case ERR_MP3_FREE_BITRATE_SYNC: return "FREE_BITRATE_SYNC";
+        case ERR_MP3_OUT_OF_MEMORY: return "OUT_OF_MEMORY";
+        case ERR_MP3_NULL_POINTER: return "NULL_POINTER";
+        case ERR_MP3_INVALID_FRAMEHEADER: return "INVALID_FRAMEHEADER";
+        case ERR_MP3_INVALID_SIDEINFO: return "INVALID_SIDEINFO";
+        case ERR_MP3_INVALID_SCALEFACT: return "INVALID_SCALEFACT";
+        case ERR_MP3_INVALID_HUFFCODES: return "INVALID_HUFFCODES";
+        case ERR_MP3_INVALID_DEQUANTIZE: return "INVALID_DEQUANTIZE";
+        case ERR_MP3_INVALID_IMDCT: return "INVALID_IMDCT";
+        case ERR_MP3_INVALID_SUBBAND: return "INVALID_SUBBAND";
+    }
+    return NULL;
+}
+
+static const audioCodec_t mp3Codec = {
+    .id = AUDIO_CODEC_ID_MP3, .name = "MP3", .fileExt = NULL, .mimeType = NULL,
+    .maxBlockSize = 1600, .needsPSRAM = false, .reusable = true, .resyncSkip = 1,
+    .init = MP3Decoder_AllocateBuffers, .deinit = MP3Decoder_FreeBuffers, .probe = MP3FindSyncWord, .decode = mp3Decode,
+    .outputFrames = mp3OutputFrames, .channels = mp3Channels, .sampleRate = mp3SampleRate,
+    .bitsPerSample = mp3BitsPerSample, .bitRate = mp3BitRate,
+    .isInit = MP3Decoder_IsInit, .flush = MP3Decoder_ClearBuffer, .setParams = NULL, .audioDataStart = NULL,
+    .duration = NULL, .errorString = mp3ErrorString, .isFatal = NULL, .param = mp3Param, .notice = NULL,
+    .streamTitle = NULL, .metadataPicture = NULL,
+};
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//                                                      A A C
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_AAC
+static int32_t  aacProbe(uint8_t* data, int32_t len) {return AACFindSyncWord(data, len);}
+static int32_t  aacDecode(uint8_t* data, int32_t* bytesLeft, int16_t* out) {return AACDecode(data, bytesLeft, out);}
+static uint16_t aacOutputFrames() {return AACGetChannels() ? AACGetOutputSamps() / AACGetChannels() : 0;}
+static uint8_t  aacChannels()     {return AACGetChannels();}
+static uint32_t aacSampleRate()   {return AACGetSampRate();}
+static uint8_t  aacBitsPerSample(){return AACGetBitsPerSample();}
+static uint32_t aacBitRate()      {return AACGetBitrate();}
+static const char* aacErrorString(int32_t err) {return AACGetErrorMessage(abs(err));}
+
+static void aacSetParams(const audioCodecParams_t* p) { // M4A, there is no ADTS header
+    AACSetRawBlockParams(p->channels, p->sampleRate, p->objectType);
+}
+
+static const char* aacParam(uint8_t idx) {
+    if(idx == 0) {
+        uint8_t answ = AACGetFormat();
+        if(answ >= 3) return "";
+        const char hf[3][8] = {"unknown", "ADIF", "ADTS"};
+        snprintf(s_paramBuff, sizeof(s_paramBuff), "AAC HeaderFormat: %s", hf[answ]);
+        return s_paramBuff;
+    }
+    if(idx == 1) {
+        uint8_t answ = AACGetSBR();
+        if(answ == 0 || answ >= 4) return "";
+        const char sbr[4][50] = {"without SBR", "upsampled SBR", "downsampled SBR", "no SBR used, but file is upsampled by a factor 2"};
+        snprintf(s_paramBuff, sizeof(s_paramBuff), "Spectral band replication: %s", sbr[answ]);
+        return s_paramBuff;
+    }
+    return NULL;
+}
+
+static const char* aacNotice() {
+    static uint8_t isPS = 0;
+    if(!isPS && AACGetParametricStereo()) { // only change 0 -> 1
+        isPS = 1;
+        return "Parametric Stereo";
+    }
+    isPS = AACGetParametricStereo();
+    return NULL;
+}
+
+static const audioCodec_t aacCodec = {
+    .id = AUDIO_CODEC_ID_AAC, .name = "AAC", .fileExt = NULL, .mimeType = NULL,
+    .maxBlockSize = 1600, .needsPSRAM = false, .reusable = false, .resyncSkip = 1,
+    .init = AACDecoder_AllocateBuffers, .deinit = AACDecoder_FreeBuffers, .probe = aacProbe, .decode = aacDecode,
+    .outputFrames = aacOutputFrames, .channels = aacChannels, .sampleRate = aacSampleRate,
+    .bitsPerSample = aacBitsPerSample, .bitRate = aacBitRate,
+    .isInit = AACDecoder_IsInit, .flush = NULL, .setParams = aacSetParams, .audioDataStart = NULL,
+    .duration = NULL, .errorString = aacErrorString, .isFatal = NULL, .param = aacParam, .notice = aacNotice,
+    .streamTitle = NULL, .metadataPicture = NULL,
+};
+
+static const audioCodec_t m4aCodec = {  // same decoder, raw frames from the mdat atom
+    .id = AUDIO_CODEC_ID_M4A, .name = "AAC", .fileExt = NULL, .mimeType = NULL,
+    .maxBlockSize = 1600, .needsPSRAM = false, .reusable = false, .resyncSkip = 1,
+    .init = AACDecoder_AllocateBuffers, .deinit = AACDecoder_FreeBuffers, .probe = aacProbe, .decode = aacDecode,
+    .outputFrames = aacOutputFrames, .channels = aacChannels, .sampleRate = aacSampleRate,
+    .bitsPerSample = aacBitsPerSample, .bitRate = aacBitRate,
+    .isInit = AACDecoder_IsInit, .flush = NULL, .setParams = aacSetParams, .audioDataStart = NULL,
+    .duration = NULL, .errorString = aacErrorString, .isFatal = NULL, .param = NULL, .notice = NULL,
+    .streamTitle = NULL, .metadataPicture = NULL,
+};
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//                                                     F L A C
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_FLAC
+static int32_t  flacProbe(uint8_t* data, int32_t len) {return FLACFindSyncWord(data, len);}
+static int32_t  flacDecode(uint8_t* data, int32_t* bytesLeft, int16_t* out) {return FLACDecode(data, bytesLeft, out);}
+static uint16_t flacOutputFrames() {return FLACGetChannels() ? FLACGetOutputSamps() / FLACGetChannels() : 0;}
+
+static void flacSetParams(const audioCodecParams_t* p) { // native FLAC, STREAMINFO is read by Audio
+    FLACSetRawBlockParams(p->channels, p->sampleRate, p->bitsPerSample, p->totalSamples, p->audioDataLength);
+}
+
+static const char* flacErrorString(int32_t err) {
+    switch(err) {
+        case ERR_FLAC_NONE: return "NONE";
+        case ERR_FLAC_BLOCKSIZE_TOO_BIG: return "BLOCKSIZE TOO BIG";
+        case ERR_FLAC_RESERVED_BLOCKSIZE_UNSUPPORTED: return "Reserved Blocksize unsupported";
+        case ERR_FLAC_SYNC_CODE_NOT_FOUND: return "SYNC CODE NOT FOUND";
+        case ERR_FLAC_UNKNOWN_CHANNEL_ASSIGNMENT: return "UNKNOWN CHANNEL ASSIGNMENT";
+        case ERR_FLAC_RESERVED_CHANNEL_ASSIGNMENT: return "RESERVED CHANNEL ASSIGNMENT";
+        case ERR_FLAC_RESERVED_SUB_TYPE: return "RESERVED SUB TYPE";
+        case ERR_FLAC_PREORDER_TOO_BIG: return "PREORDER TOO BIG";
+        case ERR_FLAC_RESERVED_RESIDUAL_CODING: return "RESERVED RESIDUAL CODING";
+        case ERR_FLAC_WRONG_RICE_PARTITION_NR: return "WRONG RICE PARTITION NR";
+        case ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG: return "BITS PER SAMPLE > 24";
+        case ERR_FLAC_BITS_PER_SAMPLE_UNKNOWN: return "BITS PER SAMPLE UNKNOWN";
+        case ERR_FLAC_DECODER_ASYNC: return "DECODER ASYNCHRON";
+        case ERR_FLAC_BITREADER_UNDERFLOW: return "BITREADER ERROR";
+        case ERR_FLAC_OUTBUFFER_TOO_SMALL: return "OUTBUFFER TOO SMALL";
+    }
+    return NULL;
+}
+
+static const audioCodec_t flacCodec = {
+    .id = AUDIO_CODEC_ID_FLAC, .name = "FLAC", .fileExt = NULL, .mimeType = NULL,
+    .maxBlockSize = 4096 * 4, .needsPSRAM = true, .reusable = true, .resyncSkip = 1,
+    .init = FLACDecoder_AllocateBuffers, .deinit = FLACDecoder_FreeBuffers, .probe = flacProbe, .decode = flacDecode,
+    .outputFrames = flacOutputFrames, .channels = FLACGetChannels, .sampleRate = FLACGetSampRate,
+    .bitsPerSample = FLACGetOutputBitsPerSample, .bitRate = FLACGetBitRate,
+    .isInit = NULL, .flush = FLACDecoderReset, .setParams = flacSetParams, .audioDataStart = FLACGetAudioDataStart,
+    .duration = FLACGetAudioFileDuration, .errorString = flacErrorString, .isFatal = NULL, .param = NULL,
+    .notice = NULL, .streamTitle = FLACgetStreamTitle, .metadataPicture = FLACgetMetadataBlockPicture,
+};
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//                                                     O P U S
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_OPUS
+static int32_t opusProbe(uint8_t* data, int32_t len) {return OPUSFindSyncWord(data, len);}
+
+static const char* opusErrorString(int32_t err) {
+    switch(err) {
+        case ERR_OPUS_NONE: return "NONE";
+        case ERR_OPUS_CHANNELS_OUT_OF_RANGE: return "UNKNOWN CHANNEL ASSIGNMENT";
+        case ERR_OPUS_INVALID_SAMPLERATE: return "SAMPLERATE IS NOT 48000Hz";
+        case ERR_OPUS_EXTRA_CHANNELS_UNSUPPORTED: return "EXTRA CHANNELS UNSUPPORTED";
+        case ERR_OPUS_SILK_MODE_UNSUPPORTED: return "SILK MODE UNSUPPORTED";
+        case ERR_OPUS_HYBRID_MODE_UNSUPPORTED: return "HYBRID MODE UNSUPPORTED";
+        case ERR_OPUS_NARROW_BAND_UNSUPPORTED: return "NARROW_BAND_UNSUPPORTED";
+        case ERR_OPUS_WIDE_BAND_UNSUPPORTED: return "WIDE_BAND_UNSUPPORTED";
+        case ERR_OPUS_SUPER_WIDE_BAND_UNSUPPORTED: return "SUPER_WIDE_BAND_UNSUPPORTED";
+        case ERR_OPUS_CELT_BAD_ARG: return "CELT_DECODER_BAD_ARG";
+        case ERR_OPUS_CELT_INTERNAL_ERROR: return "CELT DECODER INTERNAL ERROR";
+        case ERR_OPUS_CELT_UNIMPLEMENTED: return "CELT DECODER UNIMPLEMENTED ARG";
+        case ERR_OPUS_CELT_ALLOC_FAIL: return "CELT DECODER INIT ALLOC FAIL";
+        case ERR_OPUS_CELT_UNKNOWN_REQUEST: return "CELT_UNKNOWN_REQUEST FAIL";
+        case ERR_OPUS_CELT_GET_MODE_REQUEST: return "CELT_GET_MODE_REQUEST FAIL";
+        case ERR_OPUS_CELT_CLEAR_REQUEST: return "CELT_CLEAR_REAUEST_FAIL";
+        case ERR_OPUS_CELT_SET_CHANNELS: return "CELT_SET_CHANNELS_FAIL";
+        case ERR_OPUS_CELT_END_BAND: return "CELT_END_BAND_REQUEST_FAIL";
+        case ERR_CELT_OPUS_INTERNAL_ERROR: return "CELT_INTERNAL_ERROR";
+    }
+    return NULL;
+}
+
+static bool opusIsFatal(int32_t err) { // modes and bandwidths this decoder can't handle, the next frame will be the same
+    switch(err) {
+        case ERR_OPUS_HYBRID_MODE_UNSUPPORTED:
+        case ERR_OPUS_SILK_MODE_UNSUPPORTED:
+        case ERR_OPUS_NARROW_BAND_UNSUPPORTED:
+        case ERR_OPUS_WIDE_BAND_UNSUPPORTED:
+        case ERR_OPUS_SUPER_WIDE_BAND_UNSUPPORTED:
+        case ERR_OPUS_INVALID_SAMPLERATE: return true;
+    }
+    return false;
+}
+
+static const audioCodec_t opusCodec = {
+    .id = AUDIO_CODEC_ID_OPUS, .name = "OPUS", .fileExt = NULL, .mimeType = NULL,
+    .maxBlockSize = 1024, .needsPSRAM = false, .reusable = false, .resyncSkip = 0,
+    .init = OPUSDecoder_AllocateBuffers, .deinit = OPUSDecoder_FreeBuffers, .probe = opusProbe, .decode = OPUSDecode,
+    .outputFrames = OPUSGetOutputSamps, .channels = OPUSGetChannels, .sampleRate = OPUSGetSampRate,
+    .bitsPerSample = OPUSGetBitsPerSample, .bitRate = OPUSGetBitRate,
+    .isInit = NULL, .flush = OPUSDecoder_ClearBuffers, .setParams = NULL, .audioDataStart = OPUSGetAudioDataStart,
+    .duration = NULL, .errorString = opusErrorString, .isFatal = opusIsFatal, .param = NULL, .notice = NULL,
+    .streamTitle = OPUSgetStreamTitle, .metadataPicture = OPUSgetMetadataBlockPicture,
+};
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//                                                   V O R B I S
+//----------------------------------------------------------------------------------------------------------------------
+#if AUDIO_CODEC_VORBIS
+static int32_t vorbisProbe(uint8_t* data, int32_t len) {return VORBISFindSyncWord(data, len);}
+
+static const char* vorbisErrorString(int32_t err) {
+    switch(err) {
+        case ERR_VORBIS_NONE: return "NONE";
+        case ERR_VORBIS_CHANNELS_OUT_OF_RANGE: return "CHANNELS OUT OF RANGE";
+        case ERR_VORBIS_INVALID_SAMPLERATE: return "INVALID SAMPLERATE";
+        case ERR_VORBIS_EXTRA_CHANNELS_UNSUPPORTED: return "EXTRA CHANNELS UNSUPPORTED";
+        case ERR_VORBIS_DECODER_ASYNC: return "DECODER ASYNC";
+        case ERR_VORBIS_OGG_SYNC_NOT_FOUND: return "SYNC NOT FOUND";
+        case ERR_VORBIS_BAD_HEADER: return "BAD HEADER";
+        case ERR_VORBIS_NOT_AUDIO: return "NOT AUDIO";
+        case ERR_VORBIS_BAD_PACKET: return "BAD PACKET";
+    }
+    return NULL;
+}
+
+static const audioCodec_t vorbisCodec = {
+    .id = AUDIO_CODEC_ID_VORBIS, .name = "VORBIS", .fileExt = NULL, .mimeType = NULL,
+    .maxBlockSize = 4096 * 2, .needsPSRAM = true, .reusable = false, .resyncSkip = 1,
+    .init = VORBISDecoder_AllocateBuffers, .deinit = VORBISDecoder_FreeBuffers, .probe = vorbisProbe,
+    .decode = VORBISDecode, .outputFrames = VORBISGetOutputSamps, .channels = VORBISGetChannels,
+    .sampleRate = VORBISGetSampRate, .bitsPerSample = VORBISGetBitsPerSample, .bitRate = VORBISGetBitRate,
+    .isInit = NULL, .flush = VORBISDecoder_ClearBuffers, .setParams = NULL, .audioDataStart = VORBISGetAudioDataStart,
+    .duration = NULL, .errorString = vorbisErrorString, .isFatal = NULL, .param = NULL, .notice = NULL,
+    .streamTitle = VORBISgetStreamTitle, .metadataPicture = VORBISgetMetadataBlockPicture,
+};
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+//                                                  R E G I S T R Y
+//----------------------------------------------------------------------------------------------------------------------
+static const audioCodec_t* const s_builtin[] = {
+#if AUDIO_CODEC_MP3
+    &mp3Codec,
+#endif
+#if AUDIO_CODEC_AAC
+    &aacCodec, &m4aCodec,
+#endif
+#if AUDIO_CODEC_FLAC
+    &flacCodec,
+#endif
+#if AUDIO_CODEC_OPUS
+    &opusCodec,
+#endif
+#if AUDIO_CODEC_VORBIS
+    &vorbisCodec,
+#endif
+    NULL
+};
+static const audioCodec_t* s_user[AUDIO_CODEC_MAX_USER] = {NULL};
+
+//----------------------------------------------------------------------------------------------------------------------
+bool audioCodecRegister(const audioCodec_t* codec) {
+    if(!codec || !codec->init || !codec->deinit || !codec->probe || !codec->decode || !codec->outputFrames) return false;
+    if(!codec->channels || !codec->sampleRate || !codec->bitsPerSample || !codec->bitRate) return false;
+    for(int i = 0; i < AUDIO_CODEC_MAX_USER; i++) {
+        if(s_user[i] && s_user[i]->id == codec->id) {s_user[i] = codec; return true;} // replace
+    }
+    for(int i = 0; i < AUDIO_CODEC_MAX_USER; i++) {
+        if(!s_user[i]) {s_user[i] = codec; return true;}
+    }
+    log_e("no free slot for codec %s, see AUDIO_CODEC_MAX_USER", codec->name);
+    return false;
+}
+//----------------------------------------------------------------------------------------------------------------------
+const audioCodec_t* audioCodecFind(uint8_t id) {
+    for(int i = 0; i < AUDIO_CODEC_MAX_USER; i++) {
+        if(s_user[i] && s_user[i]->id == id) return s_user[i];
+    }
+    for(int i = 0; s_builtin[i]; i++) {
+        if(s_builtin[i]->id == id) return s_builtin[i];
+    }
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+const audioCodec_t* audioCodecFindByExt(const char* path) {
+    if(!path) return NULL;
+    int pLen = strlen(path);
+    for(int i = 0; i < AUDIO_CODEC_MAX_USER; i++) {
+        if(!s_user[i] || !s_user[i]->fileExt) continue;
+        int eLen = strlen(s_user[i]->fileExt);
+        if(pLen >= eLen && strcasecmp(path + pLen - eLen, s_user[i]->fileExt) == 0) return s_user[i];
+    }
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+const audioCodec_t* audioCodecFindByMime(const char* mimeType) {
+    if(!mimeType) return NULL;
+    for(int i = 0; i < AUDIO_CODEC_MAX_USER; i++) {
+        if(s_user[i] && s_user[i]->mimeType && strcasecmp(mimeType, s_user[i]->mimeType) == 0) return s_user[i];
+    }
+    return NULL;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void audioCodecDeinitAll() {
+    for(int i = 0; s_builtin[i]; i++) s_builtin[i]->deinit();
+    for(int i = 0; i < AUDIO_CODEC_MAX_USER; i++) {
+        if(s_user[i]) s_user[i]->deinit();
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * audio_codec.h
+ *
+ * decoder interface and registry, Audio reaches the decoders only through an audioCodec_t
+ *
+ * The built-in decoders are selected at compile time, e.g. -DAUDIO_CODEC_FLAC=0 -DAUDIO_CODEC_VORBIS=0 in the
+ * build_flags. A disabled decoder is not referenced anywhere, the linker (--gc-sections) drops its code and tables.
+ * More decoders can be added at runtime with audioCodecRegister() before connecttoFS() or connecttohost() is called,
+ * a registered decoder with the id of a built-in one replaces it.
+ */
+#pragma once
+
+#include "Arduino.h"
+#include <vector>
+
+#ifndef AUDIO_CODEC_MP3
+    #define AUDIO_CODEC_MP3     1
+#endif
+#ifndef AUDIO_CODEC_AAC
+    #define AUDIO_CODEC_AAC     1       // AAC, AACP and M4A
+#endif
+#ifndef AUDIO_CODEC_FLAC
+    #define AUDIO_CODEC_FLAC    1
+#endif
+#ifndef AUDIO_CODEC_OPUS
+    #define AUDIO_CODEC_OPUS    1
+#endif
+#ifndef AUDIO_CODEC_VORBIS
+    #define AUDIO_CODEC_VORBIS  1
+#endif
+
+#define AUDIO_CODEC_MAX_USER    4       // number of decoders that can be registered at runtime
+#define AUDIO_CODEC_NO_OUTPUT   100     // decode() consumed header or metadata, no samples (FLAC/OPUS/VORBIS_PARSE_OGG_DONE)
+
+enum : uint8_t { AUDIO_CODEC_ID_MP3 = 2, AUDIO_CODEC_ID_AAC = 3, AUDIO_CODEC_ID_M4A = 4, AUDIO_CODEC_ID_FLAC = 5,
+                 AUDIO_CODEC_ID_OPUS = 7, AUDIO_CODEC_ID_VORBIS = 9,  // same numbers as Audio::CODEC_xxx
+                 AUDIO_CODEC_ID_USER = 16 };                          // first free id for new decoders
+
+typedef struct {                    // stream parameters that are known from the container only
+    uint8_t  channels;
+    uint32_t sampleRate;
+    uint8_t  bitsPerSample;
+    uint8_t  objectType;            // M4A: audio object type from the esds atom
+    uint32_t totalSamples;          // FLAC: from STREAMINFO
+    uint32_t audioDataLength;       // FLAC: file size without the metadata blocks
+} audioCodecParams_t;
+
+typedef struct {
+    uint8_t       id;               // Audio::CODEC_xxx or >= AUDIO_CODEC_ID_USER
+    const char*   name;             // "MP3", used in the log
+    const char*   fileExt;          // ".mp3", for registered decoders, the built-in formats are recognized by Audio
+    const char*   mimeType;         // "audio/mpeg", as above
+    uint16_t      maxBlockSize;     // largest frame decode() must see at once, becomes the InBuff block size
+    bool          needsPSRAM;
+    bool          reusable;         // flush() is enough between two clips of this codec (gapless queue)
+    uint8_t       resyncSkip;       // bytes to skip after a decode error before the sync word is searched again
+
+    // mandatory
+    bool          (*init)(void);                                              // allocate the buffers
+    void          (*deinit)(void);                                            // free them, also if not initialized
+    int32_t       (*probe)(uint8_t* data, int32_t len);                       // offset of the next sync word, -1 none
+    int32_t       (*decode)(uint8_t* data, int32_t* bytesLeft, int16_t* out); // 0 ok, < 0 error, AUDIO_CODEC_NO_OUTPUT
+    uint16_t      (*outputFrames)(void);                                      // samples per channel of the last decode
+    uint8_t       (*channels)(void);
+    uint32_t      (*sampleRate)(void);
+    uint8_t       (*bitsPerSample)(void);
+    uint32_t      (*bitRate)(void);
+
+    // optional, NULL if not supported
+    bool          (*isInit)(void);                                   // init() is skipped if the buffers exist
+    void          (*flush)(void);                                    // forget the stream state, after a seek
+    void          (*setParams)(const audioCodecParams_t* p);
+    uint32_t      (*audioDataStart)(void);                           // ogg: first audio page
+    uint32_t      (*duration)(void);                                 // seconds, 0 unknown
+    const char*   (*errorString)(int32_t err);
+    bool          (*isFatal)(int32_t err);                           // the stream can't be played, stop the song
+    const char*   (*param)(uint8_t idx);                             // codec specific info lines, NULL: no more
+    const char*   (*notice)(void);                                   // polled after decode(), NULL: nothing new
+    char*         (*streamTitle)(void);
+    std::vector<uint32_t> (*metadataPicture)(void);                  // [pos, len] pairs of the picture segments
+} audioCodec_t;
+
+bool                audioCodecRegister(const audioCodec_t* codec);
+const audioCodec_t* audioCodecFind(uint8_t id);
+const audioCodec_t* audioCodecFindByExt(const char* path);
+const audioCodec_t* audioCodecFindByMime(const char* mimeType);
+void                audioCodecDeinitAll();
@@ -4,7 +4,7 @@
  * adapted to ESP32
  *
  * Created on: Jul 03,2020
- * Updated on: Nov 23,2024
+ * Updated on: 18.10.2026
  *
  * Author: Wolle
  *
@@ -17,7 +17,6 @@ FLACFrameHeader_t*   FLACFrameHeader;
 FLACMetadataBlock_t* FLACMetadataBlock;
 
 vector<uint32_t> s_flacSegmTableVec;
-vector<int32_t>  coefs;
 vector<uint32_t> s_flacBlockPicItem;
 uint64_t         s_flac_bitBuffer = 0;
 uint32_t         s_flacBitrate = 0;
@@ -50,6 +49,8 @@ uint8_t          s_flacPageNr = 0;
 int32_t**        s_samplesBuffer = NULL;
 uint16_t         s_maxBlocksize = MAX_BLOCKSIZE;
 int32_t          s_nBytes = 0;
+int32_t          s_flacCoefs[FLAC_MAX_LPC_ORDER];
+uint8_t          s_flacPredOrder = 0;
 
 //----------------------------------------------------------------------------------------------------------------------
 //          FLAC INI SECTION
@@ -124,13 +125,12 @@ void FLACDecoder_FreeBuffers(){
         }
         free(s_samplesBuffer); s_samplesBuffer = NULL;
     }
-    coefs.clear(); coefs.shrink_to_fit();
     s_flacSegmTableVec.clear(); s_flacSegmTableVec.shrink_to_fit();
     s_flacBlockPicItem.clear(); s_flacBlockPicItem.shrink_to_fit();
 }
 //----------------------------------------------------------------------------------------------------------------------
 void FLACDecoder_setDefaults(){
-    coefs.clear(); coefs.shrink_to_fit();
+    s_flacPredOrder = 0;
     s_flacSegmTableVec.clear(); s_flacSegmTableVec.shrink_to_fit();
     s_flacBlockPicItem.clear(); s_flacBlockPicItem.shrink_to_fit();
     s_flac_bitBuffer = 0;
@@ -200,6 +200,46 @@ int64_t readRiceSignedInt(uint8_t param, int32_t* bytesLeft){
 void alignToByte() {
     s_flacBitBufferLen -= s_flacBitBufferLen % 8;
 }
+
+static void returnWholeBytes(int32_t* bytesLeft) { // the residual reader fetches ahead, give the unread bytes back
+    uint8_t n = s_flacBitBufferLen >> 3;
+    s_flac_bitBuffer = (n < 8) ? s_flac_bitBuffer >> (n << 3) : 0; // the newest bytes are the lowest bits
+    s_flacBitBufferLen -= n << 3;
+    s_rIndex -= n;
+    *bytesLeft += n;
+}
+
+static void decodeRicePartition(int32_t* dst, int32_t n, uint8_t param, int32_t* bytesLeft) {
+    // Same result as readRiceSignedInt() per sample, but the bit buffer is topped up to 57..64 bits at once and the
+    // unary part is counted with clz. Codes longer than the reservoir and the end of the input use the bitwise reader.
+    uint64_t       buf   = s_flac_bitBuffer;
+    uint8_t        len   = s_flacBitBufferLen;
+    uint8_t*       ptr   = s_flacInptr + s_rIndex;
+    int32_t        bl    = *bytesLeft;
+    const uint32_t pmask = (1u << param) - 1; // param <= 30
+
+    for(int32_t i = 0; i < n; i++) {
+        if(len < 32) {
+            while(len <= 56 && bl > 0) { buf = (buf << 8) | *ptr++; bl--; len += 8; }
+        }
+        uint64_t top = len ? buf << (64 - len) : 0;
+        if(top) {
+            uint8_t q = __builtin_clzll(top);
+            uint8_t used = q + 1 + param;
+            if(used <= len) {
+                len -= used;
+                uint32_t v = ((uint32_t)q << param) | ((uint32_t)(buf >> len) & pmask);
+                dst[i] = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+                continue;
+            }
+        }
+        s_flac_bitBuffer = buf; s_flacBitBufferLen = len; s_rIndex = ptr - s_flacInptr; *bytesLeft = bl;
+        dst[i] = readRiceSignedInt(param, bytesLeft);
+        if(s_f_bitReaderError) return;
+        buf = s_flac_bitBuffer; len = s_flacBitBufferLen; ptr = s_flacInptr + s_rIndex; bl = *bytesLeft;
+    }
+    s_flac_bitBuffer = buf; s_flacBitBufferLen = len; s_rIndex = ptr - s_flacInptr; *bytesLeft = bl;
+}
 //----------------------------------------------------------------------------------------------------------------------
 //              F L A C - D E C O D E R
 //----------------------------------------------------------------------------------------------------------------------
@@ -732,21 +772,38 @@ int8_t FLACDecodeNative(uint8_t *inbuf, int32_t *bytesLeft, int16_t *outbuf){
         // blocksize can be much greater than outbuff, so we can't stuff all in once
         // therefore we need often more than one loop (split outputblock into pieces)
         uint16_t blockSize;
-        if(s_numOfOutSamples < s_flacOutBuffSize + s_offset) blockSize = s_numOfOutSamples - s_offset;
-        else blockSize = s_flacOutBuffSize;
-
-        for (int32_t i = 0; i < blockSize; i++) {
-            for (int32_t j = 0; j < FLACMetadataBlock->numChannels; j++) {
-                int32_t val = s_samplesBuffer[j][i + s_offset];
-                if (FLACMetadataBlock->bitsPerSample == 8) val += 128;
-                outbuf[2*i+j] = val;
+        uint16_t outBuffSize = s_flacOutBuffSize;
+        uint8_t  bps = FLACMetadataBlock->bitsPerSample;
+        if(s_numOfOutSamples < outBuffSize + s_offset) blockSize = s_numOfOutSamples - s_offset;
+        else blockSize = outBuffSize;
+
+        if(bps > 16) { // 20/24 bit, round to 16 bit for the Audio pipeline
+            uint8_t sh = bps - 16;
+            int32_t rnd = 1 << (sh - 1);
+            for (int32_t i = 0; i < blockSize; i++) {
+                for (int32_t j = 0; j < FLACMetadataBlock->numChannels; j++) {
+                    int32_t val = (s_samplesBuffer[j][i + s_offset] + rnd) >> sh;
+                    if(val >  32767) val =  32767;
+                    if(val < -32768) val = -32768;
+                    outbuf[2*i+j] = val;
+                }
+            }
+        }
+        else {
+            for (int32_t i = 0; i < blockSize; i++) {
+                for (int32_t j = 0; j < FLACMetadataBlock->numChannels; j++) {
+                    int32_t val = s_samplesBuffer[j][i + s_offset];
+                    if (bps == 8) val += 128;
+                    outbuf[2*i+j] = val;
+                }
             }
         }
 
         s_flacValidSamples = blockSize * FLACMetadataBlock->numChannels;
         s_offset += blockSize;
         if(sbl > 0){
-            s_flacCompressionRatio = (float)((s_flacValidSamples * 2) * FLACMetadataBlock->numChannels) / sbl; // valid samples are 16 bit
+            uint8_t bytesPerSample = (bps > 16) ? 3 : 2;
+            s_flacCompressionRatio = (float)((s_flacValidSamples * bytesPerSample) * FLACMetadataBlock->numChannels) / sbl;
             sbl = 0;
             s_flacBitrate = FLACMetadataBlock->sampleRate * FLACMetadataBlock->bitsPerSample * FLACMetadataBlock->numChannels;
             s_flacBitrate /= s_flacCompressionRatio;
@@ -791,7 +848,7 @@ int8_t flacDecodeFrame(uint8_t *inbuf, int32_t *bytesLeft){
         if(FLACFrameHeader->sampleSizeCode == 5) FLACMetadataBlock->bitsPerSample = 20;
         if(FLACFrameHeader->sampleSizeCode == 6) FLACMetadataBlock->bitsPerSample = 24;
     }
-    if(FLACMetadataBlock->bitsPerSample > 16) return ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG;
+    if(FLACMetadataBlock->bitsPerSample > 24) return ERR_FLAC_BITS_PER_SAMPLE_TOO_BIG;
     if(FLACMetadataBlock->bitsPerSample < 8 ) return ERR_FLAC_BITS_PER_SAMPLE_UNKNOWN;
     if(!FLACMetadataBlock->sampleRate){
         if(FLACFrameHeader->sampleRateCode == 1)  FLACMetadataBlock->sampleRate =  88200;
@@ -861,6 +918,11 @@ uint8_t FLACGetBitsPerSample(){
     return FLACMetadataBlock->bitsPerSample;
 }
 //----------------------------------------------------------------------------------------------------------------------
+uint8_t FLACGetOutputBitsPerSample(){ // what FLACDecode() writes, 20/24 bit streams are rounded to 16 bit
+    uint8_t bps = FLACGetBitsPerSample();
+    return (bps > 16) ? 16 : bps;
+}
+//----------------------------------------------------------------------------------------------------------------------
 uint8_t FLACGetChannels(){
     if(!FLACMetadataBlock) return 0;
     return FLACMetadataBlock->numChannels;
@@ -980,13 +1042,10 @@ int8_t decodeFixedPredictionSubframe(uint8_t predOrder, uint8_t sampleDepth, uin
         s_samplesBuffer[ch][i] = readSignedInt(sampleDepth, bytesLeft); // Unencoded warm-up samples (n = frame's bits-per-sample * predictor order).
     ret = decodeResiduals(predOrder, ch, bytesLeft);
     if(ret) return ret;
-    coefs.clear(); coefs.shrink_to_fit();
-    if(predOrder == 0) coefs.resize(0);
-    if(predOrder == 1) coefs.push_back(1);  // FIXED_PREDICTION_COEFFICIENTS
-    if(predOrder == 2){coefs.push_back(2); coefs.push_back(-1);}
-    if(predOrder == 3){coefs.push_back(3); coefs.push_back(-3); coefs.push_back(1);}
-    if(predOrder == 4){coefs.push_back(4); coefs.push_back(-6); coefs.push_back(4); coefs.push_back(-1);}
+    static const int32_t fixedCoefs[5][4] = {{0}, {1}, {2, -1}, {3, -3, 1}, {4, -6, 4, -1}}; // FIXED_PREDICTION_COEFFICIENTS
     if(predOrder > 4) return ERR_FLAC_PREORDER_TOO_BIG; // Error: preorder > 4"
+    memcpy(s_flacCoefs, fixedCoefs[predOrder], sizeof(fixedCoefs[0]));
+    s_flacPredOrder = predOrder;
     restoreLinearPrediction(ch, 0);
     return ERR_FLAC_NONE;
 }
@@ -999,10 +1058,10 @@ int8_t decodeLinearPredictiveCodingSubframe(int32_t lpcOrder, int32_t sampleDept
     }
     int32_t precision = readUint(4, bytesLeft) + 1;                         // (Quantized linear predictor coefficients' precision in bits)-1 (1111 = invalid).
     int32_t shift = readSignedInt(5, bytesLeft);                            // Quantized linear predictor coefficient shift needed in bits (NOTE: this number is signed two's-complement).
-    coefs.clear(); coefs.shrink_to_fit();
     for (uint8_t i = 0; i < lpcOrder; i++){
-        coefs.push_back(readSignedInt(precision, bytesLeft));           // Unencoded predictor coefficients (n = qlp coeff precision * lpc order) (NOTE: the coefficients are signed two's-complement).
+        s_flacCoefs[i] = readSignedInt(precision, bytesLeft);           // Unencoded predictor coefficients (n = qlp coeff precision * lpc order) (NOTE: the coefficients are signed two's-complement).
     }
+    s_flacPredOrder = lpcOrder;
     ret = decodeResiduals(lpcOrder, ch, bytesLeft);
     if(ret) return ret;
     restoreLinearPrediction(ch, shift);
@@ -1032,10 +1091,8 @@ int8_t decodeResiduals(uint8_t warmup, uint8_t ch, int32_t* bytesLeft) {
 
         int32_t param = readUint(paramBits, bytesLeft);
         if (param < escapeParam) {
-            for (int32_t j = start; j < end; j++){
-                if(s_f_bitReaderError) break;
-                s_samplesBuffer[ch][j] = readRiceSignedInt(param, bytesLeft);
-            }
+            if(s_f_bitReaderError) break;
+            decodeRicePartition(s_samplesBuffer[ch] + start, end - start, param, bytesLeft);
         }
         else {
             int32_t numBits = readUint(5, bytesLeft);                 // Escape code, meaning the partition is in unencoded binary form using n bits per sample; n follows as a 5-bit number.
@@ -1045,20 +1102,58 @@ int8_t decodeResiduals(uint8_t warmup, uint8_t ch, int32_t* bytesLeft) {
             }
         }
     }
+    returnWholeBytes(bytesLeft);
     if(s_f_bitReaderError) return ERR_FLAC_BITREADER_UNDERFLOW;
     return ERR_FLAC_NONE;
 }
 //----------------------------------------------------------------------------------------------------------------------
-void restoreLinearPrediction(uint8_t ch, uint8_t shift) {
+template <int ORDER, typename ACC> // the order is a constant, the coefs stay in registers and the inner loop is unrolled
+static void restoreLPC(int32_t* s, const int32_t* coef, int32_t n, uint8_t shift) {
+    int32_t c[ORDER];
+    for (int32_t j = 0; j < ORDER; j++) c[j] = coef[j];
+    for (int32_t i = ORDER; i < n; i++) {
+        ACC sum = 0;
+        for (int32_t j = 0; j < ORDER; j++) sum += (ACC)s[i - 1 - j] * c[j];
+        s[i] += (int32_t)(sum >> shift);
+    }
+}
 
-    for (int32_t i = coefs.size(); i < s_numOfOutSamples; i++) {
-        int32_t sum = 0;
-        for (int32_t j = 0; j < coefs.size(); j++){
-            sum += s_samplesBuffer[ch][i - 1 - j] * coefs[j];
-        }
-        s_samplesBuffer[ch][i] += (sum >> shift);
+template <typename ACC>
+static void restoreLPCGeneric(int32_t* s, const int32_t* coef, uint8_t order, int32_t n, uint8_t shift) {
+    for (int32_t i = order; i < n; i++) {
+        ACC sum = 0;
+        for (int32_t j = 0; j < order; j++) sum += (ACC)s[i - 1 - j] * coef[j];
+        s[i] += (int32_t)(sum >> shift);
+    }
+}
+
+template <typename ACC>
+static void restoreLPCOrder(int32_t* s, const int32_t* c, uint8_t order, int32_t n, uint8_t shift) {
+    switch(order) { // fixed predictors use 1...4, the encoders use up to 8 (-5) or 12 (-8) for LPC
+        case  0: break;
+        case  1: restoreLPC< 1, ACC>(s, c, n, shift); break;
+        case  2: restoreLPC< 2, ACC>(s, c, n, shift); break;
+        case  3: restoreLPC< 3, ACC>(s, c, n, shift); break;
+        case  4: restoreLPC< 4, ACC>(s, c, n, shift); break;
+        case  5: restoreLPC< 5, ACC>(s, c, n, shift); break;
+        case  6: restoreLPC< 6, ACC>(s, c, n, shift); break;
+        case  7: restoreLPC< 7, ACC>(s, c, n, shift); break;
+        case  8: restoreLPC< 8, ACC>(s, c, n, shift); break;
+        case  9: restoreLPC< 9, ACC>(s, c, n, shift); break;
+        case 10: restoreLPC<10, ACC>(s, c, n, shift); break;
+        case 11: restoreLPC<11, ACC>(s, c, n, shift); break;
+        case 12: restoreLPC<12, ACC>(s, c, n, shift); break;
+        default: restoreLPCGeneric<ACC>(s, c, order, n, shift); break;
     }
 }
+
+void restoreLinearPrediction(uint8_t ch, uint8_t shift) {
+    // 16 bit streams keep the 32 bit sum of the reference decoder, 20/24 bit samples need a 64 bit accumulator
+    if(FLACMetadataBlock->bitsPerSample > 16)
+        restoreLPCOrder<int64_t>(s_samplesBuffer[ch], s_flacCoefs, s_flacPredOrder, s_numOfOutSamples, shift);
+    else
+        restoreLPCOrder<int32_t>(s_samplesBuffer[ch], s_flacCoefs, s_flacPredOrder, s_numOfOutSamples, shift);
+}
 //----------------------------------------------------------------------------------------------------------------------
 int32_t FLAC_specialIndexOf(uint8_t* base, const char* str, int32_t baselen, bool exact){
     int32_t result = 0;  // seek for str in buffer or in header up to baselen, not nullterninated
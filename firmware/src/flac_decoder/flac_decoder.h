@@ -2,13 +2,13 @@
  * flac_decoder.h
  *
  * Created on: Jul 03,2020
- * Updated on: Nov 23,2024
+ * Updated on: 18.10.2026
  *
  *      Author: wolle
  *
  *  Restrictions:
  *  blocksize must not exceed 16342 bytes
- *  bits per sample must be 8 or 16
+ *  bits per sample must be 8, 16, 20 or 24, FLACDecode() rounds 20/24 bit to 16 bit
  *  num Channels must be 1 or 2
  *
  *
@@ -23,6 +23,7 @@ using namespace std;
 #define MAX_CHANNELS 2
 #define MAX_BLOCKSIZE 16384
 #define MAX_OUTBUFFSIZE 4096 * 2
+#define FLAC_MAX_LPC_ORDER 32
 
 enum : uint8_t {FLACDECODER_INIT, FLACDECODER_READ_IN, FLACDECODER_WRITE_OUT};
 enum : uint8_t {DECODE_FRAME, DECODE_SUBFRAMES, OUT_SAMPLES};
@@ -167,6 +168,7 @@ int8_t           flacDecodeFrame(uint8_t* inbuf, int32_t* bytesLeft);
 uint16_t         FLACGetOutputSamps();
 uint64_t         FLACGetTotoalSamplesInStream();
 uint8_t          FLACGetBitsPerSample();
+uint8_t          FLACGetOutputBitsPerSample();
 uint8_t          FLACGetChannels();
 uint32_t         FLACGetSampRate();
 uint32_t         FLACGetBitRate();
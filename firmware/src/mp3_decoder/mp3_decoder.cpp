@@ -52,6 +52,7 @@ ScaleFactorInfoSub_t m_ScaleFactorInfoSub[m_MAX_NGRAN][m_MAX_NCHAN];
 ScaleFactorJS_t *m_ScaleFactorJS;
 SubbandInfo_t *m_SubbandInfo;
 MP3DecInfo_t *m_MP3DecInfo;
+uint16_t *m_HuffFastTab;  /* [m_HUFF_FASTTABS][1 << m_HUFF_FASTBITS], see BuildHuffmanFastTables() */
 
 const uint16_t huffTable[4242] PROGMEM = {
     /* huffTable01[9] */
@@ -1602,6 +1603,13 @@ bool MP3Decoder_AllocateBuffers(void) {
         log_e("not enough memory to allocate mp3decoder buffers");
         return false;
     }
+    if(!m_HuffFastTab) {
+        // read for every codeword, keep it in internal RAM, without it the decoder takes the slow path
+        m_HuffFastTab = (uint16_t*)heap_caps_malloc_prefer(m_HUFF_FASTTABS * (1 << m_HUFF_FASTBITS) * sizeof(uint16_t), 2,
+                                        MALLOC_CAP_DEFAULT|MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT|MALLOC_CAP_SPIRAM);
+        if(m_HuffFastTab) BuildHuffmanFastTables();
+        else log_w("no memory for the huffman fast tables");
+    }
     MP3Decoder_ClearBuffer();
     return true;
 }
@@ -1650,6 +1658,7 @@ void MP3Decoder_FreeBuffers()
     if(m_IMDCTInfo)         {free(m_IMDCTInfo);       m_IMDCTInfo=NULL;}
     if(m_SubbandInfo)       {free(m_SubbandInfo);     m_SubbandInfo=NULL;}
     if(m_MP3FrameInfo)      {free(m_MP3FrameInfo);    m_MP3FrameInfo=NULL;}
+    if(m_HuffFastTab)       {free(m_HuffFastTab);     m_HuffFastTab=NULL;}
 
 //    log_i("MP3Decoder: %lu bytes memory was freed", ESP.getFreeHeap() - i);
 }
@@ -1658,6 +1667,104 @@ void MP3Decoder_FreeBuffers()
  * H U F F M A N N
  **********************************************************************************************************************/
 
+/***********************************************************************************************************************
+ * Function:    BuildHuffmanFastTables
+ *
+ * Description: fill the single-lookup tables used by DecodeHuffmanPairs and DecodeHuffmanQuads
+ *
+ * Inputs:      none
+ *
+ * Outputs:     m_HuffFastTab, one table per slot of huffFastSlot[], indexed by the next 8 bits of the bitstream
+ *
+ * Return:      none
+ *
+ * Notes:       an entry holds a whole codeword including its sign bits
+ *                pairs: |x| bits 0-3, sign x bit 4, |y| bits 5-8, sign y bit 9
+ *                quads: v w x y bits 3-0, their sign bits 7-4
+ *                total length in bits 12-15
+ *              entry is 0 if codeword + sign bits need more than 8 bits or linbits follow, the decoder falls back to
+ *                the table walk in that case, so the output is identical
+ **********************************************************************************************************************/
+static uint16_t HuffFastPairEntry(const uint16_t *tBase, HuffTabType_t tabType, uint32_t cache) {
+    int32_t used, len, maxBits, x, y, sx, sy;
+    const uint16_t *tCurr = tBase;
+    uint16_t cw;
+
+    used = sx = sy = 0;
+    while (true) {  /* same walk as DecodeHuffmanPairs, oneShot tables never descend */
+        maxBits = pgm_read_word(&tCurr[0]) & 0x000f;
+        cw = pgm_read_word(&tCurr[(cache >> (32 - maxBits)) + 1]);
+        len = (cw >> 12) & 0x000f;
+        if (len || tabType == oneShot)
+            break;
+        used += maxBits;
+        if (used >= m_HUFF_FASTBITS)
+            return 0;
+        cache <<= maxBits;
+        tCurr += cw;
+    }
+    used += len;
+    cache <<= len;
+    x = (cw >> 4) & 0x000f;
+    y = (cw >> 8) & 0x000f;
+    if (tabType == loopLinbits && (x == 15 || y == 15))
+        return 0;
+    if (x) {sx = cache >> 31; cache <<= 1; used++;}
+    if (y) {sy = cache >> 31; cache <<= 1; used++;}
+    if (used > m_HUFF_FASTBITS)
+        return 0;
+    return (uint16_t)((used << 12) | (sy << 9) | (y << 5) | (sx << 4) | x);
+}
+
+static uint16_t HuffFastQuadEntry(const uint8_t *tBase, int32_t maxBits, uint32_t cache) {
+    int32_t b, used, signs;
+    uint8_t cw;
+
+    cw = pgm_read_byte(&tBase[cache >> (32 - maxBits)]);
+    used = (cw >> 4) & 0x0f;
+    cache <<= used;
+    signs = 0;
+    for (b = 3; b >= 0; b--) {  /* v, w, x, y */
+        if (cw & (1 << b)) {signs |= (cache >> 31) << b; cache <<= 1; used++;}
+    }
+    if (used > m_HUFF_FASTBITS)
+        return 0;
+    return (uint16_t)((used << 12) | (signs << 4) | (cw & 0x0f));
+}
+
+void BuildHuffmanFastTables(void) {
+    const uint32_t tail = 0xffffffff >> m_HUFF_FASTBITS;
+    uint32_t built = 0, p, cache;
+    int32_t tabIdx, slot, q;
+    uint16_t e0, e1, *fTab;
+    HuffTabType_t tabType;
+
+    for (tabIdx = 0; tabIdx < m_HUFF_PAIRTABS; tabIdx++) {
+        slot = (int8_t)pgm_read_byte(&huffFastSlot[tabIdx]);
+        if (slot < 0 || (built & (1 << slot)))
+            continue;
+        built |= 1 << slot;
+        fTab = m_HuffFastTab + (slot << m_HUFF_FASTBITS);
+        tabType = (HuffTabType_t)huffTabLookup[tabIdx].tabType;
+        for (p = 0; p < (1 << m_HUFF_FASTBITS); p++) {
+            cache = p << (32 - m_HUFF_FASTBITS);
+            /* must not depend on the bits behind the 8 peeked ones */
+            e0 = HuffFastPairEntry(huffTable + huffTabOffset[tabIdx], tabType, cache);
+            e1 = HuffFastPairEntry(huffTable + huffTabOffset[tabIdx], tabType, cache | tail);
+            fTab[p] = (e0 == e1) ? e0 : 0;
+        }
+    }
+    for (q = 0; q < 2; q++) {
+        fTab = m_HuffFastTab + ((m_HUFF_FASTTABS - 2 + q) << m_HUFF_FASTBITS);
+        for (p = 0; p < (1 << m_HUFF_FASTBITS); p++) {
+            cache = p << (32 - m_HUFF_FASTBITS);
+            e0 = HuffFastQuadEntry(quadTable + quadTabOffset[q], quadTabMaxBits[q], cache);
+            e1 = HuffFastQuadEntry(quadTable + quadTabOffset[q], quadTabMaxBits[q], cache | tail);
+            fTab[p] = (e0 == e1) ? e0 : 0;
+        }
+    }
+}
+
 /***********************************************************************************************************************
  * Function:    DecodeHuffmanPairs
  *
@@ -1683,7 +1790,8 @@ int32_t DecodeHuffmanPairs(int32_t *xy, int32_t nVals, int32_t tabIdx, int32_t b
    int32_t i, x, y;
    int32_t cachedBits, padBits, len, startBits, linBits, maxBits, minBits;
     HuffTabType_t tabType;
-    uint16_t cw, *tBase, *tCurr;
+    uint16_t cw, fe, *tBase, *tCurr;
+    const uint16_t *fTab;
     uint32_t cache;
 
     if (nVals <= 0)
@@ -1707,6 +1815,9 @@ int32_t DecodeHuffmanPairs(int32_t *xy, int32_t nVals, int32_t tabIdx, int32_t b
     if(!(tabIdx >= 0)){log_d("(tabIdx >= 0)"); return -1;}
     if(!(tabType != invalidTab)){log_d("(tabType != invalidTab)"); return -1;}
 
+    fTab = NULL;
+    if (m_HuffFastTab && tabType != noBits)
+        fTab = m_HuffFastTab + ((int8_t)pgm_read_byte(&huffFastSlot[tabIdx]) << m_HUFF_FASTBITS);
 
     /* initially fill cache with any partial byte */
     cache = 0;
@@ -1730,7 +1841,14 @@ int32_t DecodeHuffmanPairs(int32_t *xy, int32_t nVals, int32_t tabIdx, int32_t b
         padBits = 0;
         while (nVals > 0) {
             /* refill cache - assumes cachedBits <= 16 */
-            if (bitsLeft >= 16) {
+            if (bitsLeft >= 24 && cachedBits <= 8) {
+                /* load 3 new bytes into left-justified cache, fewer trips through the refill */
+                cache |= (uint32_t) (*buf++) << (24 - cachedBits);
+                cache |= (uint32_t) (*buf++) << (16 - cachedBits);
+                cache |= (uint32_t) (*buf++) << ( 8 - cachedBits);
+                cachedBits += 24;
+                bitsLeft -= 24;
+            } else if (bitsLeft >= 16) {
                 /* load 2 new bytes into left-justified cache */
                 cache |= (uint32_t) (*buf++) << (24 - cachedBits);
                 cache |= (uint32_t) (*buf++) << (16 - cachedBits);
@@ -1754,6 +1872,18 @@ int32_t DecodeHuffmanPairs(int32_t *xy, int32_t nVals, int32_t tabIdx, int32_t b
 
             /* largest maxBits = 9, plus 2 for sign bits, so make sure cache has at least 11 bits */
             while (nVals > 0 && cachedBits >= 11) {
+                /* fast path, codeword and sign bits with one lookup */
+                if (fTab && (fe = fTab[cache >> (32 - m_HUFF_FASTBITS)]) != 0) {
+                    len = fe >> 12;
+                    cachedBits -= len;
+                    cache <<= len;
+                    if (cachedBits < padBits)
+                        return -1;
+                    *xy++ = (int32_t)((fe & 0x000f) | ((uint32_t)(fe & 0x0010) << 27));
+                    *xy++ = (int32_t)(((fe >> 5) & 0x000f) | ((uint32_t)(fe & 0x0200) << 22));
+                    nVals -= 2;
+                    continue;
+                }
                 cw = pgm_read_word(&tBase[cache >> (32 - maxBits)]);
 
                 len=(int32_t)( (((uint16_t)(cw)) >> 12) & 0x000f);
@@ -1792,7 +1922,14 @@ int32_t DecodeHuffmanPairs(int32_t *xy, int32_t nVals, int32_t tabIdx, int32_t b
         padBits = 0;
         while (nVals > 0) {
             /* refill cache - assumes cachedBits <= 16 */
-            if (bitsLeft >= 16) {
+            if (bitsLeft >= 24 && cachedBits <= 8) {
+                /* load 3 new bytes into left-justified cache, fewer trips through the refill */
+                cache |= (uint32_t) (*buf++) << (24 - cachedBits);
+                cache |= (uint32_t) (*buf++) << (16 - cachedBits);
+                cache |= (uint32_t) (*buf++) << ( 8 - cachedBits);
+                cachedBits += 24;
+                bitsLeft -= 24;
+            } else if (bitsLeft >= 16) {
                 /* load 2 new bytes into left-justified cache */
                 cache |= (uint32_t) (*buf++) << (24 - cachedBits);
                 cache |= (uint32_t) (*buf++) << (16 - cachedBits);
@@ -1816,6 +1953,20 @@ int32_t DecodeHuffmanPairs(int32_t *xy, int32_t nVals, int32_t tabIdx, int32_t b
 
             /* largest maxBits = 9, plus 2 for sign bits, so make sure cache has at least 11 bits */
             while (nVals > 0 && cachedBits >= 11) {
+                /* fast path, codeword and sign bits with one lookup
+                 * in the padded tail the table walk can pad again between two levels, keep it there (same bit count) */
+                if (fTab && tCurr == tBase && (padBits == 0 || cachedBits >= 11 + m_HUFF_FASTBITS) &&
+                    (fe = fTab[cache >> (32 - m_HUFF_FASTBITS)]) != 0) {
+                    len = fe >> 12;
+                    cachedBits -= len;
+                    cache <<= len;
+                    if (cachedBits < padBits)
+                        return -1;
+                    *xy++ = (int32_t)((fe & 0x000f) | ((uint32_t)(fe & 0x0010) << 27));
+                    *xy++ = (int32_t)(((fe >> 5) & 0x000f) | ((uint32_t)(fe & 0x0200) << 22));
+                    nVals -= 2;
+                    continue;
+                }
                 maxBits = (int32_t)( (((uint16_t)(pgm_read_word(&tCurr[0]))) >>  0) & 0x000f);
                 cw = pgm_read_word(&tCurr[(cache >> (32 - maxBits)) + 1]);
                 len=(int32_t)( (((uint16_t)(cw)) >> 12) & 0x000f);
@@ -1922,11 +2073,14 @@ int32_t DecodeHuffmanQuads(int32_t *vwxy, int32_t nVals, int32_t tabIdx, int32_t
    int32_t len, maxBits, cachedBits, padBits;
     uint32_t cache;
     uint8_t cw, *tBase;
+    uint16_t fe;
+    const uint16_t *fTab;
 
     if(bitsLeft<=0) return 0;
 
     tBase = (uint8_t *) quadTable + quadTabOffset[tabIdx];
     maxBits = quadTabMaxBits[tabIdx];
+    fTab = m_HuffFastTab ? m_HuffFastTab + ((m_HUFF_FASTTABS - 2 + tabIdx) << m_HUFF_FASTBITS) : NULL;
 
     /* initially fill cache with any partial byte */
     cache = 0;
@@ -1937,7 +2091,14 @@ int32_t DecodeHuffmanQuads(int32_t *vwxy, int32_t nVals, int32_t tabIdx, int32_t
     i = padBits = 0;
     while (i < (nVals - 3)) {
         /* refill cache - assumes cachedBits <= 16 */
-        if (bitsLeft >= 16) {
+        if (bitsLeft >= 24 && cachedBits <= 8) {
+            /* load 3 new bytes into left-justified cache, fewer trips through the refill */
+            cache |= (uint32_t) (*buf++) << (24 - cachedBits);
+            cache |= (uint32_t) (*buf++) << (16 - cachedBits);
+            cache |= (uint32_t) (*buf++) << ( 8 - cachedBits);
+            cachedBits += 24;
+            bitsLeft -= 24;
+        } else if (bitsLeft >= 16) {
             /* load 2 new bytes into left-justified cache */
             cache |= (uint32_t) (*buf++) << (24 - cachedBits);
             cache |= (uint32_t) (*buf++) << (16 - cachedBits);
@@ -1958,6 +2119,20 @@ int32_t DecodeHuffmanQuads(int32_t *vwxy, int32_t nVals, int32_t tabIdx, int32_t
 
         /* largest maxBits = 6, plus 4 for sign bits, so make sure cache has at least 10 bits */
         while(i < (nVals - 3) && cachedBits >= 10){
+            /* fast path, codeword and sign bits with one lookup */
+            if (fTab && (fe = fTab[cache >> (32 - m_HUFF_FASTBITS)]) != 0) {
+                len = fe >> 12;
+                cachedBits -= len;
+                cache <<= len;
+                if (cachedBits < padBits)
+                    return i;
+                *vwxy++ = (int32_t)(((fe >> 3) & 0x01) | ((uint32_t)(fe & 0x0080) << 24));
+                *vwxy++ = (int32_t)(((fe >> 2) & 0x01) | ((uint32_t)(fe & 0x0040) << 25));
+                *vwxy++ = (int32_t)(((fe >> 1) & 0x01) | ((uint32_t)(fe & 0x0020) << 26));
+                *vwxy++ = (int32_t)(((fe >> 0) & 0x01) | ((uint32_t)(fe & 0x0010) << 27));
+                i += 4;
+                continue;
+            }
             cw = pgm_read_byte(&tBase[cache >> (32 - maxBits)]);
             len=(int32_t)( (((uint8_t)(cw)) >> 4) & 0x0f);
             cachedBits -= len;
@@ -3775,12 +3950,22 @@ void PolyphaseMono(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
 
     /* right now, the compiler creates bad asm from this... */
     for (i = 15; i > 0; i--) {
+#ifdef MP3_SIMD
+        acc64x2_t sum12 = ACC64x2(rndVal); /* sum1L, sum2L */
+        for(int32_t j=0; j<8; j++){
+            c1=*coef; coef++; c2=*coef; coef++; vLo=*(vb1+(j)); vHi = *(vb1+(23-(j)));
+            sum12 = MADD64x2(sum12, vLo, vLo, c1, c2);
+            sum12 = MADD64x2(sum12, vHi, vHi, -c2, c1);
+        }
+        sum1L = ACC64x2_0(sum12); sum2L = ACC64x2_1(sum12);
+#else
         sum1L = sum2L = rndVal;
         for(int32_t j=0; j<8; j++){
             c1=*coef; coef++; c2=*coef; coef++; vLo=*(vb1+(j)); vHi = *(vb1+(23-(j)));
             sum1L=MADD64(sum1L, vLo,  c1); sum2L = MADD64(sum2L, vLo,  c2);
             sum1L=MADD64(sum1L, vHi, -c2); sum2L = MADD64(sum2L, vHi,  c1);
         }
+#endif
         vb1 += 64;
         *(pcm)       = ClipToShort((int32_t)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
         *(pcm + 2*i) = ClipToShort((int32_t)SAR64(sum2L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
@@ -3847,6 +4032,20 @@ void PolyphaseStereo(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
 
     /* right now, the compiler creates bad asm from this... */
     for (i = 15; i > 0; i--) {
+#ifdef MP3_SIMD
+        acc64x2_t sum1 = ACC64x2(rndVal); /* sum1L, sum1R */
+        acc64x2_t sum2 = ACC64x2(rndVal); /* sum2L, sum2R */
+        int32_t vLoR, vHiR;
+
+        for(int32_t j=0; j<8; j++){
+            c1=*coef; coef++; c2=*coef; coef++;
+            vLo=*(vb1+(j)); vHi = *(vb1+(23-(j))); vLoR=*(vb1+32+(j)); vHiR=*(vb1+32+(23-(j)));
+            sum1 = MADD64x2(sum1, vLo, vLoR,  c1,  c1); sum2 = MADD64x2(sum2, vLo, vLoR, c2, c2);
+            sum1 = MADD64x2(sum1, vHi, vHiR, -c2, -c2); sum2 = MADD64x2(sum2, vHi, vHiR, c1, c1);
+        }
+        sum1L = ACC64x2_0(sum1); sum1R = ACC64x2_1(sum1);
+        sum2L = ACC64x2_0(sum2); sum2R = ACC64x2_1(sum2);
+#else
         sum1L = sum2L = rndVal;
         sum1R = sum2R = rndVal;
 
@@ -3858,6 +4057,7 @@ void PolyphaseStereo(int16_t *pcm, int32_t *vbuf, const uint32_t *coefBase){
             sum1R=MADD64(sum1R, vLo,  c1); sum2R=MADD64(sum2R, vLo,  c2);
             sum1R=MADD64(sum1R, vHi, -c2); sum2R=MADD64(sum2R, vHi,  c1);
         }
+#endif
         vb1 += 64;
         *(pcm + 0)         = ClipToShort((int32_t)SAR64(sum1L, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
         *(pcm + 1)         = ClipToShort((int32_t)SAR64(sum1R, (32-m_CSHIFT)), m_DQ_FRACBITS_OUT - 2 - 2 - 15);
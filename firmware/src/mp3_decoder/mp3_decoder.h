@@ -5,6 +5,8 @@
 #include "assert.h"
 
 static const uint8_t  m_HUFF_PAIRTABS          =32;
+static const uint8_t  m_HUFF_FASTBITS          =8;      // bits peeked by the single-lookup fast path
+static const uint8_t  m_HUFF_FASTTABS          =15+2;   // distinct pair tables + quad tables A and B
 static const uint8_t  m_BLOCK_SIZE             =18;
 static const uint8_t  m_NBANDS                 =32;
 static const uint8_t  m_MAX_REORDER_SAMPS      =(192-126)*3;      // largest critical band for short blocks (see sfBandTable)
@@ -341,6 +343,14 @@ const HuffTabLookup_t huffTabLookup[m_HUFF_PAIRTABS] PROGMEM = {
 };
 
 
+/* slot of each pair table in the fast lookup tables, -1 if the table has no codewords
+ * tables 16..23 and 24..31 share their codewords, linbits escapes always take the slow path
+ * slots 15 and 16 are the quad tables A and B
+ */
+const int8_t huffFastSlot[m_HUFF_PAIRTABS] PROGMEM = {
+    -1,  0,  1,  2, -1,  3,  4,  5,  6,  7,  8,  9, 10, 11, -1, 12,
+    13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14,};
+
 const int32_t quadTabOffset[2] PROGMEM = {0, 64};
 const int32_t quadTabMaxBits[2] PROGMEM = {6, 4};
 
@@ -472,6 +482,7 @@ int32_t  MP3GetVersion();
 
 //internally used
 void MP3Decoder_ClearBuffer(void);
+void BuildHuffmanFastTables(void);
 void PolyphaseMono(int16_t *pcm, int32_t *vbuf, const uint32_t* coefBase);
 void PolyphaseStereo(int16_t *pcm, int32_t *vbuf, const uint32_t* coefBase);
 void SetBitstreamPointer(BitStreamInfo_t *bsi, int32_t nBytes, uint8_t *buf);
@@ -513,3 +524,29 @@ inline uint64_t MADD64(uint64_t sum64, int32_t x, int32_t y) {sum64 += (uint64_t
 inline uint64_t xSAR64(uint64_t x, int32_t n){return x >> n;}
 inline int32_t FASTABS(int32_t x){ return __builtin_abs(x);} //xtensa has a fast abs instruction //fb
 #define CLZ(x) __builtin_clz(x) //fb
+
+/* two 64-bit accumulators side by side for the polyphase filter, selected at compile time, bit-exact with MADD64
+ * (wrap-around 64-bit sums of 32x32 products); define MP3_NO_SIMD to force the scalar code
+ * Xtensa (ESP32, ESP32-S3 PIE) has no 32x32->64 vector multiply, it always uses the scalar code
+ */
+#if !defined(MP3_NO_SIMD) && defined(__SSE4_1__)
+    #include <smmintrin.h>
+    #define MP3_SIMD
+    typedef __m128i acc64x2_t;
+    inline acc64x2_t ACC64x2(uint64_t v) {return _mm_set1_epi64x((int64_t)v);}
+    inline acc64x2_t MADD64x2(acc64x2_t sum, int32_t x0, int32_t x1, int32_t y0, int32_t y1) {
+        return _mm_add_epi64(sum, _mm_mul_epi32(_mm_set_epi32(0, x1, 0, x0), _mm_set_epi32(0, y1, 0, y0)));} // lanes 0, 2
+    inline uint64_t ACC64x2_0(acc64x2_t sum) {return (uint64_t)_mm_cvtsi128_si64(sum);}
+    inline uint64_t ACC64x2_1(acc64x2_t sum) {return (uint64_t)_mm_extract_epi64(sum, 1);}
+#elif !defined(MP3_NO_SIMD) && defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define MP3_SIMD
+    typedef int64x2_t acc64x2_t;
+    inline acc64x2_t ACC64x2(uint64_t v) {return vdupq_n_s64((int64_t)v);}
+    inline acc64x2_t MADD64x2(acc64x2_t sum, int32_t x0, int32_t x1, int32_t y0, int32_t y1) {
+        int32x2_t x = vset_lane_s32(x1, vdup_n_s32(x0), 1);
+        int32x2_t y = vset_lane_s32(y1, vdup_n_s32(y0), 1);
+        return vmlal_s32(sum, x, y);}
+    inline uint64_t ACC64x2_0(acc64x2_t sum) {return (uint64_t)vgetq_lane_s64(sum, 0);}
+    inline uint64_t ACC64x2_1(acc64x2_t sum) {return (uint64_t)vgetq_lane_s64(sum, 1);}
+#endif
@@ -803,12 +803,24 @@ void renormalise_vector(int16_t *X, int32_t N, int16_t gain) {
 
 void comb_filter_const(int32_t *y, int32_t *x, int32_t T, int32_t N, int16_t g10, int16_t g11, int16_t g12) {
     int32_t x0, x1, x2, x3, x4;
-    int32_t i;
-    x4 = x[-T - 2];
-    x3 = x[-T - 1];
-    x2 = x[-T];
-    x1 = x[-T + 1];
-    for (i = 0; i < N; i++) {
+    int32_t i = 0;
+#ifdef CELT_SIMD
+    /* in place (y == x) the filter is recursive, but T >= 15: the 4 lanes read only samples that are already final */
+    const celt_v32_t vg10 = celt_dup32(g10), vg11 = celt_dup32(g11), vg12 = celt_dup32(g12);
+    for (; i + 4 <= N; i += 4) {
+        const int32_t *xt = x + i - T;
+        celt_v32_t v = celt_ld32(x + i);
+        v = celt_add32(v, celt_mul16x32_q15(vg10, celt_ld32(xt)));
+        v = celt_add32(v, celt_mul16x32_q15(vg11, celt_add32(celt_ld32(xt + 1), celt_ld32(xt - 1))));
+        v = celt_add32(v, celt_mul16x32_q15(vg12, celt_add32(celt_ld32(xt + 2), celt_ld32(xt - 2))));
+        celt_st32(y + i, celt_sat32(v, 300000000));
+    }
+#endif
+    x4 = x[i - T - 2];
+    x3 = x[i - T - 1];
+    x2 = x[i - T];
+    x1 = x[i - T + 1];
+    for (; i < N; i++) {
         x0 = x[i - T + 2];
         y[i]  = x[i];
         y[i] += MULT16_32_Q15(g10, x2);
@@ -985,6 +997,12 @@ void denormalise_bands(const int16_t * X, int32_t * freq,
                 g = 16384;
                 shift = -2;
             }
+        }
+#ifdef CELT_SIMD
+        for (; j + 4 <= band_end; j += 4, x += 4, f += 4) celt_st32(f, celt_mul16x16_shr(celt_ld16(x), g, shift));
+        if (j == band_end) continue;
+#endif
+        if (shift < 0) {
             do {
                 *f++ = SHL32(MULT16_16(*x++, g), -shift);
             } while (++j < band_end);
@@ -2189,7 +2207,11 @@ void celt_synthesis(int16_t *X, int32_t *out_syn[], int16_t *oldBandE, int32_t C
        or in the */
     c = 0;
     do {
-        for(i = 0; i < N; i++) out_syn[c][i] = SATURATE(out_syn[c][i], (300000000));
+        i = 0;
+#ifdef CELT_SIMD
+        for(; i + 4 <= N; i += 4) celt_st32(out_syn[c] + i, celt_sat32(celt_ld32(out_syn[c] + i), 300000000));
+#endif
+        for(; i < N; i++) out_syn[c][i] = SATURATE(out_syn[c][i], (300000000));
     } while(++c < CC);
 
     return;
@@ -3313,7 +3335,20 @@ void clt_mdct_backward(int32_t *in, int32_t * out, int32_t overlap, int32_t shif
         const int16_t * wp1 = window120;
         const int16_t * wp2 = window120 + overlap - 1;
 
-        for (i = 0; i < overlap / 2; i++) {
+        i = 0;
+#ifdef CELT_SIMD
+        for (; i + 4 <= overlap / 2; i += 4) { // xp1 and wp2 run backwards, the lanes are reversed
+            celt_v32_t x1 = celt_rev32(celt_ld32(xp1 - 3));
+            celt_v32_t x2 = celt_ld32(yp1);
+            celt_v32_t w1 = celt_ld16(wp1);
+            celt_v32_t w2 = celt_rev32(celt_ld16(wp2 - 3));
+            celt_st32(yp1, celt_sub32(celt_mul16x32_q15(w2, x2), celt_mul16x32_q15(w1, x1)));
+            celt_st32(xp1 - 3, celt_rev32(celt_add32(celt_mul16x32_q15(w1, x2), celt_mul16x32_q15(w2, x1))));
+            yp1 += 4; xp1 -= 4;
+            wp1 += 4; wp2 -= 4;
+        }
+#endif
+        for (; i < overlap / 2; i++) {
             int32_t x1, x2;
             x1 = *xp1;
             x2 = *yp1;
@@ -85,7 +85,7 @@ bool OPUSDecoder_AllocateBuffers(){
     int32_t ret = 0, silkDecSizeBytes = 0;
     (void) ret;
     (void) silkDecSizeBytes;
-    silk_InitDecoder();
+    if(silk_InitDecoder() != SILK_NO_ERROR) {log_e("SILK not init"); return false;}
     //ret = silk_Get_Decoder_Size(&silkDecSizeBytes);
     // if (ret){
     //     log_e("internal error");
@@ -106,6 +106,7 @@ void OPUSDecoder_FreeBuffers(){
     s_opusSegmentTableRdPtr = -1;
     s_opusCountCode = 0;
     CELTDecoder_FreeBuffers();
+    silk_FreeBuffers();
 }
 void OPUSDecoder_ClearBuffers(){
     if(s_opusChbuf)        memset(s_opusChbuf, 0, 512);
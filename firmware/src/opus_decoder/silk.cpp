@@ -32,6 +32,17 @@ uint32_t s_silk_internalSampleRate = 0;
 uint32_t s_API_sampleRate = 0;
 uint32_t s_prevPitchLag = 0;
 
+/* work buffers of silk_decode_core() and silk_resampler_private_IIR_FIR(), every sample passes through them. Allocated
+   once instead of per frame, internal RAM preferred (5.8 KB) */
+typedef struct {
+    int16_t sLTP[LTP_MEM_LENGTH_MS * MAX_FS_KHZ];
+    int32_t sLTP_Q15[LTP_MEM_LENGTH_MS * MAX_FS_KHZ + MAX_FRAME_LENGTH];
+    int32_t res_Q14[MAX_SUB_FRAME_LENGTH];
+    int32_t sLPC_Q14[MAX_SUB_FRAME_LENGTH + MAX_LPC_ORDER];
+    int16_t upBuf[2 * RESAMPLER_MAX_BATCH_SIZE_IN + RESAMPLER_ORDER_FIR_12];
+} silk_scratch_t;
+silk_scratch_t* s_silkScratch = NULL;
+
 /* Coefficients for 2-band filter bank based on first-order allpass filters */
 int16_t A_fb1_20 = 5394 << 1;
 int16_t A_fb1_21 = -24290; /* (int16_t)(20623 << 1) */
@@ -365,10 +376,13 @@ const int16_t silk_Resampler_2_3_COEFS_LQ[2 + 2 * 2] = {
     -2797, -6507, 4697, 10739, 1567, 8276,
 };
 
-/* Table with interplation fractions of 1/24, 3/24, 5/24, ... , 23/24 : 23/24 (46 Words) */
-const int16_t silk_resampler_frac_FIR_12[12][RESAMPLER_ORDER_FIR_12 / 2] = {
-    {189, -600, 617, 30567},  {117, -159, -1070, 29704}, {52, 221, -2392, 28276},   {-4, 529, -3350, 26341}, {-48, 758, -3956, 23973}, {-80, 905, -4235, 21254},
-    {-99, 972, -4222, 18278}, {-107, 967, -3957, 15143}, {-103, 896, -3487, 11950}, {-91, 773, -2865, 8798}, {-71, 611, -2143, 5784},  {-46, 425, -1375, 2996},
+/* Table with interplation fractions of 1/24, 3/24, 5/24, ... , 23/24, all 8 taps of a phase in one row (the second
+   half is the mirrored row 11 - phase), one load per output sample */
+const int16_t silk_resampler_frac_FIR_12[12][RESAMPLER_ORDER_FIR_12] = {
+    {189, -600, 617, 30567, 2996, -1375, 425, -46},  {117, -159, -1070, 29704, 5784, -2143, 611, -71},  {52, 221, -2392, 28276, 8798, -2865, 773, -91},
+    {-4, 529, -3350, 26341, 11950, -3487, 896, -103},  {-48, 758, -3956, 23973, 15143, -3957, 967, -107},  {-80, 905, -4235, 21254, 18278, -4222, 972, -99},
+    {-99, 972, -4222, 18278, 21254, -4235, 905, -80},  {-107, 967, -3957, 15143, 23973, -3956, 758, -48},  {-103, 896, -3487, 11950, 26341, -3350, 529, -4},
+    {-91, 773, -2865, 8798, 28276, -2392, 221, 52},  {-71, 611, -2143, 5784, 29704, -1070, -159, 117},  {-46, 425, -1375, 2996, 30567, 617, -600, 189},
 };
 
 /* Tables for 2x downsampler */
@@ -1940,6 +1954,10 @@ int32_t silk_Get_Decoder_Size(int32_t* decSizeBytes) {
 int32_t silk_InitDecoder() {
 
     int32_t n, ret = SILK_NO_ERROR;
+    if (!s_silkScratch) {
+        s_silkScratch = (silk_scratch_t*)heap_caps_malloc_prefer(sizeof(silk_scratch_t), 2, MALLOC_CAP_DEFAULT | MALLOC_CAP_INTERNAL, MALLOC_CAP_DEFAULT | MALLOC_CAP_SPIRAM);
+        if (!s_silkScratch) { return SILK_DEC_ALLOC_FAIL; }
+    }
     for (n = 0; n < DECODER_NUM_CHANNELS; n++) { ret = silk_init_decoder(&s_channel_state[n]); }
     memset(&s_decState.sStereo, 0, sizeof(s_decState.sStereo));
     /* Not strictly needed, but it's cleaner that way */
@@ -1948,7 +1966,63 @@ int32_t silk_InitDecoder() {
     return ret;
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void silk_FreeBuffers() {
+    if (s_silkScratch) { free(s_silkScratch); s_silkScratch = NULL; }
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 
+/* Short-term prediction of one subframe, sLPC_Q14[0 ... MAX_LPC_ORDER - 1] holds the filter state. Called with a
+   constant order (10 or 16), the compiler builds one unrolled loop per order without the order test per sample */
+static inline __attribute__((always_inline)) void silk_LPC_synthesis(int32_t* sLPC_Q14, const int32_t* pres_Q14, int16_t* pxq, const int16_t* A_Q12, const int32_t len,
+                                                                     const int32_t Gain_Q10, const int32_t order) {
+    int32_t i, LPC_pred_Q10;
+#ifdef SILK_SIMD
+    /* coefficients reversed and zero padded to a multiple of 4, the state is read forward from sLPC_Q14[MAX_LPC_ORDER + i - taps] */
+    const int32_t taps = (order + 3) & ~3;
+    int16_t       A_rev[MAX_LPC_ORDER];
+    silk_v32_t    A_v[MAX_LPC_ORDER / 4];
+    for (i = 0; i < taps; i++) { A_rev[i] = i < taps - order ? 0 : A_Q12[taps - 1 - i]; }
+    for (i = 0; i < taps / 4; i++) { A_v[i] = silk_ld16(&A_rev[4 * i]); }
+#endif
+    for (i = 0; i < len; i++) {
+#ifdef SILK_SIMD
+        const int32_t* s = &sLPC_Q14[MAX_LPC_ORDER + i - taps];
+        silk_v32_t     acc = silk_smulwb4(silk_ld32(s), A_v[0]);
+        acc = silk_add32(acc, silk_smulwb4(silk_ld32(s + 4), A_v[1]));
+        acc = silk_add32(acc, silk_smulwb4(silk_ld32(s + 8), A_v[2]));
+        if (taps == 16) { acc = silk_add32(acc, silk_smulwb4(silk_ld32(s + 12), A_v[3])); }
+        /* Avoids introducing a bias because silk_SMLAWB() always rounds to -inf */
+        LPC_pred_Q10 = (int32_t)((uint32_t)silk_RSHIFT(order, 1) + (uint32_t)silk_hsum32(acc));
+#else
+        /* Avoids introducing a bias because silk_SMLAWB() always rounds to -inf */
+        LPC_pred_Q10 = silk_RSHIFT(order, 1);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 1], A_Q12[0]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 2], A_Q12[1]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 3], A_Q12[2]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 4], A_Q12[3]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 5], A_Q12[4]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 6], A_Q12[5]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 7], A_Q12[6]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 8], A_Q12[7]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 9], A_Q12[8]);
+        LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 10], A_Q12[9]);
+        if (order == 16) {
+            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 11], A_Q12[10]);
+            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 12], A_Q12[11]);
+            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 13], A_Q12[12]);
+            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 14], A_Q12[13]);
+            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 15], A_Q12[14]);
+            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 16], A_Q12[15]);
+        }
+#endif
+        /* Add prediction to LPC excitation */
+        sLPC_Q14[MAX_LPC_ORDER + i] = silk_ADD_SAT32(pres_Q14[i], silk_LSHIFT_SAT32(LPC_pred_Q10, 4));
+
+        /* Scale with gain */
+        pxq[i] = (int16_t)silk_SAT16(silk_RSHIFT_ROUND(silk_SMULWW(sLPC_Q14[MAX_LPC_ORDER + i], Gain_Q10), 8));
+    }
+}
+//------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 /* Core decoder. Performs inverse NSQ operation LTP + LPC */
 void silk_decode_core(silk_decoder_state*   psDec,                   /* I/O  Decoder state                               */
                       silk_decoder_control* psDecCtrl,               /* I    Decoder control                             */
@@ -1962,14 +2036,10 @@ void silk_decode_core(silk_decoder_state*   psDec,                   /* I/O  Dec
 
     assert(psDec->prev_gain_Q16 != 0);
 
-    // int16_t sLTP[psDec->ltp_mem_length];
-    // int32_t sLTP_Q15[psDec->ltp_mem_length + psDec->frame_length];
-    // int32_t res_Q14[psDec->subfr_length];
-    // int32_t sLPC_Q14[psDec->subfr_length + MAX_LPC_ORDER];
-    int16_t* sLTP = (int16_t*)__malloc_heap_psram(psDec->ltp_mem_length * sizeof(int16_t));
-    int32_t* sLTP_Q15 = (int32_t*)__malloc_heap_psram((psDec->ltp_mem_length + psDec->frame_length) * sizeof(int32_t));
-    int32_t* res_Q14 = (int32_t*)__malloc_heap_psram(psDec->subfr_length * sizeof(int32_t));
-    int32_t* sLPC_Q14 = (int32_t*)__malloc_heap_psram((psDec->subfr_length + MAX_LPC_ORDER) * sizeof(int32_t));
+    int16_t* sLTP = s_silkScratch->sLTP;         /* [ltp_mem_length] */
+    int32_t* sLTP_Q15 = s_silkScratch->sLTP_Q15; /* [ltp_mem_length + frame_length] */
+    int32_t* res_Q14 = s_silkScratch->res_Q14;   /* [subfr_length] */
+    int32_t* sLPC_Q14 = s_silkScratch->sLPC_Q14; /* [subfr_length + MAX_LPC_ORDER] */
 
     offset_Q10 = silk_Quantization_Offsets_Q10[psDec->indices.signalType >> 1][psDec->indices.quantOffsetType];
 
@@ -2091,35 +2161,12 @@ void silk_decode_core(silk_decoder_state*   psDec,                   /* I/O  Dec
             pres_Q14 = pexc_Q14;
         }
 
-        for (i = 0; i < psDec->subfr_length; i++) {
-            /* Short-term prediction */
-            assert(psDec->LPC_order == 10 || psDec->LPC_order == 16);
-            /* Avoids introducing a bias because silk_SMLAWB() always rounds to -inf */
-            LPC_pred_Q10 = silk_RSHIFT(psDec->LPC_order, 1);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 1], A_Q12_tmp[0]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 2], A_Q12_tmp[1]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 3], A_Q12_tmp[2]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 4], A_Q12_tmp[3]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 5], A_Q12_tmp[4]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 6], A_Q12_tmp[5]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 7], A_Q12_tmp[6]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 8], A_Q12_tmp[7]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 9], A_Q12_tmp[8]);
-            LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 10], A_Q12_tmp[9]);
-            if (psDec->LPC_order == 16) {
-                LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 11], A_Q12_tmp[10]);
-                LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 12], A_Q12_tmp[11]);
-                LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 13], A_Q12_tmp[12]);
-                LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 14], A_Q12_tmp[13]);
-                LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 15], A_Q12_tmp[14]);
-                LPC_pred_Q10 = silk_SMLAWB(LPC_pred_Q10, sLPC_Q14[MAX_LPC_ORDER + i - 16], A_Q12_tmp[15]);
-            }
-
-            /* Add prediction to LPC excitation */
-            sLPC_Q14[MAX_LPC_ORDER + i] = silk_ADD_SAT32(pres_Q14[i], silk_LSHIFT_SAT32(LPC_pred_Q10, 4));
-
-            /* Scale with gain */
-            pxq[i] = (int16_t)silk_SAT16(silk_RSHIFT_ROUND(silk_SMULWW(sLPC_Q14[MAX_LPC_ORDER + i], Gain_Q10), 8));
+        /* Short-term prediction */
+        assert(psDec->LPC_order == 10 || psDec->LPC_order == 16);
+        if (psDec->LPC_order == 16) {
+            silk_LPC_synthesis(sLPC_Q14, pres_Q14, pxq, A_Q12_tmp, psDec->subfr_length, Gain_Q10, 16);
+        } else {
+            silk_LPC_synthesis(sLPC_Q14, pres_Q14, pxq, A_Q12_tmp, psDec->subfr_length, Gain_Q10, 10);
         }
 
         /* Update LPC filter state */
@@ -2130,11 +2177,6 @@ void silk_decode_core(silk_decoder_state*   psDec,                   /* I/O  Dec
 
     /* Save LPC state */
     memcpy(psDec->sLPC_Q14_buf, sLPC_Q14, MAX_LPC_ORDER * sizeof(int32_t));
-
-    free (sLTP);
-    free (sLTP_Q15);
-    free (res_Q14);
-    free (sLPC_Q14);
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 /* Decode frame */
@@ -3594,14 +3636,19 @@ int16_t* silk_resampler_private_IIR_FIR_INTERPOL(int16_t* out, int16_t* buf, int
         table_index = silk_SMULWB(index_Q16 & 0xFFFF, 12);
         buf_ptr = &buf[index_Q16 >> 16];
 
-        res_Q15 = silk_SMULBB(buf_ptr[0], silk_resampler_frac_FIR_12[table_index][0]);
-        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[1], silk_resampler_frac_FIR_12[table_index][1]);
-        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[2], silk_resampler_frac_FIR_12[table_index][2]);
-        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[3], silk_resampler_frac_FIR_12[table_index][3]);
-        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[4], silk_resampler_frac_FIR_12[11 - table_index][3]);
-        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[5], silk_resampler_frac_FIR_12[11 - table_index][2]);
-        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[6], silk_resampler_frac_FIR_12[11 - table_index][1]);
-        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[7], silk_resampler_frac_FIR_12[11 - table_index][0]);
+#ifdef SILK_SIMD
+        res_Q15 = silk_dot16x8(buf_ptr, silk_resampler_frac_FIR_12[table_index]);
+#else
+        const int16_t* FIR = silk_resampler_frac_FIR_12[table_index];
+        res_Q15 = silk_SMULBB(buf_ptr[0], FIR[0]);
+        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[1], FIR[1]);
+        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[2], FIR[2]);
+        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[3], FIR[3]);
+        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[4], FIR[4]);
+        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[5], FIR[5]);
+        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[6], FIR[6]);
+        res_Q15 = silk_SMLABB(res_Q15, buf_ptr[7], FIR[7]);
+#endif
         *out++ = (int16_t)silk_SAT16(silk_RSHIFT_ROUND(res_Q15, 15));
     }
     return out;
@@ -3616,10 +3663,7 @@ void silk_resampler_private_IIR_FIR(void*         SS,    /* I/O  Resampler state
     silk_resampler_state_struct* S = (silk_resampler_state_struct*)SS;
     int32_t                      nSamplesIn;
     int32_t                      max_index_Q16, index_increment_Q16;
-    int16_t* buf = NULL;
-
-    //ALLOC(buf, 2 * S->batchSize + RESAMPLER_ORDER_FIR_12, int16_t);
-    buf = (int16_t*)__malloc_heap_psram((2 * S->batchSize + RESAMPLER_ORDER_FIR_12) * sizeof(int16_t));
+    int16_t*                     buf = s_silkScratch->upBuf; /* [2 * batchSize + RESAMPLER_ORDER_FIR_12] */
 
     /* Copy buffered samples to start of buffer */
     memcpy(buf, S->sFIR.i16, RESAMPLER_ORDER_FIR_12 * sizeof(int16_t));
@@ -3647,8 +3691,6 @@ void silk_resampler_private_IIR_FIR(void*         SS,    /* I/O  Resampler state
 
     /* Copy last part of filtered signal to the state for the next call */
     memcpy(S->sFIR.i16, &buf[nSamplesIn << 1], RESAMPLER_ORDER_FIR_12 * sizeof(int16_t));
-
-    free (buf);
 }
 //------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 /* Upsample by a factor 2, high quality. Uses 2nd order allpass filters for the 2x upsampling, followed by a      */
@@ -379,6 +379,7 @@ LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 #define SILK_DEC_PAYLOAD_TOO_LARGE          -201 /* Payload size exceeded the maximum allowed 1024 bytes */
 #define SILK_DEC_PAYLOAD_ERROR              -202 /* Payload has bit errors */
 #define SILK_DEC_INVALID_FRAME_SIZE         -203 /* Payload has bit errors */
+#define SILK_DEC_ALLOC_FAIL                 -204 /* No memory for the work buffers */
 
 #define silk_LIMIT(a, limit1, limit2) ((limit1) > (limit2) ? ((a) > (limit1) ? (limit1) : ((a) < (limit2) ? (limit2) : (a))) : ((a) > (limit2) ? (limit2) : ((a) < (limit1) ? (limit1) : (a))))
 
@@ -442,6 +443,56 @@ static inline int32_t silk_CLZ16(int16_t in16) { return 32 - EC_ILOG(in16 << 16
 
 static inline int32_t silk_CLZ32(int32_t in32) { return in32 ? 32 - EC_ILOG(in32) : 32; }
 
+/* vector kernels for the short-term (LPC) synthesis and the FIR interpolation of the 2x upsampled signal, selected at
+ * compile time like CELT_SIMD; define SILK_NO_SIMD to force the scalar code
+ * bit-exact with the scalar loops: sums wrap mod 2^32, silk_SMULWB keeps bits 16..47 of the 64 bit product
+ * Xtensa (ESP32, ESP32-S3) uses the order-specialized scalar code, see silk_decode_core()
+ */
+#if !defined(SILK_NO_SIMD) && defined(__SSE4_1__)
+    #include <smmintrin.h>
+    #define SILK_SIMD
+    typedef __m128i silk_v32_t;
+    static inline silk_v32_t silk_ld32(const int32_t* p) {return _mm_loadu_si128((const __m128i*)p);}
+    static inline silk_v32_t silk_ld16(const int16_t* p) {return _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)p));}
+    static inline silk_v32_t silk_dup32(int32_t a) {return _mm_set1_epi32(a);}
+    static inline silk_v32_t silk_add32(silk_v32_t a, silk_v32_t b) {return _mm_add_epi32(a, b);}
+    static inline silk_v32_t silk_smulwb4(silk_v32_t a, silk_v32_t b) { // b: sign extended int16, silk_SMULWB in 4 lanes
+        __m128i even = _mm_srli_epi64(_mm_mul_epi32(a, b), 16);                                        // lanes 0, 2
+        __m128i odd  = _mm_srli_epi64(_mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)), 16); // lanes 1, 3
+        return _mm_blend_epi16(even, _mm_slli_epi64(odd, 32), 0xCC);
+    }
+    static inline int32_t silk_hsum32(silk_v32_t a) {
+        a = _mm_add_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)));
+        a = _mm_add_epi32(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(a);
+    }
+    static inline int32_t silk_dot16x8(const int16_t* x, const int16_t* y) { // 8 int16 products, int32 sum
+        return silk_hsum32(_mm_madd_epi16(_mm_loadu_si128((const __m128i*)x), _mm_loadu_si128((const __m128i*)y)));
+    }
+#elif !defined(SILK_NO_SIMD) && defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define SILK_SIMD
+    typedef int32x4_t silk_v32_t;
+    static inline silk_v32_t silk_ld32(const int32_t* p) {return vld1q_s32(p);}
+    static inline silk_v32_t silk_ld16(const int16_t* p) {return vmovl_s16(vld1_s16(p));}
+    static inline silk_v32_t silk_dup32(int32_t a) {return vdupq_n_s32(a);}
+    static inline silk_v32_t silk_add32(silk_v32_t a, silk_v32_t b) {return vaddq_s32(a, b);}
+    static inline silk_v32_t silk_smulwb4(silk_v32_t a, silk_v32_t b) {
+        int64x2_t lo = vmull_s32(vget_low_s32(a), vget_low_s32(b));
+        int64x2_t hi = vmull_s32(vget_high_s32(a), vget_high_s32(b));
+        return vcombine_s32(vshrn_n_s64(lo, 16), vshrn_n_s64(hi, 16));
+    }
+    static inline int32_t silk_hsum32(silk_v32_t a) {
+        int32x2_t s = vadd_s32(vget_low_s32(a), vget_high_s32(a));
+        return vget_lane_s32(vpadd_s32(s, s), 0);
+    }
+    static inline int32_t silk_dot16x8(const int16_t* x, const int16_t* y) {
+        int16x8_t a = vld1q_s16(x), b = vld1q_s16(y);
+        int32x4_t acc = vmull_s16(vget_low_s16(a), vget_low_s16(b));
+        return silk_hsum32(vmlal_s16(acc, vget_high_s16(a), vget_high_s16(b)));
+    }
+#endif
+
 /* Row based */
 #define matrix_ptr(Matrix_base_adr, row, column, N) (*((Matrix_base_adr) + ((row) * (N) + (column))))
 #define matrix_adr(Matrix_base_adr, row, column, N) ((Matrix_base_adr) + ((row) * (N) + (column)))
@@ -1002,6 +1053,7 @@ void     silk_CNG_Reset(silk_decoder_state* psDec);
 int32_t  silk_Get_Decoder_Size(int32_t* decSizeBytes);
 
 int32_t  silk_InitDecoder();
+void     silk_FreeBuffers();
 void     silk_setRawParams(uint8_t channels, uint8_t API_channels, uint8_t payloadSize_ms, uint32_t internalSampleRate, uint32_t API_samleRate);
 uint32_t silk_getPrevPitchLag();
 int32_t  silk_Decode(int32_t lostFlag, int32_t newPacketFlag, int16_t* samplesOut, int32_t* nSamplesOut);
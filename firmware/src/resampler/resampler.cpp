@@ -0,0 +1,153 @@
+/*
+ * resampler.cpp
+ *
+ * fixed-point polyphase sample rate converter
+ *
+ * every output sample is the dot product of the last 'taps' input samples with one phase of a windowed sinc
+ * (linear ramp for SRC_QUALITY_LOW). The phase is the fractional position of the output sample between two input
+ * samples, the nearest of 2^phaseBits precomputed phases is used. Taps are Q14 and normalized to unity DC gain per
+ * phase, the accumulator is int32. For downsampling the cutoff is moved below the output nyquist frequency.
+ */
+#include "resampler.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+Resampler::Resampler() {
+}
+Resampler::~Resampler() {
+    deinit();
+}
+//----------------------------------------------------------------------------------------------------------------------
+bool Resampler::init(uint32_t inRate, uint32_t outRate, uint8_t channels, uint8_t quality) {
+    if(!inRate || !outRate) return false;
+    if(channels < 1 || channels > 2) return false;
+    if(inRate / outRate >= 128) return false; // m_step would not fit in Q24
+    if(quality > SRC_QUALITY_HIGH) quality = SRC_QUALITY_HIGH;
+
+    if(m_coef && inRate == m_inRate && outRate == m_outRate && channels == m_channels && quality == m_quality) {
+        return true; // same configuration, keep the history (no click between two clips)
+    }
+    deinit();
+    m_inRate = inRate;
+    m_outRate = outRate;
+    m_channels = channels;
+    m_quality = quality;
+    if(inRate == outRate) return true; // bypass
+
+    float rolloff = 1.0;
+    switch(quality) {
+        case SRC_QUALITY_LOW:    m_taps =  2; m_phaseBits = 6; break;
+        case SRC_QUALITY_MEDIUM: m_taps = 16; m_phaseBits = 6; rolloff = 0.90; break;
+        default:                 m_taps = 32; m_phaseBits = 7; rolloff = 0.95; break;
+    }
+    uint16_t phases = 1 << m_phaseBits;
+    m_coef = (int16_t*)malloc(phases * m_taps * sizeof(int16_t));        // internal RAM, read for every output sample
+    m_hist = (int16_t*)calloc(m_channels * 2 * m_taps, sizeof(int16_t));
+    if(!m_coef || !m_hist) {
+        log_e("oom");
+        deinit();
+        return false;
+    }
+
+    float fc = (outRate < inRate) ? (float)outRate / inRate : 1.0; // cutoff relative to the input nyquist frequency
+    fc *= rolloff;
+    int16_t half = m_taps / 2;
+    float c[32];
+    for(int p = 0; p < phases; p++) {
+        float frac = (float)p / phases;
+        float sum = 0;
+        for(int k = 0; k < m_taps; k++) {
+            float x = k - (half - 1) - frac; // distance from the output sample in input samples
+            if(quality == SRC_QUALITY_LOW) {
+                c[k] = 1.0 - fabsf(x);
+                if(c[k] < 0) c[k] = 0;
+            }
+            else {
+                float sinc = (x == 0) ? 1.0 : sinf(PI * fc * x) / (PI * fc * x);
+                float w = 0.42 + 0.5 * cosf(PI * x / half) + 0.08 * cosf(2 * PI * x / half); // Blackman
+                c[k] = sinc * w;
+            }
+            sum += c[k];
+        }
+        int16_t* q = m_coef + p * m_taps;
+        int32_t qsum = 0;
+        int16_t kmax = 0;
+        for(int k = 0; k < m_taps; k++) {
+            q[k] = (int16_t)lrintf(c[k] / sum * (1 << m_coefBits));
+            qsum += q[k];
+            if(q[k] > q[kmax]) kmax = k;
+        }
+        q[kmax] += (1 << m_coefBits) - qsum; // exact unity gain, no DC drift
+    }
+    m_step = ((uint64_t)inRate << m_fracBits) / outRate;
+    reset();
+    m_f_active = true;
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Resampler::deinit() {
+    if(m_coef) {free(m_coef); m_coef = NULL;}
+    if(m_hist) {free(m_hist); m_hist = NULL;}
+    m_f_active = false;
+    m_inRate = m_outRate = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Resampler::reset() {
+    if(m_hist) memset(m_hist, 0, m_channels * 2 * m_taps * sizeof(int16_t));
+    m_histPos = 0;
+    m_frac = m_one; // take one input sample first
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint16_t Resampler::getMaxOutFrames(uint16_t inFrames) {
+    if(!m_f_active) return inFrames;
+    return ((uint32_t)inFrames * m_outRate + m_inRate - 1) / m_inRate + 1;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void Resampler::pushFrame(const int16_t* frame) {
+    for(int ch = 0; ch < m_channels; ch++) {
+        int16_t* h = m_hist + ch * 2 * m_taps;
+        h[m_histPos] = frame[ch];
+        h[m_histPos + m_taps] = frame[ch]; // second copy, the window m_hist[m_histPos ... m_histPos + taps - 1] is contiguous
+    }
+    m_histPos++;
+    if(m_histPos == m_taps) m_histPos = 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+uint16_t Resampler::process(const int16_t* in, uint16_t inFrames, int16_t* out, uint16_t outFrames, uint16_t* consumed) {
+    // in and out are interleaved, returns the number of output frames, *consumed: number of input frames used
+    // stops if 'out' is full, call again with the rest of 'in'
+    uint16_t inUsed = 0;
+    uint16_t outCnt = 0;
+
+    if(!m_f_active) { // bypass
+        outCnt = min(inFrames, outFrames);
+        memcpy(out, in, outCnt * m_channels * sizeof(int16_t));
+        if(consumed) *consumed = outCnt;
+        return outCnt;
+    }
+
+    const uint8_t phaseShift = m_fracBits - m_phaseBits;
+    while(true) {
+        while(m_frac < m_one) {
+            if(outCnt >= outFrames) goto exit;
+            const int16_t* c = m_coef + (m_frac >> phaseShift) * m_taps;
+            for(int ch = 0; ch < m_channels; ch++) {
+                const int16_t* h = m_hist + ch * 2 * m_taps + m_histPos;
+                int32_t acc = 1 << (m_coefBits - 1); // rounding
+                for(int k = 0; k < m_taps; k++) acc += (int32_t)h[k] * c[k];
+                acc >>= m_coefBits;
+                if(acc >  32767) acc =  32767;
+                if(acc < -32768) acc = -32768;
+                out[outCnt * m_channels + ch] = (int16_t)acc;
+            }
+            outCnt++;
+            m_frac += m_step;
+        }
+        if(inUsed >= inFrames) break;
+        m_frac -= m_one;
+        pushFrame(in + inUsed * m_channels);
+        inUsed++;
+    }
+exit:
+    if(consumed) *consumed = inUsed;
+    return outCnt;
+}
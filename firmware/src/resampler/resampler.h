@@ -0,0 +1,49 @@
+/*
+ * resampler.h
+ *
+ * fixed-point polyphase sample rate converter, 16 bit interleaved PCM (mono or stereo)
+ * used to keep the I2S clock at one rate while the sources change their sample rate
+ */
+#pragma once
+
+#include "Arduino.h"
+
+enum : uint8_t { SRC_QUALITY_LOW = 0,     // linear interpolation,   2 taps,  64 phases
+                 SRC_QUALITY_MEDIUM = 1,  // windowed sinc,          16 taps, 64 phases
+                 SRC_QUALITY_HIGH = 2 };  // windowed sinc,          32 taps, 128 phases
+
+class Resampler {
+
+public:
+    Resampler();
+    ~Resampler();
+    bool     init(uint32_t inRate, uint32_t outRate, uint8_t channels = 2, uint8_t quality = SRC_QUALITY_MEDIUM);
+    void     deinit();                              // frees the tables, resampler is bypassed
+    void     reset();                               // clears the history, keeps the coefficients
+    bool     isActive() { return m_f_active; }      // false if not initialized or inRate == outRate
+    uint32_t getInRate() { return m_inRate; }
+    uint32_t getOutRate() { return m_outRate; }
+    uint8_t  getQuality() { return m_quality; }
+    uint16_t getMaxOutFrames(uint16_t inFrames);    // upper limit of process() output for inFrames
+    uint16_t process(const int16_t* in, uint16_t inFrames, int16_t* out, uint16_t outFrames, uint16_t* consumed);
+
+private:
+    static const uint8_t  m_fracBits = 24;          // Q24 position between two input samples
+    static const uint32_t m_one      = (uint32_t)1 << m_fracBits;
+    static const uint8_t  m_coefBits = 14;          // Q14 taps, leaves headroom for the int32 accumulator
+
+    int16_t*  m_coef      = NULL;                   // [phases][taps]
+    int16_t*  m_hist      = NULL;                   // [channels][2 * taps], every sample is written twice
+    uint32_t  m_inRate    = 0;
+    uint32_t  m_outRate   = 0;
+    uint32_t  m_step      = 0;                      // input samples per output sample, Q24
+    uint32_t  m_frac      = 0;                      // position of the next output sample, Q24
+    uint16_t  m_taps      = 0;
+    uint16_t  m_histPos   = 0;                      // oldest sample in m_hist
+    uint8_t   m_phaseBits = 0;
+    uint8_t   m_channels  = 2;
+    uint8_t   m_quality   = SRC_QUALITY_MEDIUM;
+    bool      m_f_active  = false;
+
+    void      pushFrame(const int16_t* frame);
+};
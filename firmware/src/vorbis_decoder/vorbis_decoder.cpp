@@ -15,7 +15,7 @@
  * adapted for the ESP32 by schreibfaul1
  *
  *  Created on: 13.02.2023
- *  Updated on: 09.09.2024
+ *  Updated on: 18.10.2026
  */
 //----------------------------------------------------------------------------------------------------------------------
 //                                     O G G    I M P L.
@@ -1229,7 +1229,7 @@ int32_t _make_decode_table(codebook_t *s, char *lengthlist, uint8_t quantvals, i
         s->dec_table = __malloc_heap_psram((s->used_entries * 2 + 1) * sizeof(*work));
         /* +1 (rather than -2) is to accommodate 0 and 1 sized books, which are specialcased to nodeb==4 */
         if(_make_words(lengthlist, s->entries, (uint32_t *)s->dec_table, quantvals, s, maptype)) return 1;
-
+        _make_fast_table(s);
         return 0;
     }
 
@@ -1327,9 +1327,102 @@ int32_t _make_decode_table(codebook_t *s, char *lengthlist, uint8_t quantvals, i
         }
     }
     if(work) {free(work); work = NULL;}
+    _make_fast_table(s);
     return 0;
 }
 //---------------------------------------------------------------------------------------------------------------------
+/* walk the decode tree with the (LSB first) bits in lok, returns the number of bits used - 1 or read if no leaf was
+   reached, *chase is the leaf value */
+static inline int32_t _chase_tree(codebook_t *book, int32_t lok, int32_t read, uint32_t *chase_out) {
+    uint32_t chase = 0;
+    int32_t  i;
+
+    if(book->dec_nodeb == 1) {
+        if(book->dec_leafw == 1) {
+            /* 8/8 */
+            uint8_t *t = (uint8_t *)book->dec_table;
+            for(i = 0; i < read; i++) {
+                chase = t[chase * 2 + ((lok >> i) & 1)];
+                if(chase & 0x80UL) break;
+            }
+            chase &= 0x7fUL;
+        }
+        else {
+            /* 8/16 */
+            uint8_t *t = (uint8_t *)book->dec_table;
+            for(i = 0; i < read; i++) {
+                int32_t bit = (lok >> i) & 1;
+                int32_t next = t[chase + bit];
+                if(next & 0x80) {
+                    chase = (next << 8) | t[chase + bit + 1 + (!bit || (t[chase] & 0x80))];
+                    break;
+                }
+                chase = next;
+            }
+            chase &= 0x7fffUL;
+        }
+    }
+    else {
+        if(book->dec_nodeb == 2) {
+            if(book->dec_leafw == 1) {
+                /* 16/16 */
+                int32_t idx;
+                for(i = 0; i < read; i++) {
+                    idx = chase * 2 + ((lok >> i) & 1);
+                    chase = ((uint16_t *)(book->dec_table))[idx];
+                    if(chase & 0x8000UL){
+                        break;
+                    }
+                }
+                chase &= 0x7fffUL;
+            }
+            else {
+                /* 16/32 */
+                uint16_t *t = (uint16_t *)book->dec_table;
+                for(i = 0; i < read; i++) {
+                    int32_t bit = (lok >> i) & 1;
+                    int32_t next = t[chase + bit];
+                    if(next & 0x8000) {
+                        chase = (next << 16) | t[chase + bit + 1 + (!bit || (t[chase] & 0x8000))];
+                        break;
+                    }
+                    chase = next;
+                }
+                chase &= 0x7fffffffUL;
+            }
+        }
+        else {
+            for(i = 0; i < read; i++) {
+                chase = ((uint32_t *)(book->dec_table))[chase * 2 + ((lok >> i) & 1)];
+                if(chase & 0x80000000UL) break;
+            }
+            chase &= 0x7fffffffUL;
+        }
+    }
+    *chase_out = chase;
+    return i;
+}
+//---------------------------------------------------------------------------------------------------------------------
+/* direct lookup for the short codewords: every index of dec_fastbits bits is walked once through the tree, most
+   codewords of the residue books are shorter than VORBIS_FAST_BITS */
+void _make_fast_table(codebook_t *s) {
+    uint8_t bits = s->dec_maxlength < VORBIS_FAST_BITS ? s->dec_maxlength : VORBIS_FAST_BITS;
+    if(s->used_entries < 2 || bits == 0) return; /* single entry books have no tree */
+
+    uint32_t size = 1 << bits;
+    s->dec_fast = (uint32_t *)__malloc_heap_psram(size * (sizeof(uint32_t) + 1));
+    if(!s->dec_fast) return; /* works without, only slower */
+    s->dec_fastlen = (uint8_t *)(s->dec_fast + size);
+    s->dec_fastbits = bits;
+
+    for(uint32_t lok = 0; lok < size; lok++) {
+        uint32_t chase;
+        int32_t  i = _chase_tree(s, lok, bits, &chase);
+        s->dec_fast[lok] = chase;
+        s->dec_fastlen[lok] = (i < bits) ? i + 1 : 0;
+    }
+}
+//---------------------------------------------------------------------------------------------------------------------
 /* given a list of word lengths, number of used entries, and byte width of a leaf, generate the decode table */
 int32_t _make_words(char *l, uint16_t n, uint32_t *work, uint8_t quantvals, codebook_t *b, int32_t maptype) {
 
@@ -1484,6 +1577,7 @@ void vorbis_book_clear(codebook_t *b) {
    info struct */
     if(b->q_val) free(b->q_val);
     if(b->dec_table) free(b->dec_table);
+    if(b->dec_fast) free(b->dec_fast); /* dec_fastlen is part of this block */
 
     memset(b, 0, sizeof(*b));
 }
@@ -1870,6 +1964,7 @@ int32_t mapping_inverse(vorbis_info_mapping_t *info) {
     int32_t      *zerobundle = (int32_t *)alloca(sizeof(*zerobundle) * s_vorbisChannels);
     int32_t      *nonzero = (int32_t *)alloca(sizeof(*nonzero) * s_vorbisChannels);
     int32_t **floormemo = (int32_t **)alloca(sizeof(*floormemo) * s_vorbisChannels);
+    int32_t      *resend = (int32_t *)alloca(sizeof(*resend) * s_vorbisChannels);
 
     /* recover the spectral envelope; store it in the PCM vector for now */
     for(i = 0; i < s_vorbisChannels; i++) {
@@ -1917,7 +2012,15 @@ int32_t mapping_inverse(vorbis_info_mapping_t *info) {
             }
         }
 
-        res_inverse(s_residue_param + info->submaplist[i].residue, pcmbundle, zerobundle, ch_in_bundle);
+        vorbis_info_residue_t *res = s_residue_param + info->submaplist[i].residue;
+        res_inverse(res, pcmbundle, zerobundle, ch_in_bundle);
+
+        /* no residue above the end (the encoder's lowpass), the lines stay 0 whatever the floor is there */
+        int32_t end = res->type < 2 ? res->end : (res->end + ch_in_bundle - 1) / ch_in_bundle;
+        if(end > n / 2) end = n / 2;
+        for(j = 0; j < s_vorbisChannels; j++) {
+            if(!info->chmuxlist || info->chmuxlist[j] == i) resend[j] = end;
+        }
     }
 
     // for(j=0;j<vi->channels;j++)
@@ -1967,7 +2070,7 @@ int32_t mapping_inverse(vorbis_info_mapping_t *info) {
 
         if(s_floor_type[floorno]) {
             /* floor 1 */
-            floor1_inverse2(s_floor_param[floorno], floormemo[i], pcm);
+            floor1_inverse2(s_floor_param[floorno], floormemo[i], pcm, resend[i]);
         }
         else {
             /* floor 0 */
@@ -2114,8 +2217,19 @@ int32_t vorbis_book_decode(codebook_t* book) {
 //---------------------------------------------------------------------------------------------------------------------
 int32_t decode_packed_entry_number(codebook_t *book) {
     uint32_t chase = 0;
-    int32_t      read = book->dec_maxlength;
-    int32_t  lok = bitReader_look(read), i;
+    int32_t  i;
+
+    if(book->dec_fastbits) {
+        int32_t lok = bitReader_look(book->dec_fastbits);
+        uint8_t len = book->dec_fastlen[lok];
+        if(len) {
+            bitReader_adv(len);
+            return book->dec_fast[lok];
+        }
+    }
+
+    int32_t read = book->dec_maxlength;
+    int32_t lok = bitReader_look(read);
 
     while(lok < 0 && read > 1){
         lok = bitReader_look(--read);
@@ -2127,68 +2241,7 @@ int32_t decode_packed_entry_number(codebook_t *book) {
     }
 
     /* chase the tree with the bits we got */
-    if(book->dec_nodeb == 1) {
-        if(book->dec_leafw == 1) {
-            /* 8/8 */
-            uint8_t *t = (uint8_t *)book->dec_table;
-            for(i = 0; i < read; i++) {
-                chase = t[chase * 2 + ((lok >> i) & 1)];
-                if(chase & 0x80UL) break;
-            }
-            chase &= 0x7fUL;
-        }
-        else {
-            /* 8/16 */
-            uint8_t *t = (uint8_t *)book->dec_table;
-            for(i = 0; i < read; i++) {
-                int32_t bit = (lok >> i) & 1;
-                int32_t next = t[chase + bit];
-                if(next & 0x80) {
-                    chase = (next << 8) | t[chase + bit + 1 + (!bit || (t[chase] & 0x80))];
-                    break;
-                }
-                chase = next;
-            }
-            chase &= 0x7fffUL;
-        }
-    }
-    else {
-        if(book->dec_nodeb == 2) {
-            if(book->dec_leafw == 1) {
-                /* 16/16 */
-                int32_t idx;
-                for(i = 0; i < read; i++) {
-                    idx = chase * 2 + ((lok >> i) & 1);
-                    chase = ((uint16_t *)(book->dec_table))[idx];
-                    if(chase & 0x8000UL){
-                        break;
-                    }
-                }
-                chase &= 0x7fffUL;
-            }
-            else {
-                /* 16/32 */
-                uint16_t *t = (uint16_t *)book->dec_table;
-                for(i = 0; i < read; i++) {
-                    int32_t bit = (lok >> i) & 1;
-                    int32_t next = t[chase + bit];
-                    if(next & 0x8000) {
-                        chase = (next << 16) | t[chase + bit + 1 + (!bit || (t[chase] & 0x8000))];
-                        break;
-                    }
-                    chase = next;
-                }
-                chase &= 0x7fffffffUL;
-            }
-        }
-        else {
-            for(i = 0; i < read; i++) {
-                chase = ((uint32_t *)(book->dec_table))[chase * 2 + ((lok >> i) & 1)];
-                if(chase & 0x80000000UL) break;
-            }
-            chase &= 0x7fffffffUL;
-        }
-    }
+    i = _chase_tree(book, lok, read, &chase);
 
     if(i < read) {
         bitReader_adv(i + 1);
@@ -2215,28 +2268,14 @@ int32_t render_point(int32_t x0, int32_t x1, int32_t y0, int32_t y1, int32_t x)
     }
 }
 //---------------------------------------------------------------------------------------------------------------------
-/* unlike the others, we guard against n not being an integer number * of <dim> internally rather than in the upper
- layer (called only by * floor0) */
-int32_t vorbis_book_decodev_set(codebook_t *book, int32_t *a, int32_t n, int32_t point) {
-    if(book->used_entries > 0) {
-        int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
-        int32_t      i;
-
-        for(i = 0; i < n;) {
-            if(decode_map(book, v, point)) return -1;
-            for(uint8_t j = 0; i < n && j < book->dim; j++) a[i++] = v[j];
-        }
-    }
-    else {
-        int32_t i;
-
-        for(i = 0; i < n;) { a[i++] = 0; }
-    }
-
-    return 0;
+/* dequantisation constants of a book at a given point, the same for every vector of a partition */
+static inline void decode_map_prep(codebook_t *s, int32_t point, int32_t *add, int32_t *shiftM) {
+    int32_t a = point - s->q_minp;
+    *add = (a > 0) ? s->q_min >> a : s->q_min << -a;
+    *shiftM = point - s->q_delp;
 }
-//---------------------------------------------------------------------------------------------------------------------
-int32_t decode_map(codebook_t *s, int32_t *v, int32_t point) {
+
+static inline int32_t decode_map_entry(codebook_t *s, int32_t *v, int32_t add, int32_t shiftM) {
 
     uint32_t entry = decode_packed_entry_number(s);
 
@@ -2256,11 +2295,17 @@ int32_t decode_map(codebook_t *s, int32_t *v, int32_t point) {
         case 2: {
             /* packed vector of column offsets */
             int32_t mask = (1 << s->q_pack) - 1;
-            for(uint8_t i = 0; i < s->dim; i++) {
-                if(s->q_bits <= 8) v[i] = ((uint8_t *)(s->q_val))[entry & mask];
-                else
+            if(s->q_bits <= 8) {
+                for(uint8_t i = 0; i < s->dim; i++) {
+                    v[i] = ((uint8_t *)(s->q_val))[entry & mask];
+                    entry >>= s->q_pack;
+                }
+            }
+            else {
+                for(uint8_t i = 0; i < s->dim; i++) {
                     v[i] = ((uint16_t *)(s->q_val))[entry & mask];
-                entry >>= s->q_pack;
+                    entry >>= s->q_pack;
+                }
             }
             break;
         }
@@ -2281,20 +2326,40 @@ int32_t decode_map(codebook_t *s, int32_t *v, int32_t point) {
     }
 
     /* we have the unpacked multiplicands; compute final vals */
-    {
-        int32_t     shiftM = point - s->q_delp;
-        int32_t add = point - s->q_minp;
-        if(add > 0) add = s->q_min >> add;
-        else
-            add = s->q_min << -add;
+    if(shiftM > 0)
+        for(uint8_t i = 0; i < s->dim; i++) v[i] = add + ((v[i] * s->q_del) >> shiftM);
+    else
+        for(uint8_t i = 0; i < s->dim; i++) v[i] = add + ((v[i] * s->q_del) << -shiftM);
 
-        if(shiftM > 0)
-            for(uint8_t i = 0; i < s->dim; i++) v[i] = add + ((v[i] * s->q_del) >> shiftM);
-        else
-            for(uint8_t i = 0; i < s->dim; i++) v[i] = add + ((v[i] * s->q_del) << -shiftM);
+    if(s->q_seq)
+        for(uint8_t i = 1; i < s->dim; i++) v[i] += v[i - 1];
 
-        if(s->q_seq)
-            for(uint8_t i = 1; i < s->dim; i++) v[i] += v[i - 1];
+    return 0;
+}
+
+int32_t decode_map(codebook_t *s, int32_t *v, int32_t point) {
+    int32_t add, shiftM;
+    decode_map_prep(s, point, &add, &shiftM);
+    return decode_map_entry(s, v, add, shiftM);
+}
+//---------------------------------------------------------------------------------------------------------------------
+/* unlike the others, we guard against n not being an integer number * of <dim> internally rather than in the upper
+ layer (called only by * floor0) */
+int32_t vorbis_book_decodev_set(codebook_t *book, int32_t *a, int32_t n, int32_t point) {
+    if(book->used_entries > 0) {
+        int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
+        int32_t      i, add, shiftM;
+
+        decode_map_prep(book, point, &add, &shiftM);
+        for(i = 0; i < n;) {
+            if(decode_map_entry(book, v, add, shiftM)) return -1;
+            for(uint8_t j = 0; i < n && j < book->dim; j++) a[i++] = v[j];
+        }
+    }
+    else {
+        int32_t i;
+
+        for(i = 0; i < n;) { a[i++] = 0; }
     }
 
     return 0;
@@ -2439,11 +2504,17 @@ eopbreak:
 int32_t vorbis_book_decodev_add(codebook_t *book, int32_t *a, int32_t n, int32_t point) {
     if(book->used_entries > 0) {
         int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
-        uint32_t i;
+        uint8_t  dim = book->dim;
+        int32_t  i, add, shiftM;
 
-        for(i = 0; i < n;) {
-            if(decode_map(book, v, point)) return -1;
-            for(uint8_t j = 0; i < n && j < book->dim; j++) a[i++] += v[j];
+        decode_map_prep(book, point, &add, &shiftM);
+        for(i = 0; i + dim <= n; i += dim) { /* whole vectors, no bounds test per value */
+            if(decode_map_entry(book, v, add, shiftM)) return -1;
+            for(uint8_t j = 0; j < dim; j++) a[i + j] += v[j];
+        }
+        if(i < n) { /* n not a multiple of dim, invalid stream */
+            if(decode_map_entry(book, v, add, shiftM)) return -1;
+            for(uint8_t j = 0; i < n; j++) a[i++] += v[j];
         }
     }
     return 0;
@@ -2455,10 +2526,11 @@ int32_t vorbis_book_decodevs_add(codebook_t *book, int32_t *a, int32_t n, int32_
     if(book->used_entries > 0) {
         int32_t      step = n / book->dim;
         int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
-        int32_t      j;
+        int32_t      j, add, shiftM;
 
+        decode_map_prep(book, point, &add, &shiftM);
         for(j = 0; j < step; j++) {
-            if(decode_map(book, v, point)) return -1;
+            if(decode_map_entry(book, v, add, shiftM)) return -1;
             for(uint8_t i = 0, o = j; i < book->dim; i++, o += step) a[o] += v[i];
         }
     }
@@ -2482,7 +2554,8 @@ int32_t floor0_inverse2(vorbis_info_floor_t *i, int32_t *lsp, int32_t *out) {
 }
 
 //---------------------------------------------------------------------------------------------------------------------
-int32_t floor1_inverse2(vorbis_info_floor_t *in, int32_t *fit_value, int32_t *out) {
+/* end: lines from end on are 0 (above the residue), they are not rendered */
+int32_t floor1_inverse2(vorbis_info_floor_t *in, int32_t *fit_value, int32_t *out, int32_t end) {
     vorbis_info_floor_t *info = (vorbis_info_floor_t *)in;
 
     int32_t               n = s_blocksizes[s_dsp_state->W] / 2;
@@ -2494,20 +2567,20 @@ int32_t floor1_inverse2(vorbis_info_floor_t *in, int32_t *fit_value, int32_t *ou
         int32_t lx = 0;
         int32_t ly = fit_value[0] * info->mult;
 
-        for(j = 1; j < info->posts; j++) {
+        for(j = 1; j < info->posts && lx < end; j++) {
             int32_t current = info->forward_index[j];
             int32_t hy = fit_value[current] & 0x7fff;
             if(hy == fit_value[current]) {
                 hy *= info->mult;
                 hx = info->postlist[current];
 
-                render_line(n, lx, hx, ly, hy, out);
+                render_line(end, lx, hx, ly, hy, out);
 
                 lx = hx;
                 ly = hy;
             }
         }
-        for(j = hx; j < n; j++) out[j] *= ly; /* be certain */
+        for(j = hx; j < end; j++) out[j] *= ly; /* be certain */
         return (1);
     }
     memset(out, 0, sizeof(*out) * n);
@@ -2527,6 +2600,11 @@ void render_line(int32_t n, int32_t x0, int32_t x1, int32_t y0, int32_t y1, int3
     if(n > x1) n = x1;
     ady -= abs(base * adx);
 
+    if(ady == 0) { /* flat line or an integer slope, the error term stays 0 */
+        for(; x < n; x++, y += base) d[x] = MULT31_SHIFT15(d[x], FLOOR_fromdB_LOOKUP[y]);
+        return;
+    }
+
     if(x < n){
         d[x] = MULT31_SHIFT15(d[x], FLOOR_fromdB_LOOKUP[y]);
     }
@@ -3150,12 +3228,13 @@ void mdct_step8(int32_t *x, int32_t n, int32_t step) {
 int32_t vorbis_book_decodevv_add(codebook_t *book, int32_t **a, int32_t offset, uint8_t ch, int32_t n, int32_t point) {
     if(book->used_entries > 0) {
         int32_t *v = (int32_t *)alloca(sizeof(*v) * book->dim);
-        int32_t  i;
+        int32_t  i, add, shiftM;
         uint8_t  chptr = 0;
         int32_t  m = offset + n;
 
+        decode_map_prep(book, point, &add, &shiftM);
         for(i = offset; i < m;) {
-            if(decode_map(book, v, point)) return -1;
+            if(decode_map_entry(book, v, add, shiftM)) return -1;
             for(uint8_t j = 0; i < m && j < book->dim; j++) {
                 a[chptr++][i] += v[j];
                 if(chptr == ch) {
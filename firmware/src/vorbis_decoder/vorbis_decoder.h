@@ -20,7 +20,7 @@
  * adapted for the ESP32 by schreibfaul1
  *
  *  Created on: 13.02.2023
- *  Updated on: 03.04.2024
+ *  Updated on: 18.10.2026
  */
 
 
@@ -46,6 +46,10 @@ using namespace std;
 #define OV_EBADLINK   -137
 #define OV_ENOSEEK    -138
 
+#ifndef VORBIS_FAST_BITS
+    #define VORBIS_FAST_BITS 7 // codewords up to this length are decoded with one table lookup, 0: tree walk only
+#endif
+
 #define INVSQ_LOOKUP_I_SHIFT 10
 #define INVSQ_LOOKUP_I_MASK  1023
 #define COS_LOOKUP_I_SHIFT   9
@@ -89,6 +93,9 @@ typedef struct _codebook{
     int32_t     q_bits;
     uint8_t q_pack;
     void   *q_val;
+    uint8_t   dec_fastbits;  /* index width of dec_fast, 0 = no table */
+    uint32_t *dec_fast;      /* [1 << dec_fastbits] decoded entry of the short codewords */
+    uint8_t  *dec_fastlen;   /* [1 << dec_fastbits] codeword length, 0: longer code, walk the tree */
 } codebook_t;
 
 typedef struct{
@@ -271,7 +278,7 @@ int32_t               res_inverse(vorbis_info_residue_t* info, int32_t** in, int
 int32_t               vorbis_book_decodev_add(codebook_t* book, int32_t* a, int32_t n, int32_t point);
 int32_t               vorbis_book_decodevs_add(codebook_t* book, int32_t* a, int32_t n, int32_t point);
 int32_t               floor0_inverse2(vorbis_info_floor_t* i, int32_t* lsp, int32_t* out);
-int32_t               floor1_inverse2(vorbis_info_floor_t* in, int32_t* fit_value, int32_t* out);
+int32_t               floor1_inverse2(vorbis_info_floor_t* in, int32_t* fit_value, int32_t* out, int32_t end);
 void                  render_line(int32_t n, int32_t x0, int32_t x1, int32_t y0, int32_t y1, int32_t* d);
 void                  vorbis_lsp_to_curve(int32_t* curve, int32_t n, int32_t ln, int32_t* lsp, int32_t m, int32_t amp, int32_t ampoffset, int32_t nyq);
 int32_t               toBARK(int32_t n);
@@ -309,6 +316,7 @@ int32_t  _determine_node_bytes(uint32_t used, uint8_t leafwidth);
 int32_t  _determine_leaf_words(int32_t nodeb, int32_t leafwidth);
 int32_t  _make_decode_table(codebook_t *s, char *lengthlist, uint8_t quantvals, int32_t maptype);
 int32_t  _make_words(char *l, uint16_t n, uint32_t *r, uint8_t quantvals, codebook_t *b, int32_t maptype);
+void     _make_fast_table(codebook_t *s);
 uint8_t  _book_maptype1_quantvals(codebook_t *b);
 void     vorbis_book_clear(codebook_t *b);
 int32_t *_vorbis_window(int32_t left);
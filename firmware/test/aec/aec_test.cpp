@@ -0,0 +1,81 @@
+// Runs the EchoCanceller on a far end / mic WAV pair the way the sketch does: the far end is pushed at its
+// own rate, --lead-ms ahead of the mic (the I2S DMA queue), the mic in AEC_FRAME blocks at AEC_SAMPLE_RATE.
+// Prints statsJson() once a second and the residual to --out. With --speech-from it is a check: no barge-in
+// before that time, one within 0.5s of it, and an ERLE of at least --min-erle before it.
+//   aec_test far.wav mic.wav [--lead-ms 150] [--speech-from 7.0] [--min-erle 20] [--out residual.wav]
+#include "EchoCanceller.h"
+#include "wav.h"
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s far.wav mic.wav [--lead-ms ms] [--speech-from s] [--min-erle dB] [--out wav]\n", argv[0]);
+    return 2;
+  }
+  int leadMs = 150;
+  double speechFrom = -1;
+  double minErle = 20;
+  const char* outPath = nullptr;
+  for (int i = 3; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--lead-ms")) leadMs = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "--speech-from")) speechFrom = atof(argv[i + 1]);
+    else if (!strcmp(argv[i], "--min-erle")) minErle = atof(argv[i + 1]);
+    else if (!strcmp(argv[i], "--out")) outPath = argv[i + 1];
+  }
+
+  Wav far, mic;
+  if (!wavRead(argv[1], far) || !wavRead(argv[2], mic)) {
+    fprintf(stderr, "cannot read %s or %s\n", argv[1], argv[2]);
+    return 2;
+  }
+  if (mic.rate != AEC_SAMPLE_RATE || mic.channels != 1) {
+    fprintf(stderr, "mic.wav has to be mono %dHz\n", AEC_SAMPLE_RATE);
+    return 2;
+  }
+
+  EchoCanceller aec;
+  if (!aec.begin()) return 2;
+  aec.reset();
+  Wav res = mic;
+  const size_t nf = far.frames();
+  const size_t lead = (size_t)far.rate * leadMs / 1000;
+  size_t pushed = 0;
+  double bargeIn = -1, falseAt = -1, erleBefore = 0;
+  for (size_t m = 0; m + AEC_FRAME <= mic.pcm.size(); m += AEC_FRAME) {
+    size_t want = (m + AEC_FRAME) * far.rate / AEC_SAMPLE_RATE + lead;
+    while (pushed < want && pushed < nf) {
+      uint16_t n = (uint16_t)min((size_t)512, nf - pushed);
+      aec.pushReference(&far.pcm[pushed * far.channels], n, far.channels, far.rate);
+      pushed += n;
+    }
+    aec.process(&res.pcm[m]);
+    double t = (double)m / AEC_SAMPLE_RATE;
+    if (aec.speechDetected()) {
+      if (speechFrom >= 0 && t < speechFrom) {
+        if (falseAt < 0) falseAt = t;
+      } else if (bargeIn < 0) {
+        bargeIn = t;
+      }
+    }
+    if (speechFrom < 0 || t < speechFrom) erleBefore = aec.erleDb();
+    if (m % AEC_SAMPLE_RATE == 0) printf("t=%4.1f %s\n", t, aec.statsJson().c_str());
+  }
+  if (outPath != nullptr) wavWrite(outPath, res);
+
+  printf("delay %d ms, erle %.1f dB, %u us per frame, barge-in at %.2f s\n", aec.delayMs(), erleBefore,
+         (unsigned)aec.frameUs(), bargeIn);
+  if (speechFrom < 0) return 0;
+  bool ok = true;
+  if (falseAt >= 0) {
+    printf("FAIL: speech detected at %.2f s, before %.2f s\n", falseAt, speechFrom);
+    ok = false;
+  }
+  if (bargeIn < 0 || bargeIn > speechFrom + 0.5) {
+    printf("FAIL: no barge-in within 0.5 s of %.2f s\n", speechFrom);
+    ok = false;
+  }
+  if (erleBefore < minErle) {
+    printf("FAIL: erle %.1f dB, less than %.1f dB\n", erleBefore, minErle);
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
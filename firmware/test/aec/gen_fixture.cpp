@@ -0,0 +1,79 @@
+// Writes the AEC fixture: far.wav, what the Audio library hands to I2S (24kHz stereo, bursts of shaped noise
+// with 300ms pauses), and mic.wav, what the mic hears at 16kHz: the far end through a short echo path 210ms
+// later, a DC offset, noise, and near-end speech from 7.0s to 8.5s. Deterministic, so the check in aec_test
+// has fixed expectations; real captures of the same two streams can be passed to aec_test instead.
+//   gen_fixture <dir>
+#include "EchoCanceller.h"
+#include "wav.h"
+#include <random>
+#include <string>
+
+#define FAR_RATE      24000
+#define SECONDS       12
+#define ECHO_DELAY_MS 210
+#define SPEECH_FROM   7.0
+#define SPEECH_TO     8.5
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <dir>\n", argv[0]);
+    return 2;
+  }
+  std::mt19937 rng(1);
+  std::normal_distribution<double> nd(0, 1);
+
+  Wav far;
+  far.rate = FAR_RATE;
+  far.channels = 2;
+  const int nf = FAR_RATE * SECONDS;
+  far.pcm.resize(nf * 2);
+  double lp = 0;
+  for (int i = 0; i < nf; i++) {
+    lp = 0.9 * lp + 0.3 * nd(rng);
+    double t = (double)i / FAR_RATE;
+    double env = fmod(t, 2.0) > 1.7 ? 0 : 0.5 + 0.5 * sin(2 * M_PI * 3 * t);
+    double v = constrain(18000 * env * lp, -32000.0, 32000.0);
+    far.pcm[2 * i] = far.pcm[2 * i + 1] = (int16_t)v;
+  }
+
+  // the echo is the far end at the mic rate, through the same resampler the canceller uses
+  const int nm = AEC_SAMPLE_RATE * SECONDS;
+  std::vector<int16_t> mono(nf), far16(nm + 1024);
+  for (int i = 0; i < nf; i++) mono[i] = far.pcm[2 * i];
+  Resampler src;
+  src.init(FAR_RATE, AEC_SAMPLE_RATE, 1, SRC_QUALITY_LOW);
+  int used = 0, made = 0;
+  while (used < nf && made < nm) {
+    uint16_t consumed = 0;
+    made += src.process(&mono[used], min(512, nf - used), &far16[made], 1024, &consumed);
+    used += consumed;
+  }
+
+  Wav mic;
+  mic.rate = AEC_SAMPLE_RATE;
+  mic.channels = 1;
+  mic.pcm.resize(nm);
+  const int d = AEC_SAMPLE_RATE * ECHO_DELAY_MS / 1000;
+  const double ir[5] = {0.25, 0.12, -0.08, 0.05, 0.02};   // every 3rd sample
+  double lp2 = 0;
+  for (int i = 0; i < nm; i++) {
+    double v = 200 + nd(rng) * 20;
+    for (int k = 0; k < 5; k++) {
+      int j = i - d - k * 3;
+      if (j >= 0) v += ir[k] * far16[j];
+    }
+    double t = (double)i / AEC_SAMPLE_RATE;
+    if (t > SPEECH_FROM && t < SPEECH_TO) {
+      lp2 = 0.5 * lp2 + 0.5 * nd(rng);
+      v += 2500 * lp2 * (0.6 + 0.4 * sin(2 * M_PI * 4 * t));
+    }
+    mic.pcm[i] = (int16_t)constrain(v, -32768.0, 32767.0);
+  }
+
+  std::string dir = argv[1];
+  if (!wavWrite((dir + "/far.wav").c_str(), far) || !wavWrite((dir + "/mic.wav").c_str(), mic)) {
+    fprintf(stderr, "cannot write to %s\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
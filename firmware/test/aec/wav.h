@@ -0,0 +1,74 @@
+// 16 bit PCM WAV files for the AEC harness, just the canonical 44 byte header.
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+struct Wav {
+  uint32_t rate = 0;
+  uint16_t channels = 0;
+  std::vector<int16_t> pcm;              // interleaved
+  size_t frames() const { return channels ? pcm.size() / channels : 0; }
+};
+
+static inline void wavPut32(FILE* f, uint32_t v) { fwrite(&v, 4, 1, f); }
+static inline void wavPut16(FILE* f, uint16_t v) { fwrite(&v, 2, 1, f); }
+
+inline bool wavWrite(const char* path, const Wav& w) {
+  FILE* f = fopen(path, "wb");
+  if (f == nullptr) return false;
+  uint32_t bytes = (uint32_t)(w.pcm.size() * 2);
+  fwrite("RIFF", 1, 4, f);
+  wavPut32(f, 36 + bytes);
+  fwrite("WAVEfmt ", 1, 8, f);
+  wavPut32(f, 16);
+  wavPut16(f, 1);
+  wavPut16(f, w.channels);
+  wavPut32(f, w.rate);
+  wavPut32(f, w.rate * w.channels * 2);
+  wavPut16(f, w.channels * 2);
+  wavPut16(f, 16);
+  fwrite("data", 1, 4, f);
+  wavPut32(f, bytes);
+  fwrite(w.pcm.data(), 2, w.pcm.size(), f);
+  return fclose(f) == 0;
+}
+
+// walks the chunks, so files from other tools with LIST chunks etc. load too
+inline bool wavRead(const char* path, Wav& w) {
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) return false;
+  char id[4];
+  uint32_t size;
+  bool fmt = false, ok = false;
+  if (fread(id, 1, 4, f) != 4 || memcmp(id, "RIFF", 4) != 0 || fread(&size, 4, 1, f) != 1 ||
+      fread(id, 1, 4, f) != 4 || memcmp(id, "WAVE", 4) != 0) {
+    fclose(f);
+    return false;
+  }
+  while (fread(id, 1, 4, f) == 4 && fread(&size, 4, 1, f) == 1) {
+    if (memcmp(id, "fmt ", 4) == 0 && size >= 16) {
+      uint16_t format, bits;
+      uint32_t byteRate;
+      uint16_t align;
+      fread(&format, 2, 1, f);
+      fread(&w.channels, 2, 1, f);
+      fread(&w.rate, 4, 1, f);
+      fread(&byteRate, 4, 1, f);
+      fread(&align, 2, 1, f);
+      fread(&bits, 2, 1, f);
+      if (format != 1 || bits != 16 || w.channels == 0) break;
+      fseek(f, size - 16, SEEK_CUR);
+      fmt = true;
+    } else if (memcmp(id, "data", 4) == 0 && fmt) {
+      w.pcm.resize(size / 2);
+      ok = fread(w.pcm.data(), 2, w.pcm.size(), f) == w.pcm.size();
+      break;
+    } else {
+      fseek(f, size + (size & 1), SEEK_CUR);
+    }
+  }
+  fclose(f);
+  return ok;
+}
@@ -0,0 +1,85 @@
+// Bit-exactness of the CELT vector kernels (CELT_SIMD in celt.h).
+// Random input goes through celt_inner_prod(), dual_inner_prod(), comb_filter_const() (in place and out of
+// place), denormalise_bands() and clt_mdct_backward(); all results are hashed (FNV-1a). The scalar build
+// (-DCELT_NO_SIMD) and the SIMD build have to print the hash of the original scalar code below. See ../Makefile.
+#include "opus_decoder/celt.h"
+
+static const uint64_t EXPECTED = 0xe68512fa13fb257full;  // hash of the scalar code before the kernels
+static const int ITERATIONS = 200000;
+
+void comb_filter_const(int32_t* y, int32_t* x, int32_t T, int32_t N, int16_t g10, int16_t g11, int16_t g12);
+void denormalise_bands(const int16_t* X, int32_t* freq, const int16_t* bandLogE, int32_t end, int32_t M, int32_t silence);
+void clt_mdct_backward(int32_t* in, int32_t* out, int32_t overlap, int32_t shift, int32_t stride);
+bool CELTDecoder_AllocateBuffers(void);
+
+static uint32_t rs = 12345;
+static uint32_t rnd() {
+  rs ^= rs << 13;
+  rs ^= rs >> 17;
+  rs ^= rs << 5;
+  return rs;
+}
+
+static uint64_t h = 1469598103934665603ull;
+static void mix(uint32_t v) {
+  h ^= v;
+  h *= 1099511628211ull;
+}
+
+int main() {
+  if (!CELTDecoder_AllocateBuffers()) return 2;
+  static int16_t a[1024], b[1024], c[1024];
+  static int32_t buf[4096], buf2[4096];
+  for (int it = 0; it < ITERATIONS; it++) {
+    int N = rnd() % 200;
+    int sh = rnd() % 16;
+    for (int i = 0; i < N; i++) {
+      a[i] = (int16_t)rnd() >> (sh & 7);
+      b[i] = (int16_t)rnd() >> (sh >> 1);
+      c[i] = (int16_t)rnd();
+    }
+    mix(celt_inner_prod(a, b, N));
+    int32_t x1, x2;
+    dual_inner_prod(a, b, c, N, &x1, &x2);
+    mix(x1);
+    mix(x2);
+
+    int T = 15 + rnd() % 1000;
+    int M = rnd() % 960 + 1;
+    for (int i = 0; i < 2048 + 8; i++) buf[i] = (int32_t)(rnd() % 600000001) - 300000000;
+    memcpy(buf2, buf, sizeof(buf));
+    int16_t g10 = rnd(), g11 = rnd(), g12 = rnd();
+    if (rnd() & 1) comb_filter_const(buf + 1030, buf + 1030, T, M, g10, g11, g12);
+    else comb_filter_const(buf2 + 1030, buf + 1030, T, M, g10, g11, g12);
+    for (int i = 0; i < 2048; i++) {
+      mix(buf[i]);
+      mix(buf2[i]);
+    }
+
+    if (it % 10 == 0) {
+      static int16_t X[960], E[21];
+      static int32_t freq[960], out[960 + 120 + 64];
+      int LM = rnd() % 4;
+      int MM = 1 << LM;
+      for (int i = 0; i < 960; i++) X[i] = (int16_t)rnd() >> 2;
+      for (int i = 0; i < 21; i++) E[i] = (int16_t)(rnd() % 30000) - 15000;
+      denormalise_bands(X, freq, E, 21, MM, (rnd() % 16) == 0);
+      for (int i = 0; i < 120 * MM; i++) mix(freq[i]);
+      for (int i = 0; i < 120 * MM; i++) freq[i] >>= 4;
+      memset(out, 0, sizeof(out));
+      clt_mdct_backward(freq, out, 120, 3 - LM, 1);
+      for (int i = 0; i < 120 * MM + 120; i++) mix(out[i]);
+    }
+  }
+#ifdef CELT_SIMD
+  const char* path = "simd";
+#else
+  const char* path = "scalar";
+#endif
+  printf("celt kernels (%s): %016llx\n", path, (unsigned long long)h);
+  if (h != EXPECTED) {
+    printf("celt kernels (%s): expected %016llx\n", path, (unsigned long long)EXPECTED);
+    return 1;
+  }
+  return 0;
+}
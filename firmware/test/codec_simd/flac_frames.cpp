@@ -0,0 +1,345 @@
+// FLAC subframe decoding: the order-specialized LPC restore and the wide Rice reader in flac_decoder.cpp.
+// Native FLAC frames are built here from generated audio (silence, noise, sine mixes with wasted bits): verbatim,
+// constant, fixed order 0..4 and LPC order 1..32 subframes, Rice and Rice2 partitions with escapes and long
+// unary runs, all stereo modes, block sizes 16..4608, 16, 20 and 24 bit.
+// 16 bit: the output and the bytes consumed per FLACDecode() call are hashed (FNV-1a) and have to match the
+// hash of the decoder before the change. 20/24 bit streams were rejected before; their output has to be the
+// encoder's input rounded to 16 bit, sample by sample.
+//   build/flac_frames           check
+//   build/flac_frames --bench   us per 4608 sample stereo frame, see ../Makefile
+#include "flac_decoder/flac_decoder.h"
+#include <chrono>
+#include <vector>
+
+static const uint64_t EXPECTED = 0x7d18006038cca54cull;  // 16 bit, hash of the decoder before the change
+static const int FRAMES = 3000;           // per bit depth
+
+static uint32_t rs = 12345;
+static uint32_t rnd() {
+  rs ^= rs << 13;
+  rs ^= rs >> 17;
+  rs ^= rs << 5;
+  return rs;
+}
+static uint32_t rr(uint32_t n) { return rnd() % n; }
+
+static uint64_t h = 1469598103934665603ull;
+static void mix(uint32_t v) {
+  h ^= v;
+  h *= 1099511628211ull;
+}
+
+// FLAC packs bits MSB first
+struct BitWriter {
+  std::vector<uint8_t> out;
+  uint32_t acc = 0;
+  int n = 0;
+  void put(uint32_t v, int bits) {
+    for (int i = bits - 1; i >= 0; i--) {
+      acc = acc << 1 | ((v >> i) & 1);
+      if (++n == 8) {
+        out.push_back((uint8_t)acc);
+        acc = 0;
+        n = 0;
+      }
+    }
+  }
+  void putSigned(int64_t v, int bits) { put((uint32_t)v & (bits == 32 ? 0xffffffffu : (1u << bits) - 1), bits); }
+  void align() {
+    while (n) put(0, 1);
+  }
+};
+
+static int bitsFor(int64_t v) {
+  int b = 1;
+  while (v < -(1ll << (b - 1)) || v >= (1ll << (b - 1))) b++;
+  return b;
+}
+
+// ---------------- encoder ----------------
+
+static bool s_bench;  // loud stereo sine, LPC order 8, Rice2, no escapes or wasted bits
+
+// one subframe of sample size d
+static void subframe(BitWriter& w, int d, const std::vector<int64_t>& x) {
+  int bs = (int)x.size();
+  bool constant = true;
+  int64_t orv = 0;
+  for (int i = 0; i < bs; i++) {
+    if (x[i] != x[0]) constant = false;
+    orv |= x[i];
+  }
+  int wasted = 0;
+  if (!s_bench && rr(2))
+    while (wasted < 4 && orv && !(orv & (1ll << wasted))) wasted++;
+  std::vector<int64_t> y(bs);
+  for (int i = 0; i < bs; i++) y[i] = x[i] >> wasted;
+  d -= wasted;
+
+  int type, order = 0, shift = 0;
+  int64_t coef[32] = {0};
+  int kind = s_bench ? 9 : rr(10);
+  if (constant && rr(2)) type = 0;
+  else if (kind == 0) type = 1;  // verbatim
+  else if (kind < 4) {
+    order = rr(5);  // fixed
+    type = 8 + order;
+  } else {
+    order = s_bench ? 8 : 1 + (rr(4) == 0 ? rr(32) : rr(12));
+    type = 31 + order;
+  }
+  w.put(0, 1);
+  w.put(type, 6);
+  if (wasted) {  // flag, then wasted - 1 in unary
+    w.put(1, 1);
+    w.put(0, wasted - 1);
+    w.put(1, 1);
+  } else {
+    w.put(0, 1);
+  }
+  if (type == 0) {
+    w.putSigned(y[0], d);
+    return;
+  }
+  if (type == 1) {
+    for (int i = 0; i < bs; i++) w.putSigned(y[i], d);
+    return;
+  }
+  for (int i = 0; i < order; i++) w.putSigned(y[i], d);
+  if (type >= 32) {  // LPC: a fixed predictor of order 1..3 plus noise, quantized at 12..15 bit
+    static const int FIXED[3][3] = {{1}, {2, -1}, {3, -3, 1}};
+    int prec = 12 + rr(4), base = rr(3);
+    shift = rr(d > 17 ? 14 : 10);
+    int64_t lim = (1ll << (prec - 1)) - 1;
+    for (int i = 0; i < order; i++) {
+      int64_t c = (i <= base ? FIXED[base][i] * (1ll << shift) : 0) + (int64_t)rr(33) - 16;
+      coef[i] = std::max(-lim, std::min(lim, c));
+    }
+    w.put(prec - 1, 4);
+    w.put(shift, 5);
+    for (int i = 0; i < order; i++) w.putSigned(coef[i], prec);
+  } else {
+    static const int FIXED[5][4] = {{0}, {1}, {2, -1}, {3, -3, 1}, {4, -6, 4, -1}};
+    for (int i = 0; i < order; i++) coef[i] = FIXED[order][i];
+  }
+  std::vector<int64_t> res(bs);
+  for (int i = order; i < bs; i++) {
+    int64_t s = 0;
+    for (int j = 0; j < order; j++) s += y[i - 1 - j] * coef[j];
+    res[i] = y[i] - (s >> shift);
+  }
+
+  int method = s_bench ? 1 : rr(2);  // Rice, Rice2
+  int po = 0;                        // partition order
+  while (po < 8 && bs % (1 << (po + 1)) == 0 && (bs >> (po + 1)) > order && (s_bench ? po < 4 : rr(2))) po++;
+  w.put(method, 2);
+  w.put(po, 4);
+  int parts = 1 << po, ps = bs / parts, pbits = method ? 5 : 4, esc = method ? 31 : 15;
+  for (int p = 0; p < parts; p++) {
+    int first = p * ps + (p == 0 ? order : 0), end = (p + 1) * ps;
+    int nb = 1;
+    uint64_t mean = 0;
+    for (int j = first; j < end; j++) {
+      nb = std::max(nb, bitsFor(res[j]));
+      mean += res[j] < 0 ? -2 * res[j] - 1 : 2 * res[j];
+    }
+    if (end > first) mean /= end - first;
+    int par = 0;
+    while (par < esc - 1 && (1ull << (par + 1)) <= mean) par++;
+    if (!s_bench && rr(3) == 0 && par > 2) par -= 1 + rr(3);  // long unary runs
+    if ((!s_bench && rr(15) == 0) || nb > 31) {             // escape: plain nb bit values
+      w.put(esc, pbits);
+      w.put(nb, 5);
+      for (int j = first; j < end; j++) w.putSigned(res[j], nb);
+      continue;
+    }
+    w.put(par, pbits);
+    for (int j = first; j < end; j++) {
+      uint64_t v = res[j] < 0 ? -2 * res[j] - 1 : 2 * res[j];
+      for (uint64_t k = v >> par; k > 0; k--) w.put(0, 1);
+      w.put(1, 1);
+      if (par) w.put((uint32_t)(v & ((1ull << par) - 1)), par);
+    }
+  }
+}
+
+struct Frame {
+  std::vector<uint8_t> bytes;
+  std::vector<int64_t> left, right;
+  int channels;
+  uint32_t length;  // without the look-ahead padding
+};
+
+static Frame makeFrame(int bps, int bs, int channels, int assignment, int mode) {
+  Frame f;
+  f.channels = channels;
+  f.left.resize(bs);
+  f.right.resize(bs);
+  int64_t mx = (1ll << (bps - 1)) - 1;
+  int64_t amp = mx >> (s_bench ? 1 : rr(6));
+  int q = !s_bench && rr(4) == 0 ? rr(5) : 0;  // wasted bits
+  double ph = rr(1000), fr = 0.001 + rr(100) * 0.002;
+  for (int i = 0; i < bs; i++) {
+    int64_t a = 0, b = 0;
+    if (mode == 1) {
+      a = (int64_t)(rnd() % (2 * amp + 1)) - amp;
+      b = (int64_t)(rnd() % (2 * amp + 1)) - amp;
+    } else if (mode > 1) {
+      a = (int64_t)(amp * 0.9 * sin(ph + i * fr)) + (int64_t)rr(64) - 32;
+      b = (int64_t)(amp * 0.8 * sin(ph * 0.3 + i * fr * 1.3)) + (int64_t)rr(64) - 32;
+    }
+    a = std::max(-mx - 1, std::min(mx, a));
+    b = std::max(-mx - 1, std::min(mx, b));
+    f.left[i] = (a >> q) << q;
+    f.right[i] = (b >> q) << q;
+  }
+  BitWriter w;
+  w.put(0xFFF8, 16);  // sync, fixed blocksize
+  w.put(7, 4);        // block size: 16 bit field at the end of the header
+  w.put(9, 4);        // 44.1 kHz
+  w.put(assignment, 4);
+  w.put(bps == 24 ? 6 : bps == 20 ? 5 : 4, 3);
+  w.put(0, 1);
+  w.put(0, 8);  // frame number
+  w.put(bs - 1, 16);
+  w.put(0, 8);  // CRC-8, not checked
+  if (channels == 1) {
+    subframe(w, bps, f.left);
+  } else if (assignment == 1) {
+    subframe(w, bps, f.left);
+    subframe(w, bps, f.right);
+  } else {
+    std::vector<int64_t> side(bs), mid(bs);
+    for (int i = 0; i < bs; i++) {
+      side[i] = f.left[i] - f.right[i];
+      mid[i] = (f.left[i] + f.right[i]) >> 1;
+    }
+    if (assignment == 8) {  // left/side
+      subframe(w, bps, f.left);
+      subframe(w, bps + 1, side);
+    } else if (assignment == 9) {  // side/right
+      subframe(w, bps + 1, side);
+      subframe(w, bps, f.right);
+    } else {  // mid/side
+      subframe(w, bps, mid);
+      subframe(w, bps + 1, side);
+    }
+  }
+  w.align();
+  w.put(0, 16);  // CRC-16, not checked
+  f.length = (uint32_t)w.out.size();
+  f.bytes = w.out;
+  f.bytes.resize(f.length + MAX_BLOCKSIZE + 1024, 0);  // FLACDecodeNative() wants MAX_BLOCKSIZE bytes ahead
+  return f;
+}
+
+// ---------------- decode ----------------
+
+static int16_t pcm[4096 * 2];
+
+// the sample FLACDecode() has to write for an encoder sample
+static int32_t expected(int64_t e, int bps) {
+  if (bps <= 16) return (int32_t)e;
+  int sh = bps - 16;
+  return (int32_t)std::max<int64_t>(-32768, std::min<int64_t>(32767, (e + (1 << (sh - 1))) >> sh));
+}
+
+// decodes one frame, returns the number of wrong samples, -1 on an error
+static long decode(Frame& f, int bps, bool hash) {
+  FLACDecoderReset();
+  FLACSetRawBlockParams(f.channels, 44100, bps, 0, 0);
+  uint8_t* in = f.bytes.data();
+  int32_t left = (int32_t)f.bytes.size();
+  long wrong = 0;
+  uint32_t pos = 0;
+  for (int calls = 0; calls < 100; calls++) {
+    int32_t before = left;
+    int ret = FLACDecode(in, &left, pcm);
+    in += before - left;
+    if (ret < 0) {
+      printf("flac frames: decode error %d\n", ret);
+      return -1;
+    }
+    uint32_t n = FLACGetOutputSamps() / f.channels;  // frames; the output is interleaved in pairs, mono too
+    if (hash) {
+      mix(before - left);
+      mix(ret);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+      for (int c = 0; c < f.channels; c++) {
+        int16_t v = pcm[2 * i + c];
+        if (hash) mix((uint16_t)v);
+        if (v != expected((c ? f.right : f.left)[pos + i], bps)) wrong++;
+      }
+    }
+    pos += n;
+    if (ret == 0) break;  // the frame is out
+  }
+  if ((uint32_t)(in - f.bytes.data()) != f.length) {
+    printf("flac frames: %ld of %u bytes consumed\n", (long)(in - f.bytes.data()), f.length);
+    return -1;
+  }
+  return wrong + (pos != f.left.size());
+}
+
+// a random frame; 24 bit noise can come out larger than the 16 KiB read-ahead, such frames are made again
+static Frame randomFrame(int bps) {
+  for (;;) {
+    int channels = rr(5) == 0 ? 1 : 2;
+    int assignment = channels == 1 ? 0 : rr(2) ? 1 : 8 + rr(3);
+    int bs = rr(10) == 0 ? 4608 : 16 * (1 + rr(255));
+    Frame f = makeFrame(bps, bs, channels, assignment, rr(6));
+    if (f.length <= 16000) return f;
+  }
+}
+
+static int check() {
+  static const int BPS[] = {16, 20, 24};
+  for (int bps : BPS) {
+    for (int i = 0; i < FRAMES; i++) {
+      Frame f = randomFrame(bps);
+      long wrong = decode(f, bps, bps == 16);
+      if (wrong < 0) return 1;
+      if (wrong) {
+        printf("flac frames: %d bit frame %d: %ld samples differ from the encoder input\n", bps, i, wrong);
+        return 1;
+      }
+    }
+    if (bps != 16) continue;
+    printf("flac frames (16 bit): %016llx\n", (unsigned long long)h);
+    if (h != EXPECTED) {
+      printf("flac frames (16 bit): expected %016llx\n", (unsigned long long)EXPECTED);
+      return 1;
+    }
+  }
+  printf("flac frames (20/24 bit): ok\n");
+  return 0;
+}
+
+static int bench() {
+  s_bench = true;
+  printf("%-26s %12s\n", "frame", "us/frame");
+  static const int BPS[] = {16, 24};
+  for (int bps : BPS) {
+    std::vector<Frame> frames;
+    for (int i = 0; i < 50; i++) frames.push_back(makeFrame(bps, 4608, 2, 10, 2));
+    double best = 1e30;
+    for (int rep = 0; rep < 20; rep++) {  // fastest run, the host is noisy
+      auto t0 = std::chrono::steady_clock::now();
+      for (Frame& f : frames)
+        if (decode(f, bps, false) != 0) return 1;
+      double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+      best = std::min(best, us / frames.size());
+    }
+    char name[40];
+    snprintf(name, sizeof(name), "%d bit stereo LPC 8", bps);
+    printf("%-26s %12.2f\n", name, best);
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (!FLACDecoder_AllocateBuffers()) return 2;
+  bool timing = argc > 1 && strcmp(argv[1], "--bench") == 0;
+  return timing ? bench() : check();
+}
@@ -0,0 +1,47 @@
+// Bit-exactness of the MP3 Huffman fast path (the peek tables of DecodeHuffmanPairs/DecodeHuffmanQuads).
+// Random bitstreams, half of them biased towards zero bits (small values, long runs), over every table, bit
+// offset and length go through both decoders; the values and the returned bit counts are hashed (FNV-1a).
+// The hash has to match the one of the table walk before the fast path. See ../Makefile.
+// The decoder is compiled into this unit, as in mp3_polyphase.cpp.
+#include "mp3_decoder/mp3_decoder.cpp"
+#include <random>
+
+static const uint64_t EXPECTED = 0x51039e8eaf1487dbull;  // hash of the decoder before the fast path
+static const int ITERATIONS = 3000000;
+
+int main() {
+  if (!MP3Decoder_AllocateBuffers()) return 2;
+  std::mt19937 rng(1234);
+  uint8_t buf[600];
+  int32_t out[600];
+  uint64_t h = 1469598103934665603ull;
+  auto mix = [&](uint64_t v) {
+    h ^= v;
+    h *= 1099511628211ull;
+  };
+  for (int it = 0; it < ITERATIONS; it++) {
+    for (auto& b : buf) b = rng();
+    if (it & 1)
+      for (auto& b : buf) b &= rng();
+    int off = rng() % 8;
+    int bits = rng() % 2000;
+    memset(out, 0x55, sizeof(out));
+    if (rng() % 5) {
+      int tab = rng() % 32;
+      int n = (rng() % 288) * 2;
+      mix(DecodeHuffmanPairs(out, n, tab, bits, buf, off));
+      for (int i = 0; i < n; i++) mix(out[i]);
+    } else {
+      int tab = rng() % 2;
+      int n = rng() % 576;
+      mix(DecodeHuffmanQuads(out, n, tab, bits, buf, off));
+      for (int i = 0; i < n + 4 && i < 600; i++) mix(out[i]);   // quads may write up to 3 past n
+    }
+  }
+  printf("mp3 huffman: %016llx\n", (unsigned long long)h);
+  if (h != EXPECTED) {
+    printf("mp3 huffman: expected %016llx\n", (unsigned long long)EXPECTED);
+    return 1;
+  }
+  return 0;
+}
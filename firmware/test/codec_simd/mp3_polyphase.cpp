@@ -0,0 +1,73 @@
+// Bit-exactness of the MP3 polyphase synthesis kernels (MP3_SIMD in mp3_decoder.h).
+// Random vbuf and coefficient sets (the real polyCoef table on every other run) go through
+// PolyphaseMono() and PolyphaseStereo(); the PCM is hashed (FNV-1a). The scalar build (-DMP3_NO_SIMD)
+// and the SIMD build (-msse4.1, or NEON on arm) have to print the same hash, and both have to match the
+// hash of the original scalar code below. See ../Makefile.
+// The decoder is compiled into this unit: polyCoef is a const table with internal linkage.
+// --bench times the kernels instead, in ns per MP3 frame (36 calls, 1152 samples per channel); run it on the
+// scalar and the SIMD build to compare. IMDCT36, IMDCT12x3 and FDCT32 have no vector kernels and are not timed.
+#include "mp3_decoder/mp3_decoder.cpp"
+#include <chrono>
+#include <random>
+
+static const uint64_t EXPECTED = 0xf70d74eba08f1dacull;  // hash of the scalar code before the kernels
+static const int ITERATIONS = 200000;
+
+#ifdef MP3_SIMD
+static const char* path = "simd";
+#else
+static const char* path = "scalar";
+#endif
+
+static int bench() {
+  std::mt19937 rng(7);
+  static int32_t vbuf[m_VBUF_LENGTH * 2];
+  int16_t pcm[64];
+  for (auto& v : vbuf) v = (int32_t)rng() >> 4;
+  const int frames = 2000;
+  volatile int16_t sink = 0;
+  for (int stereo = 0; stereo < 2; stereo++) {
+    double best = 1e30;
+    for (int rep = 0; rep < 100; rep++) {  // the fastest run, the others were interrupted
+      auto t0 = std::chrono::steady_clock::now();
+      for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < 36; i++) {
+          int32_t* v = vbuf + (i & 7) + m_VBUF_LENGTH * (i & 1);  // vindex and the odd/even half, as in the decoder
+          if (stereo) PolyphaseStereo(pcm, v, polyCoef);
+          else PolyphaseMono(pcm, v, polyCoef);
+          sink += pcm[i & 63];
+        }
+      }
+      double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / frames;
+      best = std::min(best, ns);
+    }
+    printf("mp3 polyphase (%s): %-6s %8.0f ns/frame\n", path, stereo ? "stereo" : "mono", best);
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) return bench();
+  std::mt19937 rng(7);
+  static int32_t vbuf[m_VBUF_LENGTH * 2];
+  uint32_t coef[264];
+  int16_t pcm[64];
+  uint64_t h = 1469598103934665603ull;
+  for (int it = 0; it < ITERATIONS; it++) {
+    int sh = rng() % 8;
+    for (auto& v : vbuf) v = (int32_t)rng() >> sh;
+    for (int i = 0; i < 264; i++) coef[i] = (it & 1) ? polyCoef[i] : rng();
+    if (it & 2) PolyphaseMono(pcm, vbuf, coef);
+    else PolyphaseStereo(pcm, vbuf, coef);
+    for (int i = 0; i < 64; i++) {
+      h ^= (uint16_t)pcm[i];
+      h *= 1099511628211ull;
+    }
+  }
+  printf("mp3 polyphase (%s): %016llx\n", path, (unsigned long long)h);
+  if (h != EXPECTED) {
+    printf("mp3 polyphase (%s): expected %016llx\n", path, (unsigned long long)EXPECTED);
+    return 1;
+  }
+  return 0;
+}
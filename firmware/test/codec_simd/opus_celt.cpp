@@ -0,0 +1,179 @@
+// CELT decode through OPUSDecode(), fed page by page the way Audio.cpp feeds it, so the vector kernels in celt.h
+// and celt.cpp run inside the whole decoder instead of on their own (celt_kernels.cpp).
+// The streams are Ogg Opus files built here: OpusHead, OpusTags, then pages of CELT-only packets of every
+// bandwidth and frame size, mono and stereo, code 0 and code 1 packing, at 32..192 kbit/s. There is no encoder
+// on the host, so the frames are random range coder payloads; any byte string is a valid CELT frame and decodes
+// through energy, allocation, PVQ, the postfilter and the IMDCT like music does. All output is hashed (FNV-1a)
+// and has to match the hash of the decoder before the kernels.
+//   build/opus_celt_simd           check
+//   build/opus_celt_simd --bench   us per decoded frame for a few stream types, see ../Makefile
+#include "opus_decoder/opus_decoder.h"
+#include "opus_decoder/celt.h"
+#include <chrono>
+#include <vector>
+
+static const uint64_t EXPECTED = 0x562c81e3563e9476ull;  // hash of the decoder before the kernels
+static const int STREAMS = 40;
+static const int PACKETS = 2000;  // per stream
+
+static uint32_t rs = 12345;
+static uint32_t rnd() {
+  rs ^= rs << 13;
+  rs ^= rs >> 17;
+  rs ^= rs << 5;
+  return rs;
+}
+
+static uint64_t h = 1469598103934665603ull;
+static void mix(uint32_t v) {
+  h ^= v;
+  h *= 1099511628211ull;
+}
+
+// ---------------- Ogg Opus writer ----------------
+
+struct OggWriter {
+  std::vector<uint8_t> out;
+  uint32_t seq = 0;
+  uint64_t granule = 0;
+
+  void page(const std::vector<std::vector<uint8_t>>& packets, uint8_t headerType) {
+    std::vector<uint8_t> lacing;
+    for (auto& p : packets) {
+      size_t n = p.size();
+      while (n >= 255) {
+        lacing.push_back(255);
+        n -= 255;
+      }
+      lacing.push_back((uint8_t)n);
+    }
+    const uint8_t head[] = {'O', 'g', 'g', 'S', 0, headerType};
+    out.insert(out.end(), head, head + sizeof(head));
+    for (int i = 0; i < 8; i++) out.push_back((uint8_t)(granule >> (8 * i)));
+    put32(0x4f505553);  // serial
+    put32(seq++);
+    put32(0);           // CRC, the decoder does not check it
+    out.push_back((uint8_t)lacing.size());
+    out.insert(out.end(), lacing.begin(), lacing.end());
+    for (auto& p : packets) out.insert(out.end(), p.begin(), p.end());
+  }
+  void put32(uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+  }
+};
+
+struct StreamType {
+  const char* name;
+  uint8_t channels;
+  int8_t config;    // TOC config, -1: random CELT config per packet
+  uint16_t kbps;    // 0: random
+};
+
+// a CELT-only Ogg Opus stream
+static std::vector<uint8_t> makeStream(const StreamType& t, int packets) {
+  OggWriter w;
+  std::vector<uint8_t> head = {'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1, t.channels, 0x38, 0x01,
+                               0x80, 0xbb, 0, 0, 0, 0, 0};
+  w.page({head}, 0x02);
+  std::vector<uint8_t> tags = {'O', 'p', 'u', 's', 'T', 'a', 'g', 's', 4, 0, 0, 0, 'h', 'o', 's', 't', 0, 0, 0, 0};
+  w.page({tags}, 0x00);
+
+  std::vector<std::vector<uint8_t>> page;
+  for (int i = 0; i < packets; i++) {
+    uint8_t config = t.config >= 0 ? t.config : 16 + rnd() % 16;
+    bool stereo = t.channels == 2 && (t.config >= 0 || rnd() % 8 != 0);
+    bool two = t.config < 0 && rnd() % 4 == 0;  // code 1: two frames of the same size
+    uint32_t us = 2500u << (config & 3);
+    uint32_t kbps = t.kbps ? t.kbps : 32 + rnd() % 161;
+    uint32_t bytes = std::max<uint32_t>(kbps * us / 8000, 8);
+    if (bytes > 1275) bytes = 1275;
+    std::vector<uint8_t> p;
+    p.push_back((uint8_t)(config << 3 | (stereo ? 4 : 0) | (two ? 1 : 0)));
+    for (uint32_t f = 0; f < (two ? 2u : 1u); f++) {
+      for (uint32_t b = 0; b < bytes; b++) p.push_back((uint8_t)rnd());
+    }
+    page.push_back(p);
+    w.granule += (two ? 2 : 1) * us * 48 / 1000;
+    if (page.size() == 25 || i + 1 == packets) {
+      w.page(page, i + 1 == packets ? 0x04 : 0x00);
+      page.clear();
+    }
+  }
+  return w.out;
+}
+
+// ---------------- decode ----------------
+
+static int16_t pcm[2 * 4 * 960];
+
+// decodes a whole stream, returns the number of audio frames, -1 on an error
+static int decode(std::vector<uint8_t>& stream, bool hash) {
+  OPUSsetDefaults();
+  OPUSDecoder_ClearBuffers();
+  uint8_t* p = stream.data();
+  int32_t left = (int32_t)stream.size();
+  int frames = 0;
+  while (left > 0) {
+    int32_t before = left;
+    int32_t ret = OPUSDecode(p, &left, pcm);
+    p += before - left;
+    if (ret < 0) {
+      printf("opus celt: decode error %d at byte %ld\n", (int)ret, (long)(p - stream.data()));
+      return -1;
+    }
+    if (ret != ERR_OPUS_NONE) continue;  // Ogg pages, headers, the second frame of a packet follows
+    uint16_t n = OPUSGetOutputSamps();
+    frames++;
+    if (!hash) continue;
+    mix(n);
+    for (uint32_t i = 0; i < 2u * n; i++) mix((uint16_t)pcm[i]);
+  }
+  return frames;
+}
+
+static int check() {
+  static const StreamType MIXED[] = {{"mixed mono", 1, -1, 0}, {"mixed stereo", 2, -1, 0}};
+  for (int s = 0; s < STREAMS; s++) {
+    std::vector<uint8_t> stream = makeStream(MIXED[s & 1], PACKETS);
+    if (decode(stream, true) <= 0) return 1;
+  }
+#ifdef CELT_SIMD
+  const char* path = "simd";
+#else
+  const char* path = "scalar";
+#endif
+  printf("opus celt (%s): %016llx\n", path, (unsigned long long)h);
+  if (h != EXPECTED) {
+    printf("opus celt (%s): expected %016llx\n", path, (unsigned long long)EXPECTED);
+    return 1;
+  }
+  return 0;
+}
+
+static int bench() {
+  static const StreamType TYPES[] = {
+    {"FB 20ms stereo 128k", 2, 31, 128}, {"FB 20ms mono 64k", 1, 31, 64}, {"FB 10ms stereo 128k", 2, 30, 128},
+    {"WB 20ms mono 32k", 1, 23, 32},
+  };
+#ifdef CELT_SIMD
+  printf("%-22s %12s   (simd)\n", "stream", "us/frame");
+#else
+  printf("%-22s %12s   (scalar)\n", "stream", "us/frame");
+#endif
+  for (const StreamType& t : TYPES) {
+    std::vector<uint8_t> stream = makeStream(t, 5000);
+    decode(stream, false);  // warm up
+    auto t0 = std::chrono::steady_clock::now();
+    int frames = 0;
+    for (int rep = 0; rep < 4; rep++) frames += decode(stream, false);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / frames;
+    printf("%-22s %12.2f\n", t.name, us);
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (!OPUSDecoder_AllocateBuffers()) return 2;
+  bool timing = argc > 1 && strcmp(argv[1], "--bench") == 0;
+  return timing ? bench() : check();
+}
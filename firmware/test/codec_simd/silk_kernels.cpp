@@ -0,0 +1,60 @@
+// Bit-exactness of the SILK synthesis kernels (SILK_SIMD in silk.h) and the order-specialized LPC filter.
+// 200k random SILK packets go through silk_Decode(): NB/MB/WB internal rate, mono and stereo, 10 and 20 ms,
+// upsampled to 48 kHz, so the LPC synthesis, the LTP filter and the IIR_FIR resampler all run. Any byte string is
+// a valid SILK frame for the range decoder. The PCM is hashed (FNV-1a); the scalar build (-DSILK_NO_SIMD) and the
+// SIMD build have to print the hash of the code before the kernels. See ../Makefile.
+#include "opus_decoder/celt.h"
+#include "opus_decoder/silk.h"
+
+static const uint64_t EXPECTED = 0x9c0a421e03a4cb24ull;  // hash of the scalar code before the kernels
+static const int PACKETS = 200000;
+
+static uint32_t rs = 12345;
+static uint32_t rnd() {
+  rs ^= rs << 13;
+  rs ^= rs >> 17;
+  rs ^= rs << 5;
+  return rs;
+}
+
+static uint64_t h = 1469598103934665603ull;
+static void mix(uint32_t v) {
+  h ^= v;
+  h *= 1099511628211ull;
+}
+
+int main() {
+  static int16_t out[2 * 48 * 120 + 64];
+  static uint8_t pkt[400];
+  static const uint32_t rates[3] = {8000, 12000, 16000};
+  int rate = 2, ch = 1, ms = 20;
+  if (silk_InitDecoder() != 0) return 2;
+  for (int it = 0; it < PACKETS; it++) {
+    if (it % 500 == 0) {  // a new stream every 500 packets
+      rate = (it / 500) % 3;
+      ch = 1 + ((it / 1500) & 1);
+      ms = ((it / 3000) & 1) ? 20 : 10;
+      silk_InitDecoder();
+    }
+    int len = 20 + rnd() % 300;
+    for (int i = 0; i < len; i++) pkt[i] = rnd();
+    ec_dec_init(pkt, len);
+    silk_setRawParams(ch, 2, ms, rates[rate], 48000);
+    int32_t n = 0;
+    int ret = silk_Decode(0, 1, out, &n);
+    mix(ret);
+    mix(n);
+    for (int i = 0; i < 2 * n; i++) mix((uint16_t)out[i]);
+  }
+#ifdef SILK_SIMD
+  const char* path = "simd";
+#else
+  const char* path = "scalar";
+#endif
+  printf("silk kernels (%s): %016llx\n", path, (unsigned long long)h);
+  if (h != EXPECTED) {
+    printf("silk kernels (%s): expected %016llx\n", path, (unsigned long long)EXPECTED);
+    return 1;
+  }
+  return 0;
+}
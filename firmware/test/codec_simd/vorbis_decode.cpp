@@ -0,0 +1,413 @@
+// Vorbis decode through VORBISDecode(), fed the way Audio.cpp feeds it: codebook lookup, residue, floor 1, the
+// inverse MDCT and the overlap-add all run inside the whole decoder.
+// There is no encoder on the host, so the streams are built here: an identification and a comment header, a
+// setup header in the shape libvorbis writes (floor 1, residue 2 with coupling, two block sizes, Huffman
+// codebooks with short codes for small values and lattice VQ books of dimension 2 and 4), then audio packets
+// with a valid packet header and a random payload. Any bit string decodes with complete codebooks. Runs of
+// 8 short blocks come between long ones, as at transients. All output is hashed (FNV-1a) and has to match the
+// hash of the decoder before the floor and codebook changes.
+//   build/vorbis_decode           check
+//   build/vorbis_decode --bench   frames per second for a few stream types, see ../Makefile
+#include "vorbis_decoder/vorbis_decoder.h"
+#include <chrono>
+#include <queue>
+#include <vector>
+
+static const uint64_t EXPECTED = 0x9db0b681313da02bull;  // hash of the decoder before the floor and codebook changes
+static const int STREAMS = 12;
+static const int PACKETS = 3000;  // per stream
+
+static uint32_t rs = 12345;
+static uint32_t rnd() {
+  rs ^= rs << 13;
+  rs ^= rs >> 17;
+  rs ^= rs << 5;
+  return rs;
+}
+
+static uint64_t h = 1469598103934665603ull;
+static void mix(uint32_t v) {
+  h ^= v;
+  h *= 1099511628211ull;
+}
+
+// Vorbis packs bits LSB first
+struct BitPacker {
+  std::vector<uint8_t> out;
+  uint32_t n = 0;
+  void put(uint32_t v, int bits) {
+    for (int i = 0; i < bits; i++, n++) {
+      if ((n & 7) == 0) out.push_back(0);
+      out.back() |= ((v >> i) & 1) << (n & 7);
+    }
+  }
+  void bytes(const char* s, int len) {
+    for (int i = 0; i < len; i++) put((uint8_t)s[i], 8);
+  }
+};
+
+// ---------------- setup header ----------------
+
+// Huffman code lengths for the weights, a complete code
+static std::vector<int> huffman(const std::vector<double>& w) {
+  int n = (int)w.size();
+  std::vector<int> parent(2 * n, -1);
+  std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<std::pair<double, int>>> q;
+  for (int i = 0; i < n; i++) q.push({w[i], i});
+  int next = n;
+  while (q.size() > 1) {
+    auto a = q.top();
+    q.pop();
+    auto b = q.top();
+    q.pop();
+    parent[a.second] = parent[b.second] = next;
+    q.push({a.first + b.first, next++});
+  }
+  std::vector<int> len(n);
+  for (int i = 0; i < n; i++)
+    for (int j = i; parent[j] >= 0; j = parent[j]) len[i]++;
+  return len;
+}
+
+static uint32_t vfloat(int v) {  // Vorbis float32 of an integer: sign, exponent 788 + 0, mantissa
+  return (v < 0 ? 0x80000000u : 0) | (788u << 21) | (uint32_t)abs(v);
+}
+
+static int bitsOf(uint32_t v) {
+  int r = 0;
+  for (; v; v >>= 1) r++;
+  return r;
+}
+
+// entry book (maptype 0), short codes for the low entries
+static void entryBook(BitPacker& w, int entries, double decay) {
+  std::vector<double> weight(entries);
+  for (int i = 0; i < entries; i++) weight[i] = pow(decay, i) + 1e-3;
+  std::vector<int> len = huffman(weight);
+  w.put(0x564342, 24);
+  w.put(1, 16);
+  w.put(entries, 24);
+  w.put(0, 1);  // unordered
+  w.put(0, 1);  // not sparse
+  for (int l : len) w.put(l - 1, 5);
+  w.put(0, 4);
+}
+
+// residue class book: dim classifications per entry, the quiet classes more likely
+static void classBook(BitPacker& w, int classes, int dim) {
+  int entries = 1;
+  for (int d = 0; d < dim; d++) entries *= classes;
+  std::vector<double> weight(entries);
+  for (int e = 0; e < entries; e++) {
+    weight[e] = 1;
+    for (int d = 0, v = e; d < dim; d++, v /= classes) weight[e] *= 1.0 / (1 + v % classes);
+  }
+  std::vector<int> len = huffman(weight);
+  w.put(0x564342, 24);
+  w.put(dim, 16);
+  w.put(entries, 24);
+  w.put(0, 2);
+  for (int l : len) w.put(l - 1, 5);
+  w.put(0, 4);
+}
+
+// lattice VQ book (maptype 1): quantvals values per dimension, centred on 0, times delta
+static void latticeBook(BitPacker& w, int dim, int quantvals, int delta, double spread) {
+  int entries = 1;
+  for (int d = 0; d < dim; d++) entries *= quantvals;
+  std::vector<double> weight(entries);
+  for (int e = 0; e < entries; e++) {
+    weight[e] = 1;
+    for (int d = 0, v = e; d < dim; d++, v /= quantvals) weight[e] *= exp(-spread * abs(v % quantvals - quantvals / 2));
+  }
+  std::vector<int> len = huffman(weight);
+  w.put(0x564342, 24);
+  w.put(dim, 16);
+  w.put(entries, 24);
+  w.put(0, 2);
+  for (int l : len) w.put(l - 1, 5);
+  w.put(1, 4);
+  w.put(vfloat(-(quantvals / 2) * delta), 32);
+  w.put(vfloat(delta), 32);
+  int bits = bitsOf(quantvals - 1);
+  w.put(bits - 1, 4);
+  w.put(0, 1);  // not sequential
+  for (int i = 0; i < quantvals; i++) w.put(i, bits);
+}
+
+enum {
+  B_FLOOR_CLASS3, B_FLOOR_CLASS2, B_FLOOR_Y8, B_FLOOR_Y32, B_FLOOR_Y128, B_RES_CLASS,
+  B_L4Q3, B_L2Q5, B_L2Q9, B_L2Q17, B_L2Q17X9, B_L2Q17X81, BOOKS
+};
+
+struct FloorClass {
+  int dim, subs, master, sub[4];  // sub -1: no book, the value is 0
+};
+static const FloorClass FLOOR_CLASSES[3] = {
+  {3, 1, B_FLOOR_CLASS3, {-1, B_FLOOR_Y32}},
+  {2, 2, B_FLOOR_CLASS2, {-1, B_FLOOR_Y8, B_FLOOR_Y32, B_FLOOR_Y128}},
+  {3, 0, 0, {B_FLOOR_Y32}},
+};
+
+// floor 1, multiplier 2, posts spread logarithmically and listed in random order
+static void floor1(BitPacker& w, const std::vector<int>& partClass, int rangebits) {
+  w.put(1, 16);
+  w.put(partClass.size(), 5);
+  int maxclass = 0, posts = 0;
+  for (int c : partClass) {
+    w.put(c, 4);
+    maxclass = std::max(maxclass, c);
+    posts += FLOOR_CLASSES[c].dim;
+  }
+  for (int c = 0; c <= maxclass; c++) {
+    const FloorClass& fc = FLOOR_CLASSES[c];
+    w.put(fc.dim - 1, 3);
+    w.put(fc.subs, 2);
+    if (fc.subs) w.put(fc.master, 8);
+    for (int k = 0; k < (1 << fc.subs); k++) w.put(fc.sub[k] + 1, 8);
+  }
+  w.put(1, 2);
+  w.put(rangebits, 4);
+  std::vector<int> x(posts);
+  int range = 1 << rangebits;
+  for (int k = 0, last = 1; k < posts; k++) {
+    x[k] = std::max(last + 1, (int)pow(range, (k + 1.0) / (posts + 1)));
+    last = x[k];
+  }
+  for (int k = posts - 1; k > 0; k--) std::swap(x[k], x[rnd() % (k + 1)]);
+  for (int v : x) w.put(v, rangebits);
+}
+
+// residue 2 with 8 classifications: 0 is silent, the louder ones cascade a coarse, a finer and a fine book
+static void residue2(BitPacker& w, int end, int grouping) {
+  static const int STAGES[8][3] = {
+    {-1, -1, -1}, {B_L4Q3, -1, -1}, {B_L2Q5, -1, -1}, {B_L2Q9, -1, -1},
+    {B_L2Q17, -1, -1}, {B_L2Q17X9, B_L2Q9, -1}, {B_L2Q17X9, B_L2Q9, B_L4Q3}, {B_L2Q17X81, B_L2Q17X9, B_L2Q9},
+  };
+  w.put(2, 16);
+  w.put(0, 24);
+  w.put(end, 24);
+  w.put(grouping - 1, 24);
+  w.put(8 - 1, 6);
+  w.put(B_RES_CLASS, 8);
+  for (auto& s : STAGES) {
+    int mask = 0;
+    for (int k = 0; k < 3; k++)
+      if (s[k] >= 0) mask |= 1 << k;
+    w.put(mask, 3);
+    w.put(0, 1);
+  }
+  for (auto& s : STAGES)
+    for (int k = 0; k < 3; k++)
+      if (s[k] >= 0) w.put(s[k], 8);
+}
+
+static void mapping(BitPacker& w, int channels, int floorNr, int residueNr) {
+  w.put(0, 16);
+  w.put(0, 1);  // one submap
+  if (channels == 2) {
+    w.put(1, 1);
+    w.put(0, 8);  // one coupling step: magnitude 0, angle 1
+    w.put(0, 1);
+    w.put(1, 1);
+  } else {
+    w.put(0, 1);
+  }
+  w.put(0, 2);
+  w.put(0, 8);
+  w.put(floorNr, 8);
+  w.put(residueNr, 8);
+}
+
+static std::vector<uint8_t> setupHeader(int channels) {
+  BitPacker w;
+  w.bytes("\x05vorbis", 7);
+  w.put(BOOKS - 1, 8);
+  entryBook(w, 8, 0.6);     // B_FLOOR_CLASS3
+  entryBook(w, 16, 0.7);    // B_FLOOR_CLASS2
+  entryBook(w, 8, 0.6);     // B_FLOOR_Y8
+  entryBook(w, 32, 0.85);   // B_FLOOR_Y32
+  entryBook(w, 128, 0.95);  // B_FLOOR_Y128
+  classBook(w, 8, 2);       // B_RES_CLASS
+  latticeBook(w, 4, 3, 1, 1.2);
+  latticeBook(w, 2, 5, 1, 0.8);
+  latticeBook(w, 2, 9, 1, 0.5);
+  latticeBook(w, 2, 17, 1, 0.3);
+  latticeBook(w, 2, 17, 9, 0.4);
+  latticeBook(w, 2, 17, 81, 0.6);
+  w.put(0, 6);  // time domain transforms, unused
+  w.put(0, 16);
+  w.put(2 - 1, 6);
+  floor1(w, {2, 0, 1}, 7);                                 // short blocks, 128 lines
+  floor1(w, {2, 0, 0, 1, 0, 1, 0, 1, 0, 1, 1, 1}, 10);     // long blocks, 1024 lines
+  w.put(2 - 1, 6);
+  residue2(w, 128 * channels, 16);
+  residue2(w, 832 * channels, 32);  // to 18 kHz at 44.1 kHz
+  w.put(2 - 1, 6);
+  mapping(w, channels, 0, 0);
+  mapping(w, channels, 1, 1);
+  w.put(2 - 1, 6);
+  for (int m = 0; m < 2; m++) {
+    w.put(m, 1);  // blockflag
+    w.put(0, 16);
+    w.put(0, 16);
+    w.put(m, 8);  // mapping
+  }
+  w.put(1, 1);  // framing
+  return w.out;
+}
+
+// ---------------- Ogg Vorbis writer ----------------
+
+struct OggWriter {
+  std::vector<uint8_t> out;
+  uint32_t seq = 0;
+  uint64_t granule = 0;
+
+  void page(const std::vector<std::vector<uint8_t>>& packets, uint8_t headerType) {
+    std::vector<uint8_t> lacing;
+    for (auto& p : packets) {
+      size_t n = p.size();
+      while (n >= 255) {
+        lacing.push_back(255);
+        n -= 255;
+      }
+      lacing.push_back((uint8_t)n);
+    }
+    const uint8_t head[] = {'O', 'g', 'g', 'S', 0, headerType};
+    out.insert(out.end(), head, head + sizeof(head));
+    for (int i = 0; i < 8; i++) out.push_back((uint8_t)(granule >> (8 * i)));
+    put32(0x564f5242);  // serial
+    put32(seq++);
+    put32(0);           // CRC, the decoder does not check it
+    out.push_back((uint8_t)lacing.size());
+    out.insert(out.end(), lacing.begin(), lacing.end());
+    for (auto& p : packets) out.insert(out.end(), p.begin(), p.end());
+  }
+  void put32(uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+  }
+};
+
+struct StreamType {
+  const char* name;
+  uint8_t channels;
+  uint32_t rate;
+};
+
+static std::vector<uint8_t> makeStream(const StreamType& t, int packets) {
+  OggWriter w;
+  BitPacker id;
+  id.bytes("\x01vorbis", 7);
+  id.put(0, 32);
+  id.put(t.channels, 8);
+  id.put(t.rate, 32);
+  id.put(0, 32);
+  id.put(t.channels * 90000, 32);
+  id.put(0, 32);
+  id.put(8, 4);   // 256
+  id.put(11, 4);  // 2048
+  id.put(1, 8);
+  w.page({id.out}, 0x02);
+  BitPacker comment;
+  comment.bytes("\x03vorbis", 7);
+  comment.put(4, 32);
+  comment.bytes("host", 4);
+  comment.put(0, 32);
+  comment.put(1, 8);
+  w.page({comment.out, setupHeader(t.channels)}, 0x00);
+
+  std::vector<std::vector<uint8_t>> page;
+  // the payload decodes to about 90 kbit/s per channel at 44.1 kHz; the packets are a bit longer than the
+  // longest ones the decoder reads, so it never runs into the next packet
+  uint32_t longBytes = t.channels == 2 ? 900 : 500;
+  uint32_t shortBytes = t.channels == 2 ? 160 : 120;
+  for (int i = 0; i < packets; i++) {
+    auto isShort = [](int k) { return k % 48 >= 40; };  // 8 short blocks out of 48
+    bool shortBlock = isShort(i);
+    BitPacker p;
+    p.put(0, 1);  // audio
+    p.put(shortBlock ? 0 : 1, 1);
+    if (!shortBlock) {
+      p.put(i > 0 && !isShort(i - 1), 1);
+      p.put(!isShort(i + 1), 1);
+    }
+    p.put(1, 1);  // the first channel has a floor
+    while (p.out.size() < (shortBlock ? shortBytes : longBytes)) p.put(rnd() & 0xff, 8);
+    page.push_back(p.out);
+    w.granule += shortBlock ? 128 : 1024;
+    if (page.size() == 16 || i + 1 == packets) {
+      w.page(page, i + 1 == packets ? 0x04 : 0x00);
+      page.clear();
+    }
+  }
+  w.out.resize(w.out.size() + 4096);  // the bit reader looks ahead of a packet
+  return w.out;
+}
+
+// ---------------- decode ----------------
+
+static int16_t pcm[2 * 2048];
+
+// decodes a whole stream, returns the number of audio frames, -1 on an error
+static int decode(std::vector<uint8_t>& stream, bool hash) {
+  VORBISsetDefaults();
+  uint8_t* p = stream.data();
+  int32_t left = (int32_t)stream.size() - 4096;
+  int frames = 0;
+  while (left > 0) {
+    int32_t before = left;
+    int32_t ret = VORBISDecode(p, &left, pcm);
+    p += before - left;
+    if (ret < 0) {
+      printf("vorbis: decode error %d at byte %ld\n", (int)ret, (long)(p - stream.data()));
+      return -1;
+    }
+    if (ret == VORBIS_PARSE_OGG_DONE) continue;  // Ogg pages, headers
+    uint16_t n = VORBISGetOutputSamps();
+    if (n == 0) continue;
+    frames++;
+    if (!hash) continue;
+    mix(n);
+    for (uint32_t i = 0; i < (uint32_t)n * VORBISGetChannels(); i++) mix((uint16_t)pcm[i]);
+  }
+  return frames;
+}
+
+static int check() {
+  static const StreamType TYPES[] = {{"stereo", 2, 44100}, {"mono", 1, 44100}, {"stereo 48k", 2, 48000}};
+  for (int s = 0; s < STREAMS; s++) {
+    std::vector<uint8_t> stream = makeStream(TYPES[s % 3], PACKETS);
+    if (decode(stream, true) <= 0) return 1;
+  }
+  printf("vorbis decode: %016llx\n", (unsigned long long)h);
+  if (h != EXPECTED) {
+    printf("vorbis decode: expected %016llx\n", (unsigned long long)EXPECTED);
+    return 1;
+  }
+  return 0;
+}
+
+static int bench() {
+  static const StreamType TYPES[] = {{"44.1kHz stereo ~180k", 2, 44100}, {"44.1kHz mono ~90k", 1, 44100}};
+  printf("%-22s %12s %12s\n", "stream", "us/frame", "frames/s");
+  for (const StreamType& t : TYPES) {
+    std::vector<uint8_t> stream = makeStream(t, 4000);
+    double best = 1e30;
+    for (int rep = 0; rep < 10; rep++) {  // fastest run, the host is noisy
+      auto t0 = std::chrono::steady_clock::now();
+      int frames = decode(stream, false);
+      double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+      if (frames <= 0) return 1;
+      best = std::min(best, us / frames);
+    }
+    printf("%-22s %12.2f %12.0f\n", t.name, best, 1e6 / best);
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (!VORBISDecoder_AllocateBuffers()) return 2;
+  bool timing = argc > 1 && strcmp(argv[1], "--bench") == 0;
+  return timing ? bench() : check();
+}
@@ -0,0 +1,52 @@
+// Stand-in for the push source of the Audio library (connecttoPush/pushData/pushEnd) for elevenlabs_stream:
+// keeps what is pushed. Like the real one it takes what fits, reports a full buffer now and then, and takes
+// nothing once the song is stopped.
+#pragma once
+#include "Arduino.h"
+#include "SPIFFS.h"
+#include <vector>
+
+class Audio {
+  public:
+    std::vector<uint8_t> pushed;
+    int pushCalls = 0;
+    int stopAfterBytes = -1;    // the song stops by itself after this many bytes, -1: never
+    bool pushing = false;
+    bool ended = false;         // pushEnd() was called
+    bool stopped = false;       // stopSong() was called
+    unsigned long firstPushMs = 0;
+
+    void clear() {
+      pushed.clear();
+      pushCalls = 0;
+      stopAfterBytes = -1;
+      pushing = ended = stopped = false;
+      firstPushMs = 0;
+    }
+
+    bool connecttoPush(const char* format = "mp3") {
+      pushing = strcmp(format, "mp3") == 0;
+      ended = false;
+      return pushing;
+    }
+    size_t pushData(const uint8_t* data, size_t len) {
+      if (!pushing) return 0;
+      if (++pushCalls % 5 == 0) return 0;                  // full, the producer has to wait
+      if (stopAfterBytes >= 0 && (int)pushed.size() >= stopAfterBytes) {
+        pushing = false;                                   // e.g. stopped by the button
+        return 0;
+      }
+      if (pushed.empty()) firstPushMs = millis();
+      size_t n = len < 333 ? len : 333;
+      pushed.insert(pushed.end(), data, data + n);
+      return n;
+    }
+    void pushEnd() { ended = true; }
+    bool isRunning() { return pushing; }
+    uint32_t stopSong() {
+      stopped = true;
+      pushing = false;
+      return 0;
+    }
+    bool connecttoFS(fs::FS&, const char*, int32_t = -1) { return false; }
+};
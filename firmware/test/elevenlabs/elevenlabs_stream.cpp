@@ -0,0 +1,333 @@
+// ElevenLabsTTS stream-input mode against a mock of the /stream-input websocket on the loopback. The mock
+// answers every text message with scripted audio and alignment frames, the way the service does: base64 mp3
+// with escaped slashes, a message split over a continuation frame with a ping in between, isFinal after the
+// end of input. elevenlabs/Audio.h keeps what the client hands to pushData().
+// Cases: speak() of a multi-sentence reply, beginStream/streamText/endStream with audio arriving between two
+// pieces, an error message before any audio (HTTP fallback), playback stopped by the player, a cancelled job.
+#include "ElevenLabsTTS.h"
+#include "Audio.h"
+#include "HTTPClient.h"
+#include <mbedtls/base64.h>
+#include <poll.h>
+#include <functional>
+#include <thread>
+#include <vector>
+
+Audio audio;
+
+// ---------------- mock server ----------------
+
+struct Frame {
+  uint8_t opcode;
+  std::string payload;
+};
+
+class MockServer {
+  public:
+    std::string request;                    // the handshake the client sent
+    std::vector<Frame> frames;              // client frames, unmasked
+
+    MockServer() {
+      _listen = socket(AF_INET, SOCK_STREAM, 0);
+      int one = 1;
+      setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      sockaddr_in a = {};
+      a.sin_family = AF_INET;
+      a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      bind(_listen, (sockaddr*)&a, sizeof(a));
+      listen(_listen, 1);
+      socklen_t len = sizeof(a);
+      getsockname(_listen, (sockaddr*)&a, &len);
+      WiFiClient::redirectPort = ntohs(a.sin_port);
+    }
+    ~MockServer() { close(_listen); }
+
+    // serves one connection on a thread: handshake, then the script
+    void start(std::function<void(MockServer&)> script) {
+      request.clear();
+      frames.clear();
+      _thread = std::thread([this, script]() {
+        _fd = accept(_listen, nullptr, nullptr);
+        if (_fd < 0) return;
+        while (request.find("\r\n\r\n") == std::string::npos) {
+          char c;
+          if (!_recv((uint8_t*)&c, 1)) break;
+          request += c;
+        }
+        // the client does not check Sec-WebSocket-Accept
+        _send("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n\r\n");
+        script(*this);
+        close(_fd);
+      });
+    }
+    void join() {
+      if (_thread.joinable()) _thread.join();
+    }
+
+    // next client frame, false on close, timeout or a dropped connection
+    bool next(Frame& f) {
+      uint8_t h[2];
+      if (!_recv(h, 2)) return false;
+      uint64_t len = h[1] & 0x7F;
+      if (len >= 126) {
+        uint8_t ext[8];
+        size_t n = len == 126 ? 2 : 8;
+        if (!_recv(ext, n)) return false;
+        len = 0;
+        for (size_t i = 0; i < n; i++) len = len << 8 | ext[i];
+      }
+      uint8_t mask[4] = {0};
+      if ((h[1] & 0x80) && !_recv(mask, 4)) return false;
+      f.opcode = h[0] & 0x0F;
+      f.payload.resize(len);
+      if (len > 0 && !_recv((uint8_t*)&f.payload[0], len)) return false;
+      for (size_t i = 0; i < len; i++) f.payload[i] ^= mask[i & 3];
+      frames.push_back(f);
+      return f.opcode != 0x08;
+    }
+    // next text message, answering pings is the client's job, pongs are only recorded
+    bool nextText(std::string& text) {
+      Frame f;
+      while (next(f)) {
+        if (f.opcode == 0x01) {
+          text = f.payload;
+          return true;
+        }
+      }
+      return false;
+    }
+    void frame(uint8_t opcode, bool fin, const std::string& payload) {
+      std::string s;
+      s += (char)((fin ? 0x80 : 0) | opcode);
+      size_t n = payload.size();
+      if (n < 126) {
+        s += (char)n;
+      } else if (n <= 0xFFFF) {
+        s += (char)126;
+        s += (char)(n >> 8);
+        s += (char)n;
+      } else {
+        s += (char)127;
+        for (int i = 7; i >= 0; i--) s += (char)((uint64_t)n >> (8 * i));
+      }
+      _send(s + payload);
+    }
+
+  private:
+    int _listen = -1;
+    int _fd = -1;
+    std::thread _thread;
+
+    bool _recv(uint8_t* buf, size_t len) {
+      size_t got = 0;
+      while (got < len) {
+        pollfd p = {_fd, POLLIN, 0};
+        if (poll(&p, 1, 3000) <= 0) return false;
+        ssize_t r = recv(_fd, buf + got, len - got, 0);
+        if (r <= 0) return false;
+        got += r;
+      }
+      return true;
+    }
+    void _send(const std::string& s) { send(_fd, s.data(), s.size(), MSG_NOSIGNAL); }
+};
+
+// ---------------- scripted service ----------------
+
+static std::string base64(const std::vector<uint8_t>& v) {
+  std::vector<unsigned char> out(v.size() * 4 / 3 + 8);
+  size_t n = 0;
+  mbedtls_base64_encode(out.data(), out.size(), &n, v.data(), v.size());
+  return std::string((char*)out.data(), n);
+}
+
+// "text" of a client message, unescaped
+static std::string textOf(const std::string& msg) {
+  size_t i = msg.find("\"text\":\"");
+  if (i == std::string::npos) return "<none>";
+  std::string t;
+  for (i += 8; i < msg.size() && msg[i] != '"'; i++) {
+    if (msg[i] == '\\' && i + 1 < msg.size()) {
+      char c = msg[++i];
+      t += c == 'n' ? '\n' : c == 't' ? '\t' : c;
+    } else {
+      t += msg[i];
+    }
+  }
+  return t;
+}
+
+// the "mp3" the mock returns for a piece of text, a few KB that differ per piece
+static std::vector<uint8_t> audioFor(const std::string& text) {
+  uint32_t h = 2166136261u;
+  for (char c : text) h = (h ^ (uint8_t)c) * 16777619u;
+  std::vector<uint8_t> a(2000 + h % 3000);
+  for (auto& b : a) {
+    h = h * 1664525 + 1013904223;
+    b = h >> 24;
+  }
+  return a;
+}
+
+// an audio message for a piece, with the alignment the service sends along
+static std::string audioMessage(const std::string& text) {
+  std::string b64 = base64(audioFor(text));
+  std::string escaped;
+  for (char c : b64) escaped += c == '/' ? std::string("\\/") : std::string(1, c);
+  std::string chars;
+  for (char c : text) {
+    if (!chars.empty()) chars += ',';
+    chars += c == '"' ? "\"\\\"\"" : c == '\n' ? "\"\\n\"" : std::string("\"") + c + "\"";
+  }
+  return "{\"audio\":\"" + escaped + "\",\"isFinal\":null,\"normalizedAlignment\":{\"chars\":[" + chars +
+         "],\"charStartTimesMs\":[0]},\"alignment\":{\"chars\":[" + chars + "]}}";
+}
+
+// answers every piece with its audio, the first one split in two frames around a ping; isFinal after the end
+static void serveSpeech(MockServer& s) {
+  std::string msg;
+  bool first = true;
+  while (s.nextText(msg)) {
+    std::string text = textOf(msg);
+    if (text == " ") continue;                          // opens the stream
+    if (text.empty()) {                                 // end of input
+      s.frame(0x01, true, "{\"audio\":null,\"isFinal\":true}");
+      Frame f;
+      while (s.next(f)) {
+      }
+      return;
+    }
+    std::string m = audioMessage(text);
+    if (first) {
+      size_t cut = m.size() / 2;
+      s.frame(0x01, false, m.substr(0, cut));
+      s.frame(0x09, true, "ping!");
+      s.frame(0x00, true, m.substr(cut));
+      first = false;
+    } else {
+      s.frame(0x01, true, m);
+    }
+  }
+}
+
+static void serveError(MockServer& s) {
+  std::string msg;
+  s.nextText(msg);
+  s.frame(0x01, true, "{\"message\":\"Quota exceeded\",\"error\":\"quota_exceeded\",\"code\":1008}");
+  s.frame(0x08, true, "\x03\xf0");
+}
+
+// ---------------- checks ----------------
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("  %s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) failures++;
+}
+
+static std::vector<uint8_t> expectedAudio(const std::vector<std::string>& pieces) {
+  std::vector<uint8_t> all;
+  for (auto& p : pieces) {
+    std::vector<uint8_t> a = audioFor(p);
+    all.insert(all.end(), a.begin(), a.end());
+  }
+  return all;
+}
+
+// the pieces of text the client sent, without the opening " " and the closing ""
+static std::vector<std::string> pieces(const MockServer& s) {
+  std::vector<std::string> out;
+  for (auto& f : s.frames) {
+    if (f.opcode != 0x01) continue;
+    std::string t = textOf(f.payload);
+    if (t != " " && !t.empty()) out.push_back(t);
+  }
+  return out;
+}
+
+static bool sawFrame(const MockServer& s, uint8_t opcode, const char* payload = nullptr) {
+  for (auto& f : s.frames) {
+    if (f.opcode == opcode && (payload == nullptr || f.payload == payload)) return true;
+  }
+  return false;
+}
+
+static bool cancelAfterAudio(void*) { return !audio.pushed.empty(); }
+
+int main() {
+  MockServer server;
+  ElevenLabsTTS tts;
+  tts.setConfig("test-key", "voice1");
+
+  printf("speak(), a reply of several sentences\n");
+  const String reply = "Hello there. It is 3.5 degrees outside!\nSay \"cheese\" / smile? OK";
+  audio.clear();
+  server.start(serveSpeech);
+  bool ok = tts.speak(reply);
+  server.join();
+  std::vector<std::string> sent = pieces(server);
+  std::string joined;
+  for (auto& p : sent) joined += p;
+  check(ok, "speak() returns true");
+  check(server.request.find("GET /v1/text-to-speech/voice1/stream-input?model_id=eleven_flash_v2_5"
+                            "&output_format=mp3_22050_32 HTTP/1.1") == 0, "stream-input request line");
+  check(server.request.find("\r\nxi-api-key: test-key\r\n") != std::string::npos, "api key header");
+  check(!server.frames.empty() && server.frames[0].payload.find("chunk_length_schedule") != std::string::npos,
+        "first message opens the stream with a chunk schedule");
+  check(sent.size() >= 3 && joined == reply, "text goes up sentence by sentence, nothing lost");
+  check(audio.pushed == expectedAudio(sent), "every audio byte reaches pushData(), in order");
+  check(audio.ended, "pushEnd() after isFinal");
+  check(sawFrame(server, 0x0A, "ping!"), "ping answered with its payload");
+  check(sawFrame(server, 0x08), "socket closed by the client");
+
+  printf("beginStream/streamText/endStream, text arriving while audio plays\n");
+  audio.clear();
+  server.start(serveSpeech);
+  ok = tts.beginStream() && tts.streamText("The first part of a long answer. ");
+  delay(100);                                          // the LLM is still generating
+  ok = ok && tts.streamText("And the second part, ");
+  bool audioBeforeEnd = !audio.pushed.empty();
+  delay(100);
+  ok = ok && tts.streamText("which ends here.");
+  ok = ok && tts.endStream();
+  server.join();
+  sent = pieces(server);
+  check(ok, "all calls succeed");
+  check(sent.size() == 3, "each streamText() is one message");
+  check(audioBeforeEnd, "audio of the first part is pushed before the text is complete");
+  check(audio.pushed == expectedAudio(sent) && audio.ended, "all audio pushed, then pushEnd()");
+
+  printf("error message before any audio\n");
+  audio.clear();
+  HTTPClient::postCount = 0;
+  server.start(serveError);
+  ok = tts.speak("Hello.");
+  server.join();
+  check(!ok && audio.pushed.empty(), "speak() fails, nothing pushed");
+  check(HTTPClient::postCount == 1, "falls back to the HTTP endpoint");
+
+  printf("playback stopped by the player\n");
+  audio.clear();
+  audio.stopAfterBytes = 1000;
+  HTTPClient::postCount = 0;
+  server.start(serveSpeech);
+  ok = tts.speak("Stop me. Please stop me.");
+  server.join();
+  check(!ok, "speak() reports the stop");
+  check(audio.pushed.size() <= 1000 + 333 && !audio.ended, "no more audio, no pushEnd()");
+  check(HTTPClient::postCount == 0, "no HTTP retry once audio played");
+  check(sawFrame(server, 0x08), "the socket is closed");
+
+  printf("job cancelled while the audio comes in\n");
+  audio.clear();
+  HTTPClient::postCount = 0;
+  server.start(serveSpeech);
+  ok = tts.speak("Cancel me. Now.", cancelAfterAudio, nullptr);
+  server.join();
+  check(!ok && audio.stopped, "speak() fails and stops the song");
+  check(HTTPClient::postCount == 0, "no HTTP retry after a cancel");
+
+  printf(failures ? "elevenlabs stream: %d failed\n" : "elevenlabs stream: ok\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+// CborWriter against the encoding examples of RFC 8949 appendix A (every head length, negative integers,
+// single precision floats, text, nested maps and arrays) and its overflow handling; then the WebEventBus
+// policies: queued topics in order with the oldest dropped, coalesced topics sending only the latest value,
+// minimum intervals, binary frames, oversized payloads and resendLatest() for a new client.
+#include "WebEventBus.h"
+#include <functional>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("  %s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) failures++;
+}
+
+static std::string hex(const uint8_t* p, size_t n) {
+  std::string s;
+  char b[3];
+  for (size_t i = 0; i < n; i++) {
+    snprintf(b, sizeof(b), "%02x", p[i]);
+    s += b;
+  }
+  return s;
+}
+
+// the bytes one write produces
+static std::string cbor(const std::function<void(CborWriter&)>& write) {
+  uint8_t buf[64];
+  CborWriter w(buf, sizeof(buf));
+  write(w);
+  return w.ok() ? hex(w.data(), w.length()) : "overflow";
+}
+
+static void cborChecks() {
+  printf("cbor writer\n");
+  check(cbor([](CborWriter& w) { w.writeUInt(0); }) == "00", "0");
+  check(cbor([](CborWriter& w) { w.writeUInt(23); }) == "17", "23, the last inline argument");
+  check(cbor([](CborWriter& w) { w.writeUInt(24); }) == "1818", "24, one byte argument");
+  check(cbor([](CborWriter& w) { w.writeUInt(1000); }) == "1903e8", "1000, two bytes");
+  check(cbor([](CborWriter& w) { w.writeUInt(1000000); }) == "1a000f4240", "1000000, four bytes");
+  check(cbor([](CborWriter& w) { w.writeUInt(1000000000000ULL); }) == "1b000000e8d4a51000", "10^12, eight bytes");
+  check(cbor([](CborWriter& w) { w.writeUInt(UINT64_MAX); }) == "1bffffffffffffffff", "2^64 - 1");
+  check(cbor([](CborWriter& w) { w.writeInt(10); }) == "0a", "writeInt(10) is unsigned");
+  check(cbor([](CborWriter& w) { w.writeInt(-1); }) == "20", "-1");
+  check(cbor([](CborWriter& w) { w.writeInt(-100); }) == "3863", "-100");
+  check(cbor([](CborWriter& w) { w.writeInt(-1000); }) == "3903e7", "-1000");
+  check(cbor([](CborWriter& w) { w.writeInt(INT64_MIN); }) == "3b7fffffffffffffff", "-2^63");
+  check(cbor([](CborWriter& w) { w.writeFloat(100000.0f); }) == "fa47c35000", "100000.0");
+  check(cbor([](CborWriter& w) { w.writeFloat(-4.1f); }) == "fac0833333", "-4.1");
+  check(cbor([](CborWriter& w) { w.writeBool(false); w.writeBool(true); }) == "f4f5", "false, true");
+  check(cbor([](CborWriter& w) { w.writeText(""); }) == "60", "empty text");
+  check(cbor([](CborWriter& w) { w.writeText("IETF"); }) == "6449455446", "\"IETF\"");
+  check(cbor([](CborWriter& w) { w.writeText("\xc3\xbc"); }) == "62c3bc", "UTF-8 text, length in bytes");
+  check(cbor([](CborWriter& w) { w.writeText("abcdefghijklmnopqrstuvwxyz"); }).substr(0, 6) == "781a61",
+        "26 bytes of text, one byte length");
+  check(cbor([](CborWriter& w) {
+          w.writeMap(2);
+          w.writeText("a");
+          w.writeUInt(1);
+          w.writeText("b");
+          w.writeArray(2);
+          w.writeUInt(2);
+          w.writeUInt(3);
+        }) == "a26161016162820203",
+        "{\"a\": 1, \"b\": [2, 3]}");
+
+  uint8_t small[4];
+  CborWriter w(small, sizeof(small));
+  w.writeUInt(1000);
+  check(w.ok() && w.length() == 3, "a write that fits");
+  w.writeText("ab");
+  check(!w.ok() && w.length() == 4, "past the end: ok() false, the bytes that fit are kept");
+  w.writeBool(true);
+  check(!w.ok() && w.length() == 4, "nothing is written after an overflow");
+}
+
+// ---------------- bus ----------------
+
+struct Sent {
+  std::string payload;
+  bool binary;
+};
+
+// everything due at nowMs
+static std::vector<Sent> drain(WebEventBus& bus, uint32_t nowMs) {
+  static uint8_t* buf = nullptr;  // swapped with the bus buffers, as in WebControl
+  static size_t cap = 0;
+  std::vector<Sent> out;
+  size_t len;
+  bool binary;
+  while (bus.take(nowMs, &buf, &cap, &len, &binary)) out.push_back({std::string((char*)buf, len), binary});
+  return out;
+}
+
+static void busChecks() {
+  printf("event bus\n");
+  WebEventBus bus;
+  check(!bus.publish(WEB_EVENT_STATE, "{}"), "publish() before begin() fails");
+  check(bus.begin(), "begin()");
+  check(!bus.publish(WEB_EVENT_STATE, ""), "an empty payload is refused");
+  check(!bus.publish(WEB_EVENT_STATE, String(std::string(WEB_EVENT_MAX_PAYLOAD + 1, 'x'))),
+        "a payload over WEB_EVENT_MAX_PAYLOAD is refused");
+
+  uint32_t now = 100000;
+  for (int i = 0; i < 10; i++) bus.publish(WEB_EVENT_TRACE, String(("t" + std::to_string(i)).c_str()));
+  check(bus.dropped() == 2, "queue full: the two oldest are dropped");
+  bus.publish(WEB_EVENT_STATE, "s1");
+  bus.publish(WEB_EVENT_STATE, "s2");
+  bus.publish(WEB_EVENT_HEALTH, "h1");
+  const uint8_t vu[3] = {0xa1, 0x61, 0x6c};
+  bus.publishBinary(WEB_EVENT_VU, vu, sizeof(vu));
+
+  std::vector<Sent> sent = drain(bus, now);
+  std::string order;
+  for (const Sent& s : sent) order += (s.binary ? "<bin>" : s.payload) + " ";
+  check(order == "t2 t3 t4 t5 t6 t7 t8 t9 s2 h1 <bin> ", "queued first and in order, then the latest values");
+  check(sent.size() == 11 && sent[10].binary && sent[10].payload == std::string((const char*)vu, sizeof(vu)),
+        "the binary frame as published");
+
+  bus.publish(WEB_EVENT_HEALTH, "h2");
+  bus.publish(WEB_EVENT_VU, "v2");
+  check(drain(bus, now + 40).empty(), "health and vu wait for their intervals");
+  sent = drain(bus, now + 50);
+  check(sent.size() == 1 && sent[0].payload == "v2", "vu after 50ms");
+  sent = drain(bus, now + 1000);
+  check(sent.size() == 1 && sent[0].payload == "h2", "health after 1s");
+  check(drain(bus, now + 5000).empty(), "a value is sent once");
+
+  bus.resendLatest();
+  sent = drain(bus, now + 5001);
+  std::vector<std::string> values;
+  for (const Sent& s : sent) values.push_back(s.payload);
+  std::sort(values.begin(), values.end());  // round robin order, it starts after the topic sent last
+  check(values == std::vector<std::string>({"h2", "s2", "v2"}),
+        "resendLatest(): the latest value of every coalesced topic, at once");
+
+  bus.setPolicy(WEB_EVENT_TRACE, 100, false);
+  bus.publish(WEB_EVENT_TRACE, "a");
+  bus.publish(WEB_EVENT_TRACE, "b");
+  bus.publish(WEB_EVENT_STATE, "s3");
+  sent = drain(bus, now + 6000);
+  check(sent.size() == 2 && sent[0].payload == "a" && sent[1].payload == "s3",
+        "a queued topic held by its interval does not block the coalesced ones");
+  sent = drain(bus, now + 6100);
+  check(sent.size() == 1 && sent[0].payload == "b", "the next queued event after the interval");
+}
+
+int main() {
+  cborChecks();
+  busChecks();
+  printf(failures ? "web event bus: %d failed\n" : "web event bus: ok\n", failures);
+  return failures ? 1 : 0;
+}
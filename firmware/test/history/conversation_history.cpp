@@ -0,0 +1,131 @@
+// ConversationHistory token budgeting and the rolling summary. Cases: the fragments of the three wire formats
+// with JSON escaping, eviction of the oldest exchanges once the estimate (UTF-8 bytes / 4) is over the budget,
+// the newest exchange kept alone over it, setTokenBudget(), the summary request covering the evicted text,
+// exchanges evicted while the summary request runs, a failed or late summary, the summary cut and the
+// evicted text trimmed at a fragment boundary when summaries keep failing.
+#include "ConversationHistory.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("  %s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) failures++;
+}
+
+static bool contains(const String& s, const char* part) { return s.find(part) != std::string::npos; }
+
+static String repeat(char c, size_t n) { return String(std::string(n, c)); }
+
+static String fragments(const ConversationHistory& h) {
+  String out = "[";
+  h.appendFragments(out);
+  return out + "]";
+}
+
+static void formatChecks() {
+  printf("fragments\n");
+  String e;
+  ConversationHistory::appendJsonString(e, "a\"b\\c\n\r\t\x01 \xc3\xbc");
+  check(e == "\"a\\\"b\\\\c\\n\\r\\t\\u0001 \xc3\xbc\"", "escaping: quotes, backslash, controls, UTF-8 as is");
+
+  ConversationHistory openai(HISTORY_OPENAI);
+  String out = "x";
+  check(!openai.appendFragments(out) && out == "x", "empty: false, nothing appended");
+  openai.append("hi \"you\"", "hello");
+  openai.append("2", "two");
+  check(fragments(openai) ==
+          "[{\"role\":\"user\",\"content\":\"hi \\\"you\\\"\"},{\"role\":\"assistant\",\"content\":\"hello\"},"
+          "{\"role\":\"user\",\"content\":\"2\"},{\"role\":\"assistant\",\"content\":\"two\"}]",
+        "openai messages, comma separated");
+
+  ConversationHistory gemini(HISTORY_GEMINI);
+  gemini.append("q", "a");
+  check(fragments(gemini) ==
+          "[{\"role\":\"user\",\"parts\":[{\"text\":\"q\"}]},{\"role\":\"model\",\"parts\":[{\"text\":\"a\"}]}]",
+        "gemini contents");
+
+  ConversationHistory backend(HISTORY_BACKEND);
+  backend.append("q", "a");
+  check(fragments(backend) == "[{\"user\":\"q\",\"assistant\":\"a\"}]", "backend pairs");
+}
+
+static void budgetChecks() {
+  printf("token budget\n");
+  check(ConversationHistory::estimateTokens("") == 0 && ConversationHistory::estimateTokens("abcde") == 2 &&
+          ConversationHistory::estimateTokens("\xc3\xbc\xc3\xbc") == 1,
+        "estimate: UTF-8 bytes / 4, rounded up");
+
+  ConversationHistory h(HISTORY_BACKEND, 40);
+  h.append("first", repeat('a', 60));   // 2 + 15
+  h.append("second", repeat('b', 60));  // 2 + 15
+  check(h.size() == 2 && h.tokens() == 34 && !h.needsSummary(), "34 of 40 tokens, nothing evicted");
+  h.append("third", repeat('c', 60));
+  check(h.size() == 2 && h.tokens() == 34 && h.needsSummary(), "over 40: the oldest is evicted for the summary");
+  check(!contains(fragments(h), "first") && contains(fragments(h), "third"), "the newest two are sent");
+
+  h.append("huge", repeat('d', 400));
+  check(h.size() == 1 && h.tokens() == 101, "an exchange over the budget on its own stays");
+  h.setTokenBudget(1000);
+  h.append("small", "ok");
+  check(h.size() == 2, "a larger budget keeps more");
+  h.setTokenBudget(10);
+  check(h.size() == 1 && contains(fragments(h), "small"), "setTokenBudget() evicts right away");
+}
+
+static void summaryChecks() {
+  printf("rolling summary\n");
+  ConversationHistory h(HISTORY_BACKEND, 20);
+  String request;
+  size_t folded = 0;
+  check(!h.summaryRequest(request, folded), "no request without evicted exchanges");
+  check(h.systemPrompt("Base") == "Base", "no summary: the base prompt");
+
+  h.append("my name is Ada", repeat('a', 40));
+  h.append("I like tea", repeat('b', 40));  // evicts Ada
+  check(h.summaryRequest(request, folded), "a request once an exchange is evicted");
+  check(contains(request, "Current summary: (none)") && contains(request, "[{\"user\":\"my name is Ada\""),
+        "the request carries the evicted exchange");
+
+  h.append("and cake", repeat('c', 40));  // evicts tea while the request runs
+  h.applySummary("  The user is Ada.  ", folded);
+  check(h.systemPrompt("Base") == "Base\n\n[Earlier in this conversation]\nThe user is Ada.",
+        "summary trimmed, after the base prompt");
+  check(h.needsSummary(), "the exchange evicted meanwhile waits for the next fold");
+  h.summaryRequest(request, folded);
+  check(contains(request, "I like tea") && !contains(request, "Ada\"") && contains(request, "The user is Ada."),
+        "the next request: the old summary and only the new exchange");
+
+  h.applySummary("", folded);
+  check(h.needsSummary(), "a failed summary keeps the evicted text");
+  h.applySummary(repeat('s', HISTORY_SUMMARY_MAX_CHARS + 50), folded);
+  check(!h.needsSummary(), "a summary folds everything it was asked for");
+  check(h.systemPrompt("").length() == strlen("[Earlier in this conversation]\n") + HISTORY_SUMMARY_MAX_CHARS,
+        "the summary is cut at HISTORY_SUMMARY_MAX_CHARS, no separator without a base");
+
+  h.append("x", repeat('x', 100));
+  h.summaryRequest(request, folded);
+  h.clear();
+  h.applySummary("late", folded);
+  check(h.systemPrompt("B") == "B" && !h.needsSummary() && h.size() == 0,
+        "a summary arriving after clear() is dropped");
+
+  ConversationHistory many(HISTORY_BACKEND, 1);
+  for (int i = 0; i < 200; i++) many.append(String(("turn " + std::to_string(i)).c_str()), repeat('y', 60));
+  many.summaryRequest(request, folded);
+  size_t start = request.indexOf("Messages (JSON): [") + strlen("Messages (JSON): [");
+  String evicted = request.substring(start, request.length() - 1);
+  check(evicted.length() <= HISTORY_FOLD_MAX_CHARS && evicted.startsWith("{\"user\":") &&
+          contains(evicted, "turn 198"),
+        "failing summaries: the oldest evicted exchanges go, at a fragment boundary");
+  check(!contains(evicted, "\"turn 100\""), "turn 100 is gone");
+  many.applySummary("all of it", folded);
+  check(!many.needsSummary(), "a summary after the trim folds the rest");
+}
+
+int main() {
+  formatChecks();
+  budgetChecks();
+  summaryChecks();
+  printf(failures ? "conversation history: %d failed\n" : "conversation history: ok\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+// Host stand-in for the parts of the Arduino core the library code under test uses, so it builds with a
+// desktop compiler. Not a port: no I2S or Wi-Fi, the FreeRTOS calls in host/freertos are thin wrappers.
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <assert.h>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <ctype.h>
+
+using std::min;
+using std::max;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define __unused __attribute__((unused))
+#define pgm_read_byte(a)  (*(const uint8_t*)(a))
+#define pgm_read_word(a)  (*(const uint16_t*)(a))
+#define pgm_read_dword(a) (*(const uint32_t*)(a))
+#define log_v(...)
+#define log_d(...)
+#define log_i(...)
+#define log_w(...)
+#define log_e(...)
+#define MALLOC_CAP_DEFAULT  0
+#define MALLOC_CAP_INTERNAL 0
+#define MALLOC_CAP_SPIRAM   0
+#ifndef PI
+#define PI 3.14159265358979f
+#endif
+#define _min(a, b) ((a) < (b) ? (a) : (b))
+#define constrain(x, a, b) ((x) < (a) ? (a) : ((x) > (b) ? (b) : (x)))
+
+typedef bool boolean;
+
+inline bool psramFound() { return false; }
+inline void* ps_malloc(size_t n) { return malloc(n); }
+inline void* ps_calloc(size_t n, size_t s) { return calloc(n, s); }
+inline void* ps_realloc(void* p, size_t n) { return realloc(p, n); }
+inline void* heap_caps_malloc(size_t n, uint32_t) { return malloc(n); }
+inline void* heap_caps_malloc_prefer(size_t n, size_t, uint32_t, uint32_t) { return malloc(n); }
+inline void* heap_caps_calloc_prefer(size_t n, size_t s, size_t, uint32_t, uint32_t) { return calloc(n, s); }
+inline size_t heap_caps_get_free_size(uint32_t) { return 0; }
+
+// a check that needs exact durations steps the clock itself: after the first host_step() the time stands still
+inline int64_t& host_stepped_us() {
+  static int64_t t = -1;
+  return t;
+}
+inline void host_step(int64_t us) {
+  if (host_stepped_us() < 0) host_stepped_us() = 0;
+  host_stepped_us() += us;
+}
+inline int64_t host_us() {
+  static auto t0 = std::chrono::steady_clock::now();
+  if (host_stepped_us() >= 0) return host_stepped_us();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+}
+inline unsigned long millis() { return (unsigned long)(host_us() / 1000); }
+inline unsigned long micros() { return (unsigned long)host_us(); }
+inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline long random(long from, long to) { return from + rand() % (to - from); }
+inline uint32_t esp_random() { return ((uint32_t)rand() << 16) ^ (uint32_t)rand(); }
+
+class String : public std::string {
+  public:
+    String() {}
+    String(const char* s) : std::string(s ? s : "") {}
+    String(const std::string& s) : std::string(s) {}
+    explicit String(int v) : std::string(std::to_string(v)) {}
+    explicit String(unsigned v) : std::string(std::to_string(v)) {}
+    explicit String(long v) : std::string(std::to_string(v)) {}
+    explicit String(unsigned long v) : std::string(std::to_string(v)) {}
+    unsigned length() const { return size(); }
+    bool startsWith(const char* p) const { return compare(0, strlen(p), p) == 0; }
+    bool endsWith(const char* p) const {
+      size_t n = strlen(p);
+      return size() >= n && compare(size() - n, n, p) == 0;
+    }
+    String substring(size_t from, size_t to = npos) const {
+      if (from > size()) return String();
+      return String(substr(from, to == npos ? npos : to - from));
+    }
+    int indexOf(const char* p, size_t from = 0) const {
+      size_t i = find(p, from);
+      return i == npos ? -1 : (int)i;
+    }
+    int indexOf(char c, size_t from = 0) const {
+      size_t i = find(c, from);
+      return i == npos ? -1 : (int)i;
+    }
+    long toInt() const { return atol(c_str()); }
+    void trim() {
+      size_t a = find_first_not_of(" \t\r\n");
+      *this = a == npos ? String() : String(substr(a, find_last_not_of(" \t\r\n") - a + 1));
+    }
+};
+
+class Print {
+  public:
+    size_t printf(const char* fmt, ...) {
+      va_list a;
+      va_start(a, fmt);
+      int n = vprintf(fmt, a);
+      va_end(a);
+      return n;
+    }
+    size_t println(const char* s = "") { return ::printf("%s\n", s); }
+    size_t print(const char* s) { return ::printf("%s", s); }
+};
+extern Print Serial;
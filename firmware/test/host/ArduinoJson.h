@@ -0,0 +1,168 @@
+// Host stand-in for the ArduinoJson 6 API the library builds documents with: DynamicJsonDocument, nested
+// objects and arrays, serializeJson(). Documents are a small tree; there is no parser and no capacity limit.
+#pragma once
+#include "Arduino.h"
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct HostJsonNode {
+  enum Kind { NUL, OBJECT, ARRAY, RAW, STRING } kind = NUL;
+  std::string value;                                  // RAW: the literal, STRING: unescaped text
+  std::vector<std::pair<std::string, std::shared_ptr<HostJsonNode>>> members;
+  std::vector<std::shared_ptr<HostJsonNode>> items;
+
+  std::shared_ptr<HostJsonNode> member(const std::string& key) {
+    kind = OBJECT;
+    for (auto& m : members)
+      if (m.first == key) return m.second;
+    members.emplace_back(key, std::make_shared<HostJsonNode>());
+    return members.back().second;
+  }
+
+  static void quote(std::string& out, const std::string& s) {
+    out += '"';
+    for (unsigned char c : s) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+        out += (char)c;
+      } else if (c == '\n') {
+        out += "\\n";
+      } else if (c == '\r') {
+        out += "\\r";
+      } else if (c == '\t') {
+        out += "\\t";
+      } else if (c < 0x20) {
+        char u[8];
+        snprintf(u, sizeof(u), "\\u%04x", c);
+        out += u;
+      } else {
+        out += (char)c;
+      }
+    }
+    out += '"';
+  }
+
+  void dump(std::string& out) const {
+    switch (kind) {
+      case NUL: out += "null"; break;
+      case RAW: out += value; break;
+      case STRING: quote(out, value); break;
+      case OBJECT:
+        out += '{';
+        for (size_t i = 0; i < members.size(); i++) {
+          if (i) out += ',';
+          quote(out, members[i].first);
+          out += ':';
+          members[i].second->dump(out);
+        }
+        out += '}';
+        break;
+      case ARRAY:
+        out += '[';
+        for (size_t i = 0; i < items.size(); i++) {
+          if (i) out += ',';
+          items[i]->dump(out);
+        }
+        out += ']';
+        break;
+    }
+  }
+};
+
+class JsonArray;
+class JsonObject;
+
+class JsonVariant {
+  public:
+    JsonVariant(std::shared_ptr<HostJsonNode> n = nullptr) : _n(n) {}
+
+    template <class T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, JsonVariant&>::type
+    operator=(T v) {
+      _set(HostJsonNode::RAW, std::to_string(v));
+      return *this;
+    }
+    template <class T>
+    typename std::enable_if<std::is_floating_point<T>::value, JsonVariant&>::type operator=(T v) {
+      char b[32];
+      snprintf(b, sizeof(b), "%.9g", (double)v);
+      _set(HostJsonNode::RAW, b);
+      return *this;
+    }
+    JsonVariant& operator=(bool v) {
+      _set(HostJsonNode::RAW, v ? "true" : "false");
+      return *this;
+    }
+    JsonVariant& operator=(const char* v) {
+      if (v == nullptr) _set(HostJsonNode::NUL, "");
+      else _set(HostJsonNode::STRING, v);
+      return *this;
+    }
+    JsonVariant& operator=(const String& v) {
+      _set(HostJsonNode::STRING, v);
+      return *this;
+    }
+
+    JsonVariant operator[](const char* key) { return JsonVariant(_n->member(key)); }
+    JsonVariant operator[](const String& key) { return JsonVariant(_n->member(key)); }
+    JsonObject createNestedObject(const char* key);
+    JsonArray createNestedArray(const char* key);
+
+  protected:
+    std::shared_ptr<HostJsonNode> _n;
+    friend class JsonArray;
+
+    void _set(HostJsonNode::Kind kind, const std::string& value) {
+      _n->kind = kind;
+      _n->value = value;
+      _n->members.clear();
+      _n->items.clear();
+    }
+};
+
+class JsonObject : public JsonVariant {
+  public:
+    JsonObject(std::shared_ptr<HostJsonNode> n = nullptr) : JsonVariant(n) {
+      if (_n) _n->kind = HostJsonNode::OBJECT;
+    }
+};
+
+class JsonArray {
+  public:
+    JsonArray(std::shared_ptr<HostJsonNode> n = nullptr) : _n(n) {
+      if (_n) _n->kind = HostJsonNode::ARRAY;
+    }
+    template <class T> bool add(T v) {
+      _n->items.push_back(std::make_shared<HostJsonNode>());
+      JsonVariant(_n->items.back()) = v;
+      return true;
+    }
+    JsonObject createNestedObject() {
+      _n->items.push_back(std::make_shared<HostJsonNode>());
+      return JsonObject(_n->items.back());
+    }
+    size_t size() const { return _n->items.size(); }
+
+  private:
+    std::shared_ptr<HostJsonNode> _n;
+};
+
+inline JsonObject JsonVariant::createNestedObject(const char* key) { return JsonObject(_n->member(key)); }
+inline JsonArray JsonVariant::createNestedArray(const char* key) { return JsonArray(_n->member(key)); }
+
+class DynamicJsonDocument : public JsonObject {
+  public:
+    explicit DynamicJsonDocument(size_t) : JsonObject(std::make_shared<HostJsonNode>()) {}
+    std::string dump() const {
+      std::string out;
+      _n->dump(out);
+      return out;
+    }
+};
+
+inline size_t serializeJson(const DynamicJsonDocument& doc, String& out) {
+  out = doc.dump();
+  return out.size();
+}
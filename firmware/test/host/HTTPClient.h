@@ -0,0 +1,25 @@
+// Host stand-in for HTTPClient: every request fails with a connection error, postCount tells a test that the
+// code fell back to HTTP.
+#pragma once
+#include "WiFiClientSecure.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+
+class HTTPClient {
+  public:
+    static inline int postCount = 0;
+
+    bool begin(WiFiClient&, const String&) { return true; }
+    bool begin(const String&) { return true; }
+    void addHeader(const String&, const String&) {}
+    void setTimeout(uint16_t) {}
+    int POST(const String&) {
+      postCount++;
+      return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    int GET() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+    String getString() { return String(); }
+    bool connected() { return false; }
+    WiFiClient* getStreamPtr() { return nullptr; }
+    void end() {}
+};
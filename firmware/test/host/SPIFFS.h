@@ -0,0 +1,26 @@
+// Host stand-in for SPIFFS: mounts, but no file opens.
+#pragma once
+#include "Arduino.h"
+
+#define FILE_READ  "r"
+#define FILE_WRITE "w"
+
+namespace fs {
+class File {
+  public:
+    explicit operator bool() const { return false; }
+    size_t write(const uint8_t*, size_t) { return 0; }
+    int read(uint8_t*, size_t) { return 0; }
+    size_t size() const { return 0; }
+    void close() {}
+};
+class FS {
+  public:
+    bool begin(bool = false) { return true; }
+    File open(const char*, const char* = FILE_READ) { return File(); }
+    bool exists(const char*) { return false; }
+};
+}  // namespace fs
+using fs::File;
+
+inline fs::FS SPIFFS;
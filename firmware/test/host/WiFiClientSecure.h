@@ -0,0 +1,108 @@
+// Host stand-in for WiFiClient/WiFiClientSecure: a plain TCP socket, no TLS. Tests point every connect() at a
+// mock server on the loopback with WiFiClient::redirectPort.
+#pragma once
+#include "Arduino.h"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class WiFiClient {
+  public:
+    static inline uint16_t redirectPort = 0;    // nonzero: connect() goes to 127.0.0.1:redirectPort
+
+    virtual ~WiFiClient() { stop(); }
+
+    int connect(const char* host, uint16_t port) {
+      stop();
+      sockaddr_in a = {};
+      a.sin_family = AF_INET;
+      if (redirectPort != 0) {
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        a.sin_port = htons(redirectPort);
+      } else {
+        hostent* h = gethostbyname(host);
+        if (h == nullptr) return 0;
+        memcpy(&a.sin_addr, h->h_addr_list[0], sizeof(a.sin_addr));
+        a.sin_port = htons(port);
+      }
+      _fd = socket(AF_INET, SOCK_STREAM, 0);
+      if (_fd < 0 || ::connect(_fd, (sockaddr*)&a, sizeof(a)) != 0) {
+        stop();
+        return 0;
+      }
+      return 1;
+    }
+    void setNoDelay(bool on) {
+      int v = on;
+      if (_fd >= 0) setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &v, sizeof(v));
+    }
+    int available() {
+      int n = 0;
+      if (_fd < 0 || ioctl(_fd, FIONREAD, &n) != 0) return 0;
+      return n;
+    }
+    bool connected() {
+      if (_fd < 0) return false;
+      if (available() > 0) return true;
+      char c;
+      ssize_t r = recv(_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+      return r != 0 && !(r < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+    }
+    int read(uint8_t* buf, size_t len) {
+      if (_fd < 0) return -1;
+      ssize_t r = recv(_fd, buf, len, MSG_DONTWAIT);
+      return r < 0 ? -1 : (int)r;
+    }
+    int read() {
+      uint8_t c;
+      return read(&c, 1) == 1 ? c : -1;
+    }
+    size_t readBytes(uint8_t* buf, size_t len) {
+      size_t got = 0;
+      unsigned long start = millis();
+      while (got < len && millis() - start < _timeoutMs) {
+        int n = read(buf + got, len - got);
+        if (n > 0) got += n;
+        else if (!connected()) break;
+        else delay(1);
+      }
+      return got;
+    }
+    String readStringUntil(char end) {
+      String s;
+      unsigned long start = millis();
+      while (millis() - start < _timeoutMs) {
+        int c = read();
+        if (c == end) break;
+        if (c >= 0) s += (char)c;
+        else if (!connected()) break;
+        else delay(1);
+      }
+      return s;
+    }
+    size_t write(const uint8_t* buf, size_t len) {
+      if (_fd < 0) return 0;
+      ssize_t r = send(_fd, buf, len, MSG_NOSIGNAL);
+      return r < 0 ? 0 : (size_t)r;
+    }
+    size_t print(const String& s) { return write((const uint8_t*)s.data(), s.size()); }
+    void setTimeout(uint32_t ms) { _timeoutMs = ms; }
+    void stop() {
+      if (_fd >= 0) close(_fd);
+      _fd = -1;
+    }
+
+  private:
+    int _fd = -1;
+    unsigned long _timeoutMs = 1000;
+};
+
+class WiFiClientSecure : public WiFiClient {
+  public:
+    void setInsecure() {}
+    void setCACert(const char*) {}
+};
@@ -0,0 +1,33 @@
+// Host stand-in for the FreeRTOS types and locks the library code under test uses; spinlocks and mutexes are
+// std mutexes, the tests run on desktop threads.
+#pragma once
+#include <stdint.h>
+#include <mutex>
+#include <chrono>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+
+#define pdTRUE             1
+#define pdFALSE            0
+#define pdPASS             1
+#define pdFAIL             0
+#define portMAX_DELAY      0xFFFFFFFFu
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+#define tskNO_AFFINITY     0x7FFFFFFF
+
+struct portMUX_TYPE {
+  std::recursive_mutex m;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+inline void portMUX_INITIALIZE(portMUX_TYPE*) {}
+#define portENTER_CRITICAL(mux) (mux)->m.lock()
+#define portEXIT_CRITICAL(mux)  (mux)->m.unlock()
+
+struct HostSemaphore {
+  std::recursive_timed_mutex m;
+};
+typedef HostSemaphore* SemaphoreHandle_t;
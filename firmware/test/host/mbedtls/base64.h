@@ -0,0 +1,22 @@
+// Host stand-in for mbedtls_base64_encode, standard alphabet with padding.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL -0x002A
+
+inline int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen) {
+  static const char t[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  *olen = (slen + 2) / 3 * 4;
+  if (dlen < *olen + 1) return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+  size_t o = 0;
+  for (size_t i = 0; i < slen; i += 3) {
+    uint32_t v = (uint32_t)src[i] << 16 | (i + 1 < slen ? src[i + 1] << 8 : 0) | (i + 2 < slen ? src[i + 2] : 0);
+    dst[o++] = t[v >> 18 & 63];
+    dst[o++] = t[v >> 12 & 63];
+    dst[o++] = i + 1 < slen ? t[v >> 6 & 63] : '=';
+    dst[o++] = i + 2 < slen ? t[v & 63] : '=';
+  }
+  dst[o] = '\0';
+  return 0;
+}
@@ -0,0 +1,113 @@
+// LatencyTracer on a stepped clock (host_step()): 20 scripted turns whose stage durations grow with the turn
+// number, so the percentiles over the ring of the last LATENCY_TRACE_TURNS turns are known exactly.
+// Cases: nearest-rank p50/p90/p99 of durations and of time to first byte, the window dropping the oldest
+// turns, minSamples, marks that must not count (first() after end(), a second end()), LAT_RESPONSE filled
+// in by endTurn(), a cancelled turn, a turn dropped by beginTurn(), the histogram and the cumulative max.
+#include "LatencyTracer.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("  %s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) failures++;
+}
+
+static void stepMs(uint32_t ms) { host_step((int64_t)ms * 1000); }
+
+// turn t: transcribe 450 + 10t ms, LLM 800 + 20t ms (first byte at 700 + 20t), TTS 500 ms
+static void scriptedTurn(int t) {
+  latencyTracer.beginTurn();
+  latencyTracer.begin(LAT_ASR_CAPTURE);
+  stepMs(300);
+  latencyTracer.first(LAT_ASR_CAPTURE);
+  stepMs(1500);
+  unsigned long lastSpeech = millis();
+  stepMs(900);
+  latencyTracer.end(LAT_ASR_CAPTURE);
+  latencyTracer.recordSince(LAT_ASR_ENDPOINT, lastSpeech);
+
+  latencyTracer.begin(LAT_ASR_TRANSCRIBE);
+  stepMs(400 + 10 * t);
+  latencyTracer.first(LAT_ASR_TRANSCRIBE);
+  stepMs(50);
+  latencyTracer.end(LAT_ASR_TRANSCRIBE);
+
+  latencyTracer.begin(LAT_LLM);
+  stepMs(700 + 20 * t);
+  latencyTracer.first(LAT_LLM);
+  stepMs(100);
+  latencyTracer.end(LAT_LLM);
+  stepMs(30);
+  latencyTracer.first(LAT_LLM);  // after end(): ignored
+
+  latencyTracer.begin(LAT_TTS);
+  stepMs(300);
+  latencyTracer.first(LAT_TTS);
+  stepMs(200);
+  latencyTracer.end(LAT_TTS);
+  stepMs(10);
+  latencyTracer.end(LAT_TTS);  // already ended: ignored
+
+  stepMs(3000);
+  latencyTracer.endTurn(t % 7 != 3);
+}
+
+static bool contains(const String& s, const char* part) { return s.find(part) != std::string::npos; }
+
+int main() {
+  stepMs(1);  // from here on the clock only moves with stepMs()
+  for (int t = 0; t < 20; t++) scriptedTurn(t);
+
+  printf("20 turns, the window holds turns 4..19\n");
+  check(latencyTracer.turnCount() == 20, "turnCount() counts failed turns too");
+  check(latencyTracer.percentileMs(LAT_LLM, 50) == 1020, "llm p50: 8th of 16, turn 11");
+  check(latencyTracer.percentileMs(LAT_LLM, 90) == 1160, "llm p90: 15th of 16, turn 18");
+  check(latencyTracer.percentileMs(LAT_LLM, 99) == 1180, "llm p99: the slowest");
+  check(latencyTracer.percentileMs(LAT_LLM, 0) == 880, "p0: the fastest in the window, turn 4");
+  check(latencyTracer.percentileMs(LAT_ASR_TRANSCRIBE, 50) == 560, "transcribe p50");
+  check(latencyTracer.percentileMs(LAT_ASR_ENDPOINT, 90) == 900, "recordSince(): last speech .. now");
+  check(latencyTracer.percentileMs(LAT_TTS, 99) == 500, "a second end() does not move the end");
+  check(latencyTracer.percentileMs(LAT_RESPONSE, 90) == 2320, "response: end of capture .. end of TTS");
+  check(latencyTracer.percentileMs(LAT_VISION, 50) == 0, "a stage without samples is 0");
+  check(latencyTracer.percentileMs(LAT_LLM, 50, 16) == 1020, "minSamples met");
+  check(latencyTracer.percentileMs(LAT_LLM, 50, 17) == 0, "below minSamples: 0");
+
+  String metrics = latencyTracer.metricsJson();
+  check(contains(metrics, "\"llm\":{\"count\":20,"), "metrics: count over all turns");
+  check(contains(metrics, "\"max_us\":1180000,\"p50_us\":1020000,\"p90_us\":1160000,\"p99_us\":1180000"),
+        "metrics: llm max and percentiles in us");
+  check(contains(metrics, "\"hist\":[0,0,0,0,0,20,0,0,0,0],\"first\":{\"p50_us\":920000"),
+        "metrics: llm in the 800ms bucket, first byte p50 of turn 11 (first() after end() ignored)");
+  check(contains(latencyTracer.lastTurnJson(), "\"id\":20,"), "last turn is turn 20");
+  check(contains(latencyTracer.traceJson(2), "\"trace\":[{\"id\":20,"), "trace: newest first");
+
+  printf("cancelled and dropped turns\n");
+  latencyTracer.beginTurn();
+  latencyTracer.begin(LAT_LLM);
+  stepMs(9000);
+  latencyTracer.end(LAT_LLM);
+  latencyTracer.cancelTurn();
+  latencyTracer.endTurn();
+  check(latencyTracer.turnCount() == 20, "a cancelled turn is not committed");
+
+  latencyTracer.beginTurn();
+  latencyTracer.begin(LAT_LLM);
+  stepMs(5000);
+  latencyTracer.end(LAT_LLM);
+  latencyTracer.beginTurn();  // drops the open turn with its 5s LLM span
+  latencyTracer.begin(LAT_TTS);
+  stepMs(100);
+  latencyTracer.end(LAT_TTS);
+  latencyTracer.endTurn();
+  check(latencyTracer.turnCount() == 21, "the second turn is committed");
+  check(latencyTracer.percentileMs(LAT_LLM, 50) == 1040, "llm p50 over the 15 turns 5..19 that have it");
+  check(contains(latencyTracer.metricsJson(), "\"llm\":{\"count\":20,\"mean_us\":990000,\"max_us\":1180000,"),
+        "the dropped span is in neither the count, the mean nor the max");
+  check(latencyTracer.percentileMs(LAT_TTS, 0) == 100, "tts p0 is the new turn");
+
+  latencyTracer.reset();
+  check(latencyTracer.turnCount() == 0 && latencyTracer.percentileMs(LAT_LLM, 50) == 0, "reset() clears it all");
+
+  printf(failures ? "latency tracer: %d failed\n" : "latency tracer: ok\n", failures);
+  return failures ? 1 : 0;
+}
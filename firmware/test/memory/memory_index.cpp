@@ -0,0 +1,215 @@
+// MemoryIndex int8 search. Random unit vectors are quantized the way /v1/memory/sync sends them (int8, per-item
+// scale max|x| / 127). Cases: dot() against a plain loop for every tail length and at the int8 extremes,
+// search() against a brute-force ranking over the same scores (per kind, top counts, output format), the
+// agreement of the int8 top hits with float cosine similarity, begin() dimensions, text cut, and a full index
+// that keeps the newest MEMORY_INDEX_CAPACITY items whatever order they come in (cold fill newest first).
+#include "MemoryIndex.h"
+#include <vector>
+
+static const int DIM = 256;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("  %s %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) failures++;
+}
+
+static uint32_t rs = 12345;
+static uint32_t rnd() {
+  rs ^= rs << 13;
+  rs ^= rs >> 17;
+  rs ^= rs << 5;
+  return rs;
+}
+static float gauss() {  // Irwin-Hall, close enough for random directions
+  float s = 0;
+  for (int i = 0; i < 12; i++) s += (rnd() & 0xFFFF) / 65536.0f;
+  return s - 6;
+}
+
+struct Item {
+  char kind;
+  std::vector<float> x;  // unit length
+  std::vector<int8_t> q;
+  float scale;
+};
+
+static Item makeItem(char kind, const std::vector<float>* near = nullptr, float noise = 0) {
+  Item it;
+  it.kind = kind;
+  it.x.resize(DIM);
+  float n = 0;
+  for (int i = 0; i < DIM; i++) {
+    it.x[i] = near ? (*near)[i] + noise * gauss() : gauss();
+    n += it.x[i] * it.x[i];
+  }
+  float mx = 0;
+  for (int i = 0; i < DIM; i++) {
+    it.x[i] /= sqrtf(n);
+    mx = std::max(mx, fabsf(it.x[i]));
+  }
+  it.scale = mx / 127;
+  it.q.resize(DIM);
+  for (int i = 0; i < DIM; i++) it.q[i] = (int8_t)lrintf(it.x[i] / it.scale);
+  return it;
+}
+
+static String name(int k) { return String(("item " + std::to_string(k)).c_str()); }
+
+// "[C1] item 3\n[V1] item 7" -> {"C3", "V7"}
+static std::vector<std::string> hits(const String& result) {
+  std::vector<std::string> out;
+  size_t pos = 0;
+  while (pos < result.length()) {
+    size_t end = result.find('\n', pos);
+    if (end == std::string::npos) end = result.length();
+    std::string line = result.substr(pos, end - pos);
+    out.push_back(line.substr(1, 1) + line.substr(line.find("item ") + 5));
+    pos = end + 1;
+  }
+  return out;
+}
+
+static void dotChecks() {
+  printf("dot\n");
+  int8_t a[MEMORY_INDEX_MAX_DIM], b[MEMORY_INDEX_MAX_DIM];
+  bool same = true;
+  for (size_t n = 0; n <= 67; n++) {
+    for (size_t i = 0; i < n; i++) {
+      a[i] = (int8_t)rnd();
+      b[i] = (int8_t)rnd();
+    }
+    int32_t ref = 0;
+    for (size_t i = 0; i < n; i++) ref += a[i] * b[i];
+    same = same && MemoryIndex::dot(a, b, n) == ref;
+  }
+  check(same, "lengths 0..67, every tail of the four accumulators");
+  memset(a, -128, sizeof(a));
+  memset(b, -128, sizeof(b));
+  check(MemoryIndex::dot(a, b, MEMORY_INDEX_MAX_DIM) == 16384 * MEMORY_INDEX_MAX_DIM,
+        "-128 * -128 over the largest dim");
+}
+
+static void searchChecks() {
+  printf("search\n");
+  MemoryIndex idx;
+  check(!idx.begin(0) && !idx.begin(MEMORY_INDEX_MAX_DIM + 4) && !idx.begin(6),
+        "begin(): 0, too large, not a multiple of 4");
+  check(idx.search(nullptr, 1, 5, 3) == "", "search before begin(): nothing");
+  check(idx.begin(DIM) && idx.ready() && idx.dim() == DIM && idx.size() == 0, "begin(256)");
+
+  // 200 items in 20 clusters, so a query has a few close neighbours and many far ones
+  std::vector<Item> items;
+  std::vector<Item> centers;
+  for (int c = 0; c < 20; c++) centers.push_back(makeItem('c'));
+  for (int k = 0; k < 200; k++) {
+    items.push_back(makeItem(k % 4 == 0 ? 'v' : 'c', &centers[k % 20].x, 0.06f));
+    idx.add(items[k].kind, name(k), 1000 + k, items[k].q.data(), items[k].scale);
+  }
+  check(idx.size() == 200 && idx.cursor() == 1199, "200 items, the cursor is the newest creation time");
+
+  int exact = 0, top1 = 0, overlap = 0, total = 0;
+  const int QUERIES = 200;
+  for (int t = 0; t < QUERIES; t++) {
+    Item query = makeItem('c', &centers[t % 20].x, 0.06f);
+    std::vector<std::string> got = hits(idx.search(query.q.data(), query.scale, 5, 3));
+
+    // the same int8 scores, ranked by brute force; and float cosine
+    std::vector<std::pair<float, int>> c8, v8, cf, vf;
+    for (int k = 0; k < 200; k++) {
+      float s8 = MemoryIndex::dot(query.q.data(), items[k].q.data(), DIM) * query.scale * items[k].scale;
+      float sf = 0;
+      for (int i = 0; i < DIM; i++) sf += query.x[i] * items[k].x[i];
+      (items[k].kind == 'v' ? v8 : c8).push_back({-s8, k});
+      (items[k].kind == 'v' ? vf : cf).push_back({-sf, k});
+    }
+    std::stable_sort(c8.begin(), c8.end());
+    std::stable_sort(v8.begin(), v8.end());
+    std::sort(cf.begin(), cf.end());
+    std::sort(vf.begin(), vf.end());
+    std::vector<std::string> want;
+    for (int i = 0; i < 5; i++) want.push_back("C" + std::to_string(c8[i].second));
+    for (int i = 0; i < 3; i++) want.push_back("V" + std::to_string(v8[i].second));
+    exact += got == want;
+
+    top1 += c8[0].second == cf[0].second;
+    for (int i = 0; i < 5; i++)
+      for (int j = 0; j < 5; j++) overlap += c8[i].second == cf[j].second;
+    total += 5;
+  }
+  check(exact == QUERIES, "search() returns the brute-force top 5 conversations and top 3 visual events");
+  printf("    int8 vs float: top-1 %d/%d, top-5 overlap %.1f%%\n", top1, QUERIES, 100.0 * overlap / total);
+  check(top1 >= QUERIES * 95 / 100 && overlap >= total * 90 / 100,
+        "int8 ranks like float cosine (top-1 95%, top-5 90%)");
+
+  Item query = makeItem('c', &centers[3].x, 0.06f);
+  String r = idx.search(query.q.data(), query.scale, 2, 1);
+  check(r.startsWith("[C1] item ") && r.find("\n[C2] item ") != std::string::npos &&
+          r.find("\n[V1] item ") != std::string::npos && hits(r).size() == 3,
+        "format: [C1], [C2], [V1], one per line");
+  check(hits(idx.search(query.q.data(), query.scale, 50, 0)).size() == MEMORY_INDEX_TOP_MAX, "top counts are capped");
+  check(idx.search(query.q.data(), query.scale, 0, 0) == "", "no top: nothing");
+  std::vector<std::string> both = hits(idx.search(query.q.data(), query.scale, 5, 2));
+  check(hits(idx.search(query.q.data(), query.scale, 0, 2)) == std::vector<std::string>(both.begin() + 5, both.end()),
+        "visual events only: the same as next to conversations");
+
+  idx.add('c', String(std::string(MEMORY_INDEX_TEXT_MAX + 100, 'z').c_str()), 5000, query.q.data(), query.scale);
+  r = idx.search(query.q.data(), query.scale, 1, 0);
+  check(r.length() == strlen("[C1] ") + MEMORY_INDEX_TEXT_MAX, "text cut at MEMORY_INDEX_TEXT_MAX");
+
+  check(idx.begin(DIM) && idx.size() == 201, "begin() with the same dim keeps the items");
+  check(idx.begin(128) && idx.size() == 0 && idx.cursor() == 0, "another dim drops them");
+}
+
+static void capacityChecks() {
+  printf("capacity\n");
+  const int N = MEMORY_INDEX_CAPACITY + 100;
+  std::vector<Item> items;
+  for (int k = 0; k < N; k++) items.push_back(makeItem('c'));
+
+  // cold fill newest first, then new items oldest first
+  MemoryIndex idx;
+  idx.begin(DIM);
+  int added = 0;
+  for (int k = N - 1; k >= 0; k--) added += idx.add('c', name(k), 1000 + k, items[k].q.data(), items[k].scale);
+  check(added == MEMORY_INDEX_CAPACITY && idx.size() == MEMORY_INDEX_CAPACITY,
+        "newest first: items older than all kept are refused");
+  for (int k = N; k < N + 10; k++) {
+    items.push_back(makeItem('c'));
+    idx.add('c', name(k), 1000 + k, items[k].q.data(), items[k].scale);
+  }
+  check(idx.size() == MEMORY_INDEX_CAPACITY && idx.cursor() == (uint64_t)(1000 + N + 9),
+        "new items replace the oldest");
+
+  // every item kept has to be found by its own vector, the first of the newest ones and none of the older
+  int found = 0, stale = 0;
+  for (int k = 0; k < N + 10; k++) {
+    std::vector<std::string> h = hits(idx.search(items[k].q.data(), items[k].scale, 1, 0));
+    bool self = h.size() == 1 && h[0] == "C" + std::to_string(k);
+    if (k >= N + 10 - MEMORY_INDEX_CAPACITY) found += self;
+    else stale += self;
+  }
+  check(found == MEMORY_INDEX_CAPACITY && stale == 0, "the index holds exactly the newest MEMORY_INDEX_CAPACITY items");
+
+  MemoryIndex shuffled;
+  shuffled.begin(DIM);
+  std::vector<int> order;
+  for (int k = 0; k < N; k++) order.push_back(k);
+  for (int k = N - 1; k > 0; k--) std::swap(order[k], order[rnd() % (k + 1)]);
+  for (int k : order) shuffled.add('c', name(k), 1000 + k, items[k].q.data(), items[k].scale);
+  found = 0;
+  for (int k = N - MEMORY_INDEX_CAPACITY; k < N; k++) {
+    std::vector<std::string> h = hits(shuffled.search(items[k].q.data(), items[k].scale, 1, 0));
+    found += h.size() == 1 && h[0] == "C" + std::to_string(k);
+  }
+  check(found == MEMORY_INDEX_CAPACITY, "any order: the newest MEMORY_INDEX_CAPACITY items");
+}
+
+int main() {
+  dotChecks();
+  searchChecks();
+  capacityChecks();
+  printf(failures ? "memory index: %d failed\n" : "memory index: ok\n", failures);
+  return failures ? 1 : 0;
+}
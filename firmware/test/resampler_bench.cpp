@@ -0,0 +1,60 @@
+// Cost of the polyphase resampler per output frame, for every SRC_QUALITY_* preset and the rate pairs the
+// library runs (TTS streams into a fixed 48kHz or 44.1kHz I2S, music at 44.1kHz into 48kHz).
+// Reports ns and, on x86, TSC cycles per output frame; the input is 10s of noise.
+//   make -C firmware/test bench
+#include "resampler/resampler.h"
+#include <chrono>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+struct Case {
+  uint32_t in, out;
+  uint8_t channels;
+};
+
+static const Case CASES[] = {
+  {16000, 48000, 1}, {24000, 48000, 1}, {22050, 44100, 2}, {44100, 48000, 2}, {48000, 16000, 1},
+};
+static const char* QUALITY[] = {"low", "medium", "high"};
+
+int main() {
+  printf("%-6s %-16s %12s %12s\n", "preset", "conversion", "ns/frame", "cycles/frame");
+  uint32_t seed = 1;
+  for (uint8_t q = SRC_QUALITY_LOW; q <= SRC_QUALITY_HIGH; q++) {
+    for (const Case& c : CASES) {
+      const size_t inFrames = c.in * 10;
+      std::vector<int16_t> in(inFrames * c.channels);
+      for (auto& s : in) {
+        seed = seed * 1664525 + 1013904223;
+        s = (int16_t)(seed >> 16) >> 2;
+      }
+      Resampler src;
+      if (!src.init(c.in, c.out, c.channels, q)) return 2;
+      std::vector<int16_t> out(2048 * c.channels);
+      size_t used = 0, made = 0;
+      auto t0 = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+      uint64_t c0 = __rdtsc();
+#endif
+      while (used < inFrames) {
+        uint16_t consumed = 0;
+        uint16_t n = (uint16_t)std::min<size_t>(512, inFrames - used);
+        made += src.process(&in[used * c.channels], n, out.data(), 2048, &consumed);
+        used += consumed;
+      }
+#ifdef HAVE_TSC
+      double cycles = (double)(__rdtsc() - c0) / made;
+#else
+      double cycles = 0;
+#endif
+      double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / made;
+      char conv[32];
+      snprintf(conv, sizeof(conv), "%u->%u %s", (unsigned)c.in, (unsigned)c.out, c.channels == 2 ? "st" : "mono");
+      printf("%-6s %-16s %12.1f %12.1f\n", QUALITY[q], conv, ns, cycles);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,221 @@
+// Decode cost of the TTS formats per second of audio: 16 kHz SILK (speech-mode Opus, 20 ms frames, mono, through
+// OPUSDecode() and the upsampler to 48 kHz) against MP3 at 22.05 kHz mono 32 kbit/s (ElevenLabs mp3_22050_32) and
+// 44.1 kHz mono 64 kbit/s. SILK comes out at 48 kHz; with the I2S clock fixed at 48 kHz (setOutputSampleRate) the MP3
+// output goes through the Resampler as well, that row is MP3 plus SRC_QUALITY_MEDIUM.
+// There is no encoder on the host. The Opus stream is Ogg pages of SILK WB packets with random range coder
+// payloads, which decode like speech does. The MP3 frames have valid headers and side info (no bit reservoir,
+// long blocks, random Huffman tables, big_values and gains) and random main data, so the Huffman decoding, the
+// dequantizer, the IMDCT and the polyphase filter all run.
+// Host numbers: compare the two formats on the same machine, not with the ESP32.
+//   make -C firmware/test bench
+#include "mp3_decoder/mp3_decoder.h"
+#include "opus_decoder/opus_decoder.h"
+#include "resampler/resampler.h"
+#include <chrono>
+#include <vector>
+
+static uint32_t rs = 12345;
+static uint32_t rnd() {
+  rs ^= rs << 13;
+  rs ^= rs >> 17;
+  rs ^= rs << 5;
+  return rs;
+}
+
+struct BitWriter {
+  std::vector<uint8_t> out;
+  uint32_t acc = 0;
+  int n = 0;
+  void put(uint32_t v, int bits) {
+    for (int i = bits - 1; i >= 0; i--) {
+      acc = acc << 1 | ((v >> i) & 1);
+      if (++n == 8) {
+        out.push_back((uint8_t)acc);
+        acc = 0;
+        n = 0;
+      }
+    }
+  }
+};
+
+// ---------------- MP3 ----------------
+
+struct Mp3Type {
+  const char* name;
+  bool mpeg1;        // 44.1 kHz MPEG-1 (2 granules), else 22.05 kHz MPEG-2 (1 granule)
+  uint8_t bitrateIdx;
+  uint32_t frameBytes;
+  uint32_t samples;  // per frame
+  uint32_t rate;
+};
+
+// mono, no CRC, long blocks, main data of every frame in the frame (main_data_begin 0); a frame whose random
+// Huffman data runs past part2_3_length is thrown away and made again
+static std::vector<uint8_t> makeMp3(const Mp3Type& t, int frames) {
+  static int16_t pcm[2 * 1152];
+  std::vector<uint8_t> s;
+  int grans = t.mpeg1 ? 2 : 1;
+  int sideBytes = t.mpeg1 ? 17 : 9;
+  int mainBits = (t.frameBytes - 4 - sideBytes) * 8;
+  MP3Decoder_ClearBuffer();
+  while ((int)(s.size() / t.frameBytes) < frames) {
+    BitWriter w;
+    w.put(0xFFF, 12);
+    w.put(t.mpeg1 ? 1 : 0, 1);  // ID
+    w.put(1, 2);                // layer III
+    w.put(1, 1);                // no CRC
+    w.put(t.bitrateIdx, 4);
+    w.put(0, 2);                // 44.1 / 22.05 kHz
+    w.put(0, 2);                // no padding, private
+    w.put(3, 2);                // mono
+    w.put(0, 6);
+    w.put(0, t.mpeg1 ? 9 : 8);  // main_data_begin
+    w.put(0, t.mpeg1 ? 5 : 1);  // private bits
+    if (t.mpeg1) w.put(0, 4);   // scfsi
+    for (int gr = 0; gr < grans; gr++) {
+      w.put(mainBits / grans - 8, 12);  // part2_3_length
+      w.put(40 + rnd() % 200, 9);       // big_values
+      w.put(140 + rnd() % 30, 8);       // global_gain
+      w.put(rnd() % (t.mpeg1 ? 16 : 200), t.mpeg1 ? 4 : 9);
+      w.put(0, 1);                      // long blocks
+      static const uint8_t TABLES[] = {1, 2, 3, 5, 6, 7, 8, 9, 10, 11, 12, 13, 15, 16, 17, 24, 25};
+      for (int i = 0; i < 3; i++) w.put(TABLES[rnd() % sizeof(TABLES)], 5);
+      w.put(rnd() % 16, 4);
+      w.put(rnd() % 8, 3);
+      if (t.mpeg1) w.put(0, 1);         // preflag
+      w.put(0, 1);
+      w.put(rnd() & 1, 1);
+    }
+    while (w.out.size() < t.frameBytes + 4) w.put(rnd() & 0xFF, 8);  // 4 bytes of the next header, as in a file
+    int32_t left = (int32_t)w.out.size();
+    if (MP3Decode(w.out.data(), &left, pcm, 0) < 0) continue;
+    s.insert(s.end(), w.out.begin(), w.out.begin() + t.frameBytes);
+  }
+  return s;
+}
+
+// decodes every frame, returns the samples per channel; with src the samples after the resampler
+static long decodeMp3(std::vector<uint8_t>& s, Resampler* src = nullptr) {
+  static int16_t pcm[2 * 1152];
+  static int16_t out[4096];
+  MP3Decoder_ClearBuffer();
+  uint8_t* p = s.data();
+  int32_t left = (int32_t)s.size();
+  long samples = 0;
+  while (left > 4) {
+    int32_t before = left;
+    int32_t ret = MP3Decode(p, &left, pcm, 0);
+    if (ret < 0 || left >= before) {
+      printf("mp3: error %d\n", (int)ret);
+      return -1;
+    }
+    p += before - left;
+    if (src == nullptr) {
+      samples += MP3GetOutputSamps();
+      continue;
+    }
+    uint16_t used = 0;
+    while (used < MP3GetOutputSamps()) {
+      uint16_t consumed = 0;
+      samples += src->process(pcm + used, MP3GetOutputSamps() - used, out, 4096, &consumed);
+      used += consumed;
+    }
+  }
+  return samples;
+}
+
+// ---------------- Opus SILK ----------------
+
+static void oggPage(std::vector<uint8_t>& s, const std::vector<std::vector<uint8_t>>& packets, uint8_t type, uint32_t seq) {
+  const uint8_t head[] = {'O', 'g', 'g', 'S', 0, type, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0};
+  s.insert(s.end(), head, head + sizeof(head));
+  for (int i = 0; i < 4; i++) s.push_back((uint8_t)(seq >> (8 * i)));
+  for (int i = 0; i < 4; i++) s.push_back(0);  // CRC, not checked
+  s.push_back((uint8_t)packets.size());
+  for (auto& p : packets) s.push_back((uint8_t)p.size());  // packets < 255 bytes
+  for (auto& p : packets) s.insert(s.end(), p.begin(), p.end());
+}
+
+// SILK WB (16 kHz internal) 20 ms mono packets at about kbps
+static std::vector<uint8_t> makeSilk(int packets, int kbps) {
+  std::vector<uint8_t> s;
+  oggPage(s, {{'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1, 1, 0x38, 0x01, 0x80, 0x3e, 0, 0, 0, 0, 0}}, 0x02, 0);
+  oggPage(s, {{'O', 'p', 'u', 's', 'T', 'a', 'g', 's', 0, 0, 0, 0, 0, 0, 0, 0}}, 0x00, 1);
+  std::vector<std::vector<uint8_t>> page;
+  uint32_t seq = 2;
+  for (int i = 0; i < packets; i++) {
+    std::vector<uint8_t> p(1 + kbps * 20 / 8 - 4 + rnd() % 8);
+    p[0] = 9 << 3;  // config 9: SILK WB 20 ms, mono, one frame
+    for (size_t b = 1; b < p.size(); b++) p[b] = (uint8_t)rnd();
+    page.push_back(p);
+    if (page.size() == 50 || i + 1 == packets) {
+      oggPage(s, page, i + 1 == packets ? 0x04 : 0x00, seq++);
+      page.clear();
+    }
+  }
+  return s;
+}
+
+// decodes the stream, returns the samples per channel at 48 kHz
+static long decodeOpus(std::vector<uint8_t>& s) {
+  static int16_t pcm[2 * 2880];
+  OPUSsetDefaults();
+  OPUSDecoder_ClearBuffers();
+  uint8_t* p = s.data();
+  int32_t left = (int32_t)s.size();
+  long samples = 0;
+  while (left > 0) {
+    int32_t before = left;
+    int32_t ret = OPUSDecode(p, &left, pcm);
+    if (ret < 0) {
+      printf("opus: error %d\n", (int)ret);
+      return -1;
+    }
+    p += before - left;
+    if (ret == ERR_OPUS_NONE) samples += OPUSGetOutputSamps();
+  }
+  return samples;
+}
+
+// ---------------- timing ----------------
+
+// fastest of a few runs, in us of CPU per second of audio
+template <class F>
+static double usPerSecond(F decode, uint32_t rate) {
+  double best = 1e30;
+  for (int rep = 0; rep < 20; rep++) {
+    auto t0 = std::chrono::steady_clock::now();
+    long samples = decode();
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    if (samples <= 0) return -1;
+    best = std::min(best, us / ((double)samples / rate));
+  }
+  return best;
+}
+
+int main() {
+  if (!MP3Decoder_AllocateBuffers() || !OPUSDecoder_AllocateBuffers()) return 2;
+  printf("%-32s %14s\n", "format", "us per s audio");
+
+  static const Mp3Type MP3[] = {
+    {"mp3 22.05kHz mono 32k", false, 4, 104, 576, 22050},   // MPEG-2: 72 * 32000 / 22050
+    {"mp3 44.1kHz mono 64k", true, 5, 208, 1152, 44100},    // MPEG-1: 144 * 64000 / 44100
+  };
+  for (const Mp3Type& t : MP3) {
+    std::vector<uint8_t> s = makeMp3(t, 20 * t.rate / t.samples);  // 20 s
+    printf("%-32s %14.0f\n", t.name, usPerSecond([&] { return decodeMp3(s); }, t.rate));
+    Resampler src;
+    src.init(t.rate, 48000, 1, SRC_QUALITY_MEDIUM);
+    char name[48];
+    snprintf(name, sizeof(name), "%s -> 48kHz", t.name);
+    printf("%-32s %14.0f\n", name, usPerSecond([&] { return decodeMp3(s, &src); }, 48000));
+  }
+  static const int SILK_KBPS[] = {16, 24, 32};
+  for (int kbps : SILK_KBPS) {
+    std::vector<uint8_t> s = makeSilk(1000, kbps);  // 20 s
+    char name[48];
+    snprintf(name, sizeof(name), "opus silk 16kHz mono %dk -> 48kHz", kbps);
+    printf("%-32s %14.0f\n", name, usPerSecond([&] { return decodeOpus(s); }, 48000));
+  }
+  return 0;
+}